@@ -0,0 +1,157 @@
+#define GLEW_STATIC
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+// Not used, directly, but must be included to be added to registry
+#include "nodeeditor/operators/Operators.hpp"
+
+#include "nodeeditor/constants.h"
+#include "nodeeditor/gl/HeadlessContext.h"
+#include "nodeeditor/gl/TexturePool.h"
+#include "nodeeditor/gl/TiledRenderer.h"
+#include "nodeeditor/nodegraph/Scene.h"
+#include "nodeeditor/log.h"
+
+void printUsage(const char *program)
+{
+    fprintf(stderr,
+            "Usage: %s [options] <scene>\n"
+            "\n"
+            "Evaluates the Save nodes in a scene without a window and exits.\n"
+            "\n"
+            "Options:\n"
+            "  --node <id>       Only evaluate the Save node with the given ID, may be repeated\n"
+            "  --backend <name>  Default backend for operators, gpu or cpu. Overrides the scene setting\n"
+            "  --software        Force software rendering (Mesa llvmpipe)\n"
+            "  --tile <size>     Render in tiles of size x size pixels, streaming each Save node to an HDR file\n"
+            "  --help            Show this message\n",
+            program);
+}
+
+int main(int argc, char *argv[])
+{
+    std::string scenePath;
+    std::vector<NodeID> nodeIDs;
+    bool forceSoftware = false;
+    int backend = -1;
+    int tileSize = 0;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--node") == 0 && i + 1 < argc)
+        {
+            nodeIDs.push_back(NodeID(std::strtoul(argv[++i], nullptr, 10)));
+        }
+        else if (strcmp(argv[i], "--backend") == 0 && i + 1 < argc)
+        {
+            ++i;
+            if (strcmp(argv[i], "gpu") == 0)
+            {
+                backend = Backend_GPU;
+            }
+            else if (strcmp(argv[i], "cpu") == 0)
+            {
+                backend = Backend_CPU;
+            }
+            else
+            {
+                printUsage(argv[0]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--tile") == 0 && i + 1 < argc)
+        {
+            tileSize = std::atoi(argv[++i]);
+            if (tileSize <= 0)
+            {
+                printUsage(argv[0]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--software") == 0)
+        {
+            forceSoftware = true;
+        }
+        else if (strcmp(argv[i], "--help") == 0)
+        {
+            printUsage(argv[0]);
+            return 0;
+        }
+        else if (argv[i][0] != '-' && scenePath.empty())
+        {
+            scenePath = argv[i];
+        }
+        else
+        {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (scenePath.empty())
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    HeadlessContext context{forceSoftware};
+    if (!context.isInitialised())
+    {
+        return 1;
+    }
+
+    Scene scene;
+    if (!scene.load(scenePath))
+    {
+        LOG_ERROR("Failed to load from: %s", scenePath.c_str());
+        return 1;
+    }
+    if (backend != -1)
+    {
+        scene.setBackend(Backend(backend));
+    }
+    // Nothing is evaluated twice, so released intermediates are recycled instead of cached
+    scene.setResultCacheCapacity(0);
+
+    std::vector<Node *> targets;
+    if (nodeIDs.empty())
+    {
+        for (auto it = scene.getCurrentGraph()->begin(); it != scene.getCurrentGraph()->end(); ++it)
+        {
+            if (it->type() == "Save")
+            {
+                targets.push_back(&(*it));
+            }
+        }
+    }
+    for (NodeID nodeID : nodeIDs)
+    {
+        Node *node = scene.getNode(nodeID);
+        if (!node || node->type() != "Save")
+        {
+            LOG_ERROR("No Save node with ID %u", nodeID);
+            return 1;
+        }
+        targets.push_back(node);
+    }
+    if (targets.empty())
+    {
+        LOG_WARNING("No Save nodes to evaluate in %s", scenePath.c_str());
+        return 0;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    bool ok = tileSize > 0 ? TiledRenderer(&scene, tileSize).render(targets) : scene.evaluate(targets);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    printf("Evaluated %lu Save node(s) in %.3fs\n", targets.size(), elapsed.count());
+
+    // Textures must be deleted while the context is still current
+    scene.clear();
+    TexturePool::instance().clear();
+
+    return ok ? 0 : 1;
+}
@@ -4,30 +4,7 @@
 #include <GLFW/glfw3.h>
 
 // Not used, directly, but must be included to be added to registry
-#include "nodeeditor/operators/Add.hpp"
-#include "nodeeditor/operators/CheckerBoard.hpp"
-#include "nodeeditor/operators/Clamp.hpp"
-#include "nodeeditor/operators/Constant.hpp"
-#include "nodeeditor/operators/ConvolveTexture.hpp"
-#include "nodeeditor/operators/CopyLayer.hpp"
-#include "nodeeditor/operators/ExtractLayer.hpp"
-#include "nodeeditor/operators/Gaussian.hpp"
-#include "nodeeditor/operators/Gradient.hpp"
-#include "nodeeditor/operators/Invert.hpp"
-#include "nodeeditor/operators/JumpFlood.hpp"
-#include "nodeeditor/operators/Load.hpp"
-#include "nodeeditor/operators/Merge.hpp"
-#include "nodeeditor/operators/Multiply.hpp"
-#include "nodeeditor/operators/Normals.hpp"
-#include "nodeeditor/operators/Offset.hpp"
-#include "nodeeditor/operators/Perlin.hpp"
-#include "nodeeditor/operators/Pixel.hpp"
-#include "nodeeditor/operators/Power.hpp"
-#include "nodeeditor/operators/Save.hpp"
-#include "nodeeditor/operators/Shuffle.hpp"
-#include "nodeeditor/operators/Temperature.hpp"
-#include "nodeeditor/operators/VectorBand.hpp"
-#include "nodeeditor/operators/Voronoi.hpp"
+#include "nodeeditor/operators/Operators.hpp"
 
 #include "nodeeditor/Application.h"
 #include "nodeeditor/interface/UI.h"
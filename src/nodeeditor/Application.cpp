@@ -1,3 +1,5 @@
+#include <filesystem>
+#include <memory>
 #include <string>
 
 #include <GL/glew.h>
@@ -10,11 +12,13 @@
 #include "interface/Panel.hpp"
 #include "interface/Viewport.h"
 #include "interface/UI.h"
+#include "nodegraph/BinarySerializer.h"
 #include "nodegraph/GraphElement.h"
 #include "nodegraph/Serializer.h"
 #include "nodegraph/Settings.h"
 #include "gl/RenderScene.h"
-#include "gl/RenderSetOperator.h"
+#include "gl/ViewLayers.h"
+#include "gl/ShaderCache.h"
 #include "gl/Texture.h"
 #include "gl/util.h"
 #include "log.h"
@@ -22,6 +26,19 @@
 Application::Application(RenderScene *mapmaker, UI *ui) : m_scene(mapmaker), m_ui(ui)
 {
     m_ui->setScene(mapmaker);
+    m_snapshot = m_scene->snapshot();
+    m_scene->setDiskCache(DEFAULT_DISK_CACHE_DIRECTORY, DEFAULT_DISK_CACHE_BYTES);
+    // Compiled in the background so nodes are created without waiting on their shaders
+    m_shaderContext = std::make_unique<Context>("Shaders", 1, 1, m_scene->context(), false);
+    m_ui->use();
+    if (m_shaderContext->isInitialised())
+    {
+        Context *context = m_shaderContext.get();
+        ShaderCache::instance().prewarm([context]()
+                                        { context->use(); },
+                                        [context]()
+                                        { context->release(); });
+    }
     m_ui->viewportProperties()->setPixelPreview(&m_pixelPreview);
 
     // TODO: I'm being too lazy to work out the actual matrix for the definition
@@ -59,11 +76,14 @@ void Application::exec()
 
     while (!m_ui->isClosed())
     {
+        m_snapshot = m_scene->snapshot();
+        placeCreatedNode();
         glfwPollEvents();
 
         double now = glfwGetTime();
         if ((now - m_lastFrameTime) >= m_fpsLimit)
         {
+            updateViewRegion();
             m_ui->draw();
             m_ui->display();
             m_lastFrameTime = now;
@@ -71,6 +91,7 @@ void Application::exec()
     }
 
     m_scene->stopProcessing();
+    ShaderCache::instance().waitForPrewarm();
 }
 
 void Application::close()
@@ -116,7 +137,7 @@ void Application::onKeyChanged(int key, [[maybe_unused]] int scancode, int actio
             }
             else if (m_ui->nodegraph()->bounds().contains(m_ui->cursorPos()))
             {
-                Bounds b = m_scene->getCurrentGraph()->bounds();
+                Bounds b = m_snapshot->bounds();
                 m_ui->nodegraph()->fitBounds(b);
             }
             break;
@@ -147,6 +168,15 @@ void Application::onKeyChanged(int key, [[maybe_unused]] int scancode, int actio
         case GLFW_KEY_DELETE:
             deleteSelectedNode();
             break;
+        case GLFW_KEY_P:
+            togglePinSelectedNode();
+            break;
+        case GLFW_KEY_E:
+            toggleExportAll();
+            break;
+        case GLFW_KEY_K:
+            toggleBakeOnSave();
+            break;
         }
     }
 }
@@ -190,12 +220,11 @@ void Application::onMouseButtonChanged(int button, int action, [[maybe_unused]]
                 }
                 else if (Connector *conn = dynamic_cast<Connector *>(el))
                 {
-                    if (conn->type() == Connector::Input && conn->numConnections() > 0)
+                    if (conn->type() == Connector::Input && m_snapshot->connection(conn))
                     {
-                        conn->disconnectAll();
-                        m_scene->setDirty();
+                        m_scene->disconnectAll(conn);
                     }
-                    m_ui->nodegraph()->startConnection(conn);
+                    m_ui->nodegraph()->startConnection(conn, m_snapshot);
                 }
             }
         }
@@ -207,14 +236,10 @@ void Application::onMouseButtonChanged(int button, int action, [[maybe_unused]]
                 GraphElement *el = getElementAtPos(m_ui->cursorPos());
                 if (Connector *conn = dynamic_cast<Connector *>(el))
                 {
-                    if (m_ui->nodegraph()->activeConnection()->connect(conn))
+                    // The connection is made, and the graph reevaluated, by the processing thread
+                    if (!m_scene->connect(m_ui->nodegraph()->activeConnection(), conn))
                     {
-                        // A state has changed, so let it reevaluate
-                        m_scene->setDirty();
-                    }
-                    else
-                    {
-                        // Eg, same conncector, not output to input, connection is full, etc...
+                        // Eg, same conncector, not output to input, etc...
                         LOG_DEBUG("Connectors found but failed to connect");
                     }
                 }
@@ -261,19 +286,7 @@ void Application::onMouseMoved(double xpos, double ypos)
         m_ui->nodegraph()->updateConnection(m_ui->cursorPos());
     }
 
-    // Hover state
-    for (auto it = m_scene->getCurrentGraph()->begin(); it != m_scene->getCurrentGraph()->end(); ++it)
-    {
-        setHoverState(&(*it), cursorPos);
-        for (size_t i = 0; i < it->numInputs(); ++i)
-        {
-            setHoverState(it->input(i), cursorPos);
-        }
-        for (size_t i = 0; i < it->numOutputs(); ++i)
-        {
-            setHoverState(it->output(i), cursorPos);
-        }
-    }
+    updateHoverState(cursorPos);
     m_lastCursorPos = cursorPos;
 }
 
@@ -299,31 +312,10 @@ void Application::onResize([[maybe_unused]] int width, [[maybe_unused]] int heig
 
 void Application::setSelectedNode(Node *node)
 {
-    Node *selectedNode = m_scene->getSelectedNode();
-    if (selectedNode)
-    {
-        selectedNode->clearSelectFlag(SelectFlag_Select);
-    }
-    // Might be no new selected node
-    if (node)
-    {
-        node->setSelectFlag(SelectFlag_Select);
-    }
+    m_scene->setSelectedNode(node);
 }
 
 // Viewport
-Texture const *Application::currentTexture() const
-{
-    Node *node = m_scene->getViewNode();
-    if (!node)
-    {
-        return nullptr;
-    }
-    std::string layer = m_ui->viewportProperties()->selectedLayer();
-    Op::RenderSetOperator const *op = dynamic_cast<Op::RenderSetOperator const *>(node->op());
-    return op->layer(layer);
-}
-
 void Application::togglePause(bool pause)
 {
     m_scene->setPaused(pause);
@@ -333,7 +325,9 @@ void Application::updatePixelPreview(double xpos, double ypos)
 {
     // Invert the screen y-pos to get world position
     glm::vec2 worldPos = m_ui->viewport()->screenToWorldPos({xpos, m_ui->height() - ypos});
-    const Texture *texptr = currentTexture();
+    // Held until the pixel is read so the processing thread can't write to the texture
+    std::shared_ptr<ViewLayers const> layers = m_scene->viewLayers();
+    const Texture *texptr = layers ? layers->layer(m_ui->viewportProperties()->selectedLayer()) : nullptr;
     if (texptr)
     {
         float ratio = 0.5f * float(texptr->width()) / texptr->height();
@@ -343,6 +337,7 @@ void Application::updatePixelPreview(double xpos, double ypos)
             int y = worldPos.y * texptr->height();
             m_pixelPreview.pos = {x, y};
 
+            layers->wait();
             m_textureReader.setTexture(texptr);
             m_pixelPreview.value = m_textureReader.readPixel(x, y);
             return;
@@ -353,6 +348,14 @@ void Application::updatePixelPreview(double xpos, double ypos)
     m_pixelPreview.value = {0, 0, 0, 0};
 }
 
+void Application::updateViewRegion()
+{
+    // Lets the scene process what's visible before the rest of the image
+    glm::ivec2 origin, size;
+    m_ui->viewport()->visibleRegion(m_scene->defaultImageSize(), origin, size);
+    m_scene->setViewRegion(origin, size);
+}
+
 void Application::updateProjection()
 {
     Bounds viewportBounds = m_ui->getViewportBounds();
@@ -383,24 +386,29 @@ bool Application::elementContainsPos(GraphElement *el, glm::vec2 pos) const
 GraphElement *Application::getElementAtPos(glm::vec2 pos)
 {
     // Elements are drawn from first to last, so iterate backwards to find the first element that's on top
-    for (auto it = m_scene->getCurrentGraph()->rbegin(); it != m_scene->getCurrentGraph()->rend(); ++it)
+    for (auto it = m_snapshot->rbegin(); it != m_snapshot->rend(); ++it)
     {
-        if (elementContainsPos(&(*it), pos))
+        Node *node = (*it)->node();
+        if (elementContainsPos(node, pos))
+        {
+            return node;
+        }
+        if (!m_ui->nodegraph()->worldToScreenBounds(node->outerBounds()).contains(pos))
         {
-            return &(*it);
+            continue;
         }
-        for (size_t i = 0; i < it->numInputs(); ++i)
+        for (size_t i = 0; i < node->numInputs(); ++i)
         {
-            if (elementContainsPos(it->input(i), pos))
+            if (elementContainsPos(node->input(i), pos))
             {
-                return it->input(i);
+                return node->input(i);
             }
         }
-        for (size_t i = 0; i < it->numOutputs(); ++i)
+        for (size_t i = 0; i < node->numOutputs(); ++i)
         {
-            if (elementContainsPos(it->output(i), pos))
+            if (elementContainsPos(node->output(i), pos))
             {
-                return it->output(i);
+                return node->output(i);
             }
         }
     }
@@ -423,16 +431,23 @@ Panel *Application::panelAtPos(glm::vec2 pos)
     }
 }
 
-void Application::setHoverState(GraphElement *el, glm::vec2 cursorPos) const
+void Application::updateHoverState(glm::vec2 cursorPos)
 {
-    if (elementContainsPos(el, cursorPos))
+    GraphElement *el = getElementAtPos(cursorPos);
+    if (el == m_hoverElement)
     {
-        el->setSelectFlag(SelectFlag_Hover);
+        return;
     }
-    else
+    if (m_hoverElement)
     {
-        el->clearSelectFlag(SelectFlag_Hover);
+        m_hoverElement->clearSelectFlag(SelectFlag_Hover);
+    }
+    if (el)
+    {
+        el->setSelectFlag(SelectFlag_Hover);
     }
+    m_hoverElement = el;
+    m_hoverSnapshot = m_snapshot;
 }
 
 // Scene
@@ -442,20 +457,33 @@ void Application::createNode(glm::ivec2 screenPos, std::string nodeType)
     m_ui->nodegraph()->finishNodeSelection();
 
     NodeID nodeID = m_scene->createNode(nodeType);
-    Node *node = m_scene->getNode(nodeID);
+    Node *selectedNode = m_scene->getSelectedNode();
+    m_placement.nodeID = nodeID;
+    m_placement.selectedID = selectedNode ? selectedNode->id() : 0;
+    m_placement.worldPos = m_ui->nodegraph()->screenToWorldPos(screenPos);
+}
+
+void Application::placeCreatedNode()
+{
+    // Not in a snapshot until the processing thread has created it
+    Node *node = m_placement.nodeID ? m_snapshot->node(m_placement.nodeID) : nullptr;
+    if (!node)
+    {
+        return;
+    }
+    m_placement.nodeID = 0;
 
     // Connect to the selected node if possible
-    Node *selectedNode = m_scene->getSelectedNode();
+    Node *selectedNode = m_snapshot->node(m_placement.selectedID);
     if (selectedNode && node->numInputs() > 0 && selectedNode->numOutputs() > 0)
     {
         node->setPos(selectedNode->bounds().pos() + glm::vec2(0, node->bounds().size().y * 2));
-        node->input(0)->connect(selectedNode->output(0));
+        m_scene->connect(node->input(0), selectedNode->output(0));
     }
     // Otherwise create at the current screen position
     else
     {
-        glm::vec2 worldPos = m_ui->nodegraph()->screenToWorldPos(screenPos);
-        node->setPos(worldPos);
+        node->setPos(m_placement.worldPos);
     }
     setSelectedNode(node);
 }
@@ -466,9 +494,40 @@ void Application::deleteSelectedNode()
     if (selectedNode)
     {
         setSelectedNode(nullptr);
-        m_scene->getCurrentGraph()->deleteNode(selectedNode->id());
-        m_scene->setDirty();
+        m_scene->deleteNode(selectedNode->id());
+    }
+}
+
+void Application::togglePinSelectedNode()
+{
+    Node *selectedNode = m_scene->getSelectedNode();
+    if (!selectedNode)
+    {
+        return;
     }
+    // Pinned outputs are kept once processed, unpinning only takes effect on the next evaluation
+    if (selectedNode->hasSelectFlag(SelectFlag_Pinned))
+    {
+        selectedNode->clearSelectFlag(SelectFlag_Pinned);
+    }
+    else
+    {
+        selectedNode->setSelectFlag(SelectFlag_Pinned);
+    }
+}
+
+void Application::toggleExportAll()
+{
+    m_isExporting = !m_isExporting;
+    // Save nodes created later aren't exported until toggled again
+    m_scene->setTargetNodes(m_isExporting ? m_scene->findNodes("Save") : std::vector<NodeID>());
+    LOG_INFO("%s exporting every Save node", m_isExporting ? "Started" : "Stopped");
+}
+
+void Application::toggleBakeOnSave()
+{
+    m_bakeOnSave = !m_bakeOnSave;
+    LOG_INFO("%s baking results when saving", m_bakeOnSave ? "Started" : "Stopped");
 }
 
 void Application::setViewNode(Node *node)
@@ -478,9 +537,8 @@ void Application::setViewNode(Node *node)
 
 void Application::updateSetting(Node *node, std::string key, SettingValue value)
 {
-    node->updateSetting(key, value);
-    // Must also set the scene as dirty so that the graph is re-evaluated
-    m_scene->setDirty();
+    // Applied, and the graph reevaluated, by the processing thread
+    m_scene->updateSetting(node, key, value);
 }
 
 void Application::onSceneSizeChanged(glm::ivec2 defaultImageSize)
@@ -490,6 +548,8 @@ void Application::onSceneSizeChanged(glm::ivec2 defaultImageSize)
 
 void Application::onNewSceneRequested()
 {
+    // Kept for when the scene is opened again
+    m_scene->storeResults();
     m_scene->clear();
 }
 void Application::onLoadRequested(const std::string &filepath)
@@ -499,44 +559,12 @@ void Application::onLoadRequested(const std::string &filepath)
         return;
     }
 
-    std::ifstream file{filepath};
-    if (!file.is_open())
-    {
-        LOG_ERROR("Failed to open: %s", filepath.c_str());
-        return;
-    }
-
-    // Read the file into a buffer that a stringstream can read from
-    file.seekg(0, std::ios::end);
-    std::streampos filesize = file.tellg();
-    file.seekg(0, std::ios::beg);
-    std::vector<char> buffer(filesize);
-    file.read(buffer.data(), filesize);
-
-    std::stringstream ss;
-    ss.rdbuf()->pubsetbuf(buffer.data(), filesize);
-
-    StreamDeserializer deserializer{&ss};
-    std::string property;
-    int version;
-    if (deserializer.readProperty(property) && property == KEY_VERSION && deserializer.readInt(version))
-    {
-        deserializer.setVersion(version);
-    }
-    else
-    {
-        LOG_ERROR("Invalid file, must contain a leading version identifier");
-        return;
-    }
-
+    m_scene->storeResults();
     // Scene deserialization only modifies state if fully deserialized
-    if (!m_scene->deserialize(&deserializer))
+    if (!m_scene->load(filepath))
     {
         LOG_ERROR("Failed to load from: %s", filepath.c_str())
     }
-
-    // Would be closed in destructor anyway, just being a good citizen
-    file.close();
 }
 void Application::onSaveRequested(const std::string &filepath)
 {
@@ -545,17 +573,33 @@ void Application::onSaveRequested(const std::string &filepath)
         return;
     }
 
-    std::ofstream stream{filepath};
+    std::ofstream stream{filepath, std::ios::binary};
     if (!stream.is_open())
     {
         LOG_ERROR("Invalid filepath");
         return;
     }
-    StreamSerializer serializer{&stream};
-    serializer.writePropertyInt(KEY_VERSION, VERSION);
-    if (serializer.isOk() && m_scene->serialize(&serializer))
+    std::unique_ptr<Serializer> serializer;
+    if (filepath.size() > BINARY_SCENE_EXTENSION.size() &&
+        filepath.compare(filepath.size() - BINARY_SCENE_EXTENSION.size(), BINARY_SCENE_EXTENSION.size(), BINARY_SCENE_EXTENSION) == 0)
+    {
+        serializer = std::make_unique<BinarySerializer>(&stream);
+    }
+    else
+    {
+        serializer = std::make_unique<StreamSerializer>(&stream);
+    }
+    // Baked results are written next to the scene, and referred to by their filename
+    std::string bakedResults = m_bakeOnSave ? filepath + BAKED_RESULTS_EXTENSION : "";
+    serializer->writePropertyInt(KEY_VERSION, VERSION);
+    if (serializer->isOk() && m_scene->serialize(serializer.get(), std::filesystem::path(bakedResults).filename().string()))
     {
         LOG_INFO("Saved scene to %s", filepath.c_str());
+        if (m_bakeOnSave)
+        {
+            m_scene->bake(bakedResults);
+        }
+        m_scene->storeResults();
     }
     else
     {
@@ -1,4 +1,5 @@
 #pragma once
+#include <memory>
 #include <string>
 
 #include <GL/glew.h>
@@ -11,6 +12,7 @@
 #include "gl/RenderScene.h"
 #include "gl/TextureReader.h"
 #include "nodegraph/GraphElement.h"
+#include "nodegraph/GraphSnapshot.h"
 #include "nodegraph/Settings.h"
 
 class Application
@@ -23,9 +25,27 @@ public:
 protected:
     RenderScene *m_scene;
     UI *m_ui;
+    // Shares programs with the scene, used by the thread compiling them at startup
+    std::unique_ptr<Context> m_shaderContext;
     PixelPreview m_pixelPreview;
     TextureReader m_textureReader;
     Channel m_viewChannel = Channel_All;
+    // Whether every Save node is evaluated along with the view node
+    bool m_isExporting = false;
+    // Whether saving a scene also bakes the results of its nodes alongside it
+    bool m_bakeOnSave = false;
+    // Taken before handling each batch of events so the elements they find stay alive
+    std::shared_ptr<GraphSnapshot const> m_snapshot;
+    // The element under the cursor, and the snapshot it was found in
+    GraphElement *m_hoverElement = nullptr;
+    std::shared_ptr<GraphSnapshot const> m_hoverSnapshot;
+    // Where to place the node last created, once the processing thread has created it
+    struct
+    {
+        NodeID nodeID = 0;
+        NodeID selectedID = 0;
+        glm::vec2 worldPos;
+    } m_placement;
 
     Panel *m_panningPanel = nullptr;
     glm::vec2 m_lastCursorPos;
@@ -51,21 +71,29 @@ protected:
     void setSelectedNode(Node *node);
 
     // Viewport
-    Texture const *currentTexture() const;
     void togglePause(bool pause);
     void updatePixelPreview(double xpos, double ypos);
     void updateProjection();
+    void updateViewRegion();
     void toggleIsolateChannel(Channel channel);
 
     // Nodegraph
     bool elementContainsPos(GraphElement *el, glm::vec2 pos) const;
     GraphElement *getElementAtPos(glm::vec2 pos);
     Panel *panelAtPos(glm::vec2 pos);
-    void setHoverState(GraphElement *el, glm::vec2 cursorPos) const;
+    /* Moves the hover flag to the element under the cursor, if it's changed */
+    void updateHoverState(glm::vec2 cursorPos);
 
     // Scene
     void createNode(glm::ivec2 screenPos, std::string nodeType);
+    /* Positions, connects and selects the node last created once it's in the snapshot */
+    void placeCreatedNode();
     void deleteSelectedNode();
+    void togglePinSelectedNode();
+    /* Toggles evaluating every Save node in the graph in one pass, keeping them up to date */
+    void toggleExportAll();
+    /* Toggles baking the results of nodes with the scene when saved, see Scene::bake() */
+    void toggleBakeOnSave();
     void setViewNode(Node *node);
     void updateSetting(Node *node, std::string key, SettingValue value);
     void onNodeSizeChanged(Node *node, glm::ivec2 imageSize);
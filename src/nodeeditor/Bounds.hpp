@@ -14,6 +14,7 @@ public:
     glm::vec2 center() const { return m_min + (m_max - m_min) * 0.5f; }
     glm::vec2 size() const { return m_max - m_min; }
     bool contains(glm::vec2 pos) const { return m_min.x <= pos.x && pos.x <= m_max.x && m_min.y <= pos.y && pos.y <= m_max.y; }
+    bool intersects(const Bounds &bounds) const { return m_min.x <= bounds.m_max.x && bounds.m_min.x <= m_max.x && m_min.y <= bounds.m_max.y && bounds.m_min.y <= m_max.y; }
 
     void setPos(glm::vec2 pos)
     {
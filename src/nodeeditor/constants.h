@@ -1,4 +1,5 @@
 #pragma once
+#include <cstddef>
 #include <string>
 #include <unordered_map>
 
@@ -6,10 +7,32 @@ const float PI = 3.14159265358979f;
 const unsigned int VERSION = 1;
 const unsigned int DEFAULT_WIDTH = 1024;
 const unsigned int DEFAULT_HEIGHT = 1024;
+// Memory the scene may hold onto for results of nodes that have been reset
+const size_t DEFAULT_RESULT_CACHE_BYTES = size_t(1) << 30;
+// Memory processed nodes may hold before those the view node doesn't need are reset
+const size_t DEFAULT_OUTPUT_BUDGET_BYTES = size_t(4) << 30;
+// Disk space results may be kept in across sessions, and where
+const size_t DEFAULT_DISK_CACHE_BYTES = size_t(16) << 30;
+const std::string DEFAULT_DISK_CACHE_DIRECTORY = ".nodeeditor-cache";
+// Where linked shader programs are kept across sessions, see ShaderCache
+const std::string DEFAULT_SHADER_CACHE_DIRECTORY = ".nodeeditor-cache/shaders";
+// Memory the texture pool may hold onto in textures waiting to be reused
+const size_t DEFAULT_TEXTURE_POOL_BYTES = size_t(1) << 30;
+// Width and height of the tiles CPU operators are computed in
+const int CPU_TILE_SIZE = 64;
+// How many times smaller than the image a proxy preview is evaluated at
+const int DEFAULT_PROXY_FACTOR = 4;
+// Shortest time between edits being applied, edits made in between are applied together
+const int DEFAULT_COALESCE_WINDOW_MS = 50;
+// Scenes saved with this extension are written by the BinarySerializer, otherwise as text
+const std::string BINARY_SCENE_EXTENSION = ".bscene";
+// Appended to a scene's filename for the results baked alongside it, see BakedResults
+const std::string BAKED_RESULTS_EXTENSION = ".baked";
 const std::string KEY_VERSION = "version";
 const std::string KEY_GRAPH = "Graph";
 const std::string KEY_NODES = "nodes";
 const std::string KEY_SETTINGS = "settings";
+const std::string KEY_BAKED = "baked";
 const std::string KEY_INPUTS = "inputs";
 const std::string KEY_INPUT = "i";
 const std::string KEY_NODE_ID = "id";
@@ -18,6 +41,20 @@ const std::string KEY_NODE_FLAGS = "flags";
 
 const std::string DEFAULT_LAYER = "RGBA";
 const std::string SCENE_SETTING_IMAGE_SIZE = "imageSize";
+const std::string SCENE_SETTING_BACKEND = "backend";
+// Position of the evaluated region within the full image, only set when rendering tiles
+const std::string SCENE_SETTING_IMAGE_ORIGIN = "imageOrigin";
+// Size of a pixel relative to the full image, only set when evaluating a proxy
+const std::string SCENE_SETTING_PIXEL_SCALE = "pixelScale";
+// Registered on nodes whose operator has more than one backend
+const std::string NODE_SETTING_BACKEND = "backend";
+
+enum Backend
+{
+    Backend_Scene = 0, // Only valid for nodes, uses the scene's backend
+    Backend_GPU = 1,
+    Backend_CPU = 2,
+};
 
 enum Channel
 {
@@ -47,6 +84,7 @@ enum SelectFlag
     SelectFlag_Hover = 1 << 0,
     SelectFlag_Select = 1 << 1,
     SelectFlag_View = 1 << 2,
+    SelectFlag_Pinned = 1 << 3, // Outputs are kept once processed, see Scheduler
 };
 
 enum FileType
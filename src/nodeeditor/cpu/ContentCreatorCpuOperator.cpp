@@ -0,0 +1,19 @@
+#include "ContentCreatorCpuOperator.h"
+
+namespace Op
+{
+    glm::ivec2 ContentCreatorCpuOperator::outputSize(const std::vector<ImageBuffer const *> &inputs, Settings const *settings, Settings const *sceneSettings) const
+    {
+        glm::ivec2 imageSize = settings->getInt2("imageSize");
+        return (imageSize.x == 0 || imageSize.y == 0) ? CpuOperator::outputSize(inputs, settings, sceneSettings) : imageSize;
+    }
+    void ContentCreatorCpuOperator::registerSettings(Settings *const settings) const
+    {
+        settings->registerInt2("imageSize", glm::ivec2(0), SettingHint_Pixels);
+    }
+    Footprint ContentCreatorCpuOperator::footprint(Settings const *settings) const
+    {
+        glm::ivec2 imageSize = settings->getInt2("imageSize");
+        return {imageSize.x == 0 || imageSize.y == 0, 0};
+    }
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "../nodegraph/Settings.h"
+#include "CpuOperator.h"
+#include "ImageBuffer.h"
+
+namespace Op
+{
+    /*
+    Extends the CpuOperator to add an image size setting and default outputSize implementation,
+    matching ContentCreatorComputeShaderOperator.
+    */
+    class ContentCreatorCpuOperator : public CpuOperator
+    {
+    public:
+        virtual glm::ivec2 outputSize(const std::vector<ImageBuffer const *> &inputs, Settings const *settings, Settings const *sceneSettings) const override;
+        virtual void registerSettings(Settings *const settings) const override;
+        /* Bounded unless the image size is set, compute() must offset the pixel position by m_imageOrigin */
+        virtual Footprint footprint(Settings const *settings) const override;
+    };
+}
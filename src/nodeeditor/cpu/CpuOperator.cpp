@@ -0,0 +1,276 @@
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../constants.h"
+#include "../log.h"
+#include "CpuOperator.h"
+
+namespace Op
+{
+    CpuOperator::~CpuOperator()
+    {
+        for (auto &[key, value] : m_images)
+        {
+            delete value;
+        }
+    }
+
+    ImageBuffer const *CpuOperator::image(const std::string &layer) const
+    {
+        if (!m_computed)
+        {
+            return nullptr;
+        }
+        auto it = m_images.find(layer);
+        return it == m_images.end() ? nullptr : it->second;
+    }
+
+    bool CpuOperator::canStartAsync([[maybe_unused]] const std::vector<Operator const *> &inputs) const
+    {
+        return !m_grid && !m_computed;
+    }
+
+    bool CpuOperator::startAsync(const std::vector<Operator const *> &inputs, Settings const *settings, Settings const *sceneSettings,
+                                 WorkStealingPool *pool, std::function<void()> done)
+    {
+        auto job = std::make_shared<TileJob>();
+        const auto &definedInputs = this->inputs();
+        for (size_t i = 0; i < inputs.size(); ++i)
+        {
+            std::shared_ptr<TileGrid> grid;
+            ImageBuffer const *image = inputs[i] ? inputImage(inputs[i], grid) : nullptr;
+            if (!image && definedInputs[i].required)
+            {
+                setError("Input does not provide the default layer: " + definedInputs[i].name);
+                return false;
+            }
+            job->inputs.push_back(image);
+            job->upstream.push_back(grid);
+        }
+
+        glm::ivec2 imageSize = outputSize(job->inputs, settings, sceneSettings);
+        m_imageOrigin = imageOrigin(sceneSettings);
+        m_grid = std::make_shared<TileGrid>(imageSize, CPU_TILE_SIZE);
+        size_t numTiles = m_grid->numTiles();
+        job->output = ensureOutputImage(DEFAULT_LAYER, imageSize);
+        job->settings = settings;
+        job->grid = m_grid;
+        job->pool = pool;
+        job->done = done;
+        job->pending = std::make_unique<std::atomic<size_t>[]>(numTiles);
+        job->numRemaining = numTiles;
+        if (numTiles == 0)
+        {
+            m_computed = true;
+            done();
+            return true;
+        }
+
+        // Each tile holds one extra count until every dependency is registered
+        for (size_t i = 0; i < numTiles; ++i)
+        {
+            job->pending[i] = 1;
+        }
+        for (const std::shared_ptr<TileGrid> &upstream : job->upstream)
+        {
+            if (!upstream)
+            {
+                continue;
+            }
+            for (size_t i = 0; i < numTiles; ++i)
+            {
+                ++job->pending[i];
+            }
+            if (upstream->imageSize() == imageSize)
+            {
+                for (size_t i = 0; i < numTiles; ++i)
+                {
+                    upstream->whenComplete(i, [this, job, i]()
+                                           { releaseTile(job, i); });
+                }
+            }
+            else
+            {
+                upstream->whenAllComplete([this, job, numTiles]()
+                                          {
+                                              for (size_t i = 0; i < numTiles; ++i)
+                                              {
+                                                  releaseTile(job, i);
+                                              } });
+            }
+        }
+        for (size_t i = 0; i < numTiles; ++i)
+        {
+            releaseTile(job, i);
+        }
+        return true;
+    }
+
+    std::unique_ptr<CachedResult> CpuOperator::releaseResult()
+    {
+        std::unique_ptr<CachedResult> result = RenderSetOperator::releaseResult();
+        if (result)
+        {
+            // Only the textures are cached, a restored operator has no images
+            m_computed = false;
+        }
+        return result;
+    }
+
+    void CpuOperator::reset()
+    {
+        RenderSetOperator::reset();
+        m_inputCopies.clear();
+        m_grid.reset();
+        m_computed = false;
+    }
+
+    Footprint CpuOperator::footprint([[maybe_unused]] Settings const *settings) const
+    {
+        return {true, 0};
+    }
+
+    glm::ivec2 CpuOperator::outputSize(const std::vector<ImageBuffer const *> &inputs, [[maybe_unused]] Settings const *settings, Settings const *sceneSettings) const
+    {
+        if (!inputs.empty() && inputs[0])
+        {
+            return inputs[0]->imageSize();
+        }
+        return sceneSettings->getInt2(SCENE_SETTING_IMAGE_SIZE);
+    }
+
+    bool CpuOperator::process(const std::vector<RenderSetOperator const *> &inputs, Settings const *settings, Settings const *sceneSettings)
+    {
+        if (!m_computed)
+        {
+            // Left unprocessed, another step is only made once the schedule is replaced
+            if (isCancelled())
+            {
+                return false;
+            }
+            // Not started asynchronously, the whole image is computed on this thread
+            const auto &definedInputs = this->inputs();
+            std::vector<ImageBuffer const *> images;
+            for (size_t i = 0; i < inputs.size(); ++i)
+            {
+                std::shared_ptr<TileGrid> grid;
+                ImageBuffer const *image = inputs[i] ? inputImage(inputs[i], grid) : nullptr;
+                if (!image && definedInputs[i].required)
+                {
+                    setError("Input does not provide the default layer: " + definedInputs[i].name);
+                    return false;
+                }
+                images.push_back(image);
+            }
+
+            glm::ivec2 imageSize = outputSize(images, settings, sceneSettings);
+            ImageBuffer *output = ensureOutputImage(DEFAULT_LAYER, imageSize);
+            m_imageOrigin = imageOrigin(sceneSettings);
+            compute(images, output, {0, 0, imageSize.x, imageSize.y}, settings);
+            m_computed = true;
+        }
+
+        m_inputCopies.clear();
+        upload();
+        return true;
+    }
+
+    const float *CpuOperator::readRow(ImageBuffer const *image, int x, int y, int count, std::vector<float> &scratch)
+    {
+        int width = image->width();
+        if (y >= 0 && y < int(image->height()) && x >= 0 && x + count <= width)
+        {
+            return image->pixel(x, y);
+        }
+
+        scratch.assign(size_t(count) * image->numChannels(), 0.0f);
+        if (y >= 0 && y < int(image->height()))
+        {
+            int start = std::max(x, 0);
+            int end = std::min(x + count, width);
+            if (start < end)
+            {
+                std::copy(image->pixel(start, y), image->pixel(end, y), scratch.begin() + (start - x) * image->numChannels());
+            }
+        }
+        return scratch.data();
+    }
+
+    ImageBuffer const *CpuOperator::inputImage(Operator const *input, std::shared_ptr<TileGrid> &grid)
+    {
+        CpuOperator const *op = dynamic_cast<CpuOperator const *>(input);
+        if (op && op->image(DEFAULT_LAYER))
+        {
+            return op->image(DEFAULT_LAYER);
+        }
+        if (op && op->m_grid)
+        {
+            grid = op->m_grid;
+            return op->m_images.at(DEFAULT_LAYER);
+        }
+
+        RenderSetOperator const *renderSetOp = dynamic_cast<RenderSetOperator const *>(input);
+        Texture const *texture = renderSetOp ? renderSetOp->layer(DEFAULT_LAYER) : nullptr;
+        if (!texture)
+        {
+            return nullptr;
+        }
+        LOG_DEBUG("Reading back texture ID %u for CPU processing", texture->id());
+        m_inputCopies.emplace_back(std::make_unique<ImageBuffer>(texture->width(), texture->height()));
+        texture->readRGBA(m_inputCopies.back()->data());
+        return m_inputCopies.back().get();
+    }
+
+    ImageBuffer *CpuOperator::ensureOutputImage(const std::string &layer, const glm::ivec2 &imageSize)
+    {
+        auto it = m_images.find(layer);
+        if (it == m_images.end())
+        {
+            it = m_images.emplace(layer, new ImageBuffer(imageSize.x, imageSize.y)).first;
+            LOG_DEBUG("Created output image for layer %s with size (%u, %u)", layer.c_str(), imageSize.x, imageSize.y);
+        }
+        else
+        {
+            it->second->resize(imageSize.x, imageSize.y);
+        }
+        return it->second;
+    }
+
+    void CpuOperator::releaseTile(const std::shared_ptr<TileJob> &job, size_t index)
+    {
+        if (--job->pending[index] == 0)
+        {
+            job->pool->submit([this, job, index]()
+                              { computeTile(*job, index); });
+        }
+    }
+
+    void CpuOperator::computeTile(TileJob &job, size_t index)
+    {
+        // Cancelled tiles are still completed so that every waiting tile is released quickly
+        if (!isCancelled())
+        {
+            compute(job.inputs, job.output, job.grid->region(index), job.settings);
+        }
+        // Releases any downstream tiles waiting on this one
+        job.grid->complete(index);
+        if (--job.numRemaining == 0)
+        {
+            m_computed = true;
+            job.done();
+        }
+    }
+
+    void CpuOperator::upload()
+    {
+        for (auto &[layer, image] : m_images)
+        {
+            Texture *texture = ensureOutputLayer(layer, image->imageSize());
+            texture->write(image->data(), image->width(), image->height());
+        }
+    }
+}
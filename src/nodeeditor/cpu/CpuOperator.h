@@ -0,0 +1,127 @@
+#pragma once
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "../gl/RenderSetOperator.h"
+#include "../nodegraph/Operator.h"
+#include "../nodegraph/ResultCache.h"
+#include "../nodegraph/Settings.h"
+#include "../nodegraph/WorkStealingPool.h"
+#include "ImageBuffer.h"
+#include "TileGrid.h"
+#include "simd.h"
+
+namespace Op
+{
+    /*
+    Base class for operators computed on the CPU, the counterpart to ComputeShaderOperator.
+
+    The output is computed into an ImageBuffer from the default layer of each input.
+    Inputs computed by another CpuOperator are read directly, anything else is read back
+    from the GPU when the operator is started on the thread owning the GL context.
+
+    When started asynchronously the output is split into tiles of CPU_TILE_SIZE which
+    are computed on the scheduler's pool. An input that is itself still being computed
+    is waited on per tile: a tile of the output starts as soon as the same tile of each
+    input the same size has completed, or once all of a differently sized input has.
+    Once cancelled (see Operator::isCancelled) any tile not yet computed is skipped.
+
+    Once computed, the outputs are written to Textures in a final step on the GL thread so
+    that the operator's RenderSet can be used by any other operator, the viewer or Save.
+    */
+    class CpuOperator : public RenderSetOperator
+    {
+    public:
+        virtual ~CpuOperator();
+
+        /* The computed image for the layer, or nullptr if not computed, eg, restored from the cache */
+        ImageBuffer const *image(const std::string &layer) const;
+
+        virtual bool canStartAsync(const std::vector<Operator const *> &inputs) const override;
+        virtual bool startAsync(const std::vector<Operator const *> &inputs, Settings const *settings, Settings const *sceneSettings,
+                                WorkStealingPool *pool, std::function<void()> done) override;
+        virtual std::unique_ptr<CachedResult> releaseResult() override;
+        virtual void reset() override;
+
+        /* Size of the output image. Defaults to the first input's size, falling back on the scene image size. */
+        virtual glm::ivec2 outputSize(const std::vector<ImageBuffer const *> &inputs, Settings const *settings, Settings const *sceneSettings) const;
+        /*
+        Computes a region of the output from the default layer of each input. Optional
+        inputs that are not connected are a nullptr. Called from worker threads so must
+        not use the GL context or modify the operator, and must only read the same region
+        of any input the same size as the output.
+        */
+        virtual void compute(const std::vector<ImageBuffer const *> &inputs, ImageBuffer *output, const ImageRegion &region, Settings const *settings) const = 0;
+        /* Bounded with no margin, as compute() only reads the same region of its inputs */
+        virtual Footprint footprint(Settings const *settings) const override;
+
+        virtual bool process(const std::vector<RenderSetOperator const *> &inputs, Settings const *settings, Settings const *sceneSettings) override;
+
+    protected:
+        // The state shared by the tile tasks of one asynchronous computation
+        struct TileJob
+        {
+            std::vector<ImageBuffer const *> inputs;
+            // Inputs still being computed, kept alive until this job completes
+            std::vector<std::shared_ptr<TileGrid>> upstream;
+            ImageBuffer *output;
+            Settings const *settings;
+            std::shared_ptr<TileGrid> grid;
+            WorkStealingPool *pool;
+            std::function<void()> done;
+            // Incomplete input tiles each tile is waiting on
+            std::unique_ptr<std::atomic<size_t>[]> pending;
+            std::atomic<size_t> numRemaining;
+        };
+
+        ImageSet m_images;
+        // Inputs read back from the GPU, only held while computing
+        std::vector<std::unique_ptr<ImageBuffer>> m_inputCopies;
+        // Set once started asynchronously
+        std::shared_ptr<TileGrid> m_grid;
+        std::atomic<bool> m_computed{false};
+        // Position of the output within the full image, for operators generating content from the pixel position
+        glm::ivec2 m_imageOrigin{0};
+
+        /*
+        Returns a pointer to count pixels of row y starting at x. Pixels outside of the
+        image are zero, as for imageLoad in glsl, in which case they are written to and
+        read from the scratch buffer.
+        */
+        static const float *readRow(ImageBuffer const *image, int x, int y, int count, std::vector<float> &scratch);
+        /* Calls Simd::transformPixels for each row of the region, the input must be the same size as the output */
+        template <typename Func>
+        static void transformRegion(ImageBuffer const *input, ImageBuffer *output, const ImageRegion &region, Func func)
+        {
+            for (int y = region.y; y < region.y + region.height; ++y)
+            {
+                Simd::transformPixels(input->pixel(region.x, y), output->pixel(region.x, y), region.width, func);
+            }
+        }
+        /* Calls Simd::fillPixels for each row of the region */
+        static void fillRegion(ImageBuffer *output, const ImageRegion &region, const glm::vec4 &color)
+        {
+            for (int y = region.y; y < region.y + region.height; ++y)
+            {
+                Simd::fillPixels(output->pixel(region.x, y), region.width, color);
+            }
+        }
+
+        /*
+        Returns the default layer of the input. If the input is a CpuOperator that is still
+        being computed, grid is set to its tiles which must be waited on before reading.
+        */
+        ImageBuffer const *inputImage(Operator const *input, std::shared_ptr<TileGrid> &grid);
+        ImageBuffer *ensureOutputImage(const std::string &layer, const glm::ivec2 &imageSize);
+        /* Submits the tile to the pool once the last input tile it waits on is released */
+        void releaseTile(const std::shared_ptr<TileJob> &job, size_t index);
+        void computeTile(TileJob &job, size_t index);
+        /* Writes every computed image to the output texture of the same layer */
+        void upload();
+    };
+}
@@ -0,0 +1,99 @@
+#include <cstring>
+#include <new>
+
+#include "ImageBuffer.h"
+
+const size_t IMAGE_BUFFER_ALIGNMENT = 32;
+
+ImageBuffer::ImageBuffer(unsigned int width, unsigned int height) : m_width(width), m_height(height)
+{
+    allocate();
+}
+
+ImageBuffer::~ImageBuffer()
+{
+    release();
+}
+
+// Copy constructor
+ImageBuffer::ImageBuffer(const ImageBuffer &other) : m_width(other.m_width), m_height(other.m_height)
+{
+    allocate();
+    std::memcpy(m_data, other.m_data, byteSize());
+}
+
+// Move constructor
+ImageBuffer::ImageBuffer(ImageBuffer &&other) noexcept : m_width(other.m_width), m_height(other.m_height), m_data(other.m_data)
+{
+    other.m_data = nullptr;
+    other.m_width = 0;
+    other.m_height = 0;
+}
+
+// Copy Assignment
+ImageBuffer &ImageBuffer::operator=(const ImageBuffer &other)
+{
+    if (this != &other)
+    {
+        resize(other.m_width, other.m_height);
+        std::memcpy(m_data, other.m_data, byteSize());
+    }
+    return *this;
+}
+
+// Move assignment
+ImageBuffer &ImageBuffer::operator=(ImageBuffer &&other) noexcept
+{
+    if (this != &other)
+    {
+        release();
+        m_width = other.m_width;
+        m_height = other.m_height;
+        m_data = other.m_data;
+        other.m_data = nullptr;
+        other.m_width = 0;
+        other.m_height = 0;
+    }
+    return *this;
+}
+
+unsigned int ImageBuffer::width() const { return m_width; }
+unsigned int ImageBuffer::height() const { return m_height; }
+glm::ivec2 ImageBuffer::imageSize() const { return {int(m_width), int(m_height)}; }
+size_t ImageBuffer::numChannels() const { return 4; }
+size_t ImageBuffer::byteSize() const { return size_t(m_width) * m_height * numChannels() * sizeof(float); }
+
+void ImageBuffer::resize(unsigned int width, unsigned int height)
+{
+    if (width == m_width && height == m_height)
+    {
+        return;
+    }
+    release();
+    m_width = width;
+    m_height = height;
+    allocate();
+}
+
+float *ImageBuffer::data() { return m_data; }
+const float *ImageBuffer::data() const { return m_data; }
+float *ImageBuffer::pixel(unsigned int x, unsigned int y) { return m_data + (size_t(y) * m_width + x) * numChannels(); }
+const float *ImageBuffer::pixel(unsigned int x, unsigned int y) const { return m_data + (size_t(y) * m_width + x) * numChannels(); }
+
+void ImageBuffer::allocate()
+{
+    size_t size = byteSize();
+    if (size > 0)
+    {
+        m_data = static_cast<float *>(::operator new[](size, std::align_val_t(IMAGE_BUFFER_ALIGNMENT)));
+    }
+}
+
+void ImageBuffer::release()
+{
+    if (m_data)
+    {
+        ::operator delete[](m_data, std::align_val_t(IMAGE_BUFFER_ALIGNMENT));
+        m_data = nullptr;
+    }
+}
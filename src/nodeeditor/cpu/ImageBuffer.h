@@ -0,0 +1,57 @@
+#pragma once
+#include <map>
+#include <string>
+
+#include <glm/glm.hpp>
+
+/*
+A 32 bit float RGBA image in CPU memory, the CPU counterpart to a Texture.
+
+Pixels are stored interleaved and row by row from the bottom of the image, matching
+the layout of Texture::read(). The buffer is 32 byte aligned for AVX loads and stores.
+*/
+class ImageBuffer
+{
+public:
+    ImageBuffer(unsigned int width, unsigned int height);
+    ~ImageBuffer();
+    ImageBuffer(const ImageBuffer &other);                // Copy constructor
+    ImageBuffer(ImageBuffer &&other) noexcept;            // Move constructor
+    ImageBuffer &operator=(const ImageBuffer &other);     // Copy Assignment
+    ImageBuffer &operator=(ImageBuffer &&other) noexcept; // Move assignment
+
+    unsigned int width() const;
+    unsigned int height() const;
+    glm::ivec2 imageSize() const;
+    size_t numChannels() const;
+    size_t byteSize() const;
+
+    // Data is not preserved
+    void resize(unsigned int width, unsigned int height);
+
+    float *data();
+    const float *data() const;
+    // Pointer to the first channel of the pixel
+    float *pixel(unsigned int x, unsigned int y);
+    const float *pixel(unsigned int x, unsigned int y) const;
+
+protected:
+    unsigned int m_width, m_height;
+    float *m_data = nullptr;
+
+    void allocate();
+    void release();
+};
+
+/*
+A region of an image in pixels
+*/
+struct ImageRegion
+{
+    int x;
+    int y;
+    int width;
+    int height;
+};
+
+typedef std::map<std::string, ImageBuffer *> ImageSet;
@@ -0,0 +1,78 @@
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "TileGrid.h"
+
+TileGrid::TileGrid(const glm::ivec2 &imageSize, int tileSize) : m_imageSize(imageSize), m_tileSize(tileSize)
+{
+    m_numColumns = (imageSize.x + tileSize - 1) / tileSize;
+    int numRows = (imageSize.y + tileSize - 1) / tileSize;
+    m_numTiles = size_t(m_numColumns) * numRows;
+    m_complete.resize(m_numTiles, false);
+    m_numRemaining = m_numTiles;
+    m_waiting.resize(m_numTiles);
+}
+
+glm::ivec2 TileGrid::imageSize() const { return m_imageSize; }
+size_t TileGrid::numTiles() const { return m_numTiles; }
+
+ImageRegion TileGrid::region(size_t index) const
+{
+    int x = int(index % m_numColumns) * m_tileSize;
+    int y = int(index / m_numColumns) * m_tileSize;
+    return {x, y, std::min(m_tileSize, m_imageSize.x - x), std::min(m_tileSize, m_imageSize.y - y)};
+}
+
+void TileGrid::complete(size_t index)
+{
+    std::vector<Callback> callbacks;
+    {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        m_complete[index] = true;
+        callbacks.swap(m_waiting[index]);
+        if (--m_numRemaining == 0)
+        {
+            callbacks.insert(callbacks.end(), m_waitingAll.begin(), m_waitingAll.end());
+            m_waitingAll.clear();
+        }
+    }
+    // Callbacks may wait on other tiles so are run without the lock
+    for (Callback &callback : callbacks)
+    {
+        callback();
+    }
+}
+
+bool TileGrid::isComplete() const
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_numRemaining == 0;
+}
+
+void TileGrid::whenComplete(size_t index, Callback func)
+{
+    {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        if (!m_complete[index])
+        {
+            m_waiting[index].emplace_back(std::move(func));
+            return;
+        }
+    }
+    func();
+}
+
+void TileGrid::whenAllComplete(Callback func)
+{
+    {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        if (m_numRemaining > 0)
+        {
+            m_waitingAll.emplace_back(std::move(func));
+            return;
+        }
+    }
+    func();
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "ImageBuffer.h"
+
+/*
+Splits an image into square tiles and tracks which of them have been computed.
+
+Consumers register a callback to run once a tile, or every tile, is complete. Callbacks
+are run by the thread completing the tile, or immediately if it's already complete, and
+must not block. All methods are thread safe.
+*/
+class TileGrid
+{
+public:
+    typedef std::function<void()> Callback;
+
+    TileGrid(const glm::ivec2 &imageSize, int tileSize);
+
+    glm::ivec2 imageSize() const;
+    size_t numTiles() const;
+    /* The pixel region of the tile, clipped to the image */
+    ImageRegion region(size_t index) const;
+
+    /* Marks the tile as complete, running any callbacks waiting on it */
+    void complete(size_t index);
+    bool isComplete() const;
+    /* Calls func once the tile is complete */
+    void whenComplete(size_t index, Callback func);
+    /* Calls func once every tile is complete */
+    void whenAllComplete(Callback func);
+
+protected:
+    glm::ivec2 m_imageSize;
+    int m_tileSize;
+    int m_numColumns;
+    size_t m_numTiles;
+
+    mutable std::mutex m_mutex;
+    std::vector<bool> m_complete;
+    size_t m_numRemaining;
+    std::vector<std::vector<Callback>> m_waiting;
+    std::vector<Callback> m_waitingAll;
+};
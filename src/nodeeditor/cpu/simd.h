@@ -0,0 +1,189 @@
+#pragma once
+#include <cmath>
+
+#include <immintrin.h>
+#include <glm/glm.hpp>
+
+/*
+AVX2 helpers for per-pixel CPU kernels.
+
+Images are interleaved RGBA floats so each 256 bit register holds two pixels, with each
+128 bit half being one pixel. Shuffles within a half (eg, _mm256_permute_ps) therefore
+operate on the channels of a single pixel.
+*/
+namespace Simd
+{
+    // Lane mask to load or store only the first pixel of a register, for odd pixel counts
+    inline __m256i firstPixelMask()
+    {
+        return _mm256_setr_epi32(-1, -1, -1, -1, 0, 0, 0, 0);
+    }
+
+    inline __m256 loadPixels(const float *pixels) { return _mm256_loadu_ps(pixels); }
+    inline __m256 loadPixel(const float *pixel) { return _mm256_maskload_ps(pixel, firstPixelMask()); }
+    inline void storePixels(float *pixels, __m256 value) { _mm256_storeu_ps(pixels, value); }
+    inline void storePixel(float *pixel, __m256 value) { _mm256_maskstore_ps(pixel, firstPixelMask(), value); }
+
+    // The same RGBA value for both pixels of a register
+    inline __m256 broadcastPixel(const glm::vec4 &value)
+    {
+        return _mm256_setr_ps(value.x, value.y, value.z, value.w, value.x, value.y, value.z, value.w);
+    }
+    // Copies the channel of each pixel to all four of its lanes
+    template <int Channel>
+    inline __m256 broadcastChannel(__m256 pixels)
+    {
+        return _mm256_permute_ps(pixels, _MM_SHUFFLE(Channel, Channel, Channel, Channel));
+    }
+    inline __m256 broadcastChannel(__m256 pixels, int channel)
+    {
+        return _mm256_permutevar_ps(pixels, _mm256_set1_epi32(channel));
+    }
+    // Blend mask with every lane set for the channels in a ChannelMask
+    inline __m256 channelLanes(int channelMask)
+    {
+        __m256i bits = _mm256_setr_epi32(1, 2, 4, 8, 1, 2, 4, 8);
+        __m256i selected = _mm256_and_si256(_mm256_set1_epi32(channelMask), bits);
+        return _mm256_castsi256_ps(_mm256_cmpeq_epi32(selected, bits));
+    }
+    // Equivalent of glsl's mix, ie, a * (1 - t) + b * t
+    inline __m256 mix(__m256 a, __m256 b, __m256 t)
+    {
+        return _mm256_fmadd_ps(_mm256_sub_ps(b, a), t, a);
+    }
+
+    // Natural logarithm for x > 0, using the cephes single precision polynomial
+    inline __m256 log(__m256 x)
+    {
+        const __m256 one = _mm256_set1_ps(1.0f);
+        // Split into exponent and a mantissa in [0.5, 1)
+        __m256i bits = _mm256_castps_si256(x);
+        __m256 e = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(126)));
+        __m256 m = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007fffff)),
+                                                       _mm256_set1_epi32(0x3f000000)));
+        // Shift the mantissa into [sqrt(0.5), sqrt(2))
+        __m256 small = _mm256_cmp_ps(m, _mm256_set1_ps(0.707106781186547524f), _CMP_LT_OQ);
+        e = _mm256_sub_ps(e, _mm256_and_ps(one, small));
+        m = _mm256_sub_ps(_mm256_add_ps(m, _mm256_and_ps(m, small)), one);
+
+        __m256 z = _mm256_mul_ps(m, m);
+        __m256 y = _mm256_set1_ps(7.0376836292E-2f);
+        y = _mm256_fmadd_ps(y, m, _mm256_set1_ps(-1.1514610310E-1f));
+        y = _mm256_fmadd_ps(y, m, _mm256_set1_ps(1.1676998740E-1f));
+        y = _mm256_fmadd_ps(y, m, _mm256_set1_ps(-1.2420140846E-1f));
+        y = _mm256_fmadd_ps(y, m, _mm256_set1_ps(1.4249322787E-1f));
+        y = _mm256_fmadd_ps(y, m, _mm256_set1_ps(-1.6668057665E-1f));
+        y = _mm256_fmadd_ps(y, m, _mm256_set1_ps(2.0000714765E-1f));
+        y = _mm256_fmadd_ps(y, m, _mm256_set1_ps(-2.4999993993E-1f));
+        y = _mm256_fmadd_ps(y, m, _mm256_set1_ps(3.3333331174E-1f));
+        y = _mm256_mul_ps(_mm256_mul_ps(y, m), z);
+        y = _mm256_fmadd_ps(e, _mm256_set1_ps(-2.12194440e-4f), y);
+        y = _mm256_fnmadd_ps(z, _mm256_set1_ps(0.5f), y);
+        return _mm256_fmadd_ps(e, _mm256_set1_ps(0.693359375f), _mm256_add_ps(m, y));
+    }
+
+    // Natural exponent, using the cephes single precision polynomial
+    inline __m256 exp(__m256 x)
+    {
+        x = _mm256_min_ps(x, _mm256_set1_ps(88.3762626647949f));
+        x = _mm256_max_ps(x, _mm256_set1_ps(-88.3762626647949f));
+
+        // exp(x) = 2^n * exp(r) where r is in [-ln(2)/2, ln(2)/2]
+        __m256 n = _mm256_floor_ps(_mm256_fmadd_ps(x, _mm256_set1_ps(1.44269504088896341f), _mm256_set1_ps(0.5f)));
+        x = _mm256_fnmadd_ps(n, _mm256_set1_ps(0.693359375f), x);
+        x = _mm256_fnmadd_ps(n, _mm256_set1_ps(-2.12194440e-4f), x);
+
+        __m256 z = _mm256_mul_ps(x, x);
+        __m256 y = _mm256_set1_ps(1.9875691500E-4f);
+        y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(1.3981999507E-3f));
+        y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(8.3334519073E-3f));
+        y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(4.1665795894E-2f));
+        y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(1.6666665459E-1f));
+        y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(5.0000001201E-1f));
+        y = _mm256_fmadd_ps(y, z, _mm256_add_ps(x, _mm256_set1_ps(1.0f)));
+
+        __m256i exponent = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23);
+        return _mm256_mul_ps(y, _mm256_castsi256_ps(exponent));
+    }
+
+    /*
+    Equivalent of std::pow. Lanes with a positive or zero base are vectorised, negative
+    bases fall back on std::pow as the result depends on whether the exponent is integral.
+    */
+    inline __m256 pow(__m256 x, __m256 y)
+    {
+        const __m256 zero = _mm256_setzero_ps();
+        __m256 result = exp(_mm256_mul_ps(y, log(x)));
+
+        // 0^y is 1 for y == 0, 0 for y > 0 and inf for y < 0
+        __m256 isZero = _mm256_cmp_ps(x, zero, _CMP_EQ_OQ);
+        __m256 zeroResult = _mm256_blendv_ps(_mm256_set1_ps(INFINITY), zero, _mm256_cmp_ps(y, zero, _CMP_GT_OQ));
+        zeroResult = _mm256_blendv_ps(zeroResult, _mm256_set1_ps(1.0f), _mm256_cmp_ps(y, zero, _CMP_EQ_OQ));
+        result = _mm256_blendv_ps(result, zeroResult, isZero);
+
+        __m256 isNegative = _mm256_cmp_ps(x, zero, _CMP_LT_OQ);
+        if (_mm256_movemask_ps(isNegative))
+        {
+            alignas(32) float xs[8], ys[8], rs[8];
+            _mm256_store_ps(xs, x);
+            _mm256_store_ps(ys, y);
+            _mm256_store_ps(rs, result);
+            for (int i = 0; i < 8; ++i)
+            {
+                if (xs[i] < 0.0f)
+                {
+                    rs[i] = std::pow(xs[i], ys[i]);
+                }
+            }
+            result = _mm256_load_ps(rs);
+        }
+        return result;
+    }
+
+    /*
+    Calls func(pixels) for each pair of pixels in the input, storing the returned value
+    in the output. An odd final pixel is processed in the first half of a register.
+    */
+    template <typename Func>
+    inline void transformPixels(const float *in, float *out, size_t numPixels, Func func)
+    {
+        size_t i = 0;
+        for (; i + 2 <= numPixels; i += 2)
+        {
+            storePixels(out + i * 4, func(loadPixels(in + i * 4)));
+        }
+        if (i < numPixels)
+        {
+            storePixel(out + i * 4, func(loadPixel(in + i * 4)));
+        }
+    }
+    // As transformPixels for operators taking three images, eg, two inputs and a mask
+    template <typename Func>
+    inline void transformPixels(const float *a, const float *b, const float *c, float *out, size_t numPixels, Func func)
+    {
+        size_t i = 0;
+        for (; i + 2 <= numPixels; i += 2)
+        {
+            storePixels(out + i * 4, func(loadPixels(a + i * 4), loadPixels(b + i * 4), loadPixels(c + i * 4)));
+        }
+        if (i < numPixels)
+        {
+            storePixel(out + i * 4, func(loadPixel(a + i * 4), loadPixel(b + i * 4), loadPixel(c + i * 4)));
+        }
+    }
+
+    // Sets every pixel to the same value
+    inline void fillPixels(float *out, size_t numPixels, const glm::vec4 &color)
+    {
+        __m256 value = broadcastPixel(color);
+        size_t i = 0;
+        for (; i + 2 <= numPixels; i += 2)
+        {
+            storePixels(out + i * 4, value);
+        }
+        if (i < numPixels)
+        {
+            storePixel(out + i * 4, value);
+        }
+    }
+}
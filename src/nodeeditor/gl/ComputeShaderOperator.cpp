@@ -1,81 +1,121 @@
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "../constants.h"
 #include "../log.h"
 #include "ComputeShaderOperator.h"
+#include "TexturePool.h"
 
 namespace Op
 {
-    ComputeShaderOperator::ComputeShaderOperator(const char *computeShader) : RenderSetOperator(), m_shader(computeShader) {}
+    /* Records the value, returning false if it was already uploaded to the uniform */
+    template <typename T>
+    static bool hasChanged(UniformBinding &binding, const T &value)
+    {
+        if (binding.isUploaded && std::get<T>(binding.value) == value)
+        {
+            return false;
+        }
+        binding.value = value;
+        binding.isUploaded = true;
+        return true;
+    }
+    static void setUniform(UniformBinding &binding, bool value)
+    {
+        if (binding.location != -1 && hasChanged(binding, value))
+        {
+            glUniform1i(binding.location, int(value));
+        }
+    }
+    static void setUniform(UniformBinding &binding, glm::ivec2 value)
+    {
+        if (binding.location != -1 && hasChanged(binding, value))
+        {
+            glUniform2i(binding.location, value.x, value.y);
+        }
+    }
+
+    /* Marks every uniform of the plan as not uploaded, eg, once another operator has set them */
+    static void forgetUploads(BindingPlan &plan)
+    {
+        for (UniformBinding &binding : plan.uniforms)
+        {
+            binding.generation = 0;
+        }
+        for (UniformBinding &binding : plan.ignoreImages)
+        {
+            binding.isUploaded = false;
+        }
+        plan.imageOrigin.isUploaded = false;
+    }
+
+    ComputeShaderOperator::ComputeShaderOperator(const char *computeShader) : RenderSetOperator(), m_shaderPath(computeShader), m_shader(computeShader) {}
+    ComputeShaderOperator::~ComputeShaderOperator()
+    {
+        releaseConverted();
+    }
     std::vector<OutputLayer> ComputeShaderOperator::outputLayers(const std::vector<RenderSetOperator const *> &inputs, [[maybe_unused]] Settings const *settings, Settings const *sceneSettings)
     {
         return {{DEFAULT_LAYER, outputLayerSize(0, inputs, sceneSettings)}};
     }
+    bool ComputeShaderOperator::process(const std::vector<Operator const *> &inputs, Settings const *settings, Settings const *sceneSettings)
+    {
+        // Once started asynchronously the outputs are already queued
+        if (m_dispatched)
+        {
+            return true;
+        }
+        return RenderSetOperator::process(inputs, settings, sceneSettings);
+    }
     bool ComputeShaderOperator::process(const std::vector<RenderSetOperator const *> &inputs, Settings const *settings, Settings const *sceneSettings)
     {
-        m_shader.use();
-
-        // Add all settings to the shader. Assumes identical names.
-        size_t binding = 0;
-        for (auto it = settings->cbegin(); it != settings->cend(); ++it)
+        // Each image is bound in its own format, any the shader can't read as RGBA is converted
+        const auto &definedInputs = this->inputs();
+        std::vector<Texture const *> inputTextures(inputs.size(), nullptr);
+        std::map<size_t, std::string> imageFormats;
+        for (size_t i = 0; i < inputs.size(); ++i)
         {
-            switch (it->type())
+            Texture const *texture = inputs[i] ? inputs[i]->layer(DEFAULT_LAYER) : nullptr;
+            if (!texture)
             {
-            case SettingType_Bool:
-                m_shader.setBool(it->name(), it->value<bool>());
-                LOG_DEBUG("Setting %s to %s", it->name().c_str(), it->value<bool>() ? "true" : "false");
-                break;
-            case SettingType_Float:
-                m_shader.setFloat(it->name(), it->value<float>());
-                LOG_DEBUG("Setting %s to %.3f", it->name().c_str(), it->value<float>());
-                break;
-            case SettingType_Float2:
-                m_shader.setVec2(it->name(), it->value<glm::vec2>());
-                LOG_DEBUG("Setting %s to (%.3f, %.3f)", it->name().c_str(), it->value<glm::vec2>().x, it->value<glm::vec2>().y);
-                break;
-            case SettingType_Float3:
-                m_shader.setVec3(it->name(), it->value<glm::vec3>());
-                LOG_DEBUG("Setting %s to (%.3f, %.3f, %.3f)", it->name().c_str(), it->value<glm::vec3>().x, it->value<glm::vec3>().y, it->value<glm::vec3>().z);
-                break;
-            case SettingType_Float4:
-                m_shader.setVec4(it->name(), it->value<glm::vec4>());
-                LOG_DEBUG("Setting %s to (%.3f, %.3f, %.3f, %.3f)", it->name().c_str(), it->value<glm::vec4>().x, it->value<glm::vec4>().y, it->value<glm::vec4>().z, it->value<glm::vec4>().w);
-                break;
-            case SettingType_Float2Array:
-                bindSSBO(binding++, *it);
-                break;
-            case SettingType_Int:
-                m_shader.setInt(it->name(), it->value<int>());
-                LOG_DEBUG("Setting %s to %d", it->name().c_str(), it->value<int>());
-                break;
-            case SettingType_Int2:
-                m_shader.setIVec2(it->name(), it->value<glm::ivec2>());
-                LOG_DEBUG("Setting %s to (%d, %d)", it->name().c_str(), it->value<glm::ivec2>().x, it->value<glm::ivec2>().y);
-                break;
-            case SettingType_UInt:
-                m_shader.setUInt(it->name(), it->value<unsigned int>());
-                LOG_DEBUG("Setting %s to %u", it->name().c_str(), it->value<unsigned int>());
-                break;
-            case SettingType_String:
-                // glsl has no string type
-                LOG_WARNING("Ignoring string setting %s", it->name().c_str());
-                break;
+                continue;
+            }
+            inputTextures[i] = convertInput(texture, false);
+            if (inputTextures[i]->internalFormat() != GL_RGBA32F)
+            {
+                imageFormats[i] = inputTextures[i]->imageFormat();
+            }
+        }
+        const auto &definedOutputs = outputLayers(inputs, settings, sceneSettings);
+        for (size_t j = 0; j < definedOutputs.size(); ++j)
+        {
+            if (definedOutputs[j].internalFormat != GL_RGBA32F)
+            {
+                imageFormats[inputs.size() + j] = Texture::imageFormat(definedOutputs[j].internalFormat);
             }
         }
+        Shader &shader = variant(imageFormats);
+        shader.use();
+
+        BindingPlan &plan = bindingPlan(shader, settings);
+        bindSettings(plan, settings);
 
         // Ensure each input is bound sequentially to the shader
-        const auto &definedInputs = this->inputs();
         size_t i = 0;
         for (; i < inputs.size(); ++i)
         {
             // Optional inputs might be a nullptr
             if (inputs[i])
             {
-                const Texture *texture = inputs[i]->layer(DEFAULT_LAYER);
-                if (texture)
+                if (inputTextures[i])
                 {
-                    bindImage(i, texture, GL_READ_ONLY);
+                    bindImage(i, inputTextures[i], GL_READ_ONLY);
                     // Internal naming convention for disabling optional inputs in the shader
-                    if (!definedInputs[i].required)
+                    if (!definedInputs[i].required && i < plan.ignoreImages.size())
                     {
-                        m_shader.setBool("_ignoreImage" + std::to_string(i), false);
+                        setUniform(plan.ignoreImages[i], false);
                     }
                 }
                 else
@@ -83,19 +123,21 @@ namespace Op
                     LOG_DEBUG("Input is connected but does not provide the default layer: %s", definedInputs[i].name.c_str());
                 }
             }
-            else
+            else if (i < plan.ignoreImages.size())
             {
                 // Internal naming convention for disabling optional inputs
-                m_shader.setBool("_ignoreImage" + std::to_string(i), true);
+                setUniform(plan.ignoreImages[i], true);
             }
         }
 
+        // Internal naming convention for content generated from the pixel position
+        setUniform(plan.imageOrigin, imageOrigin(sceneSettings));
+
         // Ensure there are textures generated and bound for each defined output
         glm::ivec2 imageSize(0);
-        const auto &definedOutputs = outputLayers(inputs, settings, sceneSettings);
         for (size_t j = 0; j < definedOutputs.size(); ++j)
         {
-            Texture *outTex = ensureOutputLayer(definedOutputs[j].layer, definedOutputs[j].imageSize);
+            Texture *outTex = ensureOutputLayer(definedOutputs[j].layer, definedOutputs[j].imageSize, definedOutputs[j].internalFormat);
             bindImage(i + j, outTex, GL_WRITE_ONLY);
             imageSize = glm::max(imageSize, definedOutputs[j].imageSize);
         }
@@ -106,11 +148,208 @@ namespace Op
         return true;
     }
 
+    bool ComputeShaderOperator::canStartAsync(const std::vector<Operator const *> &inputs) const
+    {
+        for (Operator const *input : inputs)
+        {
+            RenderSetOperator const *op = dynamic_cast<RenderSetOperator const *>(input);
+            if (input && (!op || !op->isQueued()))
+            {
+                return false;
+            }
+        }
+        return !m_dispatched;
+    }
+    bool ComputeShaderOperator::startAsync(const std::vector<Operator const *> &inputs, Settings const *settings, Settings const *sceneSettings,
+                                           [[maybe_unused]] WorkStealingPool *pool, std::function<void()> done)
+    {
+        if (!RenderSetOperator::process(inputs, settings, sceneSettings))
+        {
+            if (!hasError())
+            {
+                setError("Failed to dispatch");
+            }
+            return false;
+        }
+        m_dispatched = true;
+        m_done = done;
+        return true;
+    }
+    bool ComputeShaderOperator::pollAsync(uint64_t timeout)
+    {
+        if (!m_done)
+        {
+            return false;
+        }
+        if (waitFence(timeout))
+        {
+            std::function<void()> done;
+            done.swap(m_done);
+            done();
+        }
+        return true;
+    }
+    void ComputeShaderOperator::reset()
+    {
+        RenderSetOperator::reset();
+        releaseConverted();
+        m_dispatched = false;
+        m_done = nullptr;
+    }
+
     void ComputeShaderOperator::render(glm::ivec2 imageSize)
     {
         glDispatchCompute(ceil(imageSize.x / 8.0f), ceil(imageSize.y / 4.0f), 1);
-        glMemoryBarrier(GL_ALL_BARRIER_BITS);
-        glFinish();
+        // Outputs are only read by later dispatches or copied off the GPU on this context.
+        // Other contexts, eg, the viewer, must wait on the fence.
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+        insertFence();
+    }
+    Shader &ComputeShaderOperator::variant(const std::map<size_t, std::string> &imageFormats)
+    {
+        if (imageFormats.empty())
+        {
+            return m_shader;
+        }
+        auto it = m_variants.find(imageFormats);
+        if (it == m_variants.end())
+        {
+            LOG_DEBUG("Compiling variant of %s for %lu image formats", m_shaderPath.c_str(), imageFormats.size());
+            it = m_variants.emplace(imageFormats, Shader(m_shaderPath.c_str(), imageFormats)).first;
+        }
+        return it->second;
+    }
+    Texture const *ComputeShaderOperator::convertInput(Texture const *texture, bool rgba32f)
+    {
+        if (texture->internalFormat() == GL_RGBA32F || (!rgba32f && texture->numChannels() == 4))
+        {
+            return texture;
+        }
+
+        // Conversions are only compiled once for each format and shared by every operator
+        static std::map<GLint, Shader> conversions;
+        auto it = conversions.find(texture->internalFormat());
+        if (it == conversions.end())
+        {
+            it = conversions.emplace(texture->internalFormat(), Shader("src/nodeeditor/shaders/convert.glsl", {{0, texture->imageFormat()}})).first;
+        }
+        LOG_DEBUG("Converting %s input to rgba32f", texture->imageFormat());
+
+        Texture *converted = TexturePool::instance().acquire(texture->imageSize());
+        m_converted.push_back(converted);
+        it->second.use();
+        it->second.setBool("greyscale", texture->numChannels() == 1);
+        bindImage(0, texture, GL_READ_ONLY);
+        bindImage(1, converted, GL_WRITE_ONLY);
+        glDispatchCompute(ceil(texture->width() / 8.0f), ceil(texture->height() / 4.0f), 1);
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+        return converted;
+    }
+    void ComputeShaderOperator::releaseConverted()
+    {
+        for (Texture *texture : m_converted)
+        {
+            TexturePool::instance().release(texture);
+        }
+        m_converted.clear();
+    }
+    BindingPlan &ComputeShaderOperator::bindingPlan(const Shader &shader, Settings const *settings)
+    {
+        size_t numSettings = settings->size();
+        bool isOwner = !shader.setUniformOwner(this);
+        auto it = m_plans.find(shader.ID);
+        if (it != m_plans.end() && it->second.numSettings == numSettings)
+        {
+            if (!isOwner)
+            {
+                forgetUploads(it->second);
+            }
+            return it->second;
+        }
+
+        BindingPlan plan;
+        plan.numSettings = numSettings;
+        for (auto setting = settings->cbegin(); setting != settings->cend(); ++setting)
+        {
+            size_t index = setting - settings->cbegin();
+            // Selects the implementation, see Node::prepare()
+            if (setting->name() == NODE_SETTING_BACKEND)
+            {
+                continue;
+            }
+            if (setting->type() == SettingType_Float2Array)
+            {
+                plan.buffers.push_back(index);
+            }
+            else if (setting->type() == SettingType_String)
+            {
+                // glsl has no string type
+                LOG_WARNING("Ignoring string setting %s", setting->name().c_str());
+            }
+            else if (GLint location = shader.location(setting->name()); location != -1)
+            {
+                plan.uniforms.push_back({index, location});
+            }
+            else
+            {
+                // Settings may be read by the operator instead, eg, imageSize
+                LOG_DEBUG("No uniform for setting %s", setting->name().c_str());
+            }
+        }
+        for (size_t i = 0; i < inputs().size(); ++i)
+        {
+            plan.ignoreImages.push_back({i, shader.location("_ignoreImage" + std::to_string(i))});
+        }
+        plan.imageOrigin.location = shader.location("_imageOrigin");
+        LOG_DEBUG("Bound %lu uniforms and %lu buffers of %s", plan.uniforms.size(), plan.buffers.size(), m_shaderPath.c_str());
+        return m_plans[shader.ID] = std::move(plan);
+    }
+    void ComputeShaderOperator::bindSettings(BindingPlan &plan, Settings const *settings)
+    {
+        for (UniformBinding &binding : plan.uniforms)
+        {
+            const Setting &setting = *settings->at(binding.index);
+            if (setting.generation() == binding.generation)
+            {
+                continue;
+            }
+            binding.generation = setting.generation();
+            switch (setting.type())
+            {
+            case SettingType_Bool:
+                glUniform1i(binding.location, int(setting.value<bool>()));
+                break;
+            case SettingType_Float:
+                glUniform1f(binding.location, setting.value<float>());
+                break;
+            case SettingType_Float2:
+                glUniform2fv(binding.location, 1, &setting.value<glm::vec2>()[0]);
+                break;
+            case SettingType_Float3:
+                glUniform3fv(binding.location, 1, &setting.value<glm::vec3>()[0]);
+                break;
+            case SettingType_Float4:
+                glUniform4fv(binding.location, 1, &setting.value<glm::vec4>()[0]);
+                break;
+            case SettingType_Int:
+                glUniform1i(binding.location, setting.value<int>());
+                break;
+            case SettingType_Int2:
+                glUniform2iv(binding.location, 1, &setting.value<glm::ivec2>()[0]);
+                break;
+            case SettingType_UInt:
+                glUniform1ui(binding.location, setting.value<unsigned int>());
+                break;
+            case SettingType_Float2Array:
+            case SettingType_String:
+                break;
+            }
+        }
+        // Binding points are shared with every other program so are always rebound
+        for (size_t binding = 0; binding < plan.buffers.size(); ++binding)
+        {
+            bindSSBO(binding, *settings->at(plan.buffers[binding]));
+        }
     }
     void ComputeShaderOperator::bindSSBO(size_t index, const Setting &setting)
     {
@@ -1,4 +1,7 @@
 #pragma once
+#include <functional>
+#include <map>
+#include <string>
 #include <vector>
 
 #include <glm/glm.hpp>
@@ -15,19 +18,46 @@ namespace Op
     {
         const std::string layer;
         const glm::ivec2 imageSize;
+        // One of the formats supported by Texture::imageFormat()
+        const GLint internalFormat = GL_RGBA32F;
+    };
+
+    /* A uniform and the value last uploaded to it */
+    struct UniformBinding
+    {
+        // Index of the setting, or of the input for _ignoreImageN
+        size_t index;
+        GLint location;
+        // Generation of the setting last uploaded, see Setting::generation()
+        uint64_t generation = 0;
+        // Value last uploaded to uniforms that aren't settings
+        SettingValue value;
+        bool isUploaded = false;
+    };
+    /* Uniforms of one shader bound to an operator's settings and inputs, see ComputeShaderOperator::bindingPlan() */
+    struct BindingPlan
+    {
+        size_t numSettings = 0;
+        std::vector<UniformBinding> uniforms;
+        // Settings bound to SSBOs, in binding order
+        std::vector<size_t> buffers;
+        std::vector<UniformBinding> ignoreImages;
+        UniformBinding imageOrigin{0, -1};
     };
 
     /*
     Automatically binds all settings and images to a compute shader following an explicit convention.
 
     - local_size_x = 8, local_size_y = 4, local_size_z = 1.
-    - All inputs/outputs are rgab32f image2D uniforms.
+    - All inputs/outputs are rgba32f image2D uniforms, see Image formats below.
     - All registerSettings will be set as either
         - uniforms using the same name and type.
         - SSBO bindings for dynamic array types (eg, Float2Array) using the std430 layout.
     - The default layer of each input's renderset is bound in sequential order starting from layout binding 0.
     - The outputs() method defines outputs and their expected size. These are bound sequentially from the next available binding after inputs.
     - Optional inputs should define an additional uniform _ignoreImageN where N is the input index. This will be set to true if the input image exists, or false if not.
+    - Shaders generating content from the pixel position may define a uniform ivec2 _imageOrigin. This is set to the position of the
+      dispatched region within the full image, see SCENE_SETTING_IMAGE_ORIGIN, and should be added to gl_GlobalInvocationID.
 
     For example, a ComputeShaderOperator defined as:
 
@@ -63,19 +93,77 @@ namespace Op
 
     Note that for SSBOs the block/instance name are not fixed, only the binding which is
     incremented from 0 for each setting in order.
+
+    Image formats:
+    Each OutputLayer declares the internal format of its texture, eg, GL_R32F for a single
+    channel heightmap. Shaders are still written for rgba32f, when any image is bound in
+    another format a variant of the shader is compiled with the layout qualifier replaced,
+    eg, layout(r32f, binding=1). Four channel inputs are bound in their own format. Inputs
+    with fewer channels are first converted to rgba32f, single channel images becoming
+    greyscale, so the shader reads the same values it would if the upstream operator had
+    written RGBA, and operators with a custom process() should use convertInput().
+
+    Uniforms are bound through a plan built the first time each shader variant is dispatched,
+    mapping settings to the uniform locations resolved when it was linked. A uniform keeps its
+    value in the program between dispatches, so only settings that changed are uploaded.
+    Operators of the same type share one program (see ShaderCache), so once another operator
+    has set its uniforms every setting is uploaded again.
+
+    Dispatches are not waited on. The operator is started asynchronously once each input's
+    commands have been queued, dispatching immediately, and finishes once a fence placed
+    after the dispatch signals. Later dispatches reading the outputs are ordered by a
+    memory barrier instead, so a chain of operators is queued back to back on the GPU.
     */
     class ComputeShaderOperator : public RenderSetOperator
     {
     public:
         ComputeShaderOperator(const char *computeShader);
+        virtual ~ComputeShaderOperator();
         virtual std::vector<OutputLayer> outputLayers(const std::vector<RenderSetOperator const *> &inputs, Settings const *settings, Settings const *sceneSettings);
+        /* Completes an operator started asynchronously, otherwise dispatches as RenderSetOperator::process() */
+        virtual bool process(const std::vector<Operator const *> &inputs, Settings const *settings, Settings const *sceneSettings) override;
         virtual bool process(const std::vector<RenderSetOperator const *> &inputs, Settings const *settings, Settings const *sceneSettings);
 
+        /* Whether every connected input is a RenderSetOperator that has queued its outputs */
+        virtual bool canStartAsync(const std::vector<Operator const *> &inputs) const override;
+        /* Dispatches the shader, done is called by pollAsync() once the dispatch has finished */
+        virtual bool startAsync(const std::vector<Operator const *> &inputs, Settings const *settings, Settings const *sceneSettings,
+                                WorkStealingPool *pool, std::function<void()> done) override;
+        virtual bool pollAsync(uint64_t timeout) override;
+        virtual void reset() override;
+
     protected:
+        std::string m_shaderPath;
         Shader m_shader;
+        // Variants of the shader keyed by the image formats that differ from rgba32f
+        std::map<std::map<size_t, std::string>, Shader> m_variants;
+        // Binding plans keyed by program
+        std::map<GLuint, BindingPlan> m_plans;
         std::vector<SSBO> m_ssbos;
+        // Inputs converted by convertInput(), returned to the TexturePool by reset()
+        std::vector<Texture *> m_converted;
+        // Set once dispatched by startAsync()
+        bool m_dispatched = false;
+        std::function<void()> m_done;
 
+        /* Dispatches the bound shader over the image and fences it without waiting */
         void render(glm::ivec2 imageSize);
         void bindSSBO(size_t index, const Setting &setting);
+        /*
+        The binding plan for the shader, built the first time it's used with the settings. Its
+        uploads are forgotten if another operator has used the shader's program since.
+        */
+        BindingPlan &bindingPlan(const Shader &shader, Settings const *settings);
+        /* Uploads the settings that changed since the shader was last bound, the shader must be in use */
+        void bindSettings(BindingPlan &plan, Settings const *settings);
+        /* The shader compiled for the image formats keyed by binding, or m_shader if there are none */
+        Shader &variant(const std::map<size_t, std::string> &imageFormats);
+        /*
+        Returns the texture if it can be bound to an rgba32f image uniform using its own format
+        qualifier, otherwise an rgba32f copy. If rgba32f is true, any other format is copied,
+        eg, for shaders that don't use variant(). Leaves another program bound.
+        */
+        Texture const *convertInput(Texture const *texture, bool rgba32f);
+        void releaseConverted();
     };
 }
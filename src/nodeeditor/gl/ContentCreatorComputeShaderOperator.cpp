@@ -3,14 +3,19 @@
 
 namespace Op
 {
-    ContentCreatorComputeShaderOperator::ContentCreatorComputeShaderOperator(const char *computeShader) : ComputeShaderOperator(computeShader) {}
+    ContentCreatorComputeShaderOperator::ContentCreatorComputeShaderOperator(const char *computeShader, GLint internalFormat) : ComputeShaderOperator(computeShader), m_internalFormat(internalFormat) {}
     std::vector<OutputLayer> ContentCreatorComputeShaderOperator::outputLayers(const std::vector<RenderSetOperator const *> &inputs, [[maybe_unused]] Settings const *settings, Settings const *sceneSettings)
     {
         glm::ivec2 imageSize = settings->getInt2("imageSize");
-        return {{DEFAULT_LAYER, (imageSize.x == 0 || imageSize.y == 0) ? outputLayerSize(0, inputs, sceneSettings) : imageSize}};
+        return {{DEFAULT_LAYER, (imageSize.x == 0 || imageSize.y == 0) ? outputLayerSize(0, inputs, sceneSettings) : imageSize, m_internalFormat}};
     }
     void ContentCreatorComputeShaderOperator::registerSettings(Settings *const settings) const
     {
-        settings->registerInt2("imageSize", glm::ivec2(0));
+        settings->registerInt2("imageSize", glm::ivec2(0), SettingHint_Pixels);
+    }
+    Footprint ContentCreatorComputeShaderOperator::footprint(Settings const *settings) const
+    {
+        glm::ivec2 imageSize = settings->getInt2("imageSize");
+        return {imageSize.x == 0 || imageSize.y == 0, 0};
     }
 }
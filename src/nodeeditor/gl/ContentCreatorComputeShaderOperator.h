@@ -9,13 +9,21 @@
 namespace Op
 {
     /*
-    Extends the ComputeShaderOperator to add an image size setting and default outputLayer implementation
+    Extends the ComputeShaderOperator to add an image size setting and default outputLayer implementation.
+    The output is created in the given internal format, eg, GL_R32F for single channel content.
+
+    The footprint is bounded unless the image size is set, so shaders are expected to
+    generate content from the pixel position offset by _imageOrigin.
     */
     class ContentCreatorComputeShaderOperator : public ComputeShaderOperator
     {
     public:
-        ContentCreatorComputeShaderOperator(const char *computeShader);
+        ContentCreatorComputeShaderOperator(const char *computeShader, GLint internalFormat = GL_RGBA32F);
         virtual std::vector<OutputLayer> outputLayers(const std::vector<RenderSetOperator const *> &inputs, Settings const *settings, Settings const *sceneSettings);
         virtual void registerSettings(Settings *const settings) const;
+        virtual Footprint footprint(Settings const *settings) const override;
+
+    protected:
+        GLint m_internalFormat;
     };
 }
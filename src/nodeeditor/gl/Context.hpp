@@ -6,7 +6,7 @@
 
 /*
 An OpenGL context, window visibility is optional.
-A display is still required, in future this may use an EGL device for headless rendering.
+A display is still required, see HeadlessContext for rendering without one.
 */
 class Context
 {
@@ -45,6 +45,8 @@ public:
     }
     bool isInitialised() const { return bool(m_window) && m_glew_init; }
     void use() { glfwMakeContextCurrent(m_window); }
+    /* Detaches the context from the calling thread so another thread can use it */
+    void release() { glfwMakeContextCurrent(NULL); }
 
 protected:
     GLFWwindow *m_window;
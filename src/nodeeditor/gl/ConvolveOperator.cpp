@@ -37,6 +37,7 @@ namespace Op
             setError("Missing default layer for input texture");
             return false;
         }
+        inputTexture = convertInput(inputTexture, true);
         m_shader.use();
 
         if (!populateKernel(&m_kernel, inputs, settings, sceneSettings))
@@ -54,9 +55,7 @@ namespace Op
         bindImage(0, inputTexture, GL_READ_ONLY);
         bindImage(1, outputTexture, GL_WRITE_ONLY);
 
-        glDispatchCompute(ceil(inputTexture->width() / 8.0f), ceil(inputTexture->height() / 4.0f), 1);
-        glMemoryBarrier(GL_ALL_BARRIER_BITS);
-        glFinish();
+        render(inputTexture->imageSize());
 
         return true;
     }
@@ -0,0 +1,186 @@
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GL/glew.h>
+
+#include "../log.h"
+#include "HeadlessContext.h"
+
+bool hasExtension(const char *extensions, const std::string &name)
+{
+    if (!extensions)
+    {
+        return false;
+    }
+    std::string padded = " " + std::string(extensions) + " ";
+    return padded.find(" " + name + " ") != std::string::npos;
+}
+
+// Hardware displays are exposed as devices when EGL_EXT_platform_device is supported
+std::vector<EGLDisplay> deviceDisplays(const char *clientExtensions)
+{
+    std::vector<EGLDisplay> displays;
+    if (!hasExtension(clientExtensions, "EGL_EXT_device_enumeration") ||
+        !hasExtension(clientExtensions, "EGL_EXT_platform_device"))
+    {
+        return displays;
+    }
+
+    auto queryDevices = (PFNEGLQUERYDEVICESEXTPROC)eglGetProcAddress("eglQueryDevicesEXT");
+    auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    EGLint numDevices = 0;
+    if (!queryDevices || !getPlatformDisplay || !queryDevices(0, nullptr, &numDevices) || numDevices == 0)
+    {
+        return displays;
+    }
+
+    std::vector<EGLDeviceEXT> devices(numDevices);
+    queryDevices(numDevices, devices.data(), &numDevices);
+    for (EGLDeviceEXT device : devices)
+    {
+        EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_DEVICE_EXT, device, nullptr);
+        if (display != EGL_NO_DISPLAY)
+        {
+            displays.push_back(display);
+        }
+    }
+    return displays;
+}
+
+EGLDisplay surfacelessDisplay(const char *clientExtensions)
+{
+    if (!hasExtension(clientExtensions, "EGL_MESA_platform_surfaceless"))
+    {
+        return EGL_NO_DISPLAY;
+    }
+    auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (!getPlatformDisplay)
+    {
+        return EGL_NO_DISPLAY;
+    }
+    return getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+}
+
+HeadlessContext::HeadlessContext(bool forceSoftware)
+{
+    if (forceSoftware)
+    {
+        // Must be set before the driver is loaded by the first display
+        setenv("LIBGL_ALWAYS_SOFTWARE", "1", 1);
+    }
+
+    const char *clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    if (!forceSoftware)
+    {
+        for (EGLDisplay display : deviceDisplays(clientExtensions))
+        {
+            if (createContext(display))
+            {
+                break;
+            }
+        }
+    }
+    if (m_context == EGL_NO_CONTEXT && !createContext(surfacelessDisplay(clientExtensions)) && !forceSoftware)
+    {
+        LOG_WARNING("No hardware EGL context available, falling back on software rendering");
+        setenv("LIBGL_ALWAYS_SOFTWARE", "1", 1);
+        createContext(surfacelessDisplay(clientExtensions));
+    }
+    if (m_context == EGL_NO_CONTEXT)
+    {
+        LOG_ERROR("Failed to create a headless EGL context");
+        return;
+    }
+
+    // glewInit() also loads the window system extensions which requires a display,
+    // only the GL functions are needed here.
+    glewExperimental = GL_TRUE;
+    GLenum err = glewContextInit();
+    if (err != GLEW_OK)
+    {
+        LOG_ERROR("Failed to initialise glew: %s", glewGetErrorString(err));
+        return;
+    }
+    m_glew_init = true;
+
+    const GLubyte *renderer = glGetString(GL_RENDERER);
+    m_renderer = renderer ? (const char *)renderer : "";
+    LOG_INFO("Created headless context using %s", m_renderer.c_str());
+}
+HeadlessContext::~HeadlessContext()
+{
+    destroyContext();
+}
+
+bool HeadlessContext::isInitialised() const { return m_context != EGL_NO_CONTEXT && m_glew_init; }
+void HeadlessContext::use() { eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, m_context); }
+const std::string &HeadlessContext::renderer() const { return m_renderer; }
+
+bool HeadlessContext::createContext(EGLDisplay display)
+{
+    if (display == EGL_NO_DISPLAY)
+    {
+        return false;
+    }
+
+    EGLint major, minor;
+    if (!eglInitialize(display, &major, &minor))
+    {
+        return false;
+    }
+    m_display = display;
+
+    const char *extensions = eglQueryString(display, EGL_EXTENSIONS);
+    if (!hasExtension(extensions, "EGL_KHR_surfaceless_context") || !eglBindAPI(EGL_OPENGL_API))
+    {
+        destroyContext();
+        return false;
+    }
+
+    // Compute shaders require 4.3
+    const EGLint configAttribs[] = {
+        EGL_SURFACE_TYPE, 0,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_NONE};
+    EGLConfig config = nullptr;
+    EGLint numConfigs = 0;
+    if (!hasExtension(extensions, "EGL_KHR_no_config_context") &&
+        (!eglChooseConfig(display, configAttribs, &config, 1, &numConfigs) || numConfigs == 0))
+    {
+        destroyContext();
+        return false;
+    }
+
+    const EGLint contextAttribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 4,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE};
+    m_context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttribs);
+    if (m_context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, m_context))
+    {
+        destroyContext();
+        return false;
+    }
+    LOG_DEBUG("Initialised EGL %d.%d display", major, minor);
+    return true;
+}
+
+void HeadlessContext::destroyContext()
+{
+    if (m_display == EGL_NO_DISPLAY)
+    {
+        return;
+    }
+    eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (m_context != EGL_NO_CONTEXT)
+    {
+        eglDestroyContext(m_display, m_context);
+        m_context = EGL_NO_CONTEXT;
+    }
+    eglTerminate(m_display);
+    m_display = EGL_NO_DISPLAY;
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <string>
+
+#include <EGL/egl.h>
+#include <GL/glew.h>
+
+/*
+An OpenGL context that does not require a display or window, for batch rendering.
+
+Uses EGL with no surface. GPU devices are tried first, falling back on Mesa's
+surfaceless platform which renders on llvmpipe if no hardware driver is available.
+Software rendering can be forced, eg, for deterministic output in CI.
+*/
+class HeadlessContext
+{
+public:
+    HeadlessContext(bool forceSoftware = false);
+    ~HeadlessContext();
+
+    bool isInitialised() const;
+    void use();
+    /* The GL_RENDERER string of the created context */
+    const std::string &renderer() const;
+
+protected:
+    EGLDisplay m_display = EGL_NO_DISPLAY;
+    EGLContext m_context = EGL_NO_CONTEXT;
+    bool m_glew_init = false;
+    std::string m_renderer;
+
+    bool createContext(EGLDisplay display);
+    void destroyContext();
+};
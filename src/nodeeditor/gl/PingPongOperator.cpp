@@ -6,6 +6,7 @@
 #include "../log.h"
 #include "../nodegraph/Settings.h"
 #include "PingPongOperator.h"
+#include "TexturePool.h"
 
 namespace Op
 {
@@ -14,23 +15,30 @@ namespace Op
     {
         return {{}};
     }
-    bool PingPongOperator::process(const std::vector<RenderSetOperator const *> &inputs, [[maybe_unused]] Settings const *settings, [[maybe_unused]] Settings const *sceneSettings)
+    bool PingPongOperator::process(const std::vector<RenderSetOperator const *> &inputs, Settings const *settings, [[maybe_unused]] Settings const *sceneSettings)
     {
         LOG_DEBUG("Ping pong iteration: %d", m_iteration)
-        m_shader.use();
-        m_shader.setInt("_iteration", m_iteration);
-        // TODO: ComputeShaderOperator should implement setting auto-load as func that ping pong calls here
-
-        glm::ivec2 imageSize;
+        // The ping pong layers are rgba32f so the first input must match
+        Texture const *texture = nullptr;
         if (m_iteration == 0)
         {
-            Texture const *texture = inputs[0]->layer(DEFAULT_LAYER);
+            texture = inputs[0]->layer(DEFAULT_LAYER);
             if (!texture)
             {
                 setError("Missing default layer for input texture");
                 return false;
             }
+            texture = convertInput(texture, true);
+        }
 
+        m_shader.use();
+        m_shader.setInt("_iteration", m_iteration);
+        // Settings are only uploaded on the first iteration unless they change
+        bindSettings(bindingPlan(m_shader, settings), settings);
+
+        glm::ivec2 imageSize;
+        if (m_iteration == 0)
+        {
             imageSize = texture->imageSize();
             Texture *pingTex = ensureOutputLayer(pingLayer, imageSize);
             ensureOutputLayer(pongLayer, imageSize);
@@ -54,14 +62,16 @@ namespace Op
             imageSize = pingTex->imageSize();
         }
 
-        glDispatchCompute(ceil(imageSize.x / 8.0f), ceil(imageSize.y / 4.0f), 1);
-        glMemoryBarrier(GL_ALL_BARRIER_BITS);
-        glFinish();
+        render(imageSize);
 
         ++m_iteration;
         // Protective measure to prevent subclasses that forget to implement from running indefinitely.
         return true;
     }
+    bool PingPongOperator::canStartAsync([[maybe_unused]] const std::vector<Operator const *> &inputs) const
+    {
+        return false;
+    }
     void PingPongOperator::reset()
     {
         ComputeShaderOperator::reset();
@@ -91,15 +101,25 @@ namespace Op
         {
             return false;
         }
-        Texture *texture = m_outputs.at(currentOutputLayer());
-        // XXX: Make sure this is a copy, not move...
-        // Texture outputTexture{*texture};
-        m_renderSet.emplace(layer, texture);
+        // The texture is moved to the new layer so it isn't released with the ping pong layers
+        auto it = m_outputs.find(currentOutputLayer());
+        Texture *texture = it->second;
+        m_outputs.erase(it);
+        TexturePool::instance().release(m_outputs[layer]);
+        m_outputs[layer] = texture;
+        m_renderSet[layer] = texture;
         return true;
     }
     void PingPongOperator::deletePingPongLayers()
     {
-        m_outputs.erase(pingLayer);
-        m_outputs.erase(pongLayer);
+        for (const std::string &layer : {pingLayer, pongLayer})
+        {
+            auto it = m_outputs.find(layer);
+            if (it != m_outputs.end())
+            {
+                TexturePool::instance().release(it->second);
+                m_outputs.erase(it);
+            }
+        }
     }
 }
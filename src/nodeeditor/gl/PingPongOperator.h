@@ -22,6 +22,11 @@ namespace Op
     complete. The base implementation always returns true to protect against
     infinite processing if the derived class does not override process.
 
+    Settings are bound to uniforms as for ComputeShaderOperator.
+
+    Iterations are stepped on the thread owning the GL context so the operator is never
+    started asynchronously, though no iteration waits on the previous one to finish.
+
     The following shader should be used as a base for this class
 
         #version 430 core
@@ -40,13 +45,14 @@ namespace Op
         PingPongOperator(const char *computeShader);
         virtual std::vector<Input> inputs() const override;
         virtual bool process(const std::vector<RenderSetOperator const *> &inputs, Settings const *settings, Settings const *sceneSettings) override;
+        virtual bool canStartAsync(const std::vector<Operator const *> &inputs) const override;
         virtual void reset() override;
         int iteration() const;
         glm::ivec2 imageSize(const std::vector<RenderSetOperator const *> &inputs) const;
         const std::string &currentOutputLayer() const;
-        // Copies the current iteration's output to an output texture for the given layer
+        // Moves the current iteration's output texture to the given layer
         bool copyToLayer(const std::string &layer);
-        // Deletes the ping pong layers from the output
+        // Returns the ping pong layers to the TexturePool
         void deletePingPongLayers();
 
     protected:
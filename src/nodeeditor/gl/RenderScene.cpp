@@ -1,5 +1,17 @@
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <utility>
+
+#include <glm/glm.hpp>
+
 #include "../constants.h"
+#include "RenderSetOperator.h"
+#include "Texture.h"
 #include "util.h"
+#include "ViewLayers.h"
 #include "RenderScene.h"
 
 RenderScene::RenderScene() : m_context("Scene")
@@ -12,7 +24,7 @@ void RenderScene::setDefaultImageSize(glm::ivec2 imageSize)
 {
     // TODO: Needs a way to check if any operators are affected by this...
     //       RenderSetOperator can calculate m_inputRenderSets and recalculateImageSize still
-    m_settings.get(SCENE_SETTING_IMAGE_SIZE)->set(imageSize);
+    updateSceneSetting(SCENE_SETTING_IMAGE_SIZE, imageSize);
     // bool changed = false;
     // for (auto it = getCurrentGraph()->begin(); it != getCurrentGraph()->end(); ++it)
     // {
@@ -33,4 +45,67 @@ void RenderScene::process()
     m_context.use();
     makeQuad(&m_quadVAO);
     Scene::process();
-}
\ No newline at end of file
+}
+Texture const *RenderScene::previewLayer(const std::string &layer, glm::ivec2 &origin, glm::ivec2 &extent, glm::ivec2 &imageSize)
+{
+    std::lock_guard<std::mutex> guard(m_previewMutex);
+    auto it = m_preview.find(layer);
+    if (it == m_preview.end())
+    {
+        return nullptr;
+    }
+    origin = m_previewOrigin;
+    extent = m_previewExtent;
+    imageSize = m_previewImageSize;
+    return &it->second;
+}
+
+void RenderScene::capturePreview(Node *viewNode, glm::ivec2 offset, glm::ivec2 size, glm::ivec2 origin, glm::ivec2 extent)
+{
+    Op::RenderSetOperator const *op = dynamic_cast<Op::RenderSetOperator const *>(viewNode->op());
+    if (!op)
+    {
+        return;
+    }
+
+    // Only the visible part of a region is copied, the margin is affected by the region's edges
+    std::map<std::string, Texture> preview;
+    for (const auto &[name, texture] : *op->renderSet())
+    {
+        if (texture->width() < unsigned(offset.x + size.x) || texture->height() < unsigned(offset.y + size.y))
+        {
+            continue;
+        }
+        Texture &copy = preview.emplace(std::piecewise_construct, std::forward_as_tuple(name), std::forward_as_tuple(size.x, size.y, texture->internalFormat())).first->second;
+        glCopyImageSubData(texture->id(), GL_TEXTURE_2D, 0, offset.x, offset.y, 0,
+                           copy.id(), GL_TEXTURE_2D, 0, 0, 0, 0, size.x, size.y, 1);
+    }
+    // The viewer samples the copies from its own context
+    glFinish();
+
+    std::lock_guard<std::mutex> guard(m_previewMutex);
+    m_preview.swap(preview);
+    m_previewOrigin = origin;
+    m_previewExtent = extent;
+    m_previewImageSize = m_appliedSettings.getInt2(SCENE_SETTING_IMAGE_SIZE);
+}
+
+void RenderScene::clearPreview()
+{
+    std::map<std::string, Texture> preview;
+    std::lock_guard<std::mutex> guard(m_previewMutex);
+    m_preview.swap(preview);
+}
+
+std::shared_ptr<ViewLayers const> RenderScene::viewLayers() const { return std::atomic_load(&m_viewLayers); }
+
+void RenderScene::publishView(Node *viewNode)
+{
+    Op::RenderSetOperator const *op = viewNode ? dynamic_cast<Op::RenderSetOperator const *>(viewNode->op()) : nullptr;
+    std::shared_ptr<ViewLayers const> layers;
+    if (op)
+    {
+        layers = std::make_shared<ViewLayers const>(viewNode->id(), *op->renderSet());
+    }
+    std::atomic_store(&m_viewLayers, layers);
+}
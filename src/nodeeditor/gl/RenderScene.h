@@ -1,5 +1,14 @@
 #pragma once
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <glm/glm.hpp>
+
 #include "../gl/Context.hpp"
+#include "../gl/Texture.h"
+#include "../gl/ViewLayers.h"
 #include "../nodegraph/Scene.h"
 
 class RenderScene : public Scene
@@ -10,10 +19,33 @@ public:
     const Context *context() const;
     glm::ivec2 defaultImageSize() const;
     void setDefaultImageSize(glm::ivec2 imageSize);
+    /*
+    A copy of the view node's layer from a preview, held while the full image is processed.
+    Returns nullptr if there is no preview, otherwise sets the pixels the texture covers
+    within an image of imageSize, ie, extent is larger than the texture for a proxy.
+    */
+    Texture const *previewLayer(const std::string &layer, glm::ivec2 &origin, glm::ivec2 &extent, glm::ivec2 &imageSize);
+    /*
+    The view node's full size layers, as last processed. May be read from any thread, the
+    textures aren't reused or written to while the returned layers are held. Returns
+    nullptr if the view node hasn't been processed.
+    */
+    std::shared_ptr<ViewLayers const> viewLayers() const;
 
 protected:
     Context m_context;
     GLuint m_quadVAO;
 
+    std::mutex m_previewMutex;
+    std::map<std::string, Texture> m_preview;
+    glm::ivec2 m_previewOrigin{0};
+    glm::ivec2 m_previewExtent{0};
+    glm::ivec2 m_previewImageSize{0};
+    // Replaced atomically by the processing thread
+    std::shared_ptr<ViewLayers const> m_viewLayers;
+
     virtual void process();
+    virtual void capturePreview(Node *viewNode, glm::ivec2 offset, glm::ivec2 size, glm::ivec2 origin, glm::ivec2 extent) override;
+    virtual void clearPreview() override;
+    virtual void publishView(Node *viewNode) override;
 };
@@ -1,16 +1,82 @@
+#include <memory>
+#include <vector>
+
 #include "../log.h"
 #include "../nodegraph/Operator.h"
+#include "../nodegraph/ResultCache.h"
 #include "RenderSetOperator.h"
+#include "TexturePool.h"
 
 namespace Op
 {
-    RenderSetOperator::~RenderSetOperator()
+    // Reads the textures back and writes them to the store as layers
+    static bool storeTextures(ResultStore *store, size_t key, const RenderSet &textures)
     {
-        // Outputs are owned by the operator and must be cleaned up when destroyed
-        for (auto &[key, value] : m_outputs)
+        std::vector<std::unique_ptr<float[]>> pixels;
+        std::vector<CachedLayer> layers;
+        for (const auto &[name, texture] : textures)
+        {
+            pixels.emplace_back(texture->read());
+            size_t byteSize = size_t(texture->width()) * texture->height() * texture->numChannels() * sizeof(float);
+            layers.push_back({name, int(texture->width()), int(texture->height()), int(texture->internalFormat()), pixels.back().get(), byteSize});
+        }
+        return store->insert(key, layers);
+    }
+
+    // Channels of a texture with the internal format, or 0 if it isn't supported
+    static size_t numChannels(int internalFormat)
+    {
+        switch (internalFormat)
+        {
+        case GL_RGBA32F:
+        case GL_RGBA16F:
+        case GL_RGBA8:
+            return 4;
+        case GL_RG16F:
+            return 2;
+        case GL_R32F:
+        case GL_R16F:
+            return 1;
+        default:
+            return 0;
+        }
+    }
+
+    CachedRenderSet::CachedRenderSet(RenderSet &&textures) : m_textures(std::move(textures)) {}
+    CachedRenderSet::~CachedRenderSet()
+    {
+        for (auto &[key, value] : m_textures)
+        {
+            TexturePool::instance().release(value);
+        }
+    }
+
+    size_t CachedRenderSet::byteSize() const
+    {
+        size_t size = 0;
+        for (const auto &[key, value] : m_textures)
         {
-            delete value;
+            size += value->byteSize();
         }
+        return size;
+    }
+
+    bool CachedRenderSet::store(ResultStore *store, size_t key) const
+    {
+        return storeTextures(store, key, m_textures);
+    }
+
+    RenderSet CachedRenderSet::release()
+    {
+        RenderSet textures;
+        textures.swap(m_textures);
+        return textures;
+    }
+
+    RenderSetOperator::~RenderSetOperator()
+    {
+        deleteFence();
+        releaseOutputs();
     }
 
     RenderSet_c const *RenderSetOperator::renderSet() const { return &m_renderSet; }
@@ -25,11 +91,118 @@ namespace Op
         return it->second;
     }
 
+    bool RenderSetOperator::isQueued() const { return m_queued; }
+    bool RenderSetOperator::isPending() const { return m_fence != nullptr; }
+
     void RenderSetOperator::reset()
     {
         Operator::reset();
         m_renderSet.clear();
+        m_inputRenderSet.clear();
         m_renderSetConfigured = false;
+        m_queued = false;
+        deleteFence();
+        releaseOutputs();
+    }
+
+    std::unique_ptr<CachedResult> RenderSetOperator::releaseResult()
+    {
+        if (!isRestorable())
+        {
+            return nullptr;
+        }
+
+        m_renderSet.clear();
+        m_inputRenderSet.clear();
+        m_queued = false;
+        RenderSet textures;
+        textures.swap(m_outputs);
+        return std::make_unique<CachedRenderSet>(std::move(textures));
+    }
+
+    bool RenderSetOperator::restoreResult(std::unique_ptr<CachedResult> result, const std::vector<Operator const *> &inputs)
+    {
+        CachedRenderSet *cached = dynamic_cast<CachedRenderSet *>(result.get());
+        LayeredResult *mapped = dynamic_cast<LayeredResult *>(result.get());
+        if ((!cached && !mapped) || !assembleRenderSet(inputs, m_inputRenderSet))
+        {
+            return false;
+        }
+        if (mapped)
+        {
+            for (const CachedLayer &layer : mapped->layers())
+            {
+                size_t channels = numChannels(layer.format);
+                if (channels == 0 || layer.byteSize != size_t(layer.width) * layer.height * channels * sizeof(float))
+                {
+                    LOG_WARNING("Cached layer %s of %s has an unexpected format", layer.name.c_str(), type().c_str());
+                    return false;
+                }
+            }
+        }
+
+        // Any textures left from a previous incomplete process are replaced
+        releaseOutputs();
+        if (cached)
+        {
+            m_outputs = cached->release();
+        }
+        else
+        {
+            for (const CachedLayer &layer : mapped->layers())
+            {
+                Texture *texture = TexturePool::instance().acquire({layer.width, layer.height}, layer.format);
+                texture->upload(static_cast<const float *>(layer.data));
+                m_outputs.emplace(layer.name, texture);
+            }
+        }
+        m_renderSet = m_inputRenderSet;
+        for (const auto &[key, value] : m_outputs)
+        {
+            m_renderSet[key] = value;
+        }
+        m_queued = true;
+        return true;
+    }
+
+    bool RenderSetOperator::storeResult(ResultStore *store, size_t key) const
+    {
+        if (!isRestorable())
+        {
+            return false;
+        }
+        return storeTextures(store, key, m_outputs);
+    }
+
+    bool RenderSetOperator::isRestorable() const
+    {
+        if (m_outputs.empty())
+        {
+            return false;
+        }
+
+        // Operators that pass through or rename layers can't be rebuilt from their outputs
+        RenderSet_c expected = m_inputRenderSet;
+        for (const auto &[key, value] : m_outputs)
+        {
+            expected[key] = value;
+        }
+        return expected == m_renderSet;
+    }
+
+    bool RenderSetOperator::assembleRenderSet(const std::vector<Operator const *> &inputs, RenderSet_c &renderSet) const
+    {
+        renderSet.clear();
+        if (inputs.size() > 0)
+        {
+            RenderSetOperator const *op = dynamic_cast<RenderSetOperator const *>(inputs[0]);
+            if (!op)
+            {
+                return false;
+            }
+            renderSet = *op->renderSet();
+        }
+        return true;
     }
 
     glm::ivec2 RenderSetOperator::outputLayerSize([[maybe_unused]] int outputIndex, const std::vector<RenderSetOperator const *> &inputs, Settings const *sceneSettings)
@@ -42,21 +215,31 @@ namespace Op
         return sceneSettings->getInt2(SCENE_SETTING_IMAGE_SIZE);
     }
 
-    Texture *RenderSetOperator::ensureOutputLayer(const std::string &layer, const glm::ivec2 &imageSize)
+    glm::ivec2 RenderSetOperator::imageOrigin(Settings const *sceneSettings)
+    {
+        const Setting *origin = sceneSettings ? sceneSettings->get(SCENE_SETTING_IMAGE_ORIGIN) : nullptr;
+        return origin ? origin->value<glm::ivec2>() : glm::ivec2(0);
+    }
+
+    Texture *RenderSetOperator::ensureOutputLayer(const std::string &layer, const glm::ivec2 &imageSize, GLint internalFormat)
     {
         Texture *tex;
         auto it = m_outputs.find(layer);
         if (it == m_outputs.end())
         {
-            m_outputs.emplace(layer, new Texture(imageSize.x, imageSize.y));
-            tex = m_outputs[layer];
-            LOG_DEBUG("Created output ID %u for layer %s with size (%u, %u)", m_outputs[layer]->id(), layer.c_str(), imageSize.x, imageSize.y);
+            tex = TexturePool::instance().acquire(imageSize, internalFormat);
+            m_outputs.emplace(layer, tex);
+            LOG_DEBUG("Acquired output ID %u for layer %s with size (%u, %u)", tex->id(), layer.c_str(), imageSize.x, imageSize.y);
         }
-        else if (it->second->width() != (unsigned int)imageSize.x || it->second->height() != (unsigned int)imageSize.y)
+        else if (it->second->width() != (unsigned int)imageSize.x || it->second->height() != (unsigned int)imageSize.y ||
+                 it->second->internalFormat() != internalFormat || TexturePool::instance().isHeld(it->second))
         {
-            it->second->resize(imageSize.x, imageSize.y);
-            tex = it->second;
-            LOG_DEBUG("Resized output ID %u for layer %s to (%u, %u)", tex->id(), layer.c_str(), imageSize.x, imageSize.y);
+            // Storage is immutable so a texture of the new size or format is swapped in, as is
+            // one the viewer may be reading
+            TexturePool::instance().release(it->second);
+            tex = TexturePool::instance().acquire(imageSize, internalFormat);
+            it->second = tex;
+            LOG_DEBUG("Replaced output for layer %s with ID %u of size (%u, %u)", layer.c_str(), tex->id(), imageSize.x, imageSize.y);
         }
         else
         {
@@ -67,25 +250,47 @@ namespace Op
         return tex;
     }
 
+    size_t RenderSetOperator::outputByteSize() const
+    {
+        size_t size = 0;
+        for (const auto &[key, value] : m_outputs)
+        {
+            size += value->byteSize();
+        }
+        return size;
+    }
+
+    bool RenderSetOperator::sharesOutputsWith(Operator const *other) const
+    {
+        RenderSetOperator const *op = dynamic_cast<RenderSetOperator const *>(other);
+        if (!op)
+        {
+            return false;
+        }
+        for (const auto &[key, value] : op->m_renderSet)
+        {
+            for (const auto &[outKey, outValue] : m_outputs)
+            {
+                if (value == outValue)
+                {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
     bool RenderSetOperator::process(const std::vector<Operator const *> &inputs, Settings const *settings, Settings const *sceneSettings)
     {
         if (!m_renderSetConfigured)
         {
-            m_renderSet.clear();
             // Copy the first input's (if any) renderset into this operator's renderset
-            if (inputs.size() > 0)
+            if (!assembleRenderSet(inputs, m_inputRenderSet))
             {
-                RenderSetOperator const *op = dynamic_cast<RenderSetOperator const *>(inputs[0]);
-                if (!op)
-                {
-                    setError("Input is not an instance of RenderSetOperator");
-                    return false;
-                }
-                for (const auto &[key, value] : *op->renderSet())
-                {
-                    m_renderSet[key] = value;
-                }
+                setError("Input is not an instance of RenderSetOperator");
+                return false;
             }
+            m_renderSet = m_inputRenderSet;
         }
 
         const auto &definedInputs = this->inputs();
@@ -115,7 +320,8 @@ namespace Op
             }
         }
 
-        return process(renderSets, settings, sceneSettings);
+        m_queued = process(renderSets, settings, sceneSettings);
+        return m_queued;
     }
 
     void RenderSetOperator::bindImage(size_t index, Texture const *texture, GLenum access)
@@ -125,4 +331,46 @@ namespace Op
         glBindTexture(GL_TEXTURE_2D, texture->id());
         glBindImageTexture(index, texture->id(), 0, GL_FALSE, 0, access, texture->internalFormat());
     }
+
+    void RenderSetOperator::releaseOutputs()
+    {
+        for (auto &[key, value] : m_outputs)
+        {
+            TexturePool::instance().release(value);
+        }
+        m_outputs.clear();
+    }
+
+    void RenderSetOperator::insertFence()
+    {
+        deleteFence();
+        m_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+    bool RenderSetOperator::waitFence(GLuint64 timeout)
+    {
+        if (!m_fence)
+        {
+            return true;
+        }
+        // Flushing ensures the fence is eventually signalled if nothing else flushes the context
+        GLenum result = glClientWaitSync(m_fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+        if (result == GL_TIMEOUT_EXPIRED)
+        {
+            return false;
+        }
+        if (result == GL_WAIT_FAILED)
+        {
+            LOG_ERROR("Failed to wait on fence");
+        }
+        deleteFence();
+        return true;
+    }
+    void RenderSetOperator::deleteFence()
+    {
+        if (m_fence)
+        {
+            glDeleteSync(m_fence);
+            m_fence = nullptr;
+        }
+    }
 }
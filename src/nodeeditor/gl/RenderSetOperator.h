@@ -1,12 +1,35 @@
 #pragma once
+#include <memory>
+#include <vector>
 
 #include <glm/glm.hpp>
 
 #include "Texture.h"
 #include "../nodegraph/Operator.h"
+#include "../nodegraph/ResultCache.h"
 
 namespace Op
 {
+    /*
+    The Textures owned by a processed RenderSetOperator, keyed by layer name.
+    Textures are returned to the TexturePool with the result unless restored to an Operator.
+    */
+    class CachedRenderSet : public CachedResult
+    {
+    public:
+        CachedRenderSet(RenderSet &&textures);
+        ~CachedRenderSet();
+
+        size_t byteSize() const override;
+        /* Reads the textures back and writes them to the store, eg, the disk cache */
+        bool store(ResultStore *store, size_t key) const override;
+        /* Transfers ownership of the textures to the caller */
+        RenderSet release();
+
+    protected:
+        RenderSet m_textures;
+    };
+
     /*
     Base class for processing OpenGL textures.
 
@@ -26,19 +49,45 @@ namespace Op
         RenderSet_c const *renderSet() const;
         /* Retrieves the Texture pointer from the output RenderSet, or nullptr if layer does not exist. */
         Texture const *layer(const std::string &layer) const;
+        /*
+        Whether the RenderSet is complete and every GL command writing to it has been issued,
+        ie, it can be used by later commands on the same context. The commands may not have
+        finished executing, see isPending().
+        */
+        bool isQueued() const;
+        /* Whether the last GL commands issued by the operator are not yet known to have finished */
+        bool isPending() const;
 
+        /* Clears the RenderSet and returns the outputs to the TexturePool */
         virtual void reset();
+        /*
+        Releases the owned output textures if the RenderSet consists of only the first input's
+        layers and this Operator's outputs, ie, can be reassembled by restoreResult(). Operators
+        that hold any other state affecting their output should override to return nullptr.
+        */
+        virtual std::unique_ptr<CachedResult> releaseResult() override;
+        /*
+        Takes ownership of the cached textures, or uploads the layers of a LayeredResult into
+        new outputs, and rebuilds the RenderSet over the first input's
+        */
+        virtual bool restoreResult(std::unique_ptr<CachedResult> result, const std::vector<Operator const *> &inputs) override;
+        /* Reads the output textures back and writes them to the store, if they can be restored */
+        virtual bool storeResult(ResultStore *store, size_t key) const override;
         /* Attempts to retrieve the image size of the default layer from the first input, falling back on sceneSettings image size. */
         glm::ivec2 outputLayerSize(int outputIndex, const std::vector<RenderSetOperator const *> &inputs, Settings const *sceneSettings);
+        /* Position of the evaluated region within the full image, (0, 0) unless rendering tiles */
+        static glm::ivec2 imageOrigin(Settings const *sceneSettings);
         /*
-        Creates a texture owned by this object for the requested layer or resizes it if it already exists.
+        Acquires a texture owned by this object for the requested layer from the TexturePool, or
+        replaces it if it already exists with a different size or format.
         Updates this operator's RenderSet to ensure the layer is added/overridden.
-        Method is idempotent.
-
-        If implementing custom layer names, eg, via settings, then reset() should be implemented to
-        ensure old layers are deleted to avoid memory leaks.
+        Method is idempotent. Outputs are returned to the pool by reset().
         */
-        Texture *ensureOutputLayer(const std::string &layer, const glm::ivec2 &imageSize);
+        Texture *ensureOutputLayer(const std::string &layer, const glm::ivec2 &imageSize, GLint internalFormat = GL_RGBA32F);
+        /* Memory held by the output textures */
+        virtual size_t outputByteSize() const override;
+        /* Whether any output texture is in the other operator's RenderSet */
+        virtual bool sharesOutputsWith(Operator const *other) const override;
         /*
         Constructs a vector of the input RenderSets and calls the overloaded process method.
         Derived classes should only implement the overloaded process method.
@@ -53,9 +102,26 @@ namespace Op
 
     protected:
         bool m_renderSetConfigured = false;
+        bool m_queued = false;
+        // Signalled once the last GL commands issued by the operator have finished
+        GLsync m_fence = nullptr;
         RenderSet m_outputs;
         RenderSet_c m_renderSet;
+        // The first input's RenderSet when last processed
+        RenderSet_c m_inputRenderSet;
+
+        /* Whether the RenderSet is only the first input's layers and the outputs, ie, can be restored from the outputs */
+        bool isRestorable() const;
+        /* Sets the RenderSet to the first input's layers overridden by the output layers */
+        bool assembleRenderSet(const std::vector<Operator const *> &inputs, RenderSet_c &renderSet) const;
 
         void bindImage(size_t index, Texture const *texture, GLenum access);
+        /* Returns every output texture to the TexturePool */
+        void releaseOutputs();
+        /* Replaces the fence with one following every GL command issued so far */
+        void insertFence();
+        /* Waits up to timeout nanoseconds for the fence. Returns true if there is none left pending. */
+        bool waitFence(GLuint64 timeout);
+        void deleteFence();
     };
 }
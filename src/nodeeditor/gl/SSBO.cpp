@@ -19,8 +19,12 @@ bool SSBO::load(const Setting &setting, int binding, GLenum usage)
     glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, m_id);
     if (setting.type() == SettingType_Float2Array)
     {
-        std::vector<glm::vec2> value = setting.value<std::vector<glm::vec2>>();
-        glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(float) * value.size() * 2, value.data(), usage);
+        if (setting.generation() != m_generation)
+        {
+            const std::vector<glm::vec2> &value = setting.value<std::vector<glm::vec2>>();
+            glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(float) * value.size() * 2, value.data(), usage);
+            m_generation = setting.generation();
+        }
         return true;
     }
     // TODO: Other array types. Note, float3 may need to bind as vec4...
@@ -8,8 +8,11 @@ class SSBO
 public:
     SSBO();
     ~SSBO();
+    /* Binds the buffer, only uploading the setting's value if it changed since the last load */
     bool load(const Setting &setting, int binding, GLenum usage = GL_STATIC_DRAW);
 
 protected:
     GLuint m_id;
+    // Generation of the setting last uploaded, see Setting::generation()
+    uint64_t m_generation = 0;
 };
\ No newline at end of file
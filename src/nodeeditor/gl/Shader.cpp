@@ -1,4 +1,6 @@
 #include <fstream>
+#include <map>
+#include <regex>
 #include <sstream>
 #include <string>
 
@@ -6,6 +8,7 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include "Shader.h"
+#include "ShaderCache.h"
 #include "../log.h"
 
 std::string loadFile(const char *filename)
@@ -52,6 +55,8 @@ GLuint compileShader(const char *source, GLenum shaderType)
 GLuint compileProgram(size_t numShaders, GLuint *shaders)
 {
     GLuint programID = glCreateProgram();
+    // Allows the program to be kept as a binary, see ShaderCache
+    glProgramParameteri(programID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
     for (size_t i = 0; i < numShaders; ++i)
     {
         glAttachShader(programID, shaders[i]);
@@ -71,40 +76,76 @@ GLuint compileProgram(size_t numShaders, GLuint *shaders)
     return programID;
 }
 
-Shader::Shader(const char *computeShader)
+std::string setImageFormats(const std::string &source, const std::map<size_t, std::string> &imageFormats)
 {
-    std::string source = loadFile(computeShader);
-    GLuint shader = compileShader(source.c_str(), GL_COMPUTE_SHADER);
+    static const std::regex imageLayout("layout\\s*\\(\\s*\\w+\\s*,\\s*binding\\s*=\\s*(\\d+)\\s*\\)(\\s*uniform\\s+image2D)");
+    std::string result;
+    auto last = source.cbegin();
+    for (std::sregex_iterator it(source.cbegin(), source.cend(), imageLayout), end; it != end; ++it)
+    {
+        const std::smatch &match = *it;
+        result.append(last, match[0].first);
+        auto format = imageFormats.find(std::stoul(match[1].str()));
+        if (format == imageFormats.end())
+        {
+            result.append(match[0].first, match[0].second);
+        }
+        else
+        {
+            result += "layout(" + format->second + ", binding=" + match[1].str() + ")" + match[2].str();
+        }
+        last = match[0].second;
+    }
+    result.append(last, source.cend());
+    return result;
+}
 
-    ID = compileProgram(1, &shader);
+Shader::Shader(const char *computeShader)
+{
+    ShaderCache &cache = ShaderCache::instance();
+    m_program = cache.program({{GL_COMPUTE_SHADER, cache.source(computeShader)}});
+    ID = m_program->id;
+}
 
-    glDeleteShader(shader);
+Shader::Shader(const char *computeShader, const std::map<size_t, std::string> &imageFormats)
+{
+    ShaderCache &cache = ShaderCache::instance();
+    m_program = cache.program({{GL_COMPUTE_SHADER, setImageFormats(cache.source(computeShader), imageFormats)}});
+    ID = m_program->id;
 }
 
 Shader::Shader(const char *vertexPath, const char *fragmentPath)
 {
-    std::string vertexSource = loadFile(vertexPath);
-    std::string fragmentSource = loadFile(fragmentPath);
+    ShaderCache &cache = ShaderCache::instance();
+    m_program = cache.program({{GL_VERTEX_SHADER, cache.source(vertexPath)}, {GL_FRAGMENT_SHADER, cache.source(fragmentPath)}});
+    ID = m_program->id;
+}
 
-    GLuint vertexShader = compileShader(vertexSource.c_str(), GL_VERTEX_SHADER);
-    GLuint fragmentShader = compileShader(fragmentSource.c_str(), GL_FRAGMENT_SHADER);
+void Shader::use()
+{
+    glUseProgram(ID);
+}
 
-    GLuint shaders[2] = {vertexShader, fragmentShader};
-    ID = compileProgram(2, shaders);
+bool Shader::hasUniform(const std::string &name) const
+{
+    return location(name) != -1;
+}
 
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
+GLint Shader::location(const std::string &name) const
+{
+    auto it = m_program->locations.find(name);
+    return it == m_program->locations.end() ? -1 : it->second;
 }
 
-void Shader::use()
+bool Shader::setUniformOwner(const void *owner) const
 {
-    glUseProgram(ID);
+    return m_program->uniformOwner.exchange(owner) != owner;
 }
 
 // Utility uniform functions
-GLuint Shader::getLocation(const std::string &name) const
+GLint Shader::getLocation(const std::string &name) const
 {
-    int location = glGetUniformLocation(ID, name.c_str());
+    GLint location = this->location(name);
     if (location == -1)
     {
         LOG_WARNING("Shader uniform not found: %s", name.c_str());
@@ -114,79 +155,79 @@ GLuint Shader::getLocation(const std::string &name) const
 
 void Shader::setBool(const std::string &name, bool value) const
 {
-    GLuint location = getLocation(name);
+    GLint location = getLocation(name);
     glUniform1i(location, (int)value);
 }
 
 void Shader::setUInt(const std::string &name, unsigned int value) const
 {
-    GLuint location = getLocation(name);
+    GLint location = getLocation(name);
     glUniform1ui(location, value);
 }
 
 void Shader::setInt(const std::string &name, int value) const
 {
-    GLuint location = getLocation(name);
+    GLint location = getLocation(name);
     glUniform1i(location, value);
 }
 
 void Shader::setInt2(const std::string &name, int x, int y) const
 {
-    GLuint location = getLocation(name);
+    GLint location = getLocation(name);
     glUniform2i(location, x, y);
 }
 
 void Shader::setFloat(const std::string &name, float value) const
 {
-    GLuint location = getLocation(name);
+    GLint location = getLocation(name);
     glUniform1f(location, value);
 }
 
 void Shader::setFloat2(const std::string &name, float x, float y) const
 {
-    GLuint location = getLocation(name);
+    GLint location = getLocation(name);
     glUniform2f(location, x, y);
 }
 
 void Shader::setFloat3(const std::string &name, float x, float y, float z) const
 {
-    GLuint location = getLocation(name);
+    GLint location = getLocation(name);
     glUniform3f(location, x, y, z);
 }
 
 void Shader::setFloat4(const std::string &name, float x, float y, float z, float w) const
 {
-    GLuint location = getLocation(name);
+    GLint location = getLocation(name);
     glUniform4f(location, x, y, z, w);
 }
 
 void Shader::setVec2(const std::string &name, glm::vec2 vec) const
 {
-    GLuint location = getLocation(name);
+    GLint location = getLocation(name);
     glUniform2f(location, vec.x, vec.y);
 }
 
 void Shader::setVec3(const std::string &name, glm::vec3 vec) const
 {
-    GLuint location = getLocation(name);
+    GLint location = getLocation(name);
     glUniform3f(location, vec.x, vec.y, vec.z);
 }
 
 void Shader::setVec4(const std::string &name, glm::vec4 vec) const
 {
-    GLuint location = getLocation(name);
+    GLint location = getLocation(name);
     glUniform4f(location, vec.x, vec.y, vec.z, vec.w);
 }
 
 void Shader::setIVec2(const std::string &name, glm::ivec2 vec) const
 {
-    GLuint location = getLocation(name);
+    GLint location = getLocation(name);
     glUniform2i(location, vec.x, vec.y);
 }
 
 void Shader::setMat4(const std::string &name, glm::mat4 &matrix) const
 {
-    GLuint location = getLocation(name);
+    GLint location = getLocation(name);
     // Location, Number of Matrices, Transpose?, matrices
     glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(matrix));
 }
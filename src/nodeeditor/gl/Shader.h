@@ -1,4 +1,6 @@
 #pragma once
+#include <map>
+#include <memory>
 #include <string>
 
 #include <glm/glm.hpp>
@@ -7,16 +9,38 @@
 std::string loadFile(const char *filename);
 GLuint compileShader(const char *source, GLenum shaderType);
 GLuint compileProgram(size_t numShaders, GLuint *shaders);
+/*
+Replaces the format layout qualifier of the image2D uniforms at each binding, eg,
+{{0, "r32f"}} turns "layout(rgba32f, binding=0) uniform image2D" into
+"layout(r32f, binding=0) uniform image2D".
+*/
+std::string setImageFormats(const std::string &source, const std::map<size_t, std::string> &imageFormats);
 
+struct ShaderProgram;
+
+/*
+A compiled program and its uniforms. Shaders built from the same sources share one
+program, see ShaderCache, so constructing a Shader only compiles it the first time.
+*/
 class Shader
 {
 public:
     GLuint ID;
 
     Shader(const char *computeShader);
+    /* Compiles a variant of the compute shader with the image formats replaced, see setImageFormats() */
+    Shader(const char *computeShader, const std::map<size_t, std::string> &imageFormats);
     Shader(const char *vertexPath, const char *fragmentPath);
 
     void use();
+    bool hasUniform(const std::string &name) const;
+    /* Location of an active uniform, resolved once the program is linked, or -1 if there is none */
+    GLint location(const std::string &name) const;
+    /*
+    Records the owner as the last to set the program's uniforms, which are shared with every
+    Shader built from the same sources. Returns true if another owner may have changed them.
+    */
+    bool setUniformOwner(const void *owner) const;
     // Utility uniform functions
     void setBool(const std::string &name, bool value) const;
     void setUInt(const std::string &name, unsigned int value) const;
@@ -33,5 +57,7 @@ public:
     void setMat4(const std::string &name, glm::mat4 &matrix) const;
 
 private:
-    GLuint getLocation(const std::string &name) const;
+    std::shared_ptr<ShaderProgram const> m_program;
+
+    GLint getLocation(const std::string &name) const;
 };
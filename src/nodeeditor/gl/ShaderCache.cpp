@@ -0,0 +1,291 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "../constants.h"
+#include "../log.h"
+#include "../nodegraph/OperatorRegistry.hpp"
+#include "../util.h"
+#include "Shader.h"
+#include "ShaderCache.h"
+
+/*
+Binary file layout, all little endian:
+    BinaryHeader
+    Program binary of BinaryHeader::length bytes
+*/
+static const char BINARY_MAGIC[4] = {'N', 'E', 'S', 'P'};
+static const uint32_t BINARY_VERSION = 1;
+static const std::string BINARY_EXTENSION = ".program";
+
+struct BinaryHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t format;
+    uint32_t length;
+};
+
+static void findUniforms(ShaderProgram &program)
+{
+    GLint numUniforms = 0;
+    GLint maxLength = 0;
+    glGetProgramiv(program.id, GL_ACTIVE_UNIFORMS, &numUniforms);
+    glGetProgramiv(program.id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    std::string name(maxLength, '\0');
+    for (GLint i = 0; i < numUniforms; ++i)
+    {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(program.id, GLuint(i), maxLength, &length, &size, &type, name.data());
+        std::string uniform = name.substr(0, length);
+        // Members of uniform blocks have no location
+        GLint location = glGetUniformLocation(program.id, uniform.c_str());
+        if (location == -1)
+        {
+            continue;
+        }
+        // Arrays are reported as "name[0]" but may be set by either name
+        if (uniform.size() > 3 && uniform.compare(uniform.size() - 3, 3, "[0]") == 0)
+        {
+            program.locations[uniform.substr(0, uniform.size() - 3)] = location;
+        }
+        program.locations[uniform] = location;
+    }
+}
+
+ShaderCache &ShaderCache::instance()
+{
+    static ShaderCache cache(DEFAULT_SHADER_CACHE_DIRECTORY);
+    return cache;
+}
+
+ShaderCache::ShaderCache(const std::string &directory) : m_directory(directory) {}
+ShaderCache::~ShaderCache()
+{
+    waitForPrewarm();
+}
+
+void ShaderCache::setDirectory(const std::string &directory)
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_directory = directory;
+}
+std::string ShaderCache::directory() const
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_directory;
+}
+
+std::string ShaderCache::source(const std::string &path)
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    auto it = m_sources.find(path);
+    if (it == m_sources.end())
+    {
+        it = m_sources.emplace(path, loadFile(path.c_str())).first;
+    }
+    return it->second;
+}
+
+std::shared_ptr<ShaderProgram const> ShaderCache::program(const std::vector<ShaderStage> &stages)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_driverHash == 0)
+    {
+        const char *renderer = reinterpret_cast<const char *>(glGetString(GL_RENDERER));
+        const char *version = reinterpret_cast<const char *>(glGetString(GL_VERSION));
+        m_driverHash = hashCombine(std::hash<std::string>{}(renderer ? renderer : ""), std::hash<std::string>{}(version ? version : ""));
+    }
+    size_t key = m_driverHash;
+    for (const ShaderStage &stage : stages)
+    {
+        key = hashCombine(key, stage.type);
+        key = hashCombine(key, std::hash<std::string>{}(stage.source));
+    }
+
+    auto it = m_programs.find(key);
+    while (it != m_programs.end() && !it->second)
+    {
+        m_linked.wait(lock);
+        it = m_programs.find(key);
+    }
+    if (it != m_programs.end())
+    {
+        return it->second;
+    }
+    // Claimed so other threads wait rather than compile it too
+    m_programs[key] = nullptr;
+    std::string directory = m_directory;
+    lock.unlock();
+
+    auto program = std::make_shared<ShaderProgram>();
+    program->id = directory.empty() ? 0 : loadBinary(key, directory);
+    bool isLoaded = program->id != 0;
+    if (!isLoaded)
+    {
+        program->id = compile(stages);
+        if (program->id && !directory.empty())
+        {
+            storeBinary(key, program->id, directory);
+        }
+    }
+    if (program->id)
+    {
+        findUniforms(*program);
+    }
+    // Other contexts may only use the program once it has finished linking
+    glFinish();
+
+    lock.lock();
+    m_programs[key] = program;
+    m_numLoaded += isLoaded;
+    m_linked.notify_all();
+    return program;
+}
+
+size_t ShaderCache::size() const
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_programs.size();
+}
+size_t ShaderCache::numLoaded() const
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_numLoaded;
+}
+
+void ShaderCache::prewarm(std::function<void()> makeCurrent, std::function<void()> release)
+{
+    waitForPrewarm();
+    m_prewarmThread = std::thread([makeCurrent, release]()
+                                  {
+                                      makeCurrent();
+                                      auto start = std::chrono::steady_clock::now();
+                                      size_t numOperators = 0;
+                                      // Each operator compiles its shaders when constructed
+                                      for (auto it = Op::OperatorRegistry::cbegin(); it != Op::OperatorRegistry::cend(); ++it)
+                                      {
+                                          delete Op::OperatorRegistry::create(*it);
+                                          ++numOperators;
+                                      }
+                                      release();
+                                      std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+                                      LOG_INFO("Prewarmed shaders of %lu operators in %.0fms", numOperators, elapsed.count()); });
+}
+
+void ShaderCache::waitForPrewarm()
+{
+    if (m_prewarmThread.joinable())
+    {
+        m_prewarmThread.join();
+    }
+}
+
+GLuint ShaderCache::loadBinary(size_t key, const std::string &directory)
+{
+    FILE *file = fopen(path(key, directory).c_str(), "rb");
+    if (!file)
+    {
+        return 0;
+    }
+    BinaryHeader header;
+    std::vector<char> binary;
+    bool ok = fread(&header, sizeof(header), 1, file) == 1 && std::memcmp(header.magic, BINARY_MAGIC, sizeof(BINARY_MAGIC)) == 0 &&
+              header.version == BINARY_VERSION;
+    if (ok)
+    {
+        binary.resize(header.length);
+        ok = fread(binary.data(), 1, binary.size(), file) == binary.size();
+    }
+    fclose(file);
+    if (!ok)
+    {
+        LOG_WARNING("Ignoring shader binary %s, unknown format", path(key, directory).c_str());
+        return 0;
+    }
+
+    GLuint id = glCreateProgram();
+    glProgramBinary(id, GLenum(header.format), binary.data(), GLsizei(binary.size()));
+    GLint success = GL_FALSE;
+    glGetProgramiv(id, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        LOG_DEBUG("Shader binary %s rejected by the driver, recompiling", path(key, directory).c_str());
+        glDeleteProgram(id);
+        return 0;
+    }
+    return id;
+}
+
+void ShaderCache::storeBinary(size_t key, GLuint id, const std::string &directory)
+{
+    GLint length = 0;
+    glGetProgramiv(id, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+    {
+        // The driver doesn't support binaries
+        return;
+    }
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(id, length, &length, &format, binary.data());
+
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    // Written to a temporary file first so a partly written binary is never read
+    std::string filepath = path(key, directory);
+    std::string tempPath = filepath + ".tmp";
+    FILE *file = fopen(tempPath.c_str(), "wb");
+    if (!file)
+    {
+        LOG_WARNING("Failed to open %s for writing", tempPath.c_str());
+        return;
+    }
+    BinaryHeader header;
+    std::memcpy(header.magic, BINARY_MAGIC, sizeof(BINARY_MAGIC));
+    header.version = BINARY_VERSION;
+    header.format = uint32_t(format);
+    header.length = uint32_t(length);
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    ok = ok && fwrite(binary.data(), 1, size_t(length), file) == size_t(length);
+    ok = fclose(file) == 0 && ok;
+    ok = ok && std::rename(tempPath.c_str(), filepath.c_str()) == 0;
+    if (!ok)
+    {
+        LOG_WARNING("Failed to write shader binary %s", filepath.c_str());
+        std::remove(tempPath.c_str());
+    }
+}
+
+GLuint ShaderCache::compile(const std::vector<ShaderStage> &stages)
+{
+    std::vector<GLuint> shaders;
+    for (const ShaderStage &stage : stages)
+    {
+        shaders.push_back(compileShader(stage.source.c_str(), stage.type));
+    }
+    GLuint id = compileProgram(shaders.size(), shaders.data());
+    for (GLuint shader : shaders)
+    {
+        glDeleteShader(shader);
+    }
+    return id;
+}
+
+std::string ShaderCache::path(size_t key, const std::string &directory)
+{
+    char name[32];
+    snprintf(name, sizeof(name), "%016lx", key);
+    return (std::filesystem::path(directory) / (name + BINARY_EXTENSION)).string();
+}
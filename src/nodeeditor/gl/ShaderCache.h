@@ -0,0 +1,91 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <GL/glew.h>
+
+/* A linked program shared by every Shader compiled from the same sources */
+struct ShaderProgram
+{
+    // 0 if the program failed to compile or link
+    GLuint id = 0;
+    // Active uniforms by name, so setting a uniform doesn't query the driver
+    std::unordered_map<std::string, GLint> locations;
+    // Whoever last set the program's uniforms, which are shared by every Shader using it
+    mutable std::atomic<const void *> uniformOwner = nullptr;
+};
+
+struct ShaderStage
+{
+    GLenum type;
+    std::string source;
+};
+
+/*
+Compiles each program once per process, keyed by a hash of its sources, so that every
+Shader built from the same sources, eg, by each node of an operator type, shares it.
+Programs are never deleted.
+
+Linked programs are written to the directory as driver specific binaries, and read back
+in later sessions in place of compiling. A binary the driver rejects, eg, after a driver
+update, is compiled and replaced.
+
+Shared by every context in the share group, so may be used from any thread with a
+current context. A program being compiled by one thread is waited on by any other that
+needs it.
+*/
+class ShaderCache
+{
+public:
+    static ShaderCache &instance();
+
+    ShaderCache(const std::string &directory);
+    ~ShaderCache();
+
+    /* Sets where program binaries are kept across sessions, empty disables them */
+    void setDirectory(const std::string &directory);
+    std::string directory() const;
+
+    /* Reads a shader file, only from disk the first time it's requested */
+    std::string source(const std::string &path);
+    /* Returns the program linked from the stages, reading or compiling it the first time it's requested */
+    std::shared_ptr<ShaderProgram const> program(const std::vector<ShaderStage> &stages);
+    /* Number of programs requested, and how many of them were read from binaries */
+    size_t size() const;
+    size_t numLoaded() const;
+
+    /*
+    Compiles the shaders of every registered operator on a background thread, so nodes
+    created later find their programs ready. The thread calls makeCurrent first, which
+    must make current a context in the share group not current on any other thread, and
+    release once done.
+    */
+    void prewarm(std::function<void()> makeCurrent, std::function<void()> release);
+    /* Waits for the prewarm thread to finish, if started */
+    void waitForPrewarm();
+
+protected:
+    mutable std::mutex m_mutex;
+    std::condition_variable m_linked;
+    std::string m_directory;
+    // Hash of the renderer and driver version binaries are only valid for, set once known
+    size_t m_driverHash = 0;
+    std::unordered_map<std::string, std::string> m_sources;
+    // nullptr while the program is being compiled
+    std::unordered_map<size_t, std::shared_ptr<ShaderProgram const>> m_programs;
+    size_t m_numLoaded = 0;
+    std::thread m_prewarmThread;
+
+    /* Reads the program's binary, returning 0 if there isn't one the driver accepts */
+    static GLuint loadBinary(size_t key, const std::string &directory);
+    static void storeBinary(size_t key, GLuint id, const std::string &directory);
+    static GLuint compile(const std::vector<ShaderStage> &stages);
+    static std::string path(size_t key, const std::string &directory);
+};
@@ -2,13 +2,13 @@
 
 #include "Texture.h"
 
-Texture::Texture(unsigned int width, unsigned int height, GLenum format, float *data) : m_width(width), m_height(height), m_format(format)
+Texture::Texture(unsigned int width, unsigned int height, GLint internalFormat, float *data) : m_width(width), m_height(height), m_internalFormat(internalFormat)
 {
-    glGenTextures(1, &m_id);
-    glBindTexture(GL_TEXTURE_2D, m_id);
-    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat(m_format), m_width, m_height, 0, m_format, GL_FLOAT, data);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    allocate();
+    if (data)
+    {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_width, m_height, format(), GL_FLOAT, data);
+    }
 }
 
 Texture::~Texture()
@@ -22,14 +22,12 @@ Texture::~Texture()
 // Copy constructor
 Texture::Texture(const Texture &other)
 {
-    this->m_format = other.m_format;
+    this->m_internalFormat = other.m_internalFormat;
     this->m_width = other.m_width;
     this->m_height = other.m_height;
     // Generate a new image
-    glGenTextures(1, &m_id);
-    glBindTexture(GL_TEXTURE_2D, m_id);
+    allocate();
     // Copy the image data
-    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat(m_format), m_width, m_height, 0, m_format, GL_FLOAT, 0);
     glCopyImageSubData(other.m_id, GL_TEXTURE_2D, 0, 0, 0, 0,
                        m_id, GL_TEXTURE_2D, 0, 0, 0, 0, m_width, m_height, 1);
 }
@@ -38,7 +36,7 @@ Texture::Texture(const Texture &other)
 Texture::Texture(Texture &&other) noexcept
 {
     this->m_id = other.m_id;
-    this->m_format = other.m_format;
+    this->m_internalFormat = other.m_internalFormat;
     this->m_width = other.m_width;
     this->m_height = other.m_height;
     other.m_id = 0;
@@ -47,14 +45,12 @@ Texture::Texture(Texture &&other) noexcept
 // Copy Assignment
 Texture &Texture::operator=(const Texture &other)
 {
-    this->m_format = other.m_format;
+    this->m_internalFormat = other.m_internalFormat;
     this->m_width = other.m_width;
     this->m_height = other.m_height;
     // Generate a new image
-    glGenTextures(1, &m_id);
-    glBindTexture(GL_TEXTURE_2D, m_id);
+    allocate();
     // Copy the image data
-    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat(m_format), m_width, m_height, 0, m_format, GL_FLOAT, 0);
     glCopyImageSubData(other.m_id, GL_TEXTURE_2D, 0, 0, 0, 0,
                        m_id, GL_TEXTURE_2D, 0, 0, 0, 0, m_width, m_height, 1);
     return *this;
@@ -64,7 +60,7 @@ Texture &Texture::operator=(const Texture &other)
 Texture &Texture::operator=(Texture &&other) noexcept
 {
     this->m_id = other.m_id;
-    this->m_format = other.m_format;
+    this->m_internalFormat = other.m_internalFormat;
     this->m_width = other.m_width;
     this->m_height = other.m_height;
     other.m_id = 0;
@@ -75,52 +71,102 @@ GLuint Texture::id() const { return m_id; }
 unsigned int Texture::width() const { return m_width; }
 unsigned int Texture::height() const { return m_height; }
 glm::ivec2 Texture::imageSize() const { return {m_width, m_height}; }
-GLuint Texture::format() const { return m_format; }
+GLuint Texture::format() const
+{
+    switch (m_internalFormat)
+    {
+    case GL_RGBA32F:
+    case GL_RGBA16F:
+    case GL_RGBA8:
+        return GL_RGBA;
+    case GL_RG16F:
+        return GL_RG;
+    case GL_R32F:
+    case GL_R16F:
+        return GL_RED;
+    default:
+        throw "Unsupported internal format";
+    }
+}
 
 void Texture::resize(unsigned int width, unsigned int height)
 {
     m_width = width;
     m_height = height;
-    glBindTexture(GL_TEXTURE_2D, m_id);
-    // Data is intentionally not restructured
-    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat(m_format), m_width, m_height, 0, m_format, GL_FLOAT, 0);
+    // Immutable storage can't be respecified, data is intentionally not restructured
+    glDeleteTextures(1, &m_id);
+    allocate();
 }
 
 size_t Texture::numChannels() const
 {
-    switch (m_format)
+    switch (format())
     {
     case GL_RGBA:
         return 4;
-    case GL_RGB:
-        return 3;
     case GL_RG:
         return 2;
-    case GL_RED:
+    default:
         return 1;
+    }
+}
+
+GLint Texture::internalFormat() const { return m_internalFormat; }
+const char *Texture::imageFormat() const { return imageFormat(m_internalFormat); }
+const char *Texture::imageFormat(GLint internalFormat)
+{
+    switch (internalFormat)
+    {
+    case GL_RGBA32F:
+        return "rgba32f";
+    case GL_RGBA16F:
+        return "rgba16f";
+    case GL_RGBA8:
+        return "rgba8";
+    case GL_RG16F:
+        return "rg16f";
+    case GL_R32F:
+        return "r32f";
+    case GL_R16F:
+        return "r16f";
     default:
-        throw "Unsupported format, only 32F formats currently supported";
+        throw "Unsupported internal format";
     }
 }
 
-GLint Texture::internalFormat(GLenum format) const
+size_t Texture::byteSize() const
 {
-    switch (format)
+    size_t channelSize;
+    switch (m_internalFormat)
     {
-    case GL_RGBA:
-        return GL_RGBA32F;
-    case GL_RGB:
-        return GL_RGB32F;
-    case GL_RG:
-        return GL_RG32F;
-    case GL_RED:
-        return GL_R32F;
+    case GL_RGBA32F:
+    case GL_R32F:
+        channelSize = sizeof(float);
+        break;
+    case GL_RGBA8:
+        channelSize = 1;
+        break;
     default:
-        throw "Unsupported format, only 32F formats currently supported";
+        channelSize = 2;
+        break;
     }
+    return size_t(m_width) * m_height * numChannels() * channelSize;
 }
 
-GLint Texture::internalFormat() const { return internalFormat(m_format); }
+void Texture::allocate()
+{
+    glGenTextures(1, &m_id);
+    glBindTexture(GL_TEXTURE_2D, m_id);
+    glTexStorage2D(GL_TEXTURE_2D, 1, m_internalFormat, m_width, m_height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    // Single channel images are greyscale when sampled, eg, by the viewport
+    if (format() == GL_RED)
+    {
+        GLint swizzle[] = {GL_RED, GL_RED, GL_RED, GL_ONE};
+        glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+    }
+}
 
 float *Texture::read() const
 {
@@ -130,6 +176,20 @@ float *Texture::read() const
     glGetTexImage(GL_TEXTURE_2D, 0, format(), GL_FLOAT, buffer);
     return buffer;
 }
+void Texture::readRGBA(float *pixels) const
+{
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, id());
+    glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_FLOAT, pixels);
+    // Reads aren't swizzled, copy the red channel as the viewport would display it
+    if (format() == GL_RED)
+    {
+        for (size_t i = 0, numPixels = size_t(m_width) * m_height; i < numPixels; ++i)
+        {
+            pixels[i * 4 + 1] = pixels[i * 4 + 2] = pixels[i * 4];
+        }
+    }
+}
 float *Texture::read(Channel channel) const
 {
     float *buffer = new float[width() * height()];
@@ -137,7 +197,8 @@ float *Texture::read(Channel channel) const
     glBindTexture(GL_TEXTURE_2D, id());
 
     GLenum format;
-    switch (channel)
+    // Every channel of a greyscale image is the red channel
+    switch (numChannels() == 1 ? Channel_Red : channel)
     {
     case Channel_Red:
         format = GL_RED;
@@ -160,6 +221,12 @@ void Texture::write(float *pixels, unsigned int width, unsigned int height, unsi
     glBindTexture(GL_TEXTURE_2D, m_id);
     glTexSubImage2D(GL_TEXTURE_2D, 0, posx, posy, width, height, GL_RGBA, GL_FLOAT, pixels);
 }
+void Texture::upload(const float *pixels)
+{
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, m_id);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_width, m_height, format(), GL_FLOAT, pixels);
+}
 void Texture::write(unsigned char *pixels, unsigned int width, unsigned int height, unsigned int posx, unsigned int posy)
 {
     glActiveTexture(GL_TEXTURE0);
@@ -6,10 +6,19 @@
 
 #include "../constants.h"
 
+/*
+A float texture with immutable storage, ie, resizing replaces the underlying GL texture.
+Operators should acquire textures from the TexturePool rather than constructing them.
+
+The internal format is one of the image formats supported by operators, see
+imageFormat(). Textures with fewer than four channels still read as RGBA, single
+channel textures being greyscale, ie, the red channel is copied to green and blue when
+sampled or read with readRGBA().
+*/
 class Texture
 {
 public:
-    Texture(unsigned int width, unsigned int height, GLenum format = GL_RGBA, float *data = 0);
+    Texture(unsigned int width, unsigned int height, GLint internalFormat = GL_RGBA32F, float *data = 0);
     ~Texture();
     Texture(const Texture &other);                // Copy constructor
     Texture(Texture &&other) noexcept;            // Move constructor
@@ -20,23 +29,36 @@ public:
     unsigned int width() const;
     unsigned int height() const;
     glm::ivec2 imageSize() const;
+    // Pixel format, eg, GL_RED, for transferring data
     GLuint format() const;
 
+    // Replaces the texture with a new one of the given size, the data is not preserved
     void resize(unsigned int width, unsigned int height);
     size_t numChannels() const;
     GLint internalFormat() const;
+    /* Format layout qualifier for binding the texture to an image2D uniform, eg, "rgba32f" */
+    const char *imageFormat() const;
+    static const char *imageFormat(GLint internalFormat);
+    // Memory held by the texture's storage
+    size_t byteSize() const;
 
     // Reads a copy of the texture data. Memory is owned by the caller.
     float *read() const;
     float *read(Channel channel) const;
+    // Reads the texture data as RGBA into a buffer of at least width * height * 4 floats
+    void readRGBA(float *pixels) const;
     void write(float *pixels, unsigned int width, unsigned int height, unsigned int posx = 0, unsigned int posy = 0);
+    /* Replaces the whole image with pixels in the texture's own format, eg, as returned by read() */
+    void upload(const float *pixels);
     void write(unsigned char *pixels, unsigned int width, unsigned int height, unsigned int posx = 0, unsigned int posy = 0);
 
 protected:
-    GLint internalFormat(GLenum format) const;
     unsigned int m_width, m_height;
-    GLenum m_format = GL_RGBA;
+    GLint m_internalFormat = GL_RGBA32F;
     GLuint m_id = 0;
+
+    /* Generates the texture and allocates its storage */
+    void allocate();
 };
 
 typedef std::map<std::string, Texture *> RenderSet;
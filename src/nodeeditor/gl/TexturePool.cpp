@@ -0,0 +1,153 @@
+#include <algorithm>
+#include <list>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "../constants.h"
+#include "../log.h"
+#include "TexturePool.h"
+
+TexturePool &TexturePool::instance()
+{
+    static TexturePool pool(DEFAULT_TEXTURE_POOL_BYTES);
+    return pool;
+}
+
+TexturePool::TexturePool(size_t capacityBytes) : m_capacity(capacityBytes) {}
+TexturePool::~TexturePool()
+{
+    clear();
+}
+
+Texture *TexturePool::acquire(const glm::ivec2 &imageSize, GLint internalFormat)
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    Texture *texture = nullptr;
+    auto it = m_buckets.find(Key(imageSize.x, imageSize.y, internalFormat));
+    if (it != m_buckets.end() && !it->second.empty())
+    {
+        auto idle = it->second.back();
+        it->second.pop_back();
+        texture = *idle;
+        m_idle.erase(idle);
+        m_idleBytes -= texture->byteSize();
+        LOG_DEBUG("Reusing texture ID %u with size (%d, %d)", texture->id(), imageSize.x, imageSize.y);
+    }
+    else
+    {
+        texture = new Texture(imageSize.x, imageSize.y, internalFormat);
+    }
+    m_inUseBytes += texture->byteSize();
+    return texture;
+}
+
+void TexturePool::release(Texture *texture)
+{
+    if (!texture)
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> guard(m_mutex);
+    if (m_holds.count(texture) > 0)
+    {
+        m_releasedHeld.insert(texture);
+        return;
+    }
+    makeIdle(texture);
+}
+
+void TexturePool::hold(Texture const *texture)
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    ++m_holds[texture];
+}
+void TexturePool::unhold(Texture const *texture)
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    auto it = m_holds.find(texture);
+    if (it == m_holds.end() || --it->second > 0)
+    {
+        return;
+    }
+    m_holds.erase(it);
+    if (m_releasedHeld.erase(texture) > 0)
+    {
+        makeIdle(const_cast<Texture *>(texture));
+    }
+}
+
+bool TexturePool::isHeld(Texture const *texture) const
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_holds.count(texture) > 0;
+}
+
+size_t TexturePool::capacity() const
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_capacity;
+}
+void TexturePool::setCapacity(size_t capacityBytes)
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_capacity = capacityBytes;
+    evict();
+}
+size_t TexturePool::inUseBytes() const
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_inUseBytes;
+}
+size_t TexturePool::idleBytes() const
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_idleBytes;
+}
+
+void TexturePool::clear()
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    for (Texture *texture : m_idle)
+    {
+        delete texture;
+    }
+    m_idle.clear();
+    m_buckets.clear();
+    m_idleBytes = 0;
+}
+
+TexturePool::Key TexturePool::key(const Texture *texture)
+{
+    return {texture->width(), texture->height(), texture->internalFormat()};
+}
+
+void TexturePool::makeIdle(Texture *texture)
+{
+    m_inUseBytes -= texture->byteSize();
+    m_idle.push_front(texture);
+    m_buckets[key(texture)].push_back(m_idle.begin());
+    m_idleBytes += texture->byteSize();
+    evict();
+}
+
+void TexturePool::evict()
+{
+    while (m_idleBytes > m_capacity && !m_idle.empty())
+    {
+        auto oldest = std::prev(m_idle.end());
+        Texture *texture = *oldest;
+        auto bucket = m_buckets.find(key(texture));
+        bucket->second.erase(std::find(bucket->second.begin(), bucket->second.end(), oldest));
+        if (bucket->second.empty())
+        {
+            m_buckets.erase(bucket);
+        }
+        m_idle.erase(oldest);
+        m_idleBytes -= texture->byteSize();
+        LOG_DEBUG("Deleting idle texture ID %u", texture->id());
+        delete texture;
+    }
+}
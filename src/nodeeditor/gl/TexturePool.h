@@ -0,0 +1,75 @@
+#pragma once
+#include <list>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <GL/glew.h>
+
+#include "Texture.h"
+
+/*
+Recycles Textures so that operators don't allocate new storage every time they're
+processed.
+
+Released textures are kept idle in buckets of identical size and format, and handed
+back out by acquire() before any new texture is created. Idle textures are deleted
+least recently released first once their total byte size exceeds the capacity.
+
+Textures have immutable storage so a texture is never resized, a texture of the new
+size is acquired instead. Shared by every context in the share group, so may be used
+from any thread with a current context.
+
+Textures may be held while another thread reads them, eg, the viewer. A held texture
+that's released only becomes idle once it's no longer held.
+*/
+class TexturePool
+{
+public:
+    static TexturePool &instance();
+
+    TexturePool(size_t capacityBytes);
+    ~TexturePool();
+
+    /* Returns an idle texture of the size and internal format, or a new one if none are idle. Owned by the caller until released. */
+    Texture *acquire(const glm::ivec2 &imageSize, GLint internalFormat = GL_RGBA32F);
+    /* Returns ownership of the texture to the pool */
+    void release(Texture *texture);
+    /* Keeps the texture from being reused or deleted until it's unheld as many times as it was held */
+    void hold(Texture const *texture);
+    void unhold(Texture const *texture);
+    bool isHeld(Texture const *texture) const;
+
+    size_t capacity() const;
+    void setCapacity(size_t capacityBytes);
+    /* Memory held by acquired textures, and by idle textures waiting to be reused */
+    size_t inUseBytes() const;
+    size_t idleBytes() const;
+    /* Deletes every idle texture */
+    void clear();
+
+protected:
+    // Width, height and internal format
+    typedef std::tuple<unsigned int, unsigned int, GLint> Key;
+
+    mutable std::mutex m_mutex;
+    size_t m_capacity;
+    size_t m_inUseBytes = 0;
+    size_t m_idleBytes = 0;
+    // Most recently released textures are at the front
+    std::list<Texture *> m_idle;
+    std::map<Key, std::vector<std::list<Texture *>::iterator>> m_buckets;
+    // Number of holds on each held texture, and the held textures that have been released
+    std::unordered_map<Texture const *, int> m_holds;
+    std::unordered_set<Texture const *> m_releasedHeld;
+
+    static Key key(const Texture *texture);
+    /* Makes a released texture idle. Must be called with the lock held. */
+    void makeIdle(Texture *texture);
+    /* Deletes idle textures until within capacity. Must be called with the lock held. */
+    void evict();
+};
@@ -47,6 +47,11 @@ glm::vec4 TextureReader::readPixel(int x, int y)
     }
 
     size_t index = (y * m_texture->width() + x) * m_texture->numChannels();
+    // Single channel images are displayed as greyscale
+    if (m_texture->numChannels() == 1)
+    {
+        return {m_buffer[index], m_buffer[index], m_buffer[index], 1.0f};
+    }
     glm::vec4 value;
     for (size_t i = 0; i < 4; ++i)
     {
@@ -0,0 +1,186 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "../constants.h"
+#include "../log.h"
+#include "../nodegraph/Iterators.h"
+#include "RenderSetOperator.h"
+#include "Texture.h"
+#include "TiledRenderer.h"
+
+TiledRenderer::TiledRenderer(Scene *scene, int tileSize) : m_scene(scene), m_tileSize(tileSize) {}
+
+bool TiledRenderer::render(const std::vector<Node *> &saveNodes)
+{
+    bool ok = true;
+    for (Node *save : saveNodes)
+    {
+        Connector *conn = save->input(0);
+        if (conn->numConnections() == 0)
+        {
+            LOG_ERROR("Save node %u has no input", save->id());
+            ok = false;
+            continue;
+        }
+
+        Node *node = conn->connection(0)->node();
+        int margin = m_scene->upstreamMargin(node);
+        if (margin < 0)
+        {
+            LOG_WARNING("Save node %u reads the full image upstream, rendering it untiled", save->id());
+            ok = m_scene->evaluate({save}) && ok;
+            continue;
+        }
+        LOG_INFO("Rendering save node %u in tiles of %d with a margin of %d", save->id(), m_tileSize, margin);
+        ok = renderTiled(save, node, margin) && ok;
+    }
+    return ok;
+}
+
+bool TiledRenderer::renderTiled(Node *save, Node *node, int margin)
+{
+    Settings const *settings = save->appliedSettings();
+    std::string filepath = settings->getString("filepath") + EXTENSION_HDR;
+    if (settings->getInt("format") != FileType_HDR)
+    {
+        LOG_WARNING("Tiled rendering only writes HDR, writing %s", filepath.c_str());
+    }
+    FILE *file = fopen(filepath.c_str(), "wb");
+    if (!file)
+    {
+        LOG_ERROR("Failed to open %s for writing", filepath.c_str());
+        return false;
+    }
+
+    Settings sceneSettings = *m_scene->settings();
+    sceneSettings.registerInt2(SCENE_SETTING_IMAGE_ORIGIN, glm::ivec2(0));
+    glm::ivec2 imageSize = sceneSettings.getInt2(SCENE_SETTING_IMAGE_SIZE);
+
+    // Only one row of tiles is held in memory, written as soon as it's complete. Rows
+    // are written top down, ie, starting from the last row of the texture.
+    std::vector<float> band(size_t(imageSize.x) * m_tileSize * 4);
+    std::vector<float> pixels;
+    std::vector<unsigned char> scratch;
+    bool ok = writeHeader(file, imageSize);
+    for (int top = imageSize.y; ok && top > 0; top -= m_tileSize)
+    {
+        int bottom = std::max(0, top - m_tileSize);
+        for (int left = 0; ok && left < imageSize.x; left += m_tileSize)
+        {
+            int right = std::min(imageSize.x, left + m_tileSize);
+            glm::ivec2 origin(std::max(0, left - margin), std::max(0, bottom - margin));
+            glm::ivec2 end(std::min(imageSize.x, right + margin), std::min(imageSize.y, top + margin));
+            ok = evaluateRegion(node, origin, end - origin, &sceneSettings, pixels);
+
+            int regionWidth = end.x - origin.x;
+            for (int y = bottom; ok && y < top; ++y)
+            {
+                const float *tileRow = pixels.data() + (size_t(y - origin.y) * regionWidth + (left - origin.x)) * 4;
+                std::copy(tileRow, tileRow + (right - left) * 4, band.data() + (size_t(y - bottom) * imageSize.x + left) * 4);
+            }
+        }
+        for (int y = top - 1; ok && y >= bottom; --y)
+        {
+            ok = writeScanline(file, band.data() + size_t(y - bottom) * imageSize.x * 4, imageSize.x, scratch);
+        }
+        LOG_DEBUG("Wrote rows %d to %d of %s", imageSize.y - top, imageSize.y - bottom, filepath.c_str());
+    }
+    resetUpstream(node);
+
+    ok = (fclose(file) == 0) && ok;
+    if (!ok)
+    {
+        LOG_ERROR("Failed to render %s", filepath.c_str());
+    }
+    return ok;
+}
+
+bool TiledRenderer::evaluateRegion(Node *node, glm::ivec2 origin, glm::ivec2 size, Settings *sceneSettings, std::vector<float> &pixels)
+{
+    sceneSettings->get(SCENE_SETTING_IMAGE_ORIGIN)->set(origin);
+    sceneSettings->get(SCENE_SETTING_IMAGE_SIZE)->set(size);
+    resetUpstream(node);
+    if (!m_scene->evaluate({node}, sceneSettings))
+    {
+        return false;
+    }
+
+    Op::RenderSetOperator const *op = dynamic_cast<Op::RenderSetOperator const *>(node->op());
+    Texture const *texture = op ? op->layer(DEFAULT_LAYER) : nullptr;
+    if (!texture || texture->imageSize() != size)
+    {
+        LOG_ERROR("%s did not output the default layer at the size of the region", node->type().c_str());
+        return false;
+    }
+    pixels.resize(size_t(size.x) * size.y * 4);
+    texture->readRGBA(pixels.data());
+    return true;
+}
+
+void TiledRenderer::resetUpstream(Node *node)
+{
+    for (DepthIterator it{node}; it != DepthIterator(); ++it)
+    {
+        if (it->state() != State::Unprocessed)
+        {
+            it->reset(nullptr);
+        }
+    }
+}
+
+bool TiledRenderer::writeHeader(FILE *file, glm::ivec2 imageSize)
+{
+    return fprintf(file, "#?RADIANCE\nFORMAT=32-bit_rle_rgbe\nEXPOSURE=1.0\n\n-Y %d +X %d\n", imageSize.y, imageSize.x) > 0;
+}
+
+bool TiledRenderer::writeScanline(FILE *file, const float *pixels, int width, std::vector<unsigned char> &scratch)
+{
+    // Shared exponent encoding, as written by stb_image_write
+    scratch.resize(size_t(width) * 4);
+    for (int x = 0; x < width; ++x)
+    {
+        const float *pixel = pixels + x * 4;
+        unsigned char *rgbe = scratch.data() + x * 4;
+        float maxComponent = std::max(pixel[0], std::max(pixel[1], pixel[2]));
+        if (maxComponent < 1e-32f)
+        {
+            rgbe[0] = rgbe[1] = rgbe[2] = rgbe[3] = 0;
+            continue;
+        }
+        int exponent;
+        float normalize = std::frexp(maxComponent, &exponent) * 256.0f / maxComponent;
+        rgbe[0] = (unsigned char)(pixel[0] * normalize);
+        rgbe[1] = (unsigned char)(pixel[1] * normalize);
+        rgbe[2] = (unsigned char)(pixel[2] * normalize);
+        rgbe[3] = (unsigned char)(exponent + 128);
+    }
+
+    // Readers only accept flat scanlines outside of the run length encoded width range
+    if (width < 8 || width > 0x7fff)
+    {
+        return fwrite(scratch.data(), 4, width, file) == size_t(width);
+    }
+    // Run length encoded, but only as literal runs of each component in turn
+    unsigned char header[4] = {2, 2, (unsigned char)(width >> 8), (unsigned char)(width & 0xff)};
+    bool ok = fwrite(header, 1, 4, file) == 4;
+    for (int c = 0; ok && c < 4; ++c)
+    {
+        unsigned char literal[129];
+        for (int x = 0; ok && x < width; x += 128)
+        {
+            int count = std::min(128, width - x);
+            literal[0] = (unsigned char)count;
+            for (int i = 0; i < count; ++i)
+            {
+                literal[i + 1] = scratch[(x + i) * 4 + c];
+            }
+            ok = fwrite(literal, 1, count + 1, file) == size_t(count + 1);
+        }
+    }
+    return ok;
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "../nodegraph/Node.h"
+#include "../nodegraph/Scene.h"
+#include "../nodegraph/Settings.h"
+
+/*
+Renders Save nodes one tile at a time so that images larger than GPU memory can be
+written, streaming each completed row of tiles to disk.
+
+Each tile is evaluated by processing the Save node's upstream graph over the tile grown by
+the margin of every operator's footprint along the longest path (see Scene::upstreamMargin),
+clipped to the image. Every node in the graph is evaluated over the same region, by
+setting the scene's imageSize to the region's size and imageOrigin to its position, and
+only the tile at the centre is written as it's the only part unaffected by the edges of
+the region. Nodes are reset between tiles so only one tile's intermediates are held.
+
+Graphs containing any operator with an unbounded footprint, eg, JumpFlood, can't be tiled
+and are evaluated over the full image instead.
+
+Tiled output is always written as an uncompressed Radiance HDR file regardless of the
+Save node's format, as PNG can't be written a row at a time.
+*/
+class TiledRenderer
+{
+public:
+    TiledRenderer(Scene *scene, int tileSize);
+
+    /* Renders each Save node. Returns true if every one was written. */
+    bool render(const std::vector<Node *> &saveNodes);
+
+protected:
+    Scene *m_scene;
+    int m_tileSize;
+
+    bool renderTiled(Node *save, Node *node, int margin);
+    /* Evaluates the node over the region, returning its default layer as RGBA */
+    bool evaluateRegion(Node *node, glm::ivec2 origin, glm::ivec2 size, Settings *sceneSettings, std::vector<float> &pixels);
+    /* Resets the node and everything upstream so the next region is processed from scratch */
+    void resetUpstream(Node *node);
+
+    static bool writeHeader(FILE *file, glm::ivec2 imageSize);
+    /* Writes a row of RGBA pixels as RGBE, alpha is ignored */
+    static bool writeScanline(FILE *file, const float *pixels, int width, std::vector<unsigned char> &scratch);
+};
@@ -0,0 +1,44 @@
+#include <string>
+
+#include <GL/glew.h>
+
+#include "TexturePool.h"
+#include "ViewLayers.h"
+
+ViewLayers::ViewLayers(NodeID nodeID, const RenderSet_c &layers) : m_nodeID(nodeID), m_layers(layers)
+{
+    for (const auto &[name, texture] : m_layers)
+    {
+        TexturePool::instance().hold(texture);
+    }
+    // Flushed so the viewer's context can't wait on a fence that's never submitted
+    m_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush();
+}
+ViewLayers::~ViewLayers()
+{
+    if (m_fence)
+    {
+        glDeleteSync(m_fence);
+    }
+    for (const auto &[name, texture] : m_layers)
+    {
+        TexturePool::instance().unhold(texture);
+    }
+}
+
+NodeID ViewLayers::nodeID() const { return m_nodeID; }
+const RenderSet_c &ViewLayers::layers() const { return m_layers; }
+Texture const *ViewLayers::layer(const std::string &name) const
+{
+    auto it = m_layers.find(name);
+    return it != m_layers.end() ? it->second : nullptr;
+}
+
+void ViewLayers::wait() const
+{
+    if (m_fence)
+    {
+        glWaitSync(m_fence, 0, GL_TIMEOUT_IGNORED);
+    }
+}
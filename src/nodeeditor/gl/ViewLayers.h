@@ -0,0 +1,35 @@
+#pragma once
+#include <string>
+
+#include <GL/glew.h>
+
+#include "../nodegraph/Node.h"
+#include "Texture.h"
+
+/*
+The view node's layers as published by the processing thread for the viewer to read, see
+RenderScene::viewLayers(). The TexturePool can't reuse or delete the textures while the
+layers are held, and the fence follows every GL command that wrote them when published.
+*/
+class ViewLayers
+{
+public:
+    /* Must be called on the processing thread, once the layers' commands are issued */
+    ViewLayers(NodeID nodeID, const RenderSet_c &layers);
+    ~ViewLayers();
+
+    ViewLayers(const ViewLayers &other) = delete;
+    ViewLayers &operator=(const ViewLayers &other) = delete;
+
+    NodeID nodeID() const;
+    const RenderSet_c &layers() const;
+    /* The texture of the layer, or nullptr if there is no such layer */
+    Texture const *layer(const std::string &name) const;
+    /* Makes the current context wait for the layers to be written before it reads them */
+    void wait() const;
+
+protected:
+    NodeID m_nodeID;
+    RenderSet_c m_layers;
+    GLsync m_fence = nullptr;
+};
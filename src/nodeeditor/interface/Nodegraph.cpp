@@ -23,6 +23,7 @@ const ImU32 COLOR_HOVER = IM_COL32(100, 255, 255, 255);
 const ImU32 COLOR_LINE = IM_COL32(255, 255, 255, 255);
 const ImU32 COLOR_SELECTED = IM_COL32(255, 255, 0, 255);
 const ImU32 COLOR_VIEW = IM_COL32(255, 0, 255, 255);
+const ImU32 COLOR_PINNED = IM_COL32(255, 150, 0, 255);
 const ImU32 COLOR_CONNECTOR = IM_COL32(150, 150, 150, 255);
 const ImU32 COLOR_CONNECTOR_OPTIONAL = IM_COL32(100, 100, 100, 255);
 const ImU32 COLOR_UNPROCESSED = IM_COL32(80, 80, 80, 255);
@@ -50,9 +51,10 @@ void Nodegraph::fitBounds(const Bounds &worldBounds)
     m_viewOffset = -worldBounds.pos() * m_viewScale + screenPadding * 0.5f;
 }
 
-void Nodegraph::startConnection(Connector *conn)
+void Nodegraph::startConnection(Connector *conn, std::shared_ptr<GraphSnapshot const> snapshot)
 {
     m_startConnector = conn;
+    m_connectionSnapshot = std::move(snapshot);
     m_currentLineStart = graphElementBounds(conn).center();
     m_currentLineEnd = m_currentLineStart;
 }
@@ -63,6 +65,7 @@ void Nodegraph::updateConnection(glm::vec2 pos)
 void Nodegraph::finishConnection()
 {
     m_startConnector = nullptr;
+    m_connectionSnapshot.reset();
 }
 Connector *Nodegraph::activeConnection()
 {
@@ -131,13 +134,27 @@ ImU32 Nodegraph::connColor(const Connector *connector) const
 /* GraphElement bounds within the screen window, respecting view transforms */
 Bounds Nodegraph::graphElementBounds(GraphElement *el)
 {
-    return {worldToScreenPos(el->bounds().min()), worldToScreenPos(el->bounds().max())};
+    return worldToScreenBounds(el->bounds());
+}
+Bounds Nodegraph::worldToScreenBounds(const Bounds &worldBounds)
+{
+    return {worldToScreenPos(worldBounds.min()), worldToScreenPos(worldBounds.max())};
 }
 
-void Nodegraph::drawNode(ImDrawList *drawList, Node *node)
+void Nodegraph::drawNode(ImDrawList *drawList, const GraphSnapshot::Entry &entry)
 {
-    if (!node)
+    Node *node = entry.node();
+
+    // Nodes outside of the panel only draw their connections, which may cross it
+    if (!m_bounds.intersects(worldToScreenBounds(node->outerBounds())))
     {
+        for (size_t i = 0; i < node->numInputs(); ++i)
+        {
+            if (Connector *connected = entry.connection(i))
+            {
+                drawConnection(drawList, node->input(i), connected);
+            }
+        }
         return;
     }
 
@@ -148,6 +165,11 @@ void Nodegraph::drawNode(ImDrawList *drawList, Node *node)
         drawList->AddRect(ImVec2(bounds.min().x, bounds.min().y), ImVec2(bounds.max().x, bounds.max().y),
                           COLOR_VIEW, m_nodeRounding, ImDrawFlags_Closed, m_viewThickness);
     }
+    else if (node->hasSelectFlag(SelectFlag_Pinned))
+    {
+        drawList->AddRect(ImVec2(bounds.min().x, bounds.min().y), ImVec2(bounds.max().x, bounds.max().y),
+                          COLOR_PINNED, m_nodeRounding, ImDrawFlags_Closed, m_pinThickness);
+    }
 
     // Connectors text is half size
     float fontScale = ImGui::GetCurrentWindow()->FontWindowScale;
@@ -158,11 +180,10 @@ void Nodegraph::drawNode(ImDrawList *drawList, Node *node)
         Connector *conn = node->input(i);
         Bounds b = graphElementBounds(conn);
 
-        for (size_t j = 0; j < conn->numConnections(); ++j)
+        // The connectors' own connections are changed by the processing thread
+        if (Connector *connected = entry.connection(i))
         {
-            glm::vec2 p1 = b.center();
-            glm::vec2 p2 = graphElementBounds(conn->connection(j)).center();
-            drawList->AddLine(ImVec2(p1.x, p1.y), ImVec2(p2.x, p2.y), COLOR_LINE, m_lineThickness);
+            drawConnection(drawList, conn, connected);
         }
 
         drawList->AddRectFilled(ImVec2(b.min().x, b.min().y), ImVec2(b.max().x, b.max().y), connColor(conn), m_connectorRounding);
@@ -181,13 +202,20 @@ void Nodegraph::drawNode(ImDrawList *drawList, Node *node)
     drawList->AddRectFilled(ImVec2(bounds.min().x, bounds.min().y), ImVec2(bounds.max().x, bounds.max().y), nodeColor(node), m_nodeRounding);
     drawList->AddText(ImVec2(bounds.min().x, bounds.min().y), COLOR_TEXT, node->type().c_str());
 
-    if (node && node->hasSelectFlag(SelectFlag_Select))
+    if (node->hasSelectFlag(SelectFlag_Select))
     {
         drawList->AddRect(ImVec2(bounds.min().x, bounds.min().y), ImVec2(bounds.max().x, bounds.max().y),
                           COLOR_SELECTED, m_nodeRounding, ImDrawFlags_Closed, m_selectionThickness);
     }
 }
 
+void Nodegraph::drawConnection(ImDrawList *drawList, Connector *input, Connector *output)
+{
+    glm::vec2 p1 = graphElementBounds(input).center();
+    glm::vec2 p2 = graphElementBounds(output).center();
+    drawList->AddLine(ImVec2(p1.x, p1.y), ImVec2(p2.x, p2.y), COLOR_LINE, m_lineThickness);
+}
+
 void Nodegraph::drawNodeSelection()
 {
 
@@ -268,10 +296,10 @@ void Nodegraph::draw()
                               m_lineThickness);
         }
 
-        Graph *graph = m_scene->getCurrentGraph();
-        for (auto it = graph->begin(); it != graph->end(); ++it)
+        std::shared_ptr<GraphSnapshot const> graph = m_scene->snapshot();
+        for (const auto &entry : *graph)
         {
-            drawNode(drawList, &(*it));
+            drawNode(drawList, *entry);
         }
 
         if (m_shouldDrawTextbox)
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <memory>
+
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <imgui.h>
@@ -7,6 +9,7 @@
 
 #include "../Bounds.hpp"
 #include "../nodegraph/Connector.h"
+#include "../nodegraph/GraphSnapshot.h"
 #include "../nodegraph/Node.h"
 #include "../nodegraph/Scene.h"
 #include "Panel.hpp"
@@ -28,7 +31,8 @@ public:
     void scaleFromPos(const glm::vec2 screenPos, float scale);
     void fitBounds(const Bounds &worldBounds);
 
-    void startConnection(Connector *conn);
+    /* Starts a connection from a connector of a node in the snapshot, which is held until finished */
+    void startConnection(Connector *conn, std::shared_ptr<GraphSnapshot const> snapshot);
     void updateConnection(glm::vec2 pos);
     void finishConnection();
     Connector *activeConnection();
@@ -42,6 +46,7 @@ public:
 
     /* GraphElement bounds within the screen window, respecting view transforms */
     Bounds graphElementBounds(GraphElement *el);
+    Bounds worldToScreenBounds(const Bounds &worldBounds);
 
     void draw();
 
@@ -54,9 +59,11 @@ protected:
     float m_selectionThickness = 1.0f;
     float m_lineThickness = 3.0f;
     float m_viewThickness = 8.0f;
+    float m_pinThickness = 4.0f;
 
     // Drawing a new connection
     Connector *m_startConnector = nullptr;
+    std::shared_ptr<GraphSnapshot const> m_connectionSnapshot;
     glm::vec2 m_currentLineStart;
     glm::vec2 m_currentLineEnd;
 
@@ -68,6 +75,7 @@ protected:
     ImU32 nodeColor(const Node *node) const;
     ImU32 connColor(const Connector *connector) const;
 
-    void drawNode(ImDrawList *drawList, Node *node);
+    void drawNode(ImDrawList *drawList, const GraphSnapshot::Entry &entry);
+    void drawConnection(ImDrawList *drawList, Connector *input, Connector *output);
     void drawNodeSelection();
 };
@@ -1,13 +1,15 @@
 #include <GL/glew.h>
 #include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <GLFW/glfw3.h>
 
 #include "../Bounds.hpp"
 #include "../constants.h"
 #include "../nodegraph/Node.h"
-#include "../gl/RenderSetOperator.h"
+#include "../gl/RenderScene.h"
 #include "../gl/Texture.h"
+#include "../gl/ViewLayers.h"
 #include "Panel.hpp"
 #include "Window.h"
 
@@ -18,7 +20,7 @@ Viewport::Viewport(Window *window, Bounds bounds) : Panel(window, bounds), m_vie
 Camera &Viewport::camera() { return m_camera; }
 void Viewport::setChannel(Channel channel) { m_isolateChannel = channel; }
 void Viewport::setLayer(std::string layer) { m_layer = layer; }
-void Viewport::setScene(Scene *scene) { m_scene = scene; }
+void Viewport::setScene(RenderScene *scene) { m_scene = scene; }
 
 void Viewport::draw()
 {
@@ -32,22 +34,29 @@ void Viewport::draw()
     glActiveTexture(GL_TEXTURE0);
     Channel channel = m_isolateChannel;
     glm::mat4 model{1.0f};
-    // Takes node and layer so it can read the texture live as it's processed
+    // Shows the view node's layer as last published by the processing thread
     if (m_scene && !m_layer.empty())
     {
-        Node *node = m_scene->getViewNode();
-        if (node)
+        glm::ivec2 origin, extent, imageSize;
+        Texture const *preview = m_scene->previewLayer(m_layer, origin, extent, imageSize);
+        // Kept until the next draw so the processing thread can't write to the texture while it's drawn
+        m_viewLayers = m_scene->viewLayers();
+        Texture const *texture = m_viewLayers ? m_viewLayers->layer(m_layer) : nullptr;
+        if (preview)
         {
-            Op::RenderSetOperator const *op = dynamic_cast<Op::RenderSetOperator const *>(node->op());
-            if (op)
-            {
-                Texture const *texture = op->layer(m_layer);
-                if (texture)
-                {
-                    glBindTexture(GL_TEXTURE_2D, texture->id());
-                    model = glm::scale(model, glm::vec3(float(texture->width()) / texture->height(), 1, 1));
-                }
-            }
+            // Covers its part of the full image's quad while the rest is processed
+            glm::vec2 start = glm::vec2(origin) / glm::vec2(imageSize);
+            glm::vec2 end = glm::vec2(origin + extent) / glm::vec2(imageSize);
+            float aspect = float(imageSize.x) / imageSize.y;
+            glBindTexture(GL_TEXTURE_2D, preview->id());
+            model = glm::translate(model, glm::vec3(aspect * (start.x + end.x - 1.0f), start.y + end.y - 1.0f, 0));
+            model = glm::scale(model, glm::vec3(aspect * (end.x - start.x), end.y - start.y, 1));
+        }
+        else if (texture)
+        {
+            m_viewLayers->wait();
+            glBindTexture(GL_TEXTURE_2D, texture->id());
+            model = glm::scale(model, glm::vec3(float(texture->width()) / texture->height(), 1, 1));
         }
     }
 
@@ -73,6 +82,19 @@ glm::vec2 Viewport::screenToWorldPos(glm::vec2 screenPos)
     worldPos /= worldPos.w;
     return glm::vec2(worldPos.x, worldPos.y) * 0.5f + 0.5f;
 }
+void Viewport::visibleRegion(glm::ivec2 imageSize, glm::ivec2 &origin, glm::ivec2 &size)
+{
+    // Corners of the panel with GL's inverted Y axis, as used by screenToWorldPos()
+    glm::vec2 bottomLeft = screenToWorldPos({m_bounds.min().x, m_window->height() - m_bounds.max().y});
+    glm::vec2 topRight = screenToWorldPos({m_bounds.max().x, m_window->height() - m_bounds.min().y});
+    // The image's quad is scaled horizontally by its aspect ratio around the centre
+    float ratio = 0.5f * float(imageSize.x) / imageSize.y;
+    glm::vec2 start((bottomLeft.x - (0.5f - ratio)) / (2 * ratio) * imageSize.x, bottomLeft.y * imageSize.y);
+    glm::vec2 end((topRight.x - (0.5f - ratio)) / (2 * ratio) * imageSize.x, topRight.y * imageSize.y);
+    origin = glm::ivec2(glm::floor(start));
+    size = glm::ivec2(glm::ceil(end)) - origin;
+}
+
 glm::vec2 Viewport::worldToScreenPos(glm::vec2 mapPos)
 {
     glm::vec2 ndcPos = glm::vec2(mapPos.x / (float)m_window->width(), mapPos.y / (float)m_window->height());
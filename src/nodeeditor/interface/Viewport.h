@@ -1,4 +1,6 @@
 #pragma once
+#include <memory>
+
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <GL/glew.h>
@@ -6,8 +8,9 @@
 #include "../Bounds.hpp"
 #include "../constants.h"
 #include "../nodegraph/Node.h"
-#include "../nodegraph/Scene.h"
+#include "../gl/RenderScene.h"
 #include "../gl/Shader.h"
+#include "../gl/ViewLayers.h"
 #include "Panel.hpp"
 #include "Window.h"
 
@@ -26,16 +29,19 @@ public:
     Camera &camera();
     void setChannel(Channel channel);
     void setLayer(std::string layer);
-    void setScene(Scene *scene);
+    void setScene(RenderScene *scene);
     void draw() override;
 
     glm::vec2 screenToWorldPos(glm::vec2 screenPos);
     glm::vec2 worldToScreenPos(glm::vec2 mapPos);
+    /* The pixels of an image of imageSize that are visible, possibly extending outside of it */
+    void visibleRegion(glm::ivec2 imageSize, glm::ivec2 &origin, glm::ivec2 &size);
 
 protected:
     Shader m_viewShader;
     Camera m_camera;
     Channel m_isolateChannel = Channel_All;
-    Scene *m_scene = nullptr;
+    RenderScene *m_scene = nullptr;
+    std::shared_ptr<ViewLayers const> m_viewLayers;
     std::string m_layer = DEFAULT_LAYER;
 };
\ No newline at end of file
@@ -1,9 +1,11 @@
+#include <memory>
+
 #include <imgui.h>
 #include <imgui_impl_glfw.h>
 #include <imgui_impl_opengl3.h>
 
-#include "../gl/RenderSetOperator.h"
 #include "../gl/Texture.h"
+#include "../gl/ViewLayers.h"
 #include "../util.h"
 #include "ViewportProperties.h"
 
@@ -12,7 +14,7 @@ ViewportProperties::ViewportProperties(Window *window, Bounds bounds) : Panel(wi
 void ViewportProperties::setChannel(Channel channel) { m_channel = channel; }
 void ViewportProperties::setLayer(const std::string &layer) { m_layer = layer; }
 void ViewportProperties::setPixelPreview(PixelPreview *preview) { m_pixelPreview = preview; }
-void ViewportProperties::setScene(Scene *scene) { m_scene = scene; }
+void ViewportProperties::setScene(RenderScene *scene) { m_scene = scene; }
 
 std::string ViewportProperties::selectedLayer() const { return m_layer; }
 
@@ -25,19 +27,9 @@ void ViewportProperties::draw()
     ImGui::SetNextWindowSize(ImVec2(size().x, size().y));
     ImGui::Begin("Viewport Properties", &p_open, flags);
 
-    const RenderSet_c *renderSet = nullptr;
-    if (m_scene)
-    {
-        Node *viewNode = m_scene->getViewNode();
-        if (viewNode)
-        {
-            Op::RenderSetOperator const *op = dynamic_cast<Op::RenderSetOperator const *>(viewNode->op());
-            if (op)
-            {
-                renderSet = op->renderSet();
-            }
-        }
-    }
+    // Held while drawn as the processing thread replaces the view node's layers
+    std::shared_ptr<ViewLayers const> layers = m_scene ? m_scene->viewLayers() : nullptr;
+    const RenderSet_c *renderSet = layers ? &layers->layers() : nullptr;
     ImGui::PushItemWidth(150.0f);
     if (ImGui::BeginCombo("##Layer", renderSet ? m_layer.c_str() : "--"))
     {
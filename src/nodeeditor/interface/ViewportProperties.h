@@ -4,7 +4,7 @@
 
 #include "../Bounds.hpp"
 #include "../constants.h"
-#include "../nodegraph/Scene.h"
+#include "../gl/RenderScene.h"
 #include "Panel.hpp"
 #include "Signal.hpp"
 #include "Window.h"
@@ -26,14 +26,14 @@ public:
     void setChannel(Channel channel);
     void setLayer(const std::string &layer);
     void setPixelPreview(PixelPreview *preview);
-    void setScene(Scene *scene);
+    void setScene(RenderScene *scene);
 
     std::string selectedLayer() const;
 
     void draw() override;
 
 protected:
-    Scene *m_scene = nullptr;
+    RenderScene *m_scene = nullptr;
     std::string m_layer = DEFAULT_LAYER;
     Channel m_channel = Channel_All;
     PixelPreview *m_pixelPreview;
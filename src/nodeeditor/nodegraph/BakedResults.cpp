@@ -0,0 +1,343 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../log.h"
+#include "BakedResults.h"
+#include "Compression.h"
+
+/*
+File layout, all little endian:
+    FileHeader
+    Chunk data
+    Index, found at FileHeader::indexOffset:
+        uint32_t number of results
+        ResultRecord, for each result
+            LayerRecord and name, for each layer
+                ChunkRecord, for each chunk
+*/
+static const char FILE_MAGIC[4] = {'N', 'E', 'B', 'R'};
+static const uint32_t FILE_VERSION = 1;
+// Layers are compressed in chunks of this many bytes so a chunk's buffers stay small
+static const size_t CHUNK_SIZE = 1 << 20;
+// Bytes grouped together by the shuffle, ie, the size of a float channel
+static const size_t SHUFFLE_ELEMENT_SIZE = 4;
+
+struct FileHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint64_t indexOffset;
+};
+
+struct ResultRecord
+{
+    uint64_t key;
+    uint32_t numLayers;
+    uint32_t reserved;
+};
+
+struct LayerRecord
+{
+    uint32_t nameLength;
+    int32_t width;
+    int32_t height;
+    int32_t format;
+    uint64_t byteSize;
+    uint32_t numChunks;
+    uint32_t reserved;
+};
+
+struct ChunkRecord
+{
+    uint64_t offset;
+    uint64_t storedSize;
+    uint64_t rawSize;
+};
+
+/*
+Decompressed layers of a baked result, owned by the result
+*/
+class DecodedResult : public LayeredResult
+{
+public:
+    size_t byteSize() const override { return m_byteSize; }
+    const std::vector<CachedLayer> &layers() const override { return m_layers; }
+
+    std::vector<std::unique_ptr<char[]>> m_buffers;
+    std::vector<CachedLayer> m_layers;
+    size_t m_byteSize = 0;
+};
+
+BakeWriter::BakeWriter(const std::string &path) : m_path(path), m_tempPath(path + ".tmp")
+{
+    m_file = fopen(m_tempPath.c_str(), "wb");
+    if (!m_file)
+    {
+        LOG_ERROR("Failed to open %s for writing", m_tempPath.c_str());
+        return;
+    }
+    // The index offset is filled in by finish()
+    FileHeader header;
+    std::memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+    header.version = FILE_VERSION;
+    header.indexOffset = 0;
+    write(&header, sizeof(header));
+}
+
+BakeWriter::~BakeWriter()
+{
+    if (m_file)
+    {
+        fclose(m_file);
+        std::remove(m_tempPath.c_str());
+    }
+}
+
+bool BakeWriter::isOk() const { return m_file != nullptr; }
+
+bool BakeWriter::insert(size_t key, const std::vector<CachedLayer> &layers)
+{
+    if (!m_file || contains(key))
+    {
+        return false;
+    }
+    std::vector<Layer> written;
+    for (const CachedLayer &cached : layers)
+    {
+        Layer layer{cached.name, cached.width, cached.height, cached.format, cached.byteSize, {}};
+        const char *data = static_cast<const char *>(cached.data);
+        for (size_t start = 0; start < cached.byteSize; start += CHUNK_SIZE)
+        {
+            size_t rawSize = std::min(CHUNK_SIZE, cached.byteSize - start);
+            m_shuffled.resize(rawSize);
+            m_compressed.resize(compressBound(rawSize));
+            shuffleBytes(data + start, m_shuffled.data(), rawSize, SHUFFLE_ELEMENT_SIZE);
+            size_t storedSize = compressBlock(m_shuffled.data(), rawSize, m_compressed.data(), rawSize - 1);
+            // Stored as is when compression doesn't help, so a reader knows by the size
+            const char *stored = storedSize ? m_compressed.data() : data + start;
+            storedSize = storedSize ? storedSize : rawSize;
+
+            layer.chunks.push_back({m_offset, storedSize, rawSize});
+            if (!write(stored, storedSize))
+            {
+                return false;
+            }
+        }
+        m_rawByteSize += cached.byteSize;
+        written.push_back(std::move(layer));
+    }
+    m_results[key] = std::move(written);
+    return true;
+}
+
+bool BakeWriter::contains(size_t key) const
+{
+    return m_results.find(key) != m_results.end();
+}
+
+bool BakeWriter::finish()
+{
+    if (!m_file)
+    {
+        return false;
+    }
+    uint64_t indexOffset = m_offset;
+    uint32_t numResults = uint32_t(m_results.size());
+    bool ok = write(&numResults, sizeof(numResults));
+    for (const auto &[key, layers] : m_results)
+    {
+        ResultRecord result{key, uint32_t(layers.size()), 0};
+        ok = ok && write(&result, sizeof(result));
+        for (const Layer &layer : layers)
+        {
+            LayerRecord record{uint32_t(layer.name.size()), layer.width, layer.height, layer.format, layer.byteSize,
+                               uint32_t(layer.chunks.size()), 0};
+            ok = ok && write(&record, sizeof(record)) && write(layer.name.data(), layer.name.size());
+            for (const Chunk &chunk : layer.chunks)
+            {
+                ChunkRecord chunkRecord{chunk.offset, chunk.storedSize, chunk.rawSize};
+                ok = ok && write(&chunkRecord, sizeof(chunkRecord));
+            }
+        }
+    }
+    ok = ok && fseek(m_file, long(offsetof(FileHeader, indexOffset)), SEEK_SET) == 0;
+    ok = ok && fwrite(&indexOffset, sizeof(indexOffset), 1, m_file) == 1;
+    ok = fclose(m_file) == 0 && ok;
+    m_file = nullptr;
+    ok = ok && std::rename(m_tempPath.c_str(), m_path.c_str()) == 0;
+    if (!ok)
+    {
+        LOG_ERROR("Failed to write baked results %s", m_path.c_str());
+        std::remove(m_tempPath.c_str());
+    }
+    return ok;
+}
+
+size_t BakeWriter::size() const { return m_results.size(); }
+size_t BakeWriter::rawByteSize() const { return m_rawByteSize; }
+size_t BakeWriter::storedByteSize() const { return m_offset; }
+
+bool BakeWriter::write(const void *data, size_t size)
+{
+    if (fwrite(data, 1, size, m_file) != size)
+    {
+        LOG_ERROR("Failed to write to %s", m_tempPath.c_str());
+        return false;
+    }
+    m_offset += size;
+    return true;
+}
+
+BakedResults::~BakedResults()
+{
+    if (m_data)
+    {
+        munmap(m_data, m_size);
+    }
+}
+
+std::unique_ptr<BakedResults> BakedResults::open(const std::string &path)
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        LOG_WARNING("Failed to open baked results %s", path.c_str());
+        return nullptr;
+    }
+    struct stat info;
+    std::unique_ptr<BakedResults> baked{new BakedResults()};
+    baked->m_path = path;
+    if (fstat(fd, &info) == 0 && size_t(info.st_size) >= sizeof(FileHeader))
+    {
+        baked->m_size = size_t(info.st_size);
+        void *data = mmap(nullptr, baked->m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        baked->m_data = data == MAP_FAILED ? nullptr : data;
+    }
+    // The mapping holds its own reference to the file
+    close(fd);
+    if (!baked->m_data)
+    {
+        return nullptr;
+    }
+
+    const char *bytes = static_cast<const char *>(baked->m_data);
+    size_t size = baked->m_size;
+    FileHeader header;
+    std::memcpy(&header, bytes, sizeof(header));
+    if (std::memcmp(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 || header.version != FILE_VERSION)
+    {
+        LOG_WARNING("Ignoring baked results %s, unknown format", path.c_str());
+        return nullptr;
+    }
+
+    size_t pos = header.indexOffset;
+    auto read = [&](void *value, size_t valueSize)
+    {
+        if (pos > size || valueSize > size - pos)
+        {
+            return false;
+        }
+        std::memcpy(value, bytes + pos, valueSize);
+        pos += valueSize;
+        return true;
+    };
+    uint32_t numResults = 0;
+    bool ok = read(&numResults, sizeof(numResults));
+    for (uint32_t i = 0; ok && i < numResults; ++i)
+    {
+        ResultRecord result;
+        ok = read(&result, sizeof(result));
+        std::vector<Layer> layers;
+        for (uint32_t j = 0; ok && j < result.numLayers; ++j)
+        {
+            LayerRecord record;
+            ok = read(&record, sizeof(record)) && record.nameLength <= size - pos;
+            if (!ok)
+            {
+                break;
+            }
+            Layer layer{std::string(bytes + pos, record.nameLength), record.width, record.height, record.format,
+                        size_t(record.byteSize), {}};
+            pos += record.nameLength;
+            size_t rawSize = 0;
+            for (uint32_t k = 0; ok && k < record.numChunks; ++k)
+            {
+                ChunkRecord chunk;
+                ok = read(&chunk, sizeof(chunk)) && chunk.offset <= size && chunk.storedSize <= size - chunk.offset;
+                if (ok)
+                {
+                    layer.chunks.push_back({bytes + chunk.offset, size_t(chunk.storedSize), size_t(chunk.rawSize)});
+                    rawSize += chunk.rawSize;
+                }
+            }
+            ok = ok && rawSize == layer.byteSize;
+            layers.push_back(std::move(layer));
+        }
+        baked->m_results[result.key] = std::move(layers);
+    }
+    if (!ok)
+    {
+        LOG_WARNING("Ignoring baked results %s, truncated", path.c_str());
+        return nullptr;
+    }
+    LOG_INFO("Opened %lu baked results from %s", baked->m_results.size(), path.c_str());
+    return baked;
+}
+
+size_t BakedResults::size() const { return m_results.size(); }
+
+bool BakedResults::contains(size_t key) const
+{
+    return m_results.find(key) != m_results.end();
+}
+
+std::unique_ptr<LayeredResult> BakedResults::load(size_t key) const
+{
+    auto it = m_results.find(key);
+    if (it == m_results.end())
+    {
+        return nullptr;
+    }
+    auto result = std::make_unique<DecodedResult>();
+    std::vector<char> shuffled;
+    for (const Layer &layer : it->second)
+    {
+        std::unique_ptr<char[]> buffer{new char[layer.byteSize]};
+        size_t offset = 0;
+        for (const Chunk &chunk : layer.chunks)
+        {
+            char *out = buffer.get() + offset;
+            if (chunk.storedSize == chunk.rawSize)
+            {
+                std::memcpy(out, chunk.data, chunk.rawSize);
+            }
+            else
+            {
+                shuffled.resize(chunk.rawSize);
+                if (!decompressBlock(chunk.data, chunk.storedSize, shuffled.data(), chunk.rawSize))
+                {
+                    LOG_WARNING("Ignoring baked result %lu in %s, damaged", key, m_path.c_str());
+                    return nullptr;
+                }
+                unshuffleBytes(shuffled.data(), out, chunk.rawSize, SHUFFLE_ELEMENT_SIZE);
+            }
+            offset += chunk.rawSize;
+        }
+        result->m_layers.push_back({layer.name, layer.width, layer.height, layer.format, buffer.get(), layer.byteSize});
+        result->m_byteSize += layer.byteSize;
+        result->m_buffers.push_back(std::move(buffer));
+    }
+    return result;
+}
@@ -0,0 +1,103 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ResultCache.h"
+
+/*
+Writes results into a single file baked alongside a saved scene, see BakedResults. Layers
+are split into chunks, each shuffled and compressed on its own, or stored as is if that
+doesn't make it smaller. Nothing is found at the path until finish() succeeds.
+*/
+class BakeWriter : public ResultStore
+{
+public:
+    BakeWriter(const std::string &path);
+    ~BakeWriter();
+
+    bool isOk() const;
+    bool insert(size_t key, const std::vector<CachedLayer> &layers) override;
+    bool contains(size_t key) const override;
+    /* Writes the index and moves the file into place. Returns false on failure. */
+    bool finish();
+
+    size_t size() const;
+    /* Bytes of layer data inserted, and written after compression */
+    size_t rawByteSize() const;
+    size_t storedByteSize() const;
+
+protected:
+    struct Chunk
+    {
+        uint64_t offset;
+        uint64_t storedSize;
+        uint64_t rawSize;
+    };
+    struct Layer
+    {
+        std::string name;
+        int width;
+        int height;
+        int format;
+        uint64_t byteSize;
+        std::vector<Chunk> chunks;
+    };
+
+    std::string m_path;
+    std::string m_tempPath;
+    FILE *m_file = nullptr;
+    uint64_t m_offset = 0;
+    size_t m_rawByteSize = 0;
+    std::unordered_map<size_t, std::vector<Layer>> m_results;
+    std::vector<char> m_shuffled;
+    std::vector<char> m_compressed;
+
+    bool write(const void *data, size_t size);
+};
+
+/*
+Results baked with a saved scene, keyed by each node's fingerprint (see Node::fingerprint())
+so a result is only restored while the node's settings and inputs still match. The file
+is memory mapped and a result only decompressed when loaded.
+*/
+class BakedResults
+{
+public:
+    ~BakedResults();
+
+    /* Maps the file, returns nullptr if it can't be read or isn't a baked results file */
+    static std::unique_ptr<BakedResults> open(const std::string &path);
+
+    size_t size() const;
+    bool contains(size_t key) const;
+    /* Decompresses the result for the key, or returns nullptr if it isn't baked or is damaged */
+    std::unique_ptr<LayeredResult> load(size_t key) const;
+
+protected:
+    struct Chunk
+    {
+        const char *data;
+        size_t storedSize;
+        size_t rawSize;
+    };
+    struct Layer
+    {
+        std::string name;
+        int width;
+        int height;
+        int format;
+        size_t byteSize;
+        std::vector<Chunk> chunks;
+    };
+
+    std::string m_path;
+    void *m_data = nullptr;
+    size_t m_size = 0;
+    std::unordered_map<size_t, std::vector<Layer>> m_results;
+
+    BakedResults() = default;
+};
@@ -0,0 +1,579 @@
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../log.h"
+#include "BinarySerializer.h"
+
+/*
+File layout, all little endian:
+    magic, format version
+    Records, each a tag and its value
+*/
+static const char FILE_MAGIC[4] = {'N', 'E', 'S', 'B'};
+static const uint32_t FILE_VERSION = 1;
+static const size_t HEADER_SIZE = sizeof(FILE_MAGIC) + sizeof(FILE_VERSION);
+
+enum RecordTag : uint8_t
+{
+    Tag_Name,        // A property name used for the first time: uint32 length and the name
+    Tag_Property,    // A property name used before: uint32 index in order of first use
+    Tag_ObjectStart, // uint32 length of the object's records, followed by Tag_ObjectEnd
+    Tag_ObjectEnd,
+    Tag_Bool,   // uint8
+    Tag_UInt,   // uint32
+    Tag_Int,    // int32
+    Tag_Float,  // float
+    Tag_Float2, // float[2]
+    Tag_Float3, // float[3]
+    Tag_Float4, // float[4]
+    Tag_Int2,   // int32[2]
+    Tag_String, // uint32 length and the string
+};
+
+// Number of components in a numeric value, or 0 if the tag isn't one
+static int componentsOf(uint8_t tag)
+{
+    switch (tag)
+    {
+    case Tag_Bool:
+    case Tag_UInt:
+    case Tag_Int:
+    case Tag_Float:
+        return 1;
+    case Tag_Float2:
+    case Tag_Int2:
+        return 2;
+    case Tag_Float3:
+        return 3;
+    case Tag_Float4:
+        return 4;
+    }
+    return 0;
+}
+
+// =============================================================================
+// Serializer
+
+BinarySerializer::BinarySerializer(std::ostream *stream) : m_stream(stream)
+{
+    put(FILE_MAGIC, sizeof(FILE_MAGIC));
+    putU32(FILE_VERSION);
+    flush();
+}
+
+bool BinarySerializer::isOk() const
+{
+    return m_stream->good();
+}
+bool BinarySerializer::startObject(const std::string &type)
+{
+    putName(type);
+    putTag(Tag_ObjectStart);
+    m_objects.push_back(m_buffer.size());
+    putU32(0);
+    return isOk();
+}
+bool BinarySerializer::finishObject()
+{
+    if (m_objects.empty())
+    {
+        LOG_ERROR("Attempting to finish object without having started one");
+        return false;
+    }
+    size_t start = m_objects.back();
+    m_objects.pop_back();
+    uint32_t length = uint32_t(m_buffer.size() - start - sizeof(uint32_t));
+    std::memcpy(m_buffer.data() + start, &length, sizeof(length));
+    putTag(Tag_ObjectEnd);
+    return flush();
+}
+
+void BinarySerializer::put(const void *data, size_t size)
+{
+    const char *bytes = static_cast<const char *>(data);
+    m_buffer.insert(m_buffer.end(), bytes, bytes + size);
+}
+void BinarySerializer::putTag(uint8_t tag)
+{
+    m_buffer.push_back(char(tag));
+}
+void BinarySerializer::putU32(uint32_t value)
+{
+    put(&value, sizeof(value));
+}
+void BinarySerializer::putName(const std::string &name)
+{
+    auto it = m_names.find(name);
+    if (it != m_names.end())
+    {
+        putTag(Tag_Property);
+        putU32(it->second);
+        return;
+    }
+    m_names.emplace(name, uint32_t(m_names.size()));
+    putTag(Tag_Name);
+    putU32(uint32_t(name.size()));
+    put(name.data(), name.size());
+}
+bool BinarySerializer::flush()
+{
+    if (m_objects.empty() && !m_buffer.empty())
+    {
+        m_stream->write(m_buffer.data(), m_buffer.size());
+        m_buffer.clear();
+    }
+    return isOk();
+}
+
+// -----------------------------------------------------------------------------
+// Types
+
+bool BinarySerializer::writeUInt(unsigned int value)
+{
+    putTag(Tag_UInt);
+    putU32(value);
+    return flush();
+}
+bool BinarySerializer::writeBool(bool value)
+{
+    putTag(Tag_Bool);
+    m_buffer.push_back(char(value));
+    return flush();
+}
+bool BinarySerializer::writeInt(int value)
+{
+    int32_t i = value;
+    putTag(Tag_Int);
+    put(&i, sizeof(i));
+    return flush();
+}
+bool BinarySerializer::writeFloat(float value)
+{
+    putTag(Tag_Float);
+    put(&value, sizeof(value));
+    return flush();
+}
+bool BinarySerializer::writeFloat2(const glm::vec2 &value)
+{
+    putTag(Tag_Float2);
+    put(&value[0], sizeof(float) * 2);
+    return flush();
+}
+bool BinarySerializer::writeFloat3(const glm::vec3 &value)
+{
+    putTag(Tag_Float3);
+    put(&value[0], sizeof(float) * 3);
+    return flush();
+}
+bool BinarySerializer::writeFloat4(const glm::vec4 &value)
+{
+    putTag(Tag_Float4);
+    put(&value[0], sizeof(float) * 4);
+    return flush();
+}
+bool BinarySerializer::writeInt2(const glm::ivec2 &value)
+{
+    int32_t i[2] = {value.x, value.y};
+    putTag(Tag_Int2);
+    put(i, sizeof(i));
+    return flush();
+}
+bool BinarySerializer::writeString(const std::string &value)
+{
+    putTag(Tag_String);
+    putU32(uint32_t(value.size()));
+    put(value.data(), value.size());
+    return flush();
+}
+
+// -----------------------------------------------------------------------------
+// Properties
+
+bool BinarySerializer::writePropertyUInt(const std::string &name, unsigned int value)
+{
+    putName(name);
+    return writeUInt(value);
+}
+bool BinarySerializer::writePropertyBool(const std::string &name, bool value)
+{
+    putName(name);
+    return writeBool(value);
+}
+bool BinarySerializer::writePropertyInt(const std::string &name, int value)
+{
+    putName(name);
+    return writeInt(value);
+}
+bool BinarySerializer::writePropertyFloat(const std::string &name, float value)
+{
+    putName(name);
+    return writeFloat(value);
+}
+bool BinarySerializer::writePropertyFloat2(const std::string &name, const glm::vec2 &value)
+{
+    putName(name);
+    return writeFloat2(value);
+}
+bool BinarySerializer::writePropertyFloat3(const std::string &name, const glm::vec3 &value)
+{
+    putName(name);
+    return writeFloat3(value);
+}
+bool BinarySerializer::writePropertyFloat4(const std::string &name, const glm::vec4 &value)
+{
+    putName(name);
+    return writeFloat4(value);
+}
+bool BinarySerializer::writePropertyInt2(const std::string &name, const glm::ivec2 &value)
+{
+    putName(name);
+    return writeInt2(value);
+}
+bool BinarySerializer::writePropertyString(const std::string &name, const std::string &value)
+{
+    putName(name);
+    return writeString(value);
+}
+
+// =============================================================================
+// Deserializer
+
+BinaryDeserializer::BinaryDeserializer(const char *data, size_t size) : Deserializer(), m_data(data), m_size(size), m_pos(HEADER_SIZE)
+{
+    if (!isBinary(data, size))
+    {
+        fail("Missing binary scene header");
+    }
+}
+BinaryDeserializer::~BinaryDeserializer()
+{
+    if (m_mapping)
+    {
+        munmap(m_mapping, m_size);
+    }
+}
+
+bool BinaryDeserializer::isBinary(const char *data, size_t size)
+{
+    uint32_t version;
+    if (size < HEADER_SIZE || std::memcmp(data, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0)
+    {
+        return false;
+    }
+    std::memcpy(&version, data + sizeof(FILE_MAGIC), sizeof(version));
+    return version == FILE_VERSION;
+}
+
+std::unique_ptr<BinaryDeserializer> BinaryDeserializer::open(const std::string &path)
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return nullptr;
+    }
+    struct stat info;
+    void *mapping = MAP_FAILED;
+    size_t size = 0;
+    if (fstat(fd, &info) == 0 && size_t(info.st_size) >= HEADER_SIZE)
+    {
+        size = size_t(info.st_size);
+        mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    // The mapping holds its own reference to the file
+    close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        return nullptr;
+    }
+    if (!isBinary(static_cast<const char *>(mapping), size))
+    {
+        munmap(mapping, size);
+        return nullptr;
+    }
+    // The file is read front to back once
+    madvise(mapping, size, MADV_SEQUENTIAL);
+    std::unique_ptr<BinaryDeserializer> deserializer = std::make_unique<BinaryDeserializer>(static_cast<const char *>(mapping), size);
+    deserializer->m_mapping = mapping;
+    return deserializer;
+}
+
+bool BinaryDeserializer::isOk() const
+{
+    return m_isOk;
+}
+
+size_t BinaryDeserializer::limit() const
+{
+    return m_objectEnds.empty() ? m_size : m_objectEnds.back();
+}
+bool BinaryDeserializer::fail(const char *message)
+{
+    if (m_isOk)
+    {
+        LOG_ERROR("%s at byte %lu", message, m_pos);
+    }
+    m_isOk = false;
+    return false;
+}
+bool BinaryDeserializer::take(void *data, size_t size)
+{
+    if (!m_isOk || size > limit() - m_pos)
+    {
+        return fail("Unexpected end of data");
+    }
+    std::memcpy(data, m_data + m_pos, size);
+    m_pos += size;
+    return true;
+}
+bool BinaryDeserializer::takeU32(uint32_t &value)
+{
+    return take(&value, sizeof(value));
+}
+bool BinaryDeserializer::takeString(std::string &value)
+{
+    uint32_t length;
+    if (!takeU32(length) || length > limit() - m_pos)
+    {
+        return fail("Unexpected end of data");
+    }
+    value.assign(m_data + m_pos, length);
+    m_pos += length;
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// Types
+
+// Whether a value read from the file converts to an integer T without leaving its range,
+// which is undefined for floats, eg, from a damaged file
+template <typename T, typename V>
+static bool fitsIn(V value)
+{
+    if constexpr (std::is_integral_v<T> && !std::is_same_v<T, bool>)
+    {
+        return std::isfinite(double(value)) && double(value) >= double(std::numeric_limits<T>::min()) &&
+               double(value) <= double(std::numeric_limits<T>::max());
+    }
+    return true;
+}
+
+template <typename T>
+bool BinaryDeserializer::readComponents(T *values, int count)
+{
+    uint8_t tag;
+    if (!take(&tag, sizeof(tag)))
+    {
+        return false;
+    }
+    int numComponents = componentsOf(tag);
+    if (numComponents == 0)
+    {
+        return fail("Expected a numeric value");
+    }
+    if (numComponents != count)
+    {
+        return fail("Value has the wrong number of components");
+    }
+
+    bool ok = true;
+    for (int i = 0; ok && i < count; ++i)
+    {
+        if (tag == Tag_Bool)
+        {
+            uint8_t b;
+            ok = take(&b, sizeof(b));
+            values[i] = T(b);
+        }
+        else if (tag == Tag_UInt)
+        {
+            uint32_t u;
+            ok = take(&u, sizeof(u)) && fitsIn<T>(u);
+            values[i] = ok ? T(u) : T();
+        }
+        else if (tag == Tag_Int || tag == Tag_Int2)
+        {
+            int32_t n;
+            ok = take(&n, sizeof(n)) && fitsIn<T>(n);
+            values[i] = ok ? T(n) : T();
+        }
+        else
+        {
+            float f;
+            ok = take(&f, sizeof(f)) && fitsIn<T>(f);
+            values[i] = ok ? T(f) : T();
+        }
+    }
+    return ok || fail("Value is out of range");
+}
+
+bool BinaryDeserializer::readUInt(unsigned int &value)
+{
+    return readComponents(&value, 1);
+}
+bool BinaryDeserializer::readBool(bool &value)
+{
+    return readComponents(&value, 1);
+}
+bool BinaryDeserializer::readInt(int &value)
+{
+    return readComponents(&value, 1);
+}
+bool BinaryDeserializer::readFloat(float &value)
+{
+    return readComponents(&value, 1);
+}
+bool BinaryDeserializer::readFloat2(glm::vec2 &value)
+{
+    return readComponents(&value[0], 2);
+}
+bool BinaryDeserializer::readFloat3(glm::vec3 &value)
+{
+    return readComponents(&value[0], 3);
+}
+bool BinaryDeserializer::readFloat4(glm::vec4 &value)
+{
+    return readComponents(&value[0], 4);
+}
+bool BinaryDeserializer::readInt2(glm::ivec2 &value)
+{
+    return readComponents(&value[0], 2);
+}
+bool BinaryDeserializer::readString(std::string &value)
+{
+    uint8_t tag;
+    if (!take(&tag, sizeof(tag)))
+    {
+        return false;
+    }
+    if (tag != Tag_String)
+    {
+        return fail("Expected a string");
+    }
+    return takeString(value);
+}
+
+// -----------------------------------------------------------------------------
+// Objects
+
+bool BinaryDeserializer::readProperty(std::string &name)
+{
+    // The end of the object or data is left for finishReadObject()
+    if (!m_isOk || m_pos >= limit() || uint8_t(m_data[m_pos]) == Tag_ObjectEnd)
+    {
+        return false;
+    }
+
+    uint8_t tag = uint8_t(m_data[m_pos++]);
+    if (tag == Tag_Name)
+    {
+        std::string text;
+        if (!takeString(text))
+        {
+            return false;
+        }
+        m_names.push_back(text);
+        name = std::move(text);
+        return true;
+    }
+    uint32_t index;
+    if (tag != Tag_Property)
+    {
+        return fail("Expected a property");
+    }
+    if (!takeU32(index))
+    {
+        return false;
+    }
+    if (index >= m_names.size())
+    {
+        return fail("Unknown property name");
+    }
+    name = m_names[index];
+    return true;
+}
+bool BinaryDeserializer::startReadObject()
+{
+    uint8_t tag;
+    uint32_t length;
+    if (!take(&tag, sizeof(tag)) || tag != Tag_ObjectStart || !takeU32(length))
+    {
+        return fail("Expected an object");
+    }
+    if (length > limit() - m_pos)
+    {
+        return fail("Object is truncated");
+    }
+    m_objectEnds.push_back(m_pos + length);
+    return true;
+}
+bool BinaryDeserializer::finishReadObject()
+{
+    if (m_objectEnds.empty())
+    {
+        return fail("Attempting to finish object without having started one");
+    }
+    size_t end = m_objectEnds.back();
+    if (m_pos < end)
+    {
+        LOG_WARNING("Finished reading object but discarded %lu bytes", end - m_pos);
+        while (m_isOk && m_pos < end)
+        {
+            skipRecord();
+        }
+    }
+    m_objectEnds.pop_back();
+    uint8_t tag;
+    if (!take(&tag, sizeof(tag)) || tag != Tag_ObjectEnd)
+    {
+        return fail("Expected the end of an object");
+    }
+    return true;
+}
+bool BinaryDeserializer::skipRecord()
+{
+    uint8_t tag;
+    if (!take(&tag, sizeof(tag)))
+    {
+        return false;
+    }
+    std::string text;
+    uint32_t length;
+    switch (tag)
+    {
+    case Tag_Name:
+        // Later records may refer to the name by its index
+        if (!takeString(text))
+        {
+            return false;
+        }
+        m_names.push_back(text);
+        return true;
+    case Tag_Property:
+        return takeU32(length);
+    case Tag_ObjectStart:
+        // The object's records are skipped one at a time so no names are missed
+        return takeU32(length);
+    case Tag_ObjectEnd:
+        return true;
+    case Tag_String:
+        return takeString(text);
+    }
+    if (componentsOf(tag) == 0)
+    {
+        return fail("Unknown record");
+    }
+    // Every numeric component is 4 bytes except for bools
+    char value[16];
+    return take(value, tag == Tag_Bool ? 1 : 4 * componentsOf(tag));
+}
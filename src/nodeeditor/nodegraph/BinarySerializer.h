@@ -0,0 +1,120 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Serializer.h"
+
+/*
+Binary equivalent of the StreamSerializer, read back with a BinaryDeserializer.
+
+The file starts with a header identifying the format, followed by a record for each
+call. Each record is a one byte tag followed by its value:
+    - Property names are interned, the first use of a name writes it in full and later
+      uses only its index.
+    - Objects are prefixed with the length of their records, so a reader can skip over
+      an object it doesn't understand.
+    - Values record their type, so reading a value as a different numeric type, eg, an
+      int2 as a float2, converts it as the text format would.
+
+Records are buffered until each top level object is finished, then written to the stream.
+*/
+class BinarySerializer : public Serializer
+{
+public:
+    BinarySerializer(std::ostream *stream);
+
+    bool isOk() const override;
+    bool startObject(const std::string &type) override;
+    bool finishObject() override;
+
+    bool writeUInt(unsigned int value) override;
+    bool writeBool(bool value) override;
+    bool writeInt(int value) override;
+    bool writeFloat(float value) override;
+    bool writeFloat2(const glm::vec2 &value) override;
+    bool writeFloat3(const glm::vec3 &value) override;
+    bool writeFloat4(const glm::vec4 &value) override;
+    bool writeInt2(const glm::ivec2 &value) override;
+    bool writeString(const std::string &value) override;
+
+    bool writePropertyUInt(const std::string &name, unsigned int value) override;
+    bool writePropertyBool(const std::string &name, bool value) override;
+    bool writePropertyInt(const std::string &name, int value) override;
+    bool writePropertyFloat(const std::string &name, float value) override;
+    bool writePropertyFloat2(const std::string &name, const glm::vec2 &value) override;
+    bool writePropertyFloat3(const std::string &name, const glm::vec3 &value) override;
+    bool writePropertyFloat4(const std::string &name, const glm::vec4 &value) override;
+    bool writePropertyInt2(const std::string &name, const glm::ivec2 &value) override;
+    bool writePropertyString(const std::string &name, const std::string &value) override;
+
+protected:
+    std::ostream *m_stream;
+    std::vector<char> m_buffer;
+    // Position of the length of each object being written
+    std::vector<size_t> m_objects;
+    std::unordered_map<std::string, uint32_t> m_names;
+
+    void put(const void *data, size_t size);
+    void putTag(uint8_t tag);
+    void putU32(uint32_t value);
+    void putName(const std::string &name);
+    /* Writes the buffered records once there is no object left to finish */
+    bool flush();
+};
+
+class BinaryDeserializer : public Deserializer
+{
+public:
+    /* Reads data that must outlive the deserializer, which must start with the header */
+    BinaryDeserializer(const char *data, size_t size);
+    ~BinaryDeserializer();
+
+    /* Whether the data starts with the header written by a BinarySerializer */
+    static bool isBinary(const char *data, size_t size);
+    /* Memory maps the file, returns nullptr if it can't be read or isn't in the binary format */
+    static std::unique_ptr<BinaryDeserializer> open(const std::string &path);
+
+    bool isOk() const override;
+
+    bool readUInt(unsigned int &value) override;
+    bool readBool(bool &value) override;
+    bool readInt(int &value) override;
+    bool readFloat(float &value) override;
+    bool readFloat2(glm::vec2 &value) override;
+    bool readFloat3(glm::vec3 &value) override;
+    bool readFloat4(glm::vec4 &value) override;
+    bool readInt2(glm::ivec2 &value) override;
+    bool readString(std::string &value) override;
+
+    bool readProperty(std::string &name) override;
+    bool startReadObject() override;
+    bool finishReadObject() override;
+
+protected:
+    const char *m_data;
+    size_t m_size;
+    size_t m_pos;
+    bool m_isOk = true;
+    std::vector<std::string> m_names;
+    // End of the records of each object being read
+    std::vector<size_t> m_objectEnds;
+    // Set when the data is a mapping owned by the deserializer
+    void *m_mapping = nullptr;
+
+    size_t limit() const;
+    bool fail(const char *message);
+    bool take(void *data, size_t size);
+    bool takeU32(uint32_t &value);
+    bool takeString(std::string &value);
+    /* Reads a value with count components, converting each from the type it was written as */
+    template <typename T>
+    bool readComponents(T *values, int count);
+    /* Moves past the next record, keeping any name it interns */
+    bool skipRecord();
+};
@@ -0,0 +1,7 @@
+#include <atomic>
+
+#include "CancelToken.h"
+
+void CancelToken::cancel() { m_cancelled = true; }
+bool CancelToken::isCancelled() const { return m_cancelled.load(); }
+void CancelToken::reset() { m_cancelled = false; }
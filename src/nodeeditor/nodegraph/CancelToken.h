@@ -0,0 +1,23 @@
+#pragma once
+#include <atomic>
+
+/*
+A flag shared between whoever owns some work and those performing it, so the work can
+be abandoned cooperatively once its result is no longer wanted, eg, the settings it was
+started with have been edited.
+
+Cancelling is thread safe and only ever observed, never enforced. Work that sees the
+token cancelled should return as soon as it can, leaving its output incomplete. Whoever
+cancelled the work is responsible for discarding that output before resetting the token.
+*/
+class CancelToken
+{
+public:
+    void cancel();
+    bool isCancelled() const;
+    /* Clears the cancellation, must only be called once nothing is observing the token */
+    void reset();
+
+protected:
+    std::atomic<bool> m_cancelled{false};
+};
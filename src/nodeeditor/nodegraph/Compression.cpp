@@ -0,0 +1,218 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include "Compression.h"
+
+/*
+Each sequence is a token holding the literal and match lengths, the literals, then the
+offset of the match. Lengths of 15 or more continue in the bytes that follow. The last
+sequence only has literals.
+*/
+static const size_t MIN_MATCH = 4;
+static const size_t MAX_OFFSET = 65535;
+// The last match must start this far before the end, and leave the last bytes as literals
+static const size_t MATCH_START_LIMIT = 12;
+static const size_t LAST_LITERALS = 5;
+static const int HASH_BITS = 14;
+
+static uint32_t hashSequence(const uint8_t *data)
+{
+    uint32_t sequence;
+    std::memcpy(&sequence, data, sizeof(sequence));
+    return (sequence * 2654435761u) >> (32 - HASH_BITS);
+}
+
+// Bytes needed to continue a length of at least 15 past the token
+static size_t lengthBytes(size_t length)
+{
+    return length < 15 ? 0 : (length - 15) / 255 + 1;
+}
+
+static uint8_t *writeLength(uint8_t *out, size_t length)
+{
+    if (length < 15)
+    {
+        return out;
+    }
+    length -= 15;
+    for (; length >= 255; length -= 255)
+    {
+        *out++ = 255;
+    }
+    *out++ = uint8_t(length);
+    return out;
+}
+
+static bool readLength(const uint8_t *&in, const uint8_t *end, size_t &length)
+{
+    if (length < 15)
+    {
+        return true;
+    }
+    uint8_t byte;
+    do
+    {
+        if (in == end)
+        {
+            return false;
+        }
+        byte = *in++;
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+// memcpy is undefined for null pointers even when copying nothing, eg, from an empty vector
+static void copyBytes(void *dst, const void *src, size_t size)
+{
+    if (size > 0)
+    {
+        std::memcpy(dst, src, size);
+    }
+}
+
+size_t compressBound(size_t size)
+{
+    return size + size / 255 + 16;
+}
+
+size_t compressBlock(const char *src, size_t size, char *dst, size_t capacity)
+{
+    const uint8_t *in = reinterpret_cast<const uint8_t *>(src);
+    uint8_t *out = reinterpret_cast<uint8_t *>(dst);
+    uint8_t *outEnd = out + capacity;
+
+    // Most recent position of each hashed sequence, offset by one so zero is empty
+    static thread_local uint32_t table[1 << HASH_BITS];
+    std::memset(table, 0, sizeof(table));
+
+    size_t anchor = 0;
+    size_t pos = 0;
+    while (size > MATCH_START_LIMIT && pos < size - MATCH_START_LIMIT)
+    {
+        uint32_t hash = hashSequence(in + pos);
+        size_t candidate = table[hash];
+        table[hash] = uint32_t(pos + 1);
+        if (candidate == 0 || pos - (candidate - 1) > MAX_OFFSET || std::memcmp(in + candidate - 1, in + pos, MIN_MATCH) != 0)
+        {
+            ++pos;
+            continue;
+        }
+        size_t match = candidate - 1;
+        size_t length = MIN_MATCH;
+        while (pos + length < size - LAST_LITERALS && in[match + length] == in[pos + length])
+        {
+            ++length;
+        }
+
+        size_t numLiterals = pos - anchor;
+        size_t needed = 1 + lengthBytes(numLiterals) + numLiterals + 2 + lengthBytes(length - MIN_MATCH);
+        if (size_t(outEnd - out) < needed)
+        {
+            return 0;
+        }
+        uint8_t *token = out++;
+        *token = uint8_t(std::min<size_t>(numLiterals, 15) << 4 | std::min<size_t>(length - MIN_MATCH, 15));
+        out = writeLength(out, numLiterals);
+        copyBytes(out, in + anchor, numLiterals);
+        out += numLiterals;
+        size_t offset = pos - match;
+        *out++ = uint8_t(offset);
+        *out++ = uint8_t(offset >> 8);
+        out = writeLength(out, length - MIN_MATCH);
+
+        pos += length;
+        anchor = pos;
+    }
+
+    size_t numLiterals = size - anchor;
+    if (size_t(outEnd - out) < 1 + lengthBytes(numLiterals) + numLiterals)
+    {
+        return 0;
+    }
+    *out++ = uint8_t(std::min<size_t>(numLiterals, 15) << 4);
+    out = writeLength(out, numLiterals);
+    copyBytes(out, in + anchor, numLiterals);
+    out += numLiterals;
+    return out - reinterpret_cast<uint8_t *>(dst);
+}
+
+bool decompressBlock(const char *src, size_t srcSize, char *dst, size_t size)
+{
+    const uint8_t *in = reinterpret_cast<const uint8_t *>(src);
+    const uint8_t *inEnd = in + srcSize;
+    uint8_t *out = reinterpret_cast<uint8_t *>(dst);
+    size_t pos = 0;
+    while (in < inEnd)
+    {
+        uint8_t token = *in++;
+        size_t numLiterals = token >> 4;
+        if (!readLength(in, inEnd, numLiterals) || numLiterals > size_t(inEnd - in) || numLiterals > size - pos)
+        {
+            return false;
+        }
+        copyBytes(out + pos, in, numLiterals);
+        in += numLiterals;
+        pos += numLiterals;
+        if (in == inEnd)
+        {
+            break;
+        }
+
+        if (inEnd - in < 2)
+        {
+            return false;
+        }
+        size_t offset = size_t(in[0]) | size_t(in[1]) << 8;
+        in += 2;
+        size_t length = token & 15;
+        if (offset == 0 || offset > pos || !readLength(in, inEnd, length) || length + MIN_MATCH > size - pos)
+        {
+            return false;
+        }
+        length += MIN_MATCH;
+        // Matches may overlap the bytes they produce, eg, a run of one byte
+        if (offset >= length)
+        {
+            std::memcpy(out + pos, out + pos - offset, length);
+        }
+        else
+        {
+            for (size_t i = 0; i < length; ++i)
+            {
+                out[pos + i] = out[pos + i - offset];
+            }
+        }
+        pos += length;
+    }
+    return pos == size;
+}
+
+void shuffleBytes(const char *src, char *dst, size_t size, size_t elementSize)
+{
+    size_t numElements = size / elementSize;
+    for (size_t byte = 0; byte < elementSize; ++byte)
+    {
+        char *plane = dst + byte * numElements;
+        for (size_t i = 0; i < numElements; ++i)
+        {
+            plane[i] = src[i * elementSize + byte];
+        }
+    }
+    copyBytes(dst + numElements * elementSize, src + numElements * elementSize, size - numElements * elementSize);
+}
+
+void unshuffleBytes(const char *src, char *dst, size_t size, size_t elementSize)
+{
+    size_t numElements = size / elementSize;
+    for (size_t byte = 0; byte < elementSize; ++byte)
+    {
+        const char *plane = src + byte * numElements;
+        for (size_t i = 0; i < numElements; ++i)
+        {
+            dst[i * elementSize + byte] = plane[i];
+        }
+    }
+    copyBytes(dst + numElements * elementSize, src + numElements * elementSize, size - numElements * elementSize);
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <cstddef>
+
+/*
+Lightweight compression for result data, written in the LZ4 block format so it favours
+speed over ratio. Image data compresses far better once shuffled, see shuffleBytes().
+*/
+
+/* Largest size compressBlock() can produce for size bytes */
+size_t compressBound(size_t size);
+/* Compresses the bytes into dst, returning the compressed size, or 0 if it doesn't fit in capacity */
+size_t compressBlock(const char *src, size_t size, char *dst, size_t capacity);
+/* Decompresses a block into dst, returning false unless it decodes to exactly size bytes */
+bool decompressBlock(const char *src, size_t srcSize, char *dst, size_t size);
+
+/*
+Groups the first byte of every element together, then the second, and so on, eg, so the
+exponents of neighbouring floats are next to each other. Any bytes past the last whole
+element are copied as is.
+*/
+void shuffleBytes(const char *src, char *dst, size_t size, size_t elementSize);
+/* Reverses shuffleBytes() */
+void unshuffleBytes(const char *src, char *dst, size_t size, size_t elementSize);
@@ -3,6 +3,7 @@
 #include <vector>
 
 #include "Connector.h"
+#include "Graph.h"
 #include "Node.h"
 
 Connector::Connector(Node *node, Type type, size_t index, const std::string &name, int maxConnections, bool isRequired) : GraphElement({0, 0, 15, 8}), m_node(node), m_type(type), m_index(index), m_name(name), m_maxConnections(maxConnections), m_required(isRequired)
@@ -11,7 +12,13 @@ Connector::Connector(Node *node, Type type, size_t index, const std::string &nam
 
 bool Connector::connect(Connector *connector)
 {
-    if (connector->m_node == m_node || m_type == connector->type() || isFull() || connector->isFull())
+    if (!canConnect(connector) || isFull() || connector->isFull())
+        return false;
+    // Keeps the graph's topological order, refusing connections that form a cycle
+    Node *upstream = m_type == Output ? m_node : connector->node();
+    Node *downstream = m_type == Output ? connector->node() : m_node;
+    Graph *graph = m_node->graph();
+    if (graph && graph == connector->node()->graph() && !graph->orderConnection(upstream, downstream))
         return false;
 
     m_connected.push_back(connector);
@@ -29,6 +36,10 @@ bool Connector::connect(Connector *connector)
     }
     return true;
 }
+bool Connector::canConnect(Connector const *connector) const
+{
+    return connector->m_node != m_node && m_type != connector->type();
+}
 bool Connector::disconnectConnection(std::vector<Connector *>::reverse_iterator it)
 {
     if (it != m_connected.rend())
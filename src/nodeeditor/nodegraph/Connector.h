@@ -19,7 +19,10 @@ public:
 
     Connector(Node *node, Type type, size_t index, const std::string &name, int maxConnections = -1, bool isRequired = true);
 
+    /* Returns false if the connectors can't be connected, eg, if it would form a cycle */
     bool connect(Connector *connector);
+    /* Whether the connectors could be connected if neither were full, ie, an input and output of different nodes */
+    bool canConnect(Connector const *connector) const;
     bool disconnect(Connector *connector);
     void disconnectAll();
     Type type() const;
@@ -0,0 +1,293 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../log.h"
+#include "DiskCache.h"
+
+/*
+File layout, all little endian:
+    FileHeader
+    LayerRecord and name, for each layer
+    Layer data, each starting on a DATA_ALIGNMENT boundary
+*/
+static const char FILE_MAGIC[4] = {'N', 'E', 'R', 'C'};
+static const uint32_t FILE_VERSION = 1;
+static const size_t DATA_ALIGNMENT = 64;
+static const std::string FILE_EXTENSION = ".result";
+
+struct FileHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t numLayers;
+    uint32_t reserved;
+};
+
+struct LayerRecord
+{
+    uint32_t nameLength;
+    int32_t width;
+    int32_t height;
+    int32_t format;
+    uint64_t offset;
+    uint64_t byteSize;
+};
+
+static size_t alignData(size_t offset) { return (offset + DATA_ALIGNMENT - 1) / DATA_ALIGNMENT * DATA_ALIGNMENT; }
+
+MappedResult::~MappedResult()
+{
+    if (m_data)
+    {
+        munmap(m_data, m_size);
+    }
+}
+
+std::unique_ptr<MappedResult> MappedResult::open(const std::string &path)
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return nullptr;
+    }
+    struct stat info;
+    std::unique_ptr<MappedResult> result{new MappedResult()};
+    if (fstat(fd, &info) == 0 && size_t(info.st_size) >= sizeof(FileHeader))
+    {
+        result->m_size = size_t(info.st_size);
+        void *data = mmap(nullptr, result->m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        result->m_data = data == MAP_FAILED ? nullptr : data;
+    }
+    // The mapping holds its own reference to the file
+    close(fd);
+    if (!result->m_data)
+    {
+        return nullptr;
+    }
+
+    const char *bytes = static_cast<const char *>(result->m_data);
+    FileHeader header;
+    std::memcpy(&header, bytes, sizeof(header));
+    if (std::memcmp(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 || header.version != FILE_VERSION)
+    {
+        LOG_WARNING("Ignoring cached result %s, unknown format", path.c_str());
+        return nullptr;
+    }
+
+    size_t pos = sizeof(header);
+    for (uint32_t i = 0; i < header.numLayers; ++i)
+    {
+        LayerRecord record;
+        if (pos + sizeof(record) > result->m_size)
+        {
+            return nullptr;
+        }
+        std::memcpy(&record, bytes + pos, sizeof(record));
+        pos += sizeof(record);
+        if (pos + record.nameLength > result->m_size || record.offset > result->m_size || record.byteSize > result->m_size - record.offset)
+        {
+            LOG_WARNING("Ignoring cached result %s, truncated", path.c_str());
+            return nullptr;
+        }
+        result->m_layers.push_back({std::string(bytes + pos, record.nameLength), record.width, record.height, record.format,
+                                    bytes + record.offset, size_t(record.byteSize)});
+        pos += record.nameLength;
+    }
+    return result;
+}
+
+size_t MappedResult::byteSize() const { return m_size; }
+const std::vector<CachedLayer> &MappedResult::layers() const { return m_layers; }
+
+DiskCache::DiskCache(const std::string &directory, size_t capacityBytes) : m_directory(directory), m_capacity(capacityBytes)
+{
+    std::error_code error;
+    std::filesystem::create_directories(m_directory, error);
+    if (error)
+    {
+        LOG_ERROR("Failed to create cache directory %s: %s", m_directory.c_str(), error.message().c_str());
+        return;
+    }
+
+    struct Found
+    {
+        Entry entry;
+        std::filesystem::file_time_type lastUsed;
+    };
+    std::vector<Found> found;
+    for (const auto &file : std::filesystem::directory_iterator(m_directory, error))
+    {
+        if (file.path().extension() != FILE_EXTENSION)
+        {
+            continue;
+        }
+        std::string stem = file.path().stem().string();
+        char *end = nullptr;
+        size_t key = std::strtoull(stem.c_str(), &end, 16);
+        if (stem.empty() || *end != '\0')
+        {
+            continue;
+        }
+        found.push_back({{key, size_t(file.file_size(error))}, file.last_write_time(error)});
+    }
+    std::sort(found.begin(), found.end(), [](const Found &a, const Found &b)
+              { return a.lastUsed > b.lastUsed; });
+    for (const Found &result : found)
+    {
+        m_entries.push_back(result.entry);
+        m_lookup[result.entry.key] = std::prev(m_entries.end());
+        m_byteSize += result.entry.byteSize;
+    }
+    LOG_INFO("Disk cache %s holds %lu results (%lu bytes)", m_directory.c_str(), m_entries.size(), m_byteSize);
+    evict();
+}
+
+const std::string &DiskCache::directory() const { return m_directory; }
+size_t DiskCache::capacity() const { return m_capacity; }
+void DiskCache::setCapacity(size_t capacityBytes)
+{
+    m_capacity = capacityBytes;
+    evict();
+}
+size_t DiskCache::size() const { return m_entries.size(); }
+size_t DiskCache::byteSize() const { return m_byteSize; }
+
+bool DiskCache::insert(size_t key, const std::vector<CachedLayer> &layers)
+{
+    auto existing = m_lookup.find(key);
+    if (existing != m_lookup.end())
+    {
+        erase(existing->second);
+    }
+
+    // Layer data is placed after every record so the records can be written first
+    size_t offset = sizeof(FileHeader);
+    for (const CachedLayer &layer : layers)
+    {
+        offset += sizeof(LayerRecord) + layer.name.size();
+    }
+    std::vector<LayerRecord> records;
+    for (const CachedLayer &layer : layers)
+    {
+        offset = alignData(offset);
+        records.push_back({uint32_t(layer.name.size()), layer.width, layer.height, layer.format, offset, layer.byteSize});
+        offset += layer.byteSize;
+    }
+
+    // Written to a temporary file first so a partly written result is never found
+    std::string filepath = path(key);
+    std::string tempPath = filepath + ".tmp";
+    FILE *file = fopen(tempPath.c_str(), "wb");
+    if (!file)
+    {
+        LOG_ERROR("Failed to open %s for writing", tempPath.c_str());
+        return false;
+    }
+    FileHeader header;
+    std::memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+    header.version = FILE_VERSION;
+    header.numLayers = uint32_t(layers.size());
+    header.reserved = 0;
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    for (size_t i = 0; ok && i < layers.size(); ++i)
+    {
+        ok = fwrite(&records[i], sizeof(LayerRecord), 1, file) == 1;
+        ok = ok && fwrite(layers[i].name.data(), 1, layers[i].name.size(), file) == layers[i].name.size();
+    }
+    for (size_t i = 0; ok && i < layers.size(); ++i)
+    {
+        ok = fseek(file, long(records[i].offset), SEEK_SET) == 0;
+        ok = ok && fwrite(layers[i].data, 1, layers[i].byteSize, file) == layers[i].byteSize;
+    }
+    ok = fclose(file) == 0 && ok;
+    ok = ok && std::rename(tempPath.c_str(), filepath.c_str()) == 0;
+    if (!ok)
+    {
+        LOG_ERROR("Failed to write cached result %s", filepath.c_str());
+        std::remove(tempPath.c_str());
+        return false;
+    }
+
+    m_byteSize += offset;
+    m_entries.push_front({key, offset});
+    m_lookup[key] = m_entries.begin();
+    LOG_DEBUG("Stored result %lu on disk, cache holds %lu results (%lu bytes)", key, m_entries.size(), m_byteSize);
+    evict();
+    return true;
+}
+
+bool DiskCache::contains(size_t key) const
+{
+    return m_lookup.find(key) != m_lookup.end();
+}
+
+std::unique_ptr<MappedResult> DiskCache::load(size_t key)
+{
+    auto it = m_lookup.find(key);
+    if (it == m_lookup.end())
+    {
+        return nullptr;
+    }
+    std::unique_ptr<MappedResult> result = MappedResult::open(path(key));
+    if (!result)
+    {
+        // Deleted or damaged outside of the cache
+        erase(it->second);
+        return nullptr;
+    }
+    touch(it->second);
+    return result;
+}
+
+void DiskCache::clear()
+{
+    while (!m_entries.empty())
+    {
+        erase(m_entries.begin());
+    }
+}
+
+std::string DiskCache::path(size_t key) const
+{
+    char name[32];
+    snprintf(name, sizeof(name), "%016lx", key);
+    return (std::filesystem::path(m_directory) / (name + FILE_EXTENSION)).string();
+}
+
+void DiskCache::touch(std::list<Entry>::iterator it)
+{
+    m_entries.splice(m_entries.begin(), m_entries, it);
+    std::error_code error;
+    std::filesystem::last_write_time(path(it->key), std::filesystem::file_time_type::clock::now(), error);
+}
+
+void DiskCache::erase(std::list<Entry>::iterator it)
+{
+    std::remove(path(it->key).c_str());
+    m_byteSize -= it->byteSize;
+    m_lookup.erase(it->key);
+    m_entries.erase(it);
+}
+
+void DiskCache::evict()
+{
+    while (m_byteSize > m_capacity && !m_entries.empty())
+    {
+        LOG_DEBUG("Evicting result %lu from disk", m_entries.back().key);
+        erase(std::prev(m_entries.end()));
+    }
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ResultCache.h"
+
+/*
+A result read from a DiskCache. The file is memory mapped, so the layers' data is only
+read from disk as it's used, and stays valid until the result is destroyed.
+*/
+class MappedResult : public LayeredResult
+{
+public:
+    ~MappedResult();
+
+    /* Maps the file, returns nullptr if it isn't a valid result file */
+    static std::unique_ptr<MappedResult> open(const std::string &path);
+
+    size_t byteSize() const override;
+    const std::vector<CachedLayer> &layers() const override;
+
+protected:
+    void *m_data = nullptr;
+    size_t m_size = 0;
+    std::vector<CachedLayer> m_layers;
+
+    MappedResult() = default;
+};
+
+/*
+Results kept on disk across sessions, one file per result in a directory, keyed by the
+node's fingerprint (see Node::fingerprint()). Layers are stored uncompressed, aligned so
+that a mapped file can be handed straight to the GPU.
+
+Files are evicted least recently used first once their total size exceeds the capacity.
+Use is tracked through each file's modification time, so the order survives restarts.
+Must only be used from one thread at a time.
+*/
+class DiskCache : public ResultStore
+{
+public:
+    /* Creates the directory if needed and indexes any results already in it */
+    DiskCache(const std::string &directory, size_t capacityBytes);
+
+    const std::string &directory() const;
+    size_t capacity() const;
+    void setCapacity(size_t capacityBytes);
+    size_t size() const;
+    size_t byteSize() const;
+
+    /* Writes the layers under the key, replacing any existing result. Returns false on failure. */
+    bool insert(size_t key, const std::vector<CachedLayer> &layers) override;
+    bool contains(size_t key) const override;
+    /* Maps the result for the key, or returns nullptr if it isn't cached or can't be read */
+    std::unique_ptr<MappedResult> load(size_t key);
+    /* Deletes every result */
+    void clear();
+
+protected:
+    struct Entry
+    {
+        size_t key;
+        size_t byteSize;
+    };
+
+    std::string m_directory;
+    size_t m_capacity;
+    size_t m_byteSize = 0;
+    // Most recently used results are at the front
+    std::list<Entry> m_entries;
+    std::unordered_map<size_t, std::list<Entry>::iterator> m_lookup;
+
+    std::string path(size_t key) const;
+    void touch(std::list<Entry>::iterator it);
+    void erase(std::list<Entry>::iterator it);
+    void evict();
+};
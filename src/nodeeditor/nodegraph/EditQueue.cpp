@@ -0,0 +1,46 @@
+#include <atomic>
+#include <functional>
+#include <utility>
+
+#include "EditQueue.h"
+
+EditQueue::EditQueue() : m_head(new Item()), m_tail(m_head.load()) {}
+EditQueue::~EditQueue()
+{
+    // Unapplied edits are discarded
+    while (m_tail)
+    {
+        Item *next = m_tail->next.load();
+        delete m_tail;
+        m_tail = next;
+    }
+}
+
+void EditQueue::push(Edit edit)
+{
+    Item *item = new Item();
+    item->edit = std::move(edit);
+    Item *prev = m_head.exchange(item, std::memory_order_acq_rel);
+    prev->next.store(item, std::memory_order_release);
+}
+
+bool EditQueue::empty() const
+{
+    return m_tail->next.load(std::memory_order_acquire) == nullptr;
+}
+
+size_t EditQueue::apply()
+{
+    size_t count = 0;
+    Item *next;
+    while ((next = m_tail->next.load(std::memory_order_acquire)))
+    {
+        // The applied item becomes the new tail
+        Edit edit = std::move(next->edit);
+        delete m_tail;
+        m_tail = next;
+        edit();
+        ++count;
+    }
+    return count;
+}
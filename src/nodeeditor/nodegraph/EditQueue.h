@@ -0,0 +1,45 @@
+#pragma once
+#include <atomic>
+#include <functional>
+
+/*
+Edits to the graph made by any number of threads, eg, the UI, applied in the order
+they were pushed by the single thread that owns the graph, ie, the processing thread.
+
+Pushing is lock-free so the UI never waits on processing. Each edit is a linked item:
+producers atomically swap themselves in as the head and then link the previous head to
+them, and the consumer follows the links from the tail. An edit whose producer has not
+yet linked it is picked up by the next call to apply().
+*/
+class EditQueue
+{
+public:
+    typedef std::function<void()> Edit;
+
+    EditQueue();
+    ~EditQueue();
+    EditQueue(const EditQueue &) = delete;
+    EditQueue &operator=(const EditQueue &) = delete;
+
+    /* Queues the edit. Thread safe. */
+    void push(Edit edit);
+    /* Whether there is no edit waiting to be applied. Only called from the consuming thread. */
+    bool empty() const;
+    /*
+    Applies every edit queued so far in order, including any pushed by the edits
+    themselves. Only called from the consuming thread. Returns the number applied.
+    */
+    size_t apply();
+
+protected:
+    struct Item
+    {
+        Edit edit;
+        std::atomic<Item *> next{nullptr};
+    };
+
+    // Most recently pushed item, swapped by producers
+    std::atomic<Item *> m_head;
+    // Item whose edit has already been applied, only touched by the consumer
+    Item *m_tail;
+};
@@ -1,13 +1,43 @@
+#include <algorithm>
+#include <atomic>
+#include <memory>
 #include <string>
 #include <vector>
 
 #include "../log.h"
+#include "GraphSnapshot.h"
 #include "Node.h"
 #include "OperatorRegistry.hpp"
 
 #include "Graph.h"
 
-NodeID Graph::lastID = 0;
+std::atomic<NodeID> Graph::lastID{0};
+
+Graph::~Graph()
+{
+    clear();
+}
+Graph::Graph(Graph &&graph)
+{
+    *this = std::move(graph);
+}
+Graph &Graph::operator=(Graph &&graph)
+{
+    clear();
+    m_nodes = std::move(graph.m_nodes);
+    m_indices = std::move(graph.m_indices);
+    m_order = std::move(graph.m_order);
+    m_outputByteSize = graph.m_outputByteSize;
+    for (const auto &node : m_nodes)
+    {
+        node->m_graph = this;
+    }
+    graph.m_nodes.clear();
+    graph.m_indices.clear();
+    graph.m_order.clear();
+    graph.m_outputByteSize = 0;
+    return *this;
+}
 
 Graph::value_iterator Graph::begin() { return m_nodes.begin(); }
 Graph::value_iterator Graph::end() { return m_nodes.end(); }
@@ -19,34 +49,38 @@ Graph::reverse_value_iterator Graph::rend() { return m_nodes.rend(); }
 bool Graph::createNode(NodeID nodeID, const std::string &nodeType)
 {
     Op::Operator *op = Op::OperatorRegistry::create(nodeType);
-    m_nodes.emplace(
-        std::piecewise_construct,
-        std::forward_as_tuple(nodeID),
-        std::forward_as_tuple(nodeID, op));
+    insert(std::make_shared<Node>(nodeID, op));
     return bool(op);
 }
 NodeID Graph::createNode(const std::string &nodeType)
 {
-    NodeID nodeID = ++lastID;
+    NodeID nodeID = reserveID();
     createNode(nodeID, nodeType);
     return nodeID;
 }
+NodeID Graph::reserveID() { return ++lastID; }
 bool Graph::deleteNode(NodeID nodeID)
 {
-    auto it = m_nodes.find(nodeID);
-    if (it != m_nodes.end())
+    auto it = m_indices.find(nodeID);
+    if (it == m_indices.end())
     {
-        m_nodes.erase(it);
-        return true;
+        return false;
     }
-    return false;
+    size_t index = it->second;
+    // Snapshots may keep the node alive
+    m_nodes[index]->disconnectAll();
+    removeFromOrder(m_nodes[index].get());
+    m_nodes.erase(m_nodes.begin() + index);
+    m_indices.erase(it);
+    reindex(index);
+    return true;
 }
 Node *Graph::node(NodeID nodeID)
 {
-    auto it = m_nodes.find(nodeID);
-    if (it != m_nodes.end())
+    auto it = m_indices.find(nodeID);
+    if (it != m_indices.end())
     {
-        return &it->second;
+        return m_nodes[it->second].get();
     }
     return nullptr;
 }
@@ -68,38 +102,223 @@ Bounds Graph::bounds() const
 }
 void Graph::clear()
 {
+    for (const auto &node : m_nodes)
+    {
+        node->disconnectAll();
+        node->m_graph = nullptr;
+    }
     m_nodes.clear();
+    m_indices.clear();
+    m_order.clear();
+    m_outputByteSize = 0;
 }
 
-bool Graph::serialize(Serializer *serializer) const
+void Graph::insert(std::shared_ptr<Node> node)
+{
+    // Unconnected, so can go anywhere in the topological order
+    node->m_graph = this;
+    m_outputByteSize += node->m_outputByteSize;
+    node->m_topologicalIndex = m_order.size();
+    m_order.push_back(node.get());
+
+    NodeID nodeID = node->id();
+    auto it = m_indices.find(nodeID);
+    if (it != m_indices.end())
+    {
+        m_nodes[it->second]->disconnectAll();
+        removeFromOrder(m_nodes[it->second].get());
+        m_nodes[it->second] = std::move(node);
+        return;
+    }
+    auto pos = std::upper_bound(m_nodes.begin(), m_nodes.end(), nodeID, [](NodeID id, const std::shared_ptr<Node> &other)
+                                { return id < other->id(); });
+    size_t index = pos - m_nodes.begin();
+    m_nodes.insert(pos, std::move(node));
+    reindex(index);
+}
+void Graph::reindex(size_t start)
+{
+    for (size_t i = start; i < m_nodes.size(); ++i)
+    {
+        m_indices[m_nodes[i]->id()] = i;
+    }
+}
+
+void Graph::removeFromOrder(Node *node)
+{
+    size_t index = node->m_topologicalIndex;
+    m_order.erase(m_order.begin() + index);
+    for (size_t i = index; i < m_order.size(); ++i)
+    {
+        m_order[i]->m_topologicalIndex = i;
+    }
+    m_outputByteSize -= node->m_outputByteSize;
+    node->m_graph = nullptr;
+}
+
+size_t Graph::outputByteSize() const { return m_outputByteSize; }
+const std::vector<Node *> &Graph::topologicalOrder() const { return m_order; }
+
+bool Graph::orderConnection(Node *upstream, Node *downstream)
+{
+    size_t lower = downstream->m_topologicalIndex;
+    size_t upper = upstream->m_topologicalIndex;
+    if (upper < lower)
+    {
+        return true;
+    }
+
+    // Only the nodes ordered between the two are affected: those downstream of the
+    // connection must move after those upstream of it (Pearce and Kelly, 2006)
+    m_marked.resize(m_order.size());
+    m_forward.clear();
+    m_backward.clear();
+    bool ok = collectBetween(downstream, true, lower, upper, m_forward, upstream);
+    if (ok)
+    {
+        collectBetween(upstream, false, lower, upper, m_backward, nullptr);
+    }
+    for (Node *node : m_forward)
+    {
+        m_marked[node->m_topologicalIndex] = false;
+    }
+    for (Node *node : m_backward)
+    {
+        m_marked[node->m_topologicalIndex] = false;
+    }
+    if (!ok)
+    {
+        LOG_WARNING("Connecting %s to %s would form a cycle", upstream->type().c_str(), downstream->type().c_str());
+        return false;
+    }
+
+    // The same positions are reused, upstream nodes first, each in their existing order
+    auto byIndex = [](Node *a, Node *b)
+    { return a->m_topologicalIndex < b->m_topologicalIndex; };
+    std::sort(m_backward.begin(), m_backward.end(), byIndex);
+    std::sort(m_forward.begin(), m_forward.end(), byIndex);
+    m_positions.clear();
+    for (Node *node : m_backward)
+    {
+        m_positions.push_back(node->m_topologicalIndex);
+    }
+    for (Node *node : m_forward)
+    {
+        m_positions.push_back(node->m_topologicalIndex);
+    }
+    std::sort(m_positions.begin(), m_positions.end());
+    size_t i = 0;
+    for (Node *node : m_backward)
+    {
+        node->m_topologicalIndex = m_positions[i++];
+        m_order[node->m_topologicalIndex] = node;
+    }
+    for (Node *node : m_forward)
+    {
+        node->m_topologicalIndex = m_positions[i++];
+        m_order[node->m_topologicalIndex] = node;
+    }
+    return true;
+}
+
+bool Graph::collectBetween(Node *start, bool downstream, size_t lower, size_t upper, std::vector<Node *> &nodes, Node *stop)
 {
-    bool ok = serializer->startObject(KEY_NODES);
-    for (auto it = cbegin(); it != cend(); ++it)
+    m_stack.clear();
+    m_stack.push_back(start);
+    m_marked[start->m_topologicalIndex] = true;
+    while (!m_stack.empty())
     {
-        ok = ok && serializer->startObject(it->type());
-        ok = ok && it->serialize(serializer);
-        ok = ok && serializer->finishObject();
+        Node *node = m_stack.back();
+        m_stack.pop_back();
+        nodes.push_back(node);
+        size_t numConnectors = downstream ? node->numOutputs() : node->numInputs();
+        for (size_t i = 0; i < numConnectors; ++i)
+        {
+            Connector *conn = downstream ? node->output(i) : node->input(i);
+            for (size_t j = 0; j < conn->numConnections(); ++j)
+            {
+                Node *next = conn->connection(j)->node();
+                if (next == stop)
+                {
+                    // Only the collected nodes are unmarked by the caller
+                    for (Node *pending : m_stack)
+                    {
+                        m_marked[pending->m_topologicalIndex] = false;
+                    }
+                    return false;
+                }
+                size_t index = next->m_topologicalIndex;
+                if (index < lower || index > upper || m_marked[index])
+                {
+                    continue;
+                }
+                m_marked[index] = true;
+                m_stack.push_back(next);
+            }
+        }
     }
-    ok = ok && serializer->finishObject();
+    return true;
+}
 
-    ok = ok && serializer->startObject(KEY_INPUTS);
-    for (auto it = cbegin(); it != cend(); ++it)
+void Graph::invalidateDirty(const std::function<void(Node *)> &fn)
+{
+    // Marks are propagated forwards, so every node is seen after all of its inputs
+    m_marked.resize(m_order.size());
+    for (size_t i = 0; i < m_order.size(); ++i)
     {
-        for (size_t i = 0; i < it->numInputs(); ++i)
+        Node *node = m_order[i];
+        if (!m_marked[i] && !node->isDirty())
         {
-            if (it->input(i)->numConnections() == 0)
+            continue;
+        }
+        m_marked[i] = false;
+        for (size_t j = 0; j < node->numOutputs(); ++j)
+        {
+            Connector *conn = node->output(j);
+            for (size_t k = 0; k < conn->numConnections(); ++k)
             {
-                continue;
+                m_marked[conn->connection(k)->node()->m_topologicalIndex] = true;
             }
-            ok = ok && serializer->writePropertyInt(KEY_INPUT, it->id());
-            ok = ok && serializer->writeInt(it->input(i)->index());
-            ok = ok && serializer->writeInt(it->input(i)->connection(0)->node()->id());
-            ok = ok && serializer->writeInt(it->input(i)->connection(0)->index());
         }
+        fn(node);
     }
-    ok = ok && serializer->finishObject();
+}
 
-    return ok;
+std::shared_ptr<GraphSnapshot const> Graph::snapshot(GraphSnapshot const *previous) const
+{
+    std::vector<std::shared_ptr<GraphSnapshot::Entry const>> entries;
+    entries.reserve(m_nodes.size());
+    // Both are ordered by ID so the previous entries are walked alongside
+    GraphSnapshot::const_iterator prev, prevEnd;
+    if (previous)
+    {
+        prev = previous->begin();
+        prevEnd = previous->end();
+    }
+    size_t numShared = 0;
+    for (const auto &node : m_nodes)
+    {
+        while (previous && prev != prevEnd && (*prev)->node()->id() < node->id())
+        {
+            ++prev;
+        }
+        if (previous && prev != prevEnd && (*prev)->node() == node.get() && (*prev)->isCurrent())
+        {
+            entries.push_back(*prev);
+            ++numShared;
+        }
+        else
+        {
+            entries.push_back(std::make_shared<GraphSnapshot::Entry const>(node));
+        }
+    }
+    LOG_DEBUG("Snapshot of %lu nodes, %lu shared", entries.size(), numShared);
+    return std::make_shared<GraphSnapshot const>(std::move(entries));
+}
+
+bool Graph::serialize(Serializer *serializer) const
+{
+    return snapshot()->serialize(serializer);
 }
 
 bool Graph::deserialize(Deserializer *deserializer)
@@ -114,36 +333,33 @@ bool Graph::deserialize(Deserializer *deserializer)
             std::string nodeType;
             while (ok && deserializer->readProperty(nodeType))
             {
-                // Create a temporary node to deserialize into
-                ok = ok && createNode(0, nodeType);
-                if (ok)
-                {
-                    Node &node = m_nodes.at(NodeID(0));
-                    ok = ok && deserializer->startReadObject();
-                    ok = ok && node.deserialize(deserializer);
-                    ok = ok && deserializer->finishReadObject();
-                    // Correct the node's key or remove it
-                    if (ok)
-                    {
-                        auto handler = m_nodes.extract(0);
-                        handler.key() = node.id();
-                        m_nodes.insert(std::move(handler));
-                    }
-                }
-                else
+                // Deserialized into a temporary node, only added once its ID is known
+                Op::Operator *op = Op::OperatorRegistry::create(nodeType);
+                if (!op)
                 {
                     LOG_ERROR("Failed to create node type: %s", nodeType.c_str())
+                    ok = false;
+                    break;
                 }
-                if (!ok)
+                std::shared_ptr<Node> node = std::make_shared<Node>(NodeID(0), op);
+                ok = ok && deserializer->startReadObject();
+                ok = ok && node->deserialize(deserializer);
+                ok = ok && deserializer->finishReadObject();
+                if (ok)
                 {
-                    m_nodes.erase(0);
+                    insert(std::move(node));
                 }
             }
             ok = ok && deserializer->finishReadObject();
-            if (ok)
+            if (ok && !m_nodes.empty())
             {
-                // Map is ordered, highest ID is the last ID
-                lastID = m_nodes.rbegin()->first;
+                // Nodes are ordered, highest ID is the last ID. Only ever raised as IDs
+                // may be reserved by another thread meanwhile, see reserveID().
+                NodeID maxID = m_nodes.back()->id();
+                NodeID current = lastID.load();
+                while (current < maxID && !lastID.compare_exchange_weak(current, maxID))
+                {
+                }
             }
         }
         else if (property == KEY_INPUTS)
@@ -158,7 +374,16 @@ bool Graph::deserialize(Deserializer *deserializer)
                 ok = ok && deserializer->readInt(output);
                 if (ok)
                 {
-                    node(NodeID(src))->input(input)->connect(node(NodeID(tgt))->output(output));
+                    // A damaged file may refer to nodes or connectors that don't exist, or form a cycle
+                    Node *srcNode = node(NodeID(src));
+                    Node *tgtNode = node(NodeID(tgt));
+                    Connector *srcConn = srcNode ? srcNode->input(size_t(input)) : nullptr;
+                    Connector *tgtConn = tgtNode ? tgtNode->output(size_t(output)) : nullptr;
+                    ok = srcConn && tgtConn && srcConn->connect(tgtConn);
+                    if (!ok)
+                    {
+                        LOG_ERROR("Failed to connect input %d of node %d to output %d of node %d", input, src, output, tgt);
+                    }
                 }
             }
             ok = ok && deserializer->finishReadObject();
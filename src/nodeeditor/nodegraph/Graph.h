@@ -1,26 +1,51 @@
 #pragma once
+#include <atomic>
+#include <functional>
+#include <memory>
 #include <string>
-#include <map>
+#include <unordered_map>
+#include <vector>
 
+#include "GraphSnapshot.h"
 #include "Serializer.h"
 #include "Settings.h"
 #include "Node.h"
 
+/*
+Nodes are stored densely in order of ID, with an index from ID to position for lookups.
+Creating a node with a newer ID than any other, eg, any node created by the editor, only
+appends it. Deleting a node is linear in the number of nodes: those after it are shifted
+down, both in ID order and in topological order.
+
+This is not a slot map. Each node is allocated on its own so snapshots can share it, IDs
+are the only handles, and connections are kept by each connector rather than in arrays
+owned by the graph. Walking the nodes in ID order is what lets a snapshot share entries
+with the previous one and be searched by ID.
+
+The graph also keeps its nodes in topological order, upstream before downstream, updated
+as each connection is made: only the nodes between the two being connected are reordered,
+and only if the connection goes against the current order. Connections that would form a
+cycle are refused.
+
+Nodes are shared with the snapshots taken of the graph (see snapshot()), so a node removed
+from the graph lives on until the last snapshot holding it is released. Removed nodes are
+disconnected straight away so that releasing them doesn't touch the rest of the graph.
+*/
 class Graph
 {
 public:
     // TODO: make this templated so can be reused for settings/graph
-    typedef std::map<NodeID, Node>::iterator pair_iterator;
-    typedef std::map<NodeID, Node>::const_iterator const_iterator;
-    typedef std::map<NodeID, Node>::reverse_iterator reverse_iterator;
+    typedef std::vector<std::shared_ptr<Node>>::iterator node_iterator;
+    typedef std::vector<std::shared_ptr<Node>>::const_iterator const_iterator;
+    typedef std::vector<std::shared_ptr<Node>>::reverse_iterator reverse_iterator;
 
-    class value_iterator : public pair_iterator
+    class value_iterator : public node_iterator
     {
     public:
-        value_iterator() : pair_iterator() {}
-        value_iterator(pair_iterator it) : pair_iterator(it) {}
-        Node *operator->() { return &(pair_iterator::operator->()->second); }
-        Node &operator*() { return pair_iterator::operator*().second; }
+        value_iterator() : node_iterator() {}
+        value_iterator(node_iterator it) : node_iterator(it) {}
+        Node *operator->() { return node_iterator::operator*().get(); }
+        Node &operator*() { return *node_iterator::operator*(); }
     };
 
     class const_value_iterator : public const_iterator
@@ -28,8 +53,8 @@ public:
     public:
         const_value_iterator() : const_iterator() {}
         const_value_iterator(const_iterator it) : const_iterator(it) {}
-        const Node *operator->() const { return &(const_iterator::operator->()->second); }
-        const Node &operator*() const { return const_iterator::operator*().second; }
+        const Node *operator->() const { return const_iterator::operator*().get(); }
+        const Node &operator*() const { return *const_iterator::operator*(); }
     };
 
     class reverse_value_iterator : public reverse_iterator
@@ -37,10 +62,20 @@ public:
     public:
         reverse_value_iterator() : reverse_iterator() {}
         reverse_value_iterator(reverse_iterator it) : reverse_iterator(it) {}
-        Node *operator->() { return &(reverse_iterator::operator->()->second); }
-        Node &operator*() { return reverse_iterator::operator*().second; }
+        Node *operator->() { return reverse_iterator::operator*().get(); }
+        Node &operator*() { return *reverse_iterator::operator*(); }
     };
 
+    Graph() = default;
+    ~Graph();
+    // Copies would share their nodes
+    Graph(const Graph &graph) = delete;
+    Graph &operator=(const Graph &graph) = delete;
+    Graph(Graph &&graph);
+    Graph &operator=(Graph &&graph);
+
+    friend class Node;
+
     value_iterator begin();
     value_iterator end();
     const_value_iterator cbegin() const;
@@ -49,20 +84,66 @@ public:
     reverse_value_iterator rend();
 
     NodeID createNode(const std::string &nodeType);
+    /* Creates a node with an ID from reserveID(). Returns false if the type is unknown. */
+    bool createNode(NodeID nodeID, const std::string &nodeType);
+    /* Reserves an ID for a node created later, eg, by an edit applied on another thread */
+    static NodeID reserveID();
     bool deleteNode(NodeID nodeID);
     Node *node(NodeID nodeID);
     size_t numNodes() const;
     Bounds bounds() const;
     void clear();
+    /*
+    Takes a snapshot of the graph's current structure. Entries of nodes whose connections
+    are unchanged since the previous snapshot, if given, are shared with it.
+    */
+    std::shared_ptr<GraphSnapshot const> snapshot(GraphSnapshot const *previous = nullptr) const;
+
+    /* Total size of the outputs of every processed node, kept as they're processed and reset */
+    size_t outputByteSize() const;
+    /* Every node, ordered after all of the nodes upstream of it */
+    const std::vector<Node *> &topologicalOrder() const;
+    /*
+    Called by a connector before connecting an output of upstream to an input of
+    downstream. Returns false if downstream is upstream of it, ie, it would form a cycle.
+    */
+    bool orderConnection(Node *upstream, Node *downstream);
+    /*
+    Calls the function once for every dirty node and every node downstream of one, in
+    topological order, eg, to reset them. Doesn't allocate unless the graph has grown.
+    */
+    void invalidateDirty(const std::function<void(Node *)> &fn);
 
     bool serialize(Serializer *serializer) const;
     bool deserialize(Deserializer *deserializer);
 
 protected:
-    static NodeID lastID;
-    std::map<NodeID, Node> m_nodes;
+    static std::atomic<NodeID> lastID;
+    std::vector<std::shared_ptr<Node>> m_nodes;
+    // Position of each node in m_nodes
+    std::unordered_map<NodeID, size_t> m_indices;
+
+    std::vector<Node *> m_order;
+    size_t m_outputByteSize = 0;
+    // Scratch space for reordering and invalidating, marks are indexed by topological index
+    std::vector<bool> m_marked;
+    std::vector<Node *> m_stack;
+    std::vector<Node *> m_forward;
+    std::vector<Node *> m_backward;
+    std::vector<size_t> m_positions;
+
+    /* Inserts the node in order of ID, replacing any node with the same ID */
+    void insert(std::shared_ptr<Node> node);
+    /* Updates the index of every node from the position onwards */
+    void reindex(size_t start);
+    /* Removes the node from the graph's topological order */
+    void removeFromOrder(Node *node);
+    /*
+    Collects the nodes reachable from start in the direction whose topological index is
+    within the bounds into nodes. Returns false if the stop node is reached.
+    */
+    bool collectBetween(Node *start, bool downstream, size_t lower, size_t upper, std::vector<Node *> &nodes, Node *stop);
 
-    bool createNode(NodeID nodeID, const std::string &nodeType);
     void validateUniqueSetting(const std::string &name) const;
     void validateKeyExists(const std::string &name) const;
 };
\ No newline at end of file
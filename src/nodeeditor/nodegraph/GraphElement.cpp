@@ -1,19 +1,28 @@
+#include <atomic>
+
 #include "GraphElement.h"
 
 GraphElement::GraphElement() {}
 GraphElement::GraphElement(Bounds bounds) : m_bounds(bounds) {}
+GraphElement::GraphElement(const GraphElement &element) : m_selectState(element.m_selectState.load()), m_bounds(element.m_bounds) {}
+GraphElement &GraphElement::operator=(const GraphElement &element)
+{
+    m_selectState = element.m_selectState.load();
+    m_bounds = element.m_bounds;
+    return *this;
+}
 
 void GraphElement::setSelectFlag(SelectFlag flag)
 {
-    m_selectState = SelectFlag(m_selectState | flag);
+    m_selectState |= flag;
 }
 bool GraphElement::hasSelectFlag(SelectFlag flag) const
 {
-    return m_selectState & flag;
+    return m_selectState.load() & flag;
 }
 void GraphElement::clearSelectFlag(SelectFlag flag)
 {
-    m_selectState = SelectFlag(m_selectState & ~flag);
+    m_selectState &= ~flag;
 }
 Bounds GraphElement::bounds() const
 {
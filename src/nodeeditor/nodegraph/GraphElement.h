@@ -1,4 +1,5 @@
 #pragma once
+#include <atomic>
 
 #include "../Bounds.hpp"
 #include "../constants.h"
@@ -8,6 +9,8 @@ class GraphElement
 public:
     GraphElement();
     GraphElement(Bounds bounds);
+    GraphElement(const GraphElement &element);
+    GraphElement &operator=(const GraphElement &element);
 
     void setSelectFlag(SelectFlag flag);
     bool hasSelectFlag(SelectFlag flag) const;
@@ -20,6 +23,7 @@ public:
     void move(glm::vec2 offset);
 
 protected:
-    SelectFlag m_selectState = SelectFlag_None;
+    // Set by the UI while the processing thread reads the view and pinned flags
+    std::atomic<int> m_selectState = SelectFlag_None;
     Bounds m_bounds;
 };
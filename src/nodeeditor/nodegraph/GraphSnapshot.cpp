@@ -0,0 +1,111 @@
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "Connector.h"
+#include "GraphSnapshot.h"
+#include "Node.h"
+#include "Serializer.h"
+
+GraphSnapshot::Entry::Entry(std::shared_ptr<Node> node) : m_node(std::move(node))
+{
+    // Inputs only ever have one connection
+    for (size_t i = 0; i < m_node->numInputs(); ++i)
+    {
+        Connector *conn = m_node->input(i);
+        m_connections.push_back(conn->numConnections() > 0 ? conn->connection(0) : nullptr);
+    }
+}
+Node *GraphSnapshot::Entry::node() const { return m_node.get(); }
+Connector *GraphSnapshot::Entry::connection(size_t input) const
+{
+    return input < m_connections.size() ? m_connections[input] : nullptr;
+}
+bool GraphSnapshot::Entry::isCurrent() const
+{
+    for (size_t i = 0; i < m_connections.size(); ++i)
+    {
+        Connector *conn = m_node->input(i);
+        if ((conn->numConnections() > 0 ? conn->connection(0) : nullptr) != m_connections[i])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+GraphSnapshot::GraphSnapshot(std::vector<std::shared_ptr<Entry const>> entries) : m_entries(std::move(entries)) {}
+
+GraphSnapshot::const_iterator GraphSnapshot::begin() const { return m_entries.cbegin(); }
+GraphSnapshot::const_iterator GraphSnapshot::end() const { return m_entries.cend(); }
+GraphSnapshot::const_reverse_iterator GraphSnapshot::rbegin() const { return m_entries.crbegin(); }
+GraphSnapshot::const_reverse_iterator GraphSnapshot::rend() const { return m_entries.crend(); }
+
+size_t GraphSnapshot::numNodes() const { return m_entries.size(); }
+GraphSnapshot::Entry const *GraphSnapshot::entry(NodeID nodeID) const
+{
+    auto it = std::lower_bound(m_entries.begin(), m_entries.end(), nodeID, [](const std::shared_ptr<Entry const> &entry, NodeID id)
+                               { return entry->node()->id() < id; });
+    if (it != m_entries.end() && (*it)->node()->id() == nodeID)
+    {
+        return it->get();
+    }
+    return nullptr;
+}
+Node *GraphSnapshot::node(NodeID nodeID) const
+{
+    Entry const *nodeEntry = entry(nodeID);
+    return nodeEntry ? nodeEntry->node() : nullptr;
+}
+Connector *GraphSnapshot::connection(Connector const *input) const
+{
+    Entry const *nodeEntry = entry(input->node()->id());
+    return nodeEntry ? nodeEntry->connection(input->index()) : nullptr;
+}
+
+Bounds GraphSnapshot::bounds() const
+{
+    if (m_entries.empty())
+    {
+        return {};
+    }
+    Bounds bounds = m_entries.front()->node()->bounds();
+    for (size_t i = 1; i < m_entries.size(); ++i)
+    {
+        bounds.expand(m_entries[i]->node()->bounds());
+    }
+    return bounds;
+}
+
+bool GraphSnapshot::serialize(Serializer *serializer) const
+{
+    bool ok = serializer->startObject(KEY_NODES);
+    for (const auto &entry : m_entries)
+    {
+        ok = ok && serializer->startObject(entry->node()->type());
+        ok = ok && entry->node()->serialize(serializer);
+        ok = ok && serializer->finishObject();
+    }
+    ok = ok && serializer->finishObject();
+
+    ok = ok && serializer->startObject(KEY_INPUTS);
+    for (const auto &entry : m_entries)
+    {
+        Node const *node = entry->node();
+        for (size_t i = 0; i < node->numInputs(); ++i)
+        {
+            Connector const *conn = entry->connection(i);
+            if (!conn)
+            {
+                continue;
+            }
+            ok = ok && serializer->writePropertyInt(KEY_INPUT, node->id());
+            ok = ok && serializer->writeInt(i);
+            ok = ok && serializer->writeInt(conn->node()->id());
+            ok = ok && serializer->writeInt(conn->index());
+        }
+    }
+    ok = ok && serializer->finishObject();
+
+    return ok;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <memory>
+#include <vector>
+
+#include "../Bounds.hpp"
+#include "Connector.h"
+#include "Node.h"
+#include "Serializer.h"
+
+/*
+A read-only view of a graph's structure for the UI: which nodes exist and how they are
+connected at one point in time, taken by the processing thread after applying each batch
+of edits (see Scene::snapshot()). Snapshots are never modified once taken and keep every
+node in them alive, so can be held and read by any thread without locking.
+
+This is not a snapshot for evaluation. The processing thread evaluates the live graph,
+and only the structure is frozen: the nodes are the graph's own, so connections must be
+read from the snapshot rather than the connectors, which the processing thread changes.
+Of the nodes' other state:
+- Position and the edited settings are only written by the UI, once the node is published
+- Selection flags and the processing state are atomic
+- Output layers must not be read from the nodes, the view node's are published separately
+  once processed, see Scene::publishView()
+
+A node's entry is shared with the previous snapshot while its connections are unchanged,
+so a snapshot taken after an edit only allocates entries for the nodes it touched.
+*/
+class GraphSnapshot
+{
+public:
+    class Entry
+    {
+    public:
+        Entry(std::shared_ptr<Node> node);
+
+        Node *node() const;
+        /* The output connected to the node's input when the snapshot was taken, or nullptr */
+        Connector *connection(size_t input) const;
+        /* Whether the node's connections are still the same as the entry's */
+        bool isCurrent() const;
+
+    protected:
+        std::shared_ptr<Node> m_node;
+        std::vector<Connector *> m_connections;
+    };
+
+    typedef std::vector<std::shared_ptr<Entry const>>::const_iterator const_iterator;
+    typedef std::vector<std::shared_ptr<Entry const>>::const_reverse_iterator const_reverse_iterator;
+
+    GraphSnapshot() = default;
+    /* Entries must be ordered by node ID */
+    GraphSnapshot(std::vector<std::shared_ptr<Entry const>> entries);
+
+    const_iterator begin() const;
+    const_iterator end() const;
+    const_reverse_iterator rbegin() const;
+    const_reverse_iterator rend() const;
+
+    size_t numNodes() const;
+    Entry const *entry(NodeID nodeID) const;
+    Node *node(NodeID nodeID) const;
+    /* The output connected to an input of a node in the snapshot, or nullptr */
+    Connector *connection(Connector const *input) const;
+    Bounds bounds() const;
+
+    bool serialize(Serializer *serializer) const;
+
+protected:
+    std::vector<std::shared_ptr<Entry const>> m_entries;
+};
@@ -1,52 +1,28 @@
-#include <memory>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
 
 #include "../constants.h"
 #include "Node.h"
 #include "Iterators.h"
 
 DepthIterator::DepthIterator() {}
-DepthIterator::DepthIterator(Node *node, GraphDirection direction, IteratorFlags flags, int depth) : m_node(node), m_direction(direction), m_flags(flags), m_depth(depth) {}
-
-DepthIterator::DepthIterator(const DepthIterator &it)
-{
-    m_node = it.m_node;
-    m_direction = it.m_direction;
-    m_flags = it.m_flags;
-    m_depth = it.m_depth;
-    m_connectorIndex = it.m_connectorIndex;
-    m_connectionIndex = it.m_connectionIndex;
-    m_isExhausted = it.m_isExhausted;
-
-    if (it.m_next)
-    {
-        m_next = std::make_shared<DepthIterator>(*it.m_next);
-    }
-}
-DepthIterator &DepthIterator::operator=(const DepthIterator &it)
+DepthIterator::DepthIterator(Node *node, GraphDirection direction, IteratorFlags flags, int depth) : m_direction(direction), m_flags(flags)
 {
-    m_node = it.m_node;
-    m_direction = it.m_direction;
-    m_flags = it.m_flags;
-    m_depth = it.m_depth;
-    m_connectorIndex = it.m_connectorIndex;
-    m_connectionIndex = it.m_connectionIndex;
-    m_isExhausted = it.m_isExhausted;
-
-    if (it.m_next)
+    if (node)
     {
-        m_next = std::make_shared<DepthIterator>(*it.m_next);
+        m_stack.push_back({node, depth, 0, 0});
+        visit(node);
     }
-    return *this;
 }
 
 int DepthIterator::depth() const
 {
-    auto it = deepestIterator();
-    if (!it)
+    if (m_stack.empty())
     {
         return -1;
     }
-    return it->m_depth;
+    return m_stack.back().depth;
 }
 GraphDirection DepthIterator::direction() const { return m_direction; }
 IteratorFlags DepthIterator::flags() const { return m_flags; }
@@ -57,7 +33,7 @@ Node *DepthIterator::operator->()
 }
 Node &DepthIterator::operator*()
 {
-    return *(deepestIterator()->m_node);
+    return *currentNode();
 }
 DepthIterator &DepthIterator::operator++()
 {
@@ -73,69 +49,94 @@ DepthIterator DepthIterator::operator++(int)
 bool operator==(const DepthIterator &a, const DepthIterator &b) { return a.currentNode() == b.currentNode(); }
 bool operator!=(const DepthIterator &a, const DepthIterator &b) { return a.currentNode() != b.currentNode(); }
 
-const DepthIterator *DepthIterator::deepestIterator() const
+Node *DepthIterator::currentNode() const
 {
-    if (m_isExhausted || !m_node)
-    {
-        return nullptr;
-    }
-
-    const DepthIterator *curr = this;
-    while (curr->m_next)
-    {
-        curr = curr->m_next.get();
-    }
-    return curr;
+    return m_stack.empty() ? nullptr : m_stack.back().node;
 }
-Node *DepthIterator::currentNode() const
+static size_t slotOf(Node *node, size_t numSlots)
 {
-    auto it = deepestIterator();
-    if (!it)
-    {
-        return nullptr;
-    }
-    return it->m_node;
+    uint64_t hash = reinterpret_cast<uintptr_t>(node);
+    hash = (hash ^ (hash >> 31)) * 0x9E3779B97F4A7C15ull;
+    return size_t(hash >> 32) & (numSlots - 1);
 }
-bool DepthIterator::advance()
+bool DepthIterator::visit(Node *node)
 {
-    if (m_isExhausted)
+    if (2 * (m_numVisited + 1) > m_numSlots)
     {
-        return false;
+        growVisited();
     }
-    if (m_next && m_next->advance())
+    Node **slots = m_heapSlots.empty() ? m_inlineSlots : m_heapSlots.data();
+    for (size_t i = slotOf(node, m_numSlots);; i = (i + 1) & (m_numSlots - 1))
     {
-        return true;
+        if (slots[i] == node)
+        {
+            return false;
+        }
+        if (!slots[i])
+        {
+            slots[i] = node;
+            ++m_numVisited;
+            return true;
+        }
     }
-
-    // Increment through connections / connectors until a node is found
-    size_t numConnectors = m_direction == GraphDirection_Upstream ? m_node->numInputs() : m_node->numOutputs();
-    while ((size_t)m_connectorIndex < numConnectors)
+}
+void DepthIterator::growVisited()
+{
+    if (m_numSlots == 0)
+    {
+        std::fill(m_inlineSlots, m_inlineSlots + InlineVisitedSlots, nullptr);
+        m_numSlots = InlineVisitedSlots;
+        return;
+    }
+    Node **slots = m_heapSlots.empty() ? m_inlineSlots : m_heapSlots.data();
+    std::vector<Node *> grown(m_numSlots * 2, nullptr);
+    for (size_t i = 0; i < m_numSlots; ++i)
     {
-        Connector *conn;
-        if (m_direction == GraphDirection_Upstream)
+        if (!slots[i])
         {
-            conn = m_node->input(m_connectorIndex);
+            continue;
         }
-        else
+        size_t j = slotOf(slots[i], grown.size());
+        while (grown[j])
         {
-            conn = m_node->output(m_connectorIndex);
+            j = (j + 1) & (grown.size() - 1);
         }
-        while (size_t(++m_connectionIndex) < conn->numConnections())
+        grown[j] = slots[i];
+    }
+    m_heapSlots = std::move(grown);
+    m_numSlots = m_heapSlots.size();
+}
+bool DepthIterator::advance()
+{
+    while (!m_stack.empty())
+    {
+        // Increment through the current node's connections until an unvisited node is found
+        Frame &frame = m_stack.back();
+        Node *node = frame.node;
+        size_t numConnectors = m_direction == GraphDirection_Upstream ? node->numInputs() : node->numOutputs();
+        while (frame.connectorIndex < numConnectors)
         {
-            // Found a connection, wrap in an iterator and report success
-            Node *node = conn->connection(m_connectionIndex)->node();
-            if (m_flags & IteratorFlags_SkipProcessed && node->state() == State::Processed)
+            Connector *conn = m_direction == GraphDirection_Upstream ? node->input(frame.connectorIndex) : node->output(frame.connectorIndex);
+            if (frame.connectionIndex >= conn->numConnections())
+            {
+                ++frame.connectorIndex;
+                frame.connectionIndex = 0;
+                continue;
+            }
+            Node *next = conn->connection(frame.connectionIndex++)->node();
+            if (m_flags & IteratorFlags_SkipProcessed && next->state() == State::Processed)
+            {
+                continue;
+            }
+            if (!visit(next))
             {
                 continue;
             }
-            m_next = std::make_shared<DepthIterator>(node, m_direction, m_flags, m_depth + 1);
+            m_stack.push_back({next, frame.depth + 1, 0, 0});
             return true;
         }
-        // Ran out of connections, move to next connector and reset connection index
-        ++m_connectorIndex;
-        m_connectionIndex = -1;
+        // Ran out of connectors, return to the node it was reached from
+        m_stack.pop_back();
     }
-    // Ran out of connectors, node is exhausted
-    m_isExhausted = true;
     return false;
 }
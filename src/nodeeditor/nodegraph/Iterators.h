@@ -1,7 +1,8 @@
 #pragma once
-#include <memory>
+#include <vector>
 
 #include "Node.h"
+#include "SmallVector.hpp"
 
 enum GraphDirection
 {
@@ -15,15 +16,21 @@ enum IteratorFlags
     IteratorFlags_SkipProcessed = 1 << 0,
 };
 
+/*
+Walks every node upstream or downstream of a node, depth first, starting with the node
+itself. Each node is visited once, even if it can be reached along several paths.
+
+The path to the current node is kept on an explicit stack and the visited nodes in a
+hash table, both stored inline for the graphs typically walked, so iterating doesn't
+allocate until more than a few dozen nodes have been visited.
+*/
 class DepthIterator
 {
 public:
     DepthIterator();
     DepthIterator(Node *node, GraphDirection direction = GraphDirection_Upstream, IteratorFlags flags = IteratorFlags_None, int depth = 0);
 
-    DepthIterator(const DepthIterator &it);            // Copy constructor
-    DepthIterator &operator=(const DepthIterator &it); // Copy assignment
-
+    // Number of connections between the current node and the starting node along the path taken
     int depth() const;
     GraphDirection direction() const;
     IteratorFlags flags() const;
@@ -37,18 +44,30 @@ public:
     friend bool operator!=(const DepthIterator &a, const DepthIterator &b);
 
 private:
-    Node *m_node = nullptr;
+    struct Frame
+    {
+        Node *node;
+        int depth;
+        size_t connectorIndex;
+        size_t connectionIndex;
+    };
+    static constexpr size_t InlineStackSize = 16;
+    // Slots in the visited table before it moves to the heap, kept at most half full
+    static constexpr size_t InlineVisitedSlots = 64;
+
     GraphDirection m_direction = GraphDirection_Upstream;
     IteratorFlags m_flags = IteratorFlags_None;
-    int m_depth = 0;
-    // Using a shared ptr to handle the lifetime of recursive iterators when an iterator
-    // in the chain is copied - such as some monster using it++ instead of ++it
-    std::shared_ptr<DepthIterator> m_next = nullptr;
-    int m_connectorIndex = 0;
-    int m_connectionIndex = -1;
-    bool m_isExhausted = false;
-
-    const DepthIterator *deepestIterator() const;
+    // The current node is on top
+    SmallVector<Frame, InlineStackSize> m_stack;
+    // Open addressing table of visited nodes, inline until it outgrows it
+    Node *m_inlineSlots[InlineVisitedSlots];
+    std::vector<Node *> m_heapSlots;
+    size_t m_numSlots = 0;
+    size_t m_numVisited = 0;
+
     Node *currentNode() const;
+    // Marks the node as visited, returns false if it already was
+    bool visit(Node *node);
+    void growVisited();
     bool advance();
 };
@@ -1,16 +1,23 @@
+#include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 
 #include "../constants.h"
 #include "../log.h"
+#include "../util.h"
 #include "Settings.h"
 #include "Connector.h"
+#include "Graph.h"
 #include "Node.h"
 #include "Operator.h"
 #include "OperatorRegistry.hpp"
+#include "ResultCache.h"
+#include "WorkStealingPool.h"
 
 Node::Node(NodeID id, Op::Operator *op) : GraphElement({0, 0, 100, 25}), m_id(id), m_op(op)
 {
+    m_backendOps[m_backend] = op;
     if (op)
     {
         m_name = op->name();
@@ -24,6 +31,15 @@ Node::Node(NodeID id, Op::Operator *op) : GraphElement({0, 0, 100, 25}), m_id(id
         {
             addOutput(output.name);
         }
+        if (Op::OperatorRegistry::hasBackend(m_type, Backend_CPU))
+        {
+            m_settings.registerInt(NODE_SETTING_BACKEND,
+                                   Backend_Scene,
+                                   {{"scene", Backend_Scene},
+                                    {"gpu", Backend_GPU},
+                                    {"cpu", Backend_CPU}});
+        }
+        m_appliedSettings = m_settings;
     }
     else
     {
@@ -33,14 +49,7 @@ Node::Node(NodeID id, Op::Operator *op) : GraphElement({0, 0, 100, 25}), m_id(id
 }
 Node::~Node()
 {
-    for (Connector &conn : m_inputs)
-    {
-        conn.disconnectAll();
-    }
-    for (Connector &conn : m_outputs)
-    {
-        conn.disconnectAll();
-    }
+    disconnectAll();
 }
 Node::Node(Node &&node) noexcept : GraphElement(std::move(node))
 {
@@ -58,12 +67,17 @@ Node::Node(Node &&node) noexcept : GraphElement(std::move(node))
     {
         conn.m_node = this;
     }
-    m_state = node.m_state;
+    m_state = node.m_state.load();
     m_dirty = node.m_dirty;
     m_error = node.m_error;
+    m_fingerprint = node.m_fingerprint;
+    m_outputByteSize = node.m_outputByteSize;
 
-    m_op = std::move(node.m_op);
+    m_op = node.m_op.load();
+    m_backendOps = node.m_backendOps;
+    m_backend = node.m_backend;
     m_settings = node.m_settings;
+    m_appliedSettings = node.m_appliedSettings;
 }
 Node::Node(const Node &node) : GraphElement(node)
 {
@@ -81,12 +95,18 @@ Node::Node(const Node &node) : GraphElement(node)
     {
         conn.m_node = this;
     }
-    m_state = node.m_state;
+    m_state = node.m_state.load();
     m_dirty = node.m_dirty;
     m_error = node.m_error;
+    m_fingerprint = node.m_fingerprint;
+    m_outputByteSize = node.m_outputByteSize;
 
-    m_op = Op::OperatorRegistry::create(node.m_op->type());
+    m_op = Op::OperatorRegistry::create(node.op()->type(), node.m_backend);
+    m_backendOps = {};
+    m_backendOps[node.m_backend] = m_op;
+    m_backend = node.m_backend;
     m_settings = node.m_settings;
+    m_appliedSettings = node.m_appliedSettings;
 }
 Node &Node::operator=(Node &&node) noexcept
 {
@@ -106,12 +126,17 @@ Node &Node::operator=(Node &&node) noexcept
     {
         conn.m_node = this;
     }
-    m_state = node.m_state;
+    m_state = node.m_state.load();
     m_dirty = node.m_dirty;
     m_error = node.m_error;
+    m_fingerprint = node.m_fingerprint;
+    m_outputByteSize = node.m_outputByteSize;
 
-    m_op = std::move(node.m_op);
+    m_op = node.m_op.load();
+    m_backendOps = node.m_backendOps;
+    m_backend = node.m_backend;
     m_settings = node.m_settings;
+    m_appliedSettings = node.m_appliedSettings;
     return *this;
 }
 Node &Node::operator=(const Node &node)
@@ -132,12 +157,18 @@ Node &Node::operator=(const Node &node)
     {
         conn.m_node = this;
     }
-    m_state = node.m_state;
+    m_state = node.m_state.load();
     m_dirty = node.m_dirty;
     m_error = node.m_error;
+    m_fingerprint = node.m_fingerprint;
+    m_outputByteSize = node.m_outputByteSize;
 
-    m_op = Op::OperatorRegistry::create(node.m_op->type());
+    m_op = Op::OperatorRegistry::create(node.op()->type(), node.m_backend);
+    m_backendOps = {};
+    m_backendOps[node.m_backend] = m_op;
+    m_backend = node.m_backend;
     m_settings = node.m_settings;
+    m_appliedSettings = node.m_appliedSettings;
     return *this;
 }
 
@@ -155,14 +186,32 @@ const std::string &Node::name() const { return m_name; }
 const std::string &Node::type() const { return m_type; }
 State Node::state() const { return m_state; }
 Op::Operator *Node::op() const { return m_op; }
+Backend Node::backend() const { return m_backend; }
+Graph *Node::graph() const { return m_graph; }
+size_t Node::topologicalIndex() const { return m_topologicalIndex; }
 
 // Maybe settings needs a redo so that the register methods are on the node, and the settings object it exposes is immutable
 // This ensures settings are only updated through updateSetting() so that the dirty bit can be set
 Settings const *Node::settings() const { return &m_settings; }
-void Node::updateSetting(const std::string &name, SettingValue value)
+Settings const *Node::appliedSettings() const { return &m_appliedSettings; }
+void Node::updateSetting(const std::string &name, const SettingValue &value)
+{
+    editSetting(name, value);
+    applySetting(name, value);
+}
+void Node::editSetting(const std::string &name, const SettingValue &value)
 {
     m_settings.get(name)->set(value);
-    setDirty(true);
+}
+void Node::applySetting(const std::string &name, const SettingValue &value)
+{
+    Setting *setting = m_appliedSettings.get(name);
+    uint64_t generation = setting->generation();
+    setting->set(value);
+    if (setting->generation() != generation)
+    {
+        setDirty(true);
+    }
 }
 
 void Node::addInput(const std::string &name, bool required)
@@ -197,27 +246,170 @@ Connector *Node::output(size_t index)
 {
     return index >= m_outputs.size() ? nullptr : &m_outputs[index];
 }
+Bounds Node::outerBounds() const
+{
+    // Connectors are spread along the top and bottom edges
+    Bounds outer = bounds();
+    if (!m_inputs.empty())
+    {
+        outer.expand(m_inputs.front().bounds());
+    }
+    if (!m_outputs.empty())
+    {
+        outer.expand(m_outputs.front().bounds());
+    }
+    return outer;
+}
+void Node::disconnectAll()
+{
+    for (Connector &conn : m_inputs)
+    {
+        conn.disconnectAll();
+    }
+    for (Connector &conn : m_outputs)
+    {
+        conn.disconnectAll();
+    }
+}
 
+void Node::setState(State state)
+{
+    size_t outputByteSize = state == State::Processed && m_op ? op()->outputByteSize() : 0;
+    if (m_graph)
+    {
+        m_graph->m_outputByteSize += outputByteSize - m_outputByteSize;
+    }
+    m_outputByteSize = outputByteSize;
+    m_state = state;
+}
 void Node::setError(const std::string &errorMsg)
 {
     m_error = errorMsg;
-    m_state = State::Error;
+    setState(State::Error);
     LOG_ERROR("Node %s has error: %s", type().c_str(), m_error.c_str());
 }
 bool Node::isDirty() const { return m_dirty; }
 void Node::setDirty(bool dirty) { m_dirty = dirty; }
 
-void Node::reset()
+void Node::reset(ResultCache *cache, bool hold)
 {
     LOG_DEBUG("Resetting %s", type().c_str());
+    if (cache && m_op && m_state == State::Processed)
+    {
+        if (hold)
+        {
+            cache->hold(m_fingerprint, op()->releaseResult());
+        }
+        else
+        {
+            cache->insert(m_fingerprint, op()->releaseResult());
+        }
+    }
     m_error.clear();
     setDirty(false);
-    m_state = State::Unprocessed;
+    setState(State::Unprocessed);
     if (m_op)
     {
-        m_op->reset();
+        op()->reset();
+    }
+}
+size_t Node::fingerprint() const { return m_fingerprint; }
+void Node::updateFingerprint(Settings const *sceneSettings)
+{
+    if (m_state == State::Unprocessed)
+    {
+        m_fingerprint = calculateFingerprint(sceneSettings);
     }
 }
+void Node::prepare(Settings const *sceneSettings, CancelToken const *cancelToken)
+{
+    if (!m_op || m_state != State::Unprocessed)
+    {
+        return;
+    }
+
+    Backend backend = resolveBackend(sceneSettings);
+    if (backend != m_backend)
+    {
+        Op::Operator *op = m_backendOps[backend];
+        if (!op)
+        {
+            op = Op::OperatorRegistry::create(m_type, backend);
+            m_backendOps[backend] = op;
+        }
+        if (op)
+        {
+            LOG_DEBUG("Switching %s to backend %d", type().c_str(), backend);
+            m_op = op;
+            m_backend = backend;
+        }
+    }
+    op()->setCancelToken(cancelToken);
+    m_fingerprint = calculateFingerprint(sceneSettings);
+
+    // Proxies are evaluated with distances in pixels scaled to the smaller image
+    Setting const *pixelScale = sceneSettings ? sceneSettings->get(SCENE_SETTING_PIXEL_SCALE) : nullptr;
+    m_isScaled = pixelScale && pixelScale->value<float>() != 1.0f;
+    if (m_isScaled)
+    {
+        m_scaledSettings = m_appliedSettings;
+        m_scaledSettings.scalePixels(pixelScale->value<float>());
+    }
+}
+bool Node::restoreResult(ResultCache *cache)
+{
+    if (!m_op || m_state != State::Unprocessed)
+    {
+        return false;
+    }
+
+    std::unique_ptr<CachedResult> result = cache->take(m_fingerprint);
+    if (!result)
+    {
+        return false;
+    }
+
+    std::vector<Op::Operator const *> inputOps;
+    if (!evaluateInputs(inputOps) || !op()->restoreResult(std::move(result), inputOps))
+    {
+        return false;
+    }
+    LOG_DEBUG("Restored %s from cache", type().c_str());
+    setState(State::Processed);
+    return true;
+}
+bool Node::canProcessAsync() const
+{
+    if (!m_op || m_state == State::Error)
+    {
+        return false;
+    }
+
+    return op()->canProcessAsync(inputOperators());
+}
+bool Node::canStartAsync() const
+{
+    if (!m_op || m_state != State::Unprocessed)
+    {
+        return false;
+    }
+    return op()->canStartAsync(inputOperators());
+}
+bool Node::startAsync(Settings const *sceneSettings, WorkStealingPool *pool, std::function<void()> done)
+{
+    LOG_DEBUG("Starting %s", type().c_str());
+    if (!op()->startAsync(inputOperators(), processSettings(), sceneSettings, pool, done))
+    {
+        setError(op()->hasError() ? op()->error() : "Failed to start processing");
+        return false;
+    }
+    setState(State::Processing);
+    return true;
+}
+bool Node::pollAsync(uint64_t timeout)
+{
+    return m_op && op()->pollAsync(timeout);
+}
 bool Node::processStep(Settings const *sceneSettings)
 {
     bool ok = false;
@@ -229,7 +421,12 @@ bool Node::processStep(Settings const *sceneSettings)
         ok = process(sceneSettings);
         if (ok && (m_state == State::Processing || m_state == State::Unprocessed))
         {
-            m_state = State::Processed;
+            setState(State::Processed);
+        }
+        // Multi-step operators remain processing until complete
+        else if (!ok && m_state == State::Unprocessed)
+        {
+            setState(State::Processing);
         }
         break;
     case State::Processed:
@@ -256,16 +453,73 @@ bool Node::process(Settings const *sceneSettings)
         return false;
     }
 
-    bool isComplete = m_op->process(inputOps, &m_settings, sceneSettings);
-    if (m_op->hasError())
+    bool isComplete = op()->process(inputOps, processSettings(), sceneSettings);
+    if (op()->hasError())
     {
-        setError(m_op->error());
+        setError(op()->error());
         return false;
     }
 
     return isComplete;
 }
 
+Settings const *Node::processSettings() const
+{
+    return m_isScaled ? &m_scaledSettings : &m_appliedSettings;
+}
+bool Node::storeResult(ResultStore *store) const
+{
+    if (!m_op || m_state != State::Processed)
+    {
+        return false;
+    }
+    return store->contains(m_fingerprint) || op()->storeResult(store, m_fingerprint);
+}
+size_t Node::calculateFingerprint(Settings const *sceneSettings) const
+{
+    size_t seed = std::hash<std::string>{}(m_type);
+    seed = hashCombine(seed, m_appliedSettings.hash());
+    seed = hashCombine(seed, sceneSettings ? sceneSettings->hash() : 0);
+    seed = hashCombine(seed, m_op ? op()->volatileHash(&m_appliedSettings) : 0);
+    for (const Connector &conn : m_inputs)
+    {
+        if (conn.numConnections() > 0)
+        {
+            Connector *upstream = conn.connection(0);
+            seed = hashCombine(seed, upstream->node()->fingerprint());
+            seed = hashCombine(seed, upstream->index());
+        }
+        else
+        {
+            seed = hashCombine(seed, 0);
+        }
+    }
+    return seed;
+}
+
+Backend Node::resolveBackend(Settings const *sceneSettings) const
+{
+    Setting const *setting = m_appliedSettings.get(NODE_SETTING_BACKEND);
+    Backend backend = setting ? Backend(setting->value<int>()) : Backend_Scene;
+    if (backend == Backend_Scene)
+    {
+        setting = sceneSettings ? sceneSettings->get(SCENE_SETTING_BACKEND) : nullptr;
+        backend = setting ? Backend(setting->value<int>()) : Backend_GPU;
+    }
+    // Operators without an implementation for the backend always use the GPU
+    return Op::OperatorRegistry::hasBackend(m_type, backend) ? backend : Backend_GPU;
+}
+
+std::vector<Op::Operator const *> Node::inputOperators() const
+{
+    std::vector<Op::Operator const *> inputs;
+    for (const Connector &conn : m_inputs)
+    {
+        inputs.push_back(conn.numConnections() > 0 ? conn.connection(0)->node()->op() : nullptr);
+    }
+    return inputs;
+}
+
 bool Node::evaluateInputs(std::vector<Op::Operator const *> &inputs)
 {
     for (Connector &conn : m_inputs)
@@ -297,7 +551,7 @@ bool Node::serialize(Serializer *serializer) const
 {
     bool ok = serializer->writePropertyInt(KEY_NODE_ID, id());
     ok = ok && serializer->writePropertyInt2(KEY_NODE_POS, bounds().pos());
-    ok = ok && serializer->writePropertyInt(KEY_NODE_FLAGS, (int)m_selectState);
+    ok = ok && serializer->writePropertyInt(KEY_NODE_FLAGS, m_selectState.load());
 
     ok = ok && serializer->startObject(KEY_SETTINGS);
     ok = ok && m_settings.serialize(serializer);
@@ -344,6 +598,7 @@ bool Node::deserialize(Deserializer *deserializer)
             ok = ok && deserializer->startReadObject();
             ok = ok && m_settings.deserialize(deserializer);
             ok = ok && deserializer->finishReadObject();
+            m_appliedSettings = m_settings;
         }
         else
         {
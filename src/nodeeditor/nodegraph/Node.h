@@ -1,16 +1,24 @@
 #pragma once
+#include <array>
+#include <atomic>
+#include <functional>
 #include <string>
 #include <vector>
 
 #include "../constants.h"
+#include "CancelToken.h"
 #include "Serializer.h"
 #include "Settings.h"
 #include "Connector.h"
 #include "GraphElement.h"
 #include "Operator.h"
+#include "ResultCache.h"
+#include "WorkStealingPool.h"
 
 typedef unsigned int NodeID;
 
+class Graph;
+
 enum class State
 {
     Unprocessed,
@@ -32,17 +40,41 @@ public:
 
     friend bool operator==(const Node &a, const Node &b);
     friend bool operator!=(const Node &a, const Node &b);
+    friend class Graph;
 
     NodeID id() const;
     const std::string &name() const;
     const std::string &type() const;
     State state() const;
+    // The operator of the node's current backend. Operators stay valid for the node's lifetime.
     Op::Operator *op() const;
+    // The backend the current operator was created for
+    Backend backend() const;
+    // The graph the node is in, or nullptr if it has been removed
+    Graph *graph() const;
+    // Position of the node in its graph's topological order
+    size_t topologicalIndex() const;
 
     // Maybe settings needs a redo so that the register methods are on the node, and the settings object it exposes is immutable
     // This ensures settings are only updated through updateSetting() so that the dirty bit can be set
+    /*
+    Settings as last edited, eg, shown in the UI and serialized. Owned by the thread editing
+    the graph: the processing thread only writes them while creating the node, before it's
+    in a snapshot, and never reads them, see Scene::updateSetting().
+    */
     Settings const *settings() const;
-    void updateSetting(const std::string &name, SettingValue value);
+    /*
+    Settings the node is evaluated with. Edits made from the UI are applied by the
+    processing thread while nothing is processing, see Scene::updateSetting(), so these
+    never change while the operator is reading them.
+    */
+    Settings const *appliedSettings() const;
+    /* Edits and applies the setting at once, for when there is no processing thread */
+    void updateSetting(const std::string &name, const SettingValue &value);
+    /* Updates only the edited settings, on the thread editing the graph */
+    void editSetting(const std::string &name, const SettingValue &value);
+    /* Updates only the applied settings and marks the node dirty if the value changed, on the thread processing the graph */
+    void applySetting(const std::string &name, const SettingValue &value);
 
     void addInput(const std::string &name = "", bool required = true);
     size_t numInputs() const;
@@ -52,12 +84,61 @@ public:
     bool addOutput(const std::string &name = "");
     size_t numOutputs() const;
     Connector *output(size_t index);
+    /* Disconnects every input and output */
+    void disconnectAll();
+    /* Bounds of the node and all of its connectors */
+    Bounds outerBounds() const;
 
     void setError(const std::string &errorMsg);
     bool isDirty() const;
     void setDirty(bool dirty = true);
 
-    void reset();
+    /*
+    Resets the node to be processed again. If a cache is given and the node was fully
+    processed, the operator's result is released into the cache under its fingerprint,
+    or held by it if hold is set, see ResultCache::hold().
+    */
+    void reset(ResultCache *cache = nullptr, bool hold = false);
+    /*
+    Hash of the node's operator type, settings, scene settings, the operator's volatile
+    state (see Operator::volatileHash()) and the fingerprints of its inputs, set when the
+    node begins processing. Nodes with equal fingerprints produce equal results.
+    */
+    size_t fingerprint() const;
+    /*
+    Recalculates an unprocessed node's fingerprint without preparing it, eg, to find its
+    result in a store. Its inputs' fingerprints must be up to date.
+    */
+    void updateFingerprint(Settings const *sceneSettings);
+    /*
+    Prepares an unprocessed node to be processed. Must be called from the thread owning
+    the GL context as the operator is switched if the node's backend has changed. Also
+    calculates the node's fingerprint. The operator abandons its work once the cancel
+    token is cancelled, if given.
+    */
+    void prepare(Settings const *sceneSettings, CancelToken const *cancelToken = nullptr);
+    /*
+    Attempts to restore a prepared node's result from the cache instead of processing.
+    Returns true if the node is now processed.
+    */
+    bool restoreResult(ResultCache *cache);
+    /*
+    Writes a processed node's result to the store under its fingerprint, eg, the disk cache,
+    unless it's already there. Returns true if the result is now in the store.
+    */
+    bool storeResult(ResultStore *store) const;
+    // Whether the next processing step can be run off the GL context's thread
+    bool canProcessAsync() const;
+    // Whether the unprocessed node can be started with startAsync(), even if its inputs are still processing
+    bool canStartAsync() const;
+    /*
+    Starts processing the operator on the pool, see Operator::startAsync(). done is called
+    from a worker once finished, after which processStep() completes processing once the
+    inputs are processed. Returns false if the node failed to start and is now in error.
+    */
+    bool startAsync(Settings const *sceneSettings, WorkStealingPool *pool, std::function<void()> done);
+    // Polls a started node that completes on the GL context's thread, see Operator::pollAsync()
+    bool pollAsync(uint64_t timeout);
     bool processStep(Settings const *sceneSettings);
 
     bool serialize(Serializer *serializer) const;
@@ -68,16 +149,40 @@ protected:
     NodeID m_id;
     std::string m_name;
     std::string m_type;
-    Op::Operator *m_op;
+    // The active backend's operator, switched by the processing thread while the UI reads it
+    std::atomic<Op::Operator *> m_op;
+    // Operators created for each backend, kept for the node's lifetime as the UI may still
+    // read one through a snapshot after the node switches to another backend
+    std::array<Op::Operator *, Backend_CPU + 1> m_backendOps = {};
+    Backend m_backend = Backend_GPU;
     Settings m_settings;
+    Settings m_appliedSettings;
+    // Settings with pixel measurements scaled for a proxy, set by prepare()
+    Settings m_scaledSettings;
+    bool m_isScaled = false;
     std::vector<Connector> m_inputs;
     std::vector<Connector> m_outputs;
+    // Set by the graph, never copied
+    Graph *m_graph = nullptr;
+    size_t m_topologicalIndex = 0;
 
     // State properties
-    State m_state = State::Unprocessed;
+    // Set by the processing thread while the UI reads it to draw the node
+    std::atomic<State> m_state = State::Unprocessed;
     bool m_dirty = false;
     std::string m_error;
-
+    size_t m_fingerprint = 0;
+    // Size of the operator's outputs while processed, counted by the graph
+    size_t m_outputByteSize = 0;
+
+    /* Sets the state, keeping the graph's total size of processed outputs up to date */
+    void setState(State state);
+    size_t calculateFingerprint(Settings const *sceneSettings) const;
+    Backend resolveBackend(Settings const *sceneSettings) const;
+    // The operator connected to each input, or nullptr if not connected
+    std::vector<Op::Operator const *> inputOperators() const;
     bool evaluateInputs(std::vector<Op::Operator const *> &inputs);
     bool process(Settings const *sceneSettings);
+    // The settings the operator is processed with
+    Settings const *processSettings() const;
 };
\ No newline at end of file
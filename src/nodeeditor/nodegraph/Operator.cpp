@@ -1,8 +1,13 @@
+#include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "CancelToken.h"
+#include "ResultCache.h"
 #include "Settings.h"
 #include "Operator.h"
+#include "WorkStealingPool.h"
 
 namespace Op
 {
@@ -21,6 +26,59 @@ namespace Op
     {
     }
 
+    bool Operator::canProcessAsync([[maybe_unused]] const std::vector<Operator const *> &inputs) const
+    {
+        return false;
+    }
+
+    bool Operator::canStartAsync([[maybe_unused]] const std::vector<Operator const *> &inputs) const
+    {
+        return false;
+    }
+    bool Operator::startAsync([[maybe_unused]] const std::vector<Operator const *> &inputs,
+                              [[maybe_unused]] Settings const *settings,
+                              [[maybe_unused]] Settings const *sceneSettings,
+                              [[maybe_unused]] WorkStealingPool *pool,
+                              [[maybe_unused]] std::function<void()> done)
+    {
+        setError("Operator does not support asynchronous processing");
+        return false;
+    }
+    bool Operator::pollAsync([[maybe_unused]] uint64_t timeout)
+    {
+        return false;
+    }
+
+    std::unique_ptr<CachedResult> Operator::releaseResult()
+    {
+        return nullptr;
+    }
+    bool Operator::restoreResult([[maybe_unused]] std::unique_ptr<CachedResult> result,
+                                 [[maybe_unused]] const std::vector<Operator const *> &inputs)
+    {
+        return false;
+    }
+    bool Operator::storeResult([[maybe_unused]] ResultStore *store, [[maybe_unused]] size_t key) const
+    {
+        return false;
+    }
+    size_t Operator::outputByteSize() const
+    {
+        return 0;
+    }
+    bool Operator::sharesOutputsWith([[maybe_unused]] Operator const *other) const
+    {
+        return false;
+    }
+    Footprint Operator::footprint([[maybe_unused]] Settings const *settings) const
+    {
+        return {};
+    }
+    size_t Operator::volatileHash([[maybe_unused]] Settings const *settings) const
+    {
+        return 0;
+    }
+
     void Operator::reset()
     {
         m_error.clear();
@@ -39,5 +97,11 @@ namespace Op
         return !m_error.empty();
     }
 
+    void Operator::setCancelToken(CancelToken const *token) { m_cancelToken = token; }
+    bool Operator::isCancelled() const
+    {
+        return m_cancelToken && m_cancelToken->isCancelled();
+    }
+
     void Operator::setType(const std::string &type) { m_type = type; }
 }
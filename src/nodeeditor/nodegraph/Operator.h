@@ -1,8 +1,14 @@
 #pragma once
+#include <cstdint>
+#include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "CancelToken.h"
+#include "ResultCache.h"
 #include "Settings.h"
+#include "WorkStealingPool.h"
 
 namespace Op
 {
@@ -17,6 +23,18 @@ namespace Op
   {
     std::string name = "";
   };
+  /*
+  Which pixels of its inputs an operator reads to compute a region of its output, see
+  Operator::footprint().
+  */
+  struct Footprint
+  {
+    // Whether a region of the output depends only on the same region of the inputs
+    // grown by the margin, and not on the full image, eg, its size
+    bool bounded = false;
+    // Pixels read beyond each side of the region
+    int margin = 0;
+  };
 
   /*
   Operator represents the core logic that can be assigned to a Node.
@@ -37,6 +55,11 @@ namespace Op
   Processing state is tracked in the Node and the framework will not call state
   out of order. Should parameters change, eg, settings/inputs, the reset() method is
   called and process() method will be called to completion again.
+
+  Work may be cancelled while in progress, eg, when a setting is edited. Operators doing
+  a lot of work in one call to process() or startAsync() should check isCancelled() and
+  return early if set. An operator's output is discarded once cancelled so it may be
+  left incomplete, but process() must not report the operator as processed.
   */
   class Operator
   {
@@ -57,6 +80,74 @@ namespace Op
     /* Receives an Operator per Input defined by inputs() and performs any processing */
     virtual bool process(const std::vector<Operator const *> &inputs, Settings const *settings, Settings const *sceneSettings) = 0;
     /*
+    Whether the next call to process() with the given inputs can be made from a worker
+    thread, ie, it makes no GL calls and only reads from its inputs. Default is false so
+    the operator is always processed on the thread owning the GL context.
+    */
+    virtual bool canProcessAsync(const std::vector<Operator const *> &inputs) const;
+    /*
+    Whether startAsync() can be called with the given inputs. Unlike process(), inputs
+    may be operators that were started asynchronously and have not yet finished, the
+    operator is responsible for waiting on the parts of them it reads. Default is false.
+    */
+    virtual bool canStartAsync(const std::vector<Operator const *> &inputs) const;
+    /*
+    Starts processing on the pool from the thread owning the GL context. done is called
+    from a worker once the asynchronous work has finished, after which process() is called
+    as normal to complete processing, eg, upload the result. Returns false if an error
+    was set and the operator could not be started.
+    */
+    virtual bool startAsync(const std::vector<Operator const *> &inputs, Settings const *settings, Settings const *sceneSettings,
+                            WorkStealingPool *pool, std::function<void()> done);
+    /*
+    Called on the thread owning the GL context while a started operator has not finished,
+    waiting up to timeout nanoseconds for it. Operators whose work completes on the GPU
+    rather than the pool call done from here once it has, eg, when a fence signals.
+    Returns false if the operator does not need polling, ie, done is called by a worker.
+    */
+    virtual bool pollAsync(uint64_t timeout);
+    /*
+    Called on a fully processed Operator before it is reset. Returns the processed output
+    so it can be cached and restored by restoreResult() on a later Operator with the same
+    settings and inputs. Ownership of any resources in the result passes to the caller.
+    Default returns nullptr, ie, the result is not cacheable.
+    */
+    virtual std::unique_ptr<CachedResult> releaseResult();
+    /*
+    Restores a result previously returned from releaseResult() on an Operator of the same
+    type in place of processing, or a LayeredResult written by storeResult(). Inputs are as
+    for process(). Returns true if successful, at which point the Operator is considered
+    processed. Default returns false.
+    */
+    virtual bool restoreResult(std::unique_ptr<CachedResult> result, const std::vector<Operator const *> &inputs);
+    /*
+    Writes a fully processed Operator's output to the store under the key, eg, the disk
+    cache, so it can be restored in a later session. Returns true if written. Default
+    returns false, ie, the result is not cacheable.
+    */
+    virtual bool storeResult(ResultStore *store, size_t key) const;
+    /* Approximate memory held by the outputs, used to enforce the scene's output budget. Default is 0. */
+    virtual size_t outputByteSize() const;
+    /*
+    Whether the other operator's output refers to resources owned by this one, eg, a layer
+    passed through unmodified, so this operator can't be reset while the other is in use.
+    Default is false.
+    */
+    virtual bool sharesOutputsWith(Operator const *other) const;
+    /*
+    Which pixels of the inputs are read to compute a region of the output, so that a
+    region can be evaluated without the rest of the image, eg, by the TiledRenderer.
+    Operators that generate content from the pixel position must offset it by the scene's
+    imageOrigin to be bounded. Default is unbounded, ie, the full image is required.
+    */
+    virtual Footprint footprint(Settings const *settings) const;
+    /*
+    Hash of anything besides the settings and inputs the output depends on, eg, the size
+    and modification time of a file it reads, so that a result is only restored from a
+    cache while that is unchanged (see Node::fingerprint()). Default is 0.
+    */
+    virtual size_t volatileHash(Settings const *settings) const;
+    /*
     Resets any internal state for the Operator.
     Default behaviour clears any error message, any custom implementation should make sure to
     call the base method.
@@ -70,9 +161,15 @@ namespace Op
     /* Whether or not the Operator has an error set */
     bool hasError() const;
 
+    /* Sets the token the framework cancels the operator's current work with, may be nullptr */
+    void setCancelToken(CancelToken const *token);
+    /* Whether the current work has been cancelled and should be abandoned */
+    bool isCancelled() const;
+
   private:
     std::string m_error;
     std::string m_type = "";
+    CancelToken const *m_cancelToken = nullptr;
 
     friend OperatorRegistry;
 
@@ -3,10 +3,14 @@
 #include <map>
 #include <string>
 
+#include "../constants.h"
 #include "Operator.h"
 
 #define REGISTER_OPERATOR(op_type, create_func) \
     bool op_type##_registered = OperatorRegistry::registerOperator(#op_type, (create_func))
+// Registers an alternative implementation of op_type that runs on the CPU
+#define REGISTER_CPU_OPERATOR(op_type, create_func) \
+    bool op_type##_cpu_registered = OperatorRegistry::registerOperator(#op_type, (create_func), Backend_CPU)
 
 namespace Op
 {
@@ -16,9 +20,9 @@ namespace Op
         typedef std::function<Operator *()> FactoryFunction;
         typedef std::map<std::string, FactoryFunction> FactoryMap;
 
-        static bool registerOperator(const std::string &type, FactoryFunction func)
+        static bool registerOperator(const std::string &type, FactoryFunction func, Backend backend = Backend_GPU)
         {
-            FactoryMap *map = getFactoryMap();
+            FactoryMap *map = getFactoryMap(backend);
             if (map->find(type) != map->end())
             {
                 return false;
@@ -27,9 +31,13 @@ namespace Op
             return true;
         }
 
-        static Operator *create(const std::string &type)
+        /*
+        Creates an Operator of the given type for the backend. Types without an
+        implementation for the requested backend use the GPU implementation.
+        */
+        static Operator *create(const std::string &type, Backend backend = Backend_GPU)
         {
-            FactoryMap *map = getFactoryMap();
+            FactoryMap *map = getFactoryMap(hasBackend(type, backend) ? backend : Backend_GPU);
             if (map->find(type) == map->end())
             {
                 return nullptr;
@@ -39,6 +47,12 @@ namespace Op
             return op;
         }
 
+        static bool hasBackend(const std::string &type, Backend backend)
+        {
+            FactoryMap *map = getFactoryMap(backend);
+            return map->find(type) != map->end();
+        }
+
         class key_iterator : public FactoryMap::const_iterator
         {
         public:
@@ -50,21 +64,23 @@ namespace Op
 
         static key_iterator cbegin()
         {
-            FactoryMap *map = getFactoryMap();
+            FactoryMap *map = getFactoryMap(Backend_GPU);
             return map->cbegin();
         }
 
         static key_iterator cend()
         {
-            FactoryMap *map = getFactoryMap();
+            FactoryMap *map = getFactoryMap(Backend_GPU);
             return map->cend();
         }
 
     private:
-        static FactoryMap *getFactoryMap()
+        // Every type has a GPU implementation, other backends are optional
+        static FactoryMap *getFactoryMap(Backend backend)
         {
-            static FactoryMap map;
-            return &map;
+            static FactoryMap gpuMap;
+            static FactoryMap cpuMap;
+            return backend == Backend_CPU ? &cpuMap : &gpuMap;
         }
     };
 }
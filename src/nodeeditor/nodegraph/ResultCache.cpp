@@ -0,0 +1,178 @@
+#include <list>
+#include <memory>
+#include <unordered_map>
+
+#include "../log.h"
+#include "BakedResults.h"
+#include "DiskCache.h"
+#include "ResultCache.h"
+
+bool CachedResult::store([[maybe_unused]] ResultStore *store, [[maybe_unused]] size_t key) const
+{
+    return false;
+}
+bool LayeredResult::store(ResultStore *store, size_t key) const
+{
+    return store->insert(key, layers());
+}
+
+ResultCache::ResultCache(size_t capacityBytes) : m_capacity(capacityBytes) {}
+
+size_t ResultCache::capacity() const { return m_capacity; }
+void ResultCache::setCapacity(size_t capacityBytes)
+{
+    m_capacity = capacityBytes;
+    evict();
+}
+size_t ResultCache::size() const { return m_entries.size(); }
+size_t ResultCache::byteSize() const { return m_byteSize; }
+
+void ResultCache::insert(size_t key, std::unique_ptr<CachedResult> result)
+{
+    if (!result)
+    {
+        return;
+    }
+
+    auto it = m_lookup.find(key);
+    if (it != m_lookup.end())
+    {
+        erase(it->second);
+    }
+
+    m_byteSize += result->byteSize();
+    m_entries.push_front({key, std::move(result)});
+    m_lookup[key] = m_entries.begin();
+    LOG_DEBUG("Cached result %lu, cache holds %lu results (%lu bytes)", key, m_entries.size(), m_byteSize);
+    evict();
+}
+
+void ResultCache::hold(size_t key, std::unique_ptr<CachedResult> result)
+{
+    if (!result)
+    {
+        return;
+    }
+    LOG_DEBUG("Holding result %lu", key);
+    m_held[key] = std::move(result);
+}
+void ResultCache::releaseHeld()
+{
+    for (auto &[key, result] : m_held)
+    {
+        insert(key, std::move(result));
+    }
+    m_held.clear();
+}
+
+bool ResultCache::contains(size_t key) const
+{
+    return m_held.count(key) > 0 || m_lookup.find(key) != m_lookup.end() || (m_diskCache && m_diskCache->contains(key)) ||
+           (m_bakedResults && m_bakedResults->contains(key));
+}
+
+std::unique_ptr<CachedResult> ResultCache::take(size_t key)
+{
+    auto held = m_held.find(key);
+    if (held != m_held.end())
+    {
+        std::unique_ptr<CachedResult> result = std::move(held->second);
+        m_held.erase(held);
+        return result;
+    }
+
+    auto it = m_lookup.find(key);
+    if (it == m_lookup.end())
+    {
+        return load(key);
+    }
+
+    m_byteSize -= it->second->result->byteSize();
+    std::unique_ptr<CachedResult> result = std::move(it->second->result);
+    erase(it->second);
+    return result;
+}
+
+void ResultCache::clear()
+{
+    m_held.clear();
+    m_lookup.clear();
+    m_entries.clear();
+    m_byteSize = 0;
+}
+
+void ResultCache::setDiskCache(DiskCache *diskCache) { m_diskCache = diskCache; }
+DiskCache *ResultCache::diskCache() const { return m_diskCache; }
+void ResultCache::setBakedResults(BakedResults *bakedResults) { m_bakedResults = bakedResults; }
+
+size_t ResultCache::store(ResultStore *store)
+{
+    size_t numStored = 0;
+    for (const auto &[key, result] : m_held)
+    {
+        if (!store->contains(key) && result->store(store, key))
+        {
+            ++numStored;
+        }
+    }
+    for (const Entry &entry : m_entries)
+    {
+        if (!store->contains(entry.key) && entry.result->store(store, entry.key))
+        {
+            ++numStored;
+        }
+    }
+    return numStored;
+}
+bool ResultCache::store(size_t key, ResultStore *store)
+{
+    if (store->contains(key))
+    {
+        return false;
+    }
+    auto held = m_held.find(key);
+    if (held != m_held.end())
+    {
+        return held->second->store(store, key);
+    }
+    auto it = m_lookup.find(key);
+    if (it != m_lookup.end())
+    {
+        return it->second->result->store(store, key);
+    }
+    std::unique_ptr<CachedResult> result = load(key);
+    return result && result->store(store, key);
+}
+
+std::unique_ptr<CachedResult> ResultCache::load(size_t key) const
+{
+    std::unique_ptr<CachedResult> result;
+    if (m_diskCache)
+    {
+        result = m_diskCache->load(key);
+    }
+    if (!result && m_bakedResults)
+    {
+        result = m_bakedResults->load(key);
+    }
+    return result;
+}
+
+void ResultCache::erase(std::list<Entry>::iterator it)
+{
+    if (it->result)
+    {
+        m_byteSize -= it->result->byteSize();
+    }
+    m_lookup.erase(it->key);
+    m_entries.erase(it);
+}
+
+void ResultCache::evict()
+{
+    while (m_byteSize > m_capacity && !m_entries.empty())
+    {
+        LOG_DEBUG("Evicting cached result %lu", m_entries.back().key);
+        erase(std::prev(m_entries.end()));
+    }
+}
@@ -0,0 +1,134 @@
+#pragma once
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class BakedResults;
+class DiskCache;
+class ResultStore;
+
+/*
+A processed Operator's output, detached from the Operator so that it can be held
+by the ResultCache and handed back to an Operator with the same fingerprint.
+*/
+class CachedResult
+{
+public:
+    virtual ~CachedResult() = default;
+
+    /* Approximate memory held by the result, used to enforce the cache capacity */
+    virtual size_t byteSize() const = 0;
+    /* Writes the result to the store under the key. Default returns false, ie, not persistable. */
+    virtual bool store(ResultStore *store, size_t key) const;
+};
+
+/* One image of a result, eg, a layer of a RenderSet */
+struct CachedLayer
+{
+    std::string name;
+    int width;
+    int height;
+    // Backend specific, eg, the GL internal format
+    int format;
+    const void *data;
+    size_t byteSize;
+};
+
+/* A result read back from a ResultStore as the layers it was written with */
+class LayeredResult : public CachedResult
+{
+public:
+    virtual const std::vector<CachedLayer> &layers() const = 0;
+    /* Writes the layers as read back, eg, to bake a result restored from the disk cache */
+    bool store(ResultStore *store, size_t key) const override;
+};
+
+/* Somewhere results can be written to as layers, eg, a DiskCache */
+class ResultStore
+{
+public:
+    virtual ~ResultStore() = default;
+
+    /* Writes the layers under the key. Returns false on failure. */
+    virtual bool insert(size_t key, const std::vector<CachedLayer> &layers) = 0;
+    virtual bool contains(size_t key) const = 0;
+};
+
+/*
+Least recently used cache of node results keyed by the node's fingerprint, ie, a
+hash of its operator type, settings and the fingerprints of everything upstream.
+
+Entries are evicted oldest first once the total byte size exceeds the capacity.
+Results are owned by the cache until taken, and destroyed on eviction so the cache
+must only be modified from the thread that owns any GL resources they hold.
+
+If a disk cache or baked results are set, results not held in memory are looked up in
+them, and store() writes the results held in memory to a store, eg, to the disk cache
+before the scene is closed.
+*/
+class ResultCache
+{
+public:
+    ResultCache(size_t capacityBytes);
+
+    size_t capacity() const;
+    void setCapacity(size_t capacityBytes);
+    size_t size() const;
+    size_t byteSize() const;
+
+    /* Adds the result to the cache, replacing any existing result for the key */
+    void insert(size_t key, std::unique_ptr<CachedResult> result);
+    /*
+    Holds the result apart from the cached results until taken, so it's never evicted, eg, a
+    full size result set aside while a preview is processed at another size.
+    */
+    void hold(size_t key, std::unique_ptr<CachedResult> result);
+    /* Moves the held results that weren't taken into the cache, evicting as usual */
+    void releaseHeld();
+    /* Whether the result for the key is cached or held in memory, on disk or baked */
+    bool contains(size_t key) const;
+    /*
+    Removes and returns the result for the key, or nullptr if not cached. Results on disk
+    or baked are read, not removed.
+    */
+    std::unique_ptr<CachedResult> take(size_t key);
+    void clear();
+
+    /* Sets the disk cache backing this one, not owned. nullptr disables it. */
+    void setDiskCache(DiskCache *diskCache);
+    DiskCache *diskCache() const;
+    /* Sets results baked with a scene to fall back on after the disk cache, not owned. nullptr disables them. */
+    void setBakedResults(BakedResults *bakedResults);
+    /* Writes every result cached or held in memory that isn't in the store yet to it. Returns the number written. */
+    size_t store(ResultStore *store);
+    /*
+    Writes the result for the key to the store, read from the disk cache or baked results if
+    it isn't held in memory, eg, to bake a scene opened with baked results again. Returns
+    true if written.
+    */
+    bool store(size_t key, ResultStore *store);
+
+protected:
+    struct Entry
+    {
+        size_t key;
+        std::unique_ptr<CachedResult> result;
+    };
+
+    size_t m_capacity;
+    size_t m_byteSize = 0;
+    DiskCache *m_diskCache = nullptr;
+    BakedResults *m_bakedResults = nullptr;
+    // Most recently inserted results are at the front
+    std::list<Entry> m_entries;
+    std::unordered_map<size_t, std::list<Entry>::iterator> m_lookup;
+    // Results set aside by hold(), not counted against the capacity
+    std::unordered_map<size_t, std::unique_ptr<CachedResult>> m_held;
+
+    /* Reads the result for the key from the disk cache, then the baked results */
+    std::unique_ptr<CachedResult> load(size_t key) const;
+    void erase(std::list<Entry>::iterator it);
+    void evict();
+};
@@ -1,21 +1,37 @@
+#include <algorithm>
+#include <chrono>
 #include <condition_variable>
+#include <filesystem>
+#include <fstream>
 #include <functional>
 #include <memory>
 #include <mutex>
+#include <sstream>
 #include <string>
 #include <thread>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
+#include <glm/glm.hpp>
+
 #include "../constants.h"
 #include "../log.h"
 #include "../util.h"
+#include "BinarySerializer.h"
 #include "Iterators.h"
 #include "Node.h"
 #include "Scene.h"
+#include "Serializer.h"
+
+// How long edits must stop for before the full resolution image replaces a proxy
+static const std::chrono::milliseconds PROXY_REFINE_DELAY{250};
 
-Scene::Scene()
+Scene::Scene() : m_resultCache(DEFAULT_RESULT_CACHE_BYTES), m_scheduler(&m_resultCache), m_outputBudget(DEFAULT_OUTPUT_BUDGET_BYTES), m_proxyFactor(DEFAULT_PROXY_FACTOR), m_coalesceWindow(DEFAULT_COALESCE_WINDOW_MS)
 {
     registerSettings(&m_settings);
+    m_appliedSettings = m_settings;
+    publishSnapshot();
 }
 Scene::~Scene()
 {
@@ -27,45 +43,186 @@ Scene::~Scene()
 
 NodeID Scene::createNode(std::string nodeType)
 {
-    return getCurrentGraph()->createNode(nodeType);
+    NodeID nodeID = Graph::reserveID();
+    post([this, nodeID, nodeType]()
+         {
+             if (!m_graph.createNode(nodeID, nodeType))
+             {
+                 LOG_ERROR("Failed to create node type: %s", nodeType.c_str());
+             } });
+    return nodeID;
 }
 Graph *Scene::getCurrentGraph() { return &m_graph; }
 Graph const *Scene::getCurrentGraph() const { return &m_graph; }
+std::shared_ptr<GraphSnapshot const> Scene::snapshot() const { return std::atomic_load(&m_snapshot); }
 Node *Scene::getCurrentNode() { return m_currNode; }
-Node *Scene::getViewNode()
+Node *Scene::getViewNode() { return snapshot()->node(m_viewNodeID.load()); }
+Node *Scene::getSelectedNode() { return snapshot()->node(m_selectedNodeID.load()); }
+Node *Scene::getNode(NodeID nodeID) { return snapshot()->node(nodeID); }
+
+void Scene::setDirty()
 {
-    for (auto it = getCurrentGraph()->begin(); it != getCurrentGraph()->end(); ++it)
+    // Cancelled before flagging so the thread always replaces the cancelled schedule
+    m_scheduler.cancel();
+    m_lastEdited = std::chrono::steady_clock::now().time_since_epoch().count();
+    m_isDirty = true;
+    // The lock is only taken if the thread may be waiting, otherwise it checks the flag
+    // before going to sleep
+    if (m_internalPause.load() || m_paused.load())
     {
-        if (it->hasSelectFlag(SelectFlag_View))
-        {
-            return &(*it);
-        }
+        std::lock_guard<std::mutex> guard(m_mutex);
+        m_internalPause = false;
+        m_condition.notify_one();
     }
-    return nullptr;
 }
-Node *Scene::getSelectedNode()
+
+void Scene::post(EditQueue::Edit edit)
 {
-    for (auto it = m_graph.begin(); it != m_graph.end(); ++it)
+    if (m_thread)
     {
-        if (it->hasSelectFlag(SelectFlag_Select))
-        {
-            return &(*it);
-        }
+        m_edits.push(std::move(edit));
+    }
+    else
+    {
+        edit();
+        publishSnapshot();
     }
-    return nullptr;
+    setDirty();
 }
-Node *Scene::getNode(NodeID nodeID) { return m_graph.node(nodeID); }
 
-void Scene::setDirty()
+void Scene::updateSetting(Node *node, const std::string &name, SettingValue value)
 {
-    m_isDirty = true;
-    setInternalPause(false);
+    // The edited settings are only touched by this thread, the applied ones only by the queue
+    node->editSetting(name, value);
+    NodeID nodeID = node->id();
+    post([this, nodeID, name, value]()
+         {
+             if (Node *node = m_graph.node(nodeID))
+             {
+                 node->applySetting(name, value);
+             } });
+}
+
+bool Scene::connect(Connector *a, Connector *b)
+{
+    if (!a->canConnect(b))
+    {
+        return false;
+    }
+    NodeID nodeA = a->node()->id(), nodeB = b->node()->id();
+    Connector::Type typeA = a->type(), typeB = b->type();
+    size_t indexA = a->index(), indexB = b->index();
+    post([=]()
+         {
+             Connector *connA = connector(nodeA, typeA, indexA);
+             Connector *connB = connector(nodeB, typeB, indexB);
+             if (!connA || !connB || !connA->connect(connB))
+             {
+                 LOG_DEBUG("Failed to connect nodes %u and %u", nodeA, nodeB);
+             } });
+    return true;
+}
+
+void Scene::disconnectAll(Connector *conn)
+{
+    NodeID nodeID = conn->node()->id();
+    Connector::Type type = conn->type();
+    size_t index = conn->index();
+    post([this, nodeID, type, index]()
+         {
+             if (Connector *conn = connector(nodeID, type, index))
+             {
+                 conn->disconnectAll();
+             } });
+}
+
+void Scene::deleteNode(NodeID nodeID)
+{
+    post([this, nodeID]()
+         {
+             // Disconnecting marks the downstream nodes dirty
+             m_graph.deleteNode(nodeID); });
+}
+
+void Scene::setBackend(Backend backend)
+{
+    updateSceneSetting(SCENE_SETTING_BACKEND, int(backend));
+}
+Backend Scene::backend() const
+{
+    return Backend(m_settings.getInt(SCENE_SETTING_BACKEND));
+}
+Settings const *Scene::settings() const { return &m_settings; }
+void Scene::setOutputBudget(size_t bytes) { m_outputBudget = bytes; }
+size_t Scene::outputBudget() const { return m_outputBudget.load(); }
+void Scene::setResultCacheCapacity(size_t bytes) { m_resultCache.setCapacity(bytes); }
+void Scene::setDiskCache(const std::string &directory, size_t capacityBytes)
+{
+    post([this, directory, capacityBytes]()
+         {
+             m_resultCache.setDiskCache(nullptr);
+             m_diskCache.reset(directory.empty() ? nullptr : new DiskCache(directory, capacityBytes));
+             m_resultCache.setDiskCache(m_diskCache.get()); });
+}
+void Scene::storeResults()
+{
+    post([this]()
+         {
+             if (!m_diskCache)
+             {
+                 return;
+             }
+             size_t numStored = 0;
+             for (auto it = m_graph.begin(); it != m_graph.end(); ++it)
+             {
+                 numStored += it->storeResult(m_diskCache.get());
+             }
+             numStored += m_resultCache.store(m_diskCache.get());
+             LOG_INFO("Stored %lu results in %s", numStored, m_diskCache->directory().c_str()); });
+}
+void Scene::bake(const std::string &path)
+{
+    post([this, path]()
+         {
+             BakeWriter writer{path};
+             // Upstream first, so unprocessed nodes' fingerprints are calculated from their inputs'
+             for (Node *node : m_graph.topologicalOrder())
+             {
+                 if (!writer.isOk())
+                 {
+                     break;
+                 }
+                 // Nodes reset since being processed, or never processed since the scene was
+                 // opened, may still have their result in the cache, on disk or baked
+                 if (node->state() == State::Processed)
+                 {
+                     node->storeResult(&writer);
+                 }
+                 else
+                 {
+                     node->updateFingerprint(&m_appliedSettings);
+                     m_resultCache.store(node->fingerprint(), &writer);
+                 }
+             }
+             if (writer.finish())
+             {
+                 LOG_INFO("Baked %lu results in %s, %lu bytes compressed to %lu", writer.size(), path.c_str(),
+                          writer.rawByteSize(), writer.storedByteSize());
+             } });
 }
 
 void Scene::clear()
 {
-    m_currNode = nullptr;
-    m_graph.clear();
+    post([this]()
+         {
+             m_currNode = nullptr;
+             m_graph.clear();
+             m_resultCache.setBakedResults(nullptr);
+             m_bakedResults.reset();
+             m_viewNodeID = 0;
+             m_selectedNodeID = 0;
+             m_targetIDs.clear();
+             m_targetsChanged = true; });
 }
 
 void Scene::setViewNode(Node *node)
@@ -75,23 +232,114 @@ void Scene::setViewNode(Node *node)
     {
         viewNode->clearSelectFlag(SelectFlag_View);
     }
-    if (!node)
+    if (node)
+    {
+        node->setSelectFlag(SelectFlag_View);
+    }
+    m_viewNodeID = node ? node->id() : 0;
+
+    // The thread rebuilds its schedule from the new view node, or drops the old one's, and
+    // publishes its layers so is woken even if it's processed or the scene is paused
+    m_targetsChanged = true;
+    setDirty();
+    if (node)
+    {
+        LOG_DEBUG("View node changed to '%s'", node->type().c_str());
+    }
+}
+
+void Scene::setTargetNodes(std::vector<NodeID> nodeIDs)
+{
+    LOG_DEBUG("Targeting %lu nodes", nodeIDs.size());
+    post([this, nodeIDs]()
+         {
+             m_targetIDs = nodeIDs;
+             m_targetsChanged = true; });
+}
+
+std::vector<NodeID> Scene::findNodes(const std::string &nodeType) const
+{
+    std::shared_ptr<GraphSnapshot const> graph = snapshot();
+    std::vector<NodeID> nodeIDs;
+    for (const auto &entry : *graph)
+    {
+        if (entry->node()->type() == nodeType)
+        {
+            nodeIDs.push_back(entry->node()->id());
+        }
+    }
+    return nodeIDs;
+}
+
+void Scene::setSelectedNode(Node *node)
+{
+    Node *selectedNode = getSelectedNode();
+    if (selectedNode)
+    {
+        selectedNode->clearSelectFlag(SelectFlag_Select);
+    }
+    if (node)
+    {
+        node->setSelectFlag(SelectFlag_Select);
+    }
+    m_selectedNodeID = node ? node->id() : 0;
+}
+
+void Scene::setViewRegion(glm::ivec2 origin, glm::ivec2 size)
+{
+    std::lock_guard<std::mutex> guard(m_viewRegionMutex);
+    if (origin == m_viewRegionOrigin && size == m_viewRegionSize)
     {
         return;
     }
-    node->setSelectFlag(SelectFlag_View);
+    m_viewRegionOrigin = origin;
+    m_viewRegionSize = size;
+    // The thread only reacts if it's evaluating or previewing a region
+    m_viewRegionChanged = true;
+}
+void Scene::setProxyFactor(int factor) { m_proxyFactor = std::max(1, factor); }
+int Scene::proxyFactor() const { return m_proxyFactor.load(); }
+void Scene::setCoalesceWindow(std::chrono::milliseconds window) { m_coalesceWindow = std::max<std::chrono::milliseconds::rep>(0, window.count()); }
+std::chrono::milliseconds Scene::coalesceWindow() const { return std::chrono::milliseconds(m_coalesceWindow.load()); }
+bool Scene::isEvaluatingPreview() const { return m_previewPass.load() != PreviewPass_None; }
 
-    // TODO: m_currNode is not thread safe currently
-    m_currNode = calculateCurrentNode(node);
-    LOG_DEBUG(
-        "View node changed to '%s', current calculated as: '%s'",
-        (node ? node->type().c_str() : "None"),
-        (m_currNode ? m_currNode->type().c_str() : "None"));
+int Scene::upstreamMargin(Node *node) const
+{
+    std::unordered_map<Node *, int> margins;
+    return upstreamMargin(node, margins);
+}
+
+int Scene::upstreamMargin(Node *node, std::unordered_map<Node *, int> &margins)
+{
+    auto it = margins.find(node);
+    if (it != margins.end())
+    {
+        return it->second;
+    }
 
-    if (node->state() != State::Processed)
+    Op::Footprint footprint = node->op() ? node->op()->footprint(node->appliedSettings()) : Op::Footprint();
+    int margin = footprint.bounded ? footprint.margin : -1;
+    // Regions grow by the longest path upstream
+    int upstream = 0;
+    for (size_t i = 0; i < node->numInputs(); ++i)
+    {
+        Connector *conn = node->input(i);
+        for (size_t j = 0; j < conn->numConnections(); ++j)
+        {
+            int inputMargin = upstreamMargin(conn->connection(j)->node(), margins);
+            if (inputMargin < 0)
+            {
+                margin = -1;
+            }
+            upstream = std::max(upstream, inputMargin);
+        }
+    }
+    if (margin >= 0)
     {
-        setInternalPause(false);
+        margin += upstream;
     }
+    margins[node] = margin;
+    return margin;
 }
 
 bool Scene::startProcessing()
@@ -112,8 +360,12 @@ void Scene::stopProcessing()
     m_stopped = true;
     setInternalPause(false);
     setPaused(false);
-    LOG_INFO("Waiting on thread to stop");
-    m_thread->join();
+    if (m_thread)
+    {
+        LOG_INFO("Waiting on thread to stop");
+        m_thread->join();
+        m_thread.reset();
+    }
 }
 
 void Scene::setPaused(bool paused)
@@ -144,7 +396,8 @@ bool Scene::isPaused()
 bool Scene::waitToProcess()
 {
     std::unique_lock<std::mutex> lock(m_mutex);
-    m_condition.wait(lock, std::bind(&Scene::isActive, this));
+    m_condition.wait(lock, [this]()
+                     { return isActive() || m_isDirty.load(); });
     return true;
 }
 
@@ -157,30 +410,91 @@ void Scene::process()
     // immediate when it wakes up
     while (waitToProcess() && !m_stopped.load())
     {
-        // Ensure all state changes are processed first and reevaluate state
-        if (maybeCleanNodes())
+        // Edits soon after the last were applied wait for any more to arrive, the work
+        // they make stale has already been cancelled
+        if (m_isDirty.load() && waitUntil(m_lastCleaned + coalesceWindow()))
         {
-            LOG_DEBUG("Cleaned up state");
-            m_currNode = calculateCurrentNode(getViewNode());
             continue;
         }
 
-        Node *viewNode = getViewNode();
-        // If the current node is invalid or doesn't need processing, wait for changes
-        if (!m_currNode || !viewNode || m_currNode->state() == State::Error || (m_currNode == viewNode && m_currNode->state() == State::Processed))
+        // Ensure all state changes are processed first and reevaluate state
+        bool edited = applyEdits();
+        bool cleaned = maybeCleanNodes();
+        if (cleaned)
+        {
+            m_lastCleaned = std::chrono::steady_clock::now();
+        }
+        bool regionMoved = m_viewRegionChanged.exchange(false) && isViewRegionStale();
+        if (m_targetsChanged.exchange(false) || edited || cleaned || regionMoved)
+        {
+            LOG_DEBUG("Rescheduling nodes");
+            scheduleTargets();
+            maybePublishView();
+            continue;
+        }
+        // Woken while paused only to apply edits
+        if (!isActive())
         {
-            setInternalPause(true);
             continue;
         }
 
-        // If the node completed processing, advance to the next node
-        if (m_currNode->processStep(&m_settings) && m_currNode->state() == State::Processed)
+        if (m_scheduler.isFinished())
         {
-            m_currNode = calculateCurrentNode(viewNode);
+            // The full image is only processed once the preview is shown
+            if (m_previewPass.load() != PreviewPass_None)
+            {
+                if (m_previewPass.load() != PreviewPass_Proxy || !waitForIdleInput())
+                {
+                    finishPreviewPass();
+                }
+                continue;
+            }
+            if (m_hasPreview)
+            {
+                clearPreview();
+                m_hasPreview = false;
+            }
+            // Full size results held for a preview and not restored are no longer needed
+            m_resultCache.releaseHeld();
+            // If there is nothing left that can be processed, wait for changes. Edits
+            // flag the scene dirty before checking if the thread is paused.
+            m_currNode = nullptr;
+            setInternalPause(true);
+            if (m_isDirty.load())
+            {
+                setInternalPause(false);
+            }
+            continue;
         }
+
+        m_currNode = m_scheduler.step(m_previewPass.load() != PreviewPass_None ? &m_previewSettings : &m_appliedSettings);
+        m_processOne = false;
+        maybePublishView();
+        evictOutputs(targetNodes());
     }
 }
 
+void Scene::capturePreview([[maybe_unused]] Node *viewNode, [[maybe_unused]] glm::ivec2 offset, [[maybe_unused]] glm::ivec2 size, [[maybe_unused]] glm::ivec2 origin, [[maybe_unused]] glm::ivec2 extent) {}
+void Scene::clearPreview() {}
+void Scene::publishView([[maybe_unused]] Node *viewNode) {}
+
+void Scene::maybePublishView()
+{
+    Node *viewNode = m_graph.node(m_viewNodeID.load());
+    NodeID viewID = viewNode ? viewNode->id() : 0;
+    // Outputs evaluated for a preview aren't the size of the image
+    bool isProcessed = viewNode && viewNode->state() == State::Processed && m_previewPass.load() == PreviewPass_None;
+    size_t fingerprint = isProcessed ? viewNode->fingerprint() : 0;
+    // Outputs of an edited view node stay published until it's processed again
+    if (viewID == m_publishedViewID && (!isProcessed || fingerprint == m_publishedFingerprint))
+    {
+        return;
+    }
+    publishView(isProcessed ? viewNode : nullptr);
+    m_publishedViewID = viewID;
+    m_publishedFingerprint = fingerprint;
+}
+
 bool Scene::isActive()
 {
     // Stop on step requests advancing a single operator step and should occur
@@ -208,50 +522,337 @@ void Scene::setInternalPause(bool paused)
     }
 }
 
-Node *Scene::calculateCurrentNode(Node *viewNode) const
+std::vector<Node *> Scene::targetNodes()
 {
-    // Everything is up to date, nothing to do
-    if (!viewNode || viewNode->state() == State::Processed)
+    std::vector<Node *> targets;
+    Node *viewNode = m_graph.node(m_viewNodeID.load());
+    if (viewNode)
     {
-        LOG_DEBUG("Current view node is fully processed, no new current node");
-        return nullptr;
+        targets.push_back(viewNode);
     }
+    // Targets may have been deleted since they were set
+    for (NodeID nodeID : m_targetIDs)
+    {
+        Node *node = m_graph.node(nodeID);
+        if (node && std::find(targets.begin(), targets.end(), node) == targets.end())
+        {
+            targets.push_back(node);
+        }
+    }
+    return targets;
+}
+
+void Scene::scheduleTargets()
+{
+    std::vector<Node *> targets = targetNodes();
+    // Nodes can't be reset while a worker is processing them
+    m_scheduler.clear();
+    if (m_previewPass.load() != PreviewPass_None)
+    {
+        // An unfinished preview's results can't be used for anything else
+        resetPreviewNodes();
+        m_previewPass = PreviewPass_None;
+    }
+
+    // Previews are only shown of the view node
+    bool canPreview = targets.size() == 1 && targets[0]->id() == m_viewNodeID.load();
+    PreviewPass pass = PreviewPass_None;
+    if (canPreview && prepareRegionPass(targets))
+    {
+        pass = PreviewPass_Region;
+    }
+    else if (canPreview && prepareProxyPass(targets))
+    {
+        pass = PreviewPass_Proxy;
+    }
+
+    if (pass != PreviewPass_None)
+    {
+        glm::ivec2 size = m_previewSettings.getInt2(SCENE_SETTING_IMAGE_SIZE);
+        LOG_DEBUG("Processing a %dx%d preview first", size.x, size.y);
+        // Full size results are held and restored once the preview is done
+        resetUpstream(targets);
+        m_previewPass = pass;
+    }
+    else if (m_hasPreview)
+    {
+        clearPreview();
+        m_hasPreview = false;
+    }
+    m_scheduler.schedule(targets);
+}
+
+bool Scene::prepareRegionPass(const std::vector<Node *> &targets)
+{
+    glm::ivec2 start, end;
+    if (targets.size() != 1 || targets[0]->state() == State::Processed || !visibleRegion(start, end))
+    {
+        return false;
+    }
+    int margin = upstreamMargin(targets[0]);
+    if (margin < 0)
+    {
+        return false;
+    }
+
+    glm::ivec2 imageSize = m_appliedSettings.getInt2(SCENE_SETTING_IMAGE_SIZE);
+    glm::ivec2 regionStart = glm::max(start - margin, glm::ivec2(0));
+    glm::ivec2 regionEnd = glm::min(end + margin, imageSize);
+    if (regionStart == glm::ivec2(0) && regionEnd == imageSize)
+    {
+        return false;
+    }
+
+    m_previewOrigin = start;
+    m_previewSize = end - start;
+    m_previewSettings = m_appliedSettings;
+    m_previewSettings.registerInt2(SCENE_SETTING_IMAGE_ORIGIN, regionStart);
+    m_previewSettings.get(SCENE_SETTING_IMAGE_SIZE)->set(regionEnd - regionStart);
+    return true;
+}
+
+bool Scene::prepareProxyPass(const std::vector<Node *> &targets)
+{
+    int factor = m_proxyFactor.load();
+    glm::ivec2 imageSize = m_appliedSettings.getInt2(SCENE_SETTING_IMAGE_SIZE);
+    glm::ivec2 proxySize = imageSize / factor;
+    if (factor <= 1 || targets.size() != 1 || targets[0]->state() == State::Processed || proxySize.x < 1 || proxySize.y < 1)
+    {
+        return false;
+    }
+
+    m_previewOrigin = glm::ivec2(0);
+    m_previewSize = imageSize;
+    m_previewSettings = m_appliedSettings;
+    m_previewSettings.registerFloat(SCENE_SETTING_PIXEL_SCALE, 1.0f / factor);
+    m_previewSettings.get(SCENE_SETTING_IMAGE_SIZE)->set(proxySize);
+    return true;
+}
 
-    // Depth-first search up from target and return the deepest unprocessed node
-    // (ie, prev node when the iteration has to move to a sibling or shallower node)
-    DepthIterator it{viewNode, GraphDirection_Upstream, IteratorFlags_SkipProcessed};
-    DepthIterator last = it++;
-    for (; it != DepthIterator(); last = it++)
+void Scene::finishPreviewPass()
+{
+    std::vector<Node *> targets = targetNodes();
+    if (!targets.empty() && targets[0]->state() == State::Processed)
     {
-        if (it.depth() <= last.depth())
+        if (m_previewPass.load() == PreviewPass_Region)
+        {
+            glm::ivec2 regionOrigin = m_previewSettings.getInt2(SCENE_SETTING_IMAGE_ORIGIN);
+            capturePreview(targets[0], m_previewOrigin - regionOrigin, m_previewSize, m_previewOrigin, m_previewSize);
+        }
+        else
         {
-            break;
+            glm::ivec2 proxySize = m_previewSettings.getInt2(SCENE_SETTING_IMAGE_SIZE);
+            capturePreview(targets[0], glm::ivec2(0), proxySize, m_previewOrigin, m_previewSize);
         }
+        m_hasPreview = true;
     }
 
-    LOG_DEBUG("New current node calculated as '%s'", last->type().c_str());
-    return &(*last);
+    LOG_DEBUG("Processed the preview, processing the full image");
+    m_scheduler.clear();
+    resetPreviewNodes();
+    m_previewPass = PreviewPass_None;
+    m_scheduler.schedule(targets);
 }
 
-bool Scene::maybeCleanNodes()
+bool Scene::waitForIdleInput()
 {
-    if (!m_isDirty.load())
+    std::chrono::steady_clock::time_point lastEdited{std::chrono::steady_clock::duration(m_lastEdited.load())};
+    // Further edits reschedule the proxy once the wait is over
+    return waitUntil(lastEdited + PROXY_REFINE_DELAY);
+}
+
+bool Scene::waitUntil(std::chrono::steady_clock::time_point deadline)
+{
+    std::chrono::steady_clock::duration remaining = deadline - std::chrono::steady_clock::now();
+    if (remaining <= std::chrono::steady_clock::duration::zero())
     {
         return false;
     }
-    m_isDirty = false;
-    for (auto it = m_graph.begin(); it != m_graph.end(); ++it)
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_condition.wait_for(lock, remaining, [this]()
+                         { return m_stopped.load(); });
+    return true;
+}
+
+bool Scene::visibleRegion(glm::ivec2 &start, glm::ivec2 &end)
+{
+    glm::ivec2 origin, size;
     {
-        if (it->isDirty())
+        std::lock_guard<std::mutex> guard(m_viewRegionMutex);
+        origin = m_viewRegionOrigin;
+        size = m_viewRegionSize;
+    }
+    glm::ivec2 imageSize = m_appliedSettings.getInt2(SCENE_SETTING_IMAGE_SIZE);
+    start = glm::clamp(origin, glm::ivec2(0), imageSize);
+    end = glm::clamp(origin + size, glm::ivec2(0), imageSize);
+    return end.x > start.x && end.y > start.y;
+}
+
+bool Scene::isViewRegionStale()
+{
+    // Once the full image is processed the view region no longer matters
+    PreviewPass pass = m_previewPass.load();
+    if (pass == PreviewPass_Proxy || (pass == PreviewPass_None && (!m_hasPreview || m_scheduler.isFinished())))
+    {
+        return false;
+    }
+    glm::ivec2 start, end;
+    if (!visibleRegion(start, end))
+    {
+        return false;
+    }
+    if (pass == PreviewPass_Region)
+    {
+        return start != m_previewOrigin || end - start != m_previewSize;
+    }
+    // The preview is kept while it still covers everything visible
+    glm::ivec2 previewEnd = m_previewOrigin + m_previewSize;
+    return start.x < m_previewOrigin.x || start.y < m_previewOrigin.y || end.x > previewEnd.x || end.y > previewEnd.y;
+}
+
+void Scene::resetUpstream(const std::vector<Node *> &targets)
+{
+    m_previewNodeIDs.clear();
+    for (Node *target : targets)
+    {
+        for (DepthIterator it{target}; it != DepthIterator(); ++it)
         {
-            LOG_DEBUG("Cleaning node '%s' and downstream", it->type().c_str());
-            // All nodes after (and including) a dirty node must be reset
-            for (DepthIterator it2{&(*it), GraphDirection_Downstream}; it2 != DepthIterator(); it2++)
+            m_previewNodeIDs.push_back(it->id());
+            // Kept whatever the cache's capacity, including pinned nodes' results
+            if (it->state() != State::Unprocessed)
             {
-                it2->reset();
+                it->reset(&m_resultCache, true);
             }
         }
     }
+}
+
+void Scene::resetPreviewNodes()
+{
+    // Nodes processed outside the preview, eg, for other targets, are at full size and kept
+    for (NodeID nodeID : m_previewNodeIDs)
+    {
+        Node *node = m_graph.node(nodeID);
+        if (node && node->state() != State::Unprocessed)
+        {
+            node->reset(&m_resultCache);
+        }
+    }
+    m_previewNodeIDs.clear();
+}
+
+void Scene::evictOutputs(const std::vector<Node *> &targets)
+{
+    size_t budget = m_outputBudget.load();
+    if (budget == 0 || m_graph.outputByteSize() <= budget)
+    {
+        return;
+    }
+
+    std::unordered_set<Node *> needed;
+    for (Node *target : targets)
+    {
+        for (DepthIterator it{target, GraphDirection_Upstream}; it != DepthIterator(); ++it)
+        {
+            needed.insert(&(*it));
+        }
+    }
+    for (auto it = m_graph.begin(); it != m_graph.end() && m_graph.outputByteSize() > budget; ++it)
+    {
+        if (it->state() != State::Processed || needed.count(&(*it)))
+        {
+            continue;
+        }
+        // Downstream nodes may hold the node's textures in their RenderSets so are reset
+        // with it, none of them can be needed by the targets either
+        std::vector<Node *> evicted;
+        bool pending = false;
+        for (DepthIterator it2{&(*it), GraphDirection_Downstream}; it2 != DepthIterator() && !pending; ++it2)
+        {
+            pending = it2->state() != State::Processed && m_scheduler.isScheduled(&(*it2));
+            evicted.push_back(&(*it2));
+        }
+        if (pending)
+        {
+            continue;
+        }
+        for (Node *node : evicted)
+        {
+            if (node->state() == State::Processed)
+            {
+                LOG_DEBUG("Evicting outputs of '%s'", node->type().c_str());
+                node->reset(&m_resultCache);
+            }
+        }
+    }
+}
+
+bool Scene::applyEdits()
+{
+    if (m_edits.empty())
+    {
+        return false;
+    }
+    // Nothing may be processing while the graph changes
+    m_scheduler.clear();
+    m_currNode = nullptr;
+    size_t count = m_edits.apply();
+    LOG_DEBUG("Applied %lu edits", count);
+    publishSnapshot();
+    return true;
+}
+
+void Scene::publishSnapshot()
+{
+    std::shared_ptr<GraphSnapshot const> previous = std::atomic_load(&m_snapshot);
+    std::atomic_store(&m_snapshot, m_graph.snapshot(previous.get()));
+}
+
+Connector *Scene::connector(NodeID nodeID, Connector::Type type, size_t index)
+{
+    Node *node = m_graph.node(nodeID);
+    if (!node)
+    {
+        return nullptr;
+    }
+    return type == Connector::Input ? node->input(index) : node->output(index);
+}
+
+void Scene::findFlaggedNodes()
+{
+    m_viewNodeID = 0;
+    m_selectedNodeID = 0;
+    for (auto it = m_graph.begin(); it != m_graph.end(); ++it)
+    {
+        if (it->hasSelectFlag(SelectFlag_View))
+        {
+            m_viewNodeID = it->id();
+        }
+        if (it->hasSelectFlag(SelectFlag_Select))
+        {
+            m_selectedNodeID = it->id();
+        }
+    }
+}
+
+bool Scene::maybeCleanNodes()
+{
+    if (!m_isDirty.load())
+    {
+        return false;
+    }
+    m_isDirty = false;
+    // Nodes can't be reset while a worker is processing them
+    m_scheduler.clear();
+    // All nodes after (and including) a dirty node must be reset, each only once however
+    // many dirty nodes it is downstream of
+    m_graph.invalidateDirty([this](Node *node)
+                            {
+                                if (node->isDirty())
+                                {
+                                    LOG_DEBUG("Cleaning node '%s' and downstream", node->type().c_str());
+                                }
+                                node->reset(&m_resultCache); });
     return true;
 }
 
@@ -274,34 +875,71 @@ bool Scene::processOne()
     return true;
 }
 
+bool Scene::evaluate(const std::vector<Node *> &targets, Settings const *sceneSettings)
+{
+    applyEdits();
+    maybeCleanNodes();
+    m_scheduler.schedule(targets);
+    while (!m_scheduler.isFinished())
+    {
+        m_currNode = m_scheduler.step(sceneSettings ? sceneSettings : &m_appliedSettings);
+    }
+    m_currNode = nullptr;
+
+    bool ok = true;
+    for (Node *target : targets)
+    {
+        if (target->state() != State::Processed)
+        {
+            LOG_ERROR("Failed to process node %u (%s)", target->id(), target->type().c_str());
+            ok = false;
+        }
+    }
+    return ok;
+}
+
 void Scene::registerSettings(Settings *settings) const
 {
     settings->registerInt2(SCENE_SETTING_IMAGE_SIZE, {DEFAULT_WIDTH, DEFAULT_HEIGHT});
+    settings->registerInt(SCENE_SETTING_BACKEND, Backend_GPU, {{"gpu", Backend_GPU}, {"cpu", Backend_CPU}});
 }
 
-bool Scene::serialize(Serializer *serializer) const
+void Scene::updateSceneSetting(const std::string &name, SettingValue value)
+{
+    m_settings.get(name)->set(value);
+    post([this, name, value]()
+         { m_appliedSettings.get(name)->set(value); });
+}
+
+bool Scene::serialize(Serializer *serializer, const std::string &bakedResults) const
 {
     bool ok = serializer->startObject(KEY_SETTINGS);
     ok = ok && m_settings.serialize(serializer, false); // Write ALL settings
     ok = ok && serializer->finishObject();
 
     ok = ok && serializer->startObject(KEY_GRAPH);
-    ok = ok && getCurrentGraph()->serialize(serializer);
+    ok = ok && snapshot()->serialize(serializer);
     ok = ok && serializer->finishObject();
+
+    if (!bakedResults.empty())
+    {
+        ok = ok && serializer->writePropertyString(KEY_BAKED, bakedResults);
+    }
     return ok;
 }
 
-bool Scene::deserialize(Deserializer *deserializer)
+bool Scene::deserialize(Deserializer *deserializer, const std::string &directory)
 {
-    setInternalPause(true);
-
-    Graph graph;
+    // Held by the edit that replaces the scene's graph, which must be copyable
+    std::shared_ptr<Graph> graph = std::make_shared<Graph>();
     // Must register default settings so that settings can be set. Also prevents
     // errors when deserializing old content that may be missing modern settings.
     Settings settings;
     registerSettings(&settings);
+    std::string bakedResults;
 
     bool ok = true;
+    bool hasGraph = false;
     std::string property;
     while (ok && deserializer->readProperty(property))
     {
@@ -314,18 +952,87 @@ bool Scene::deserialize(Deserializer *deserializer)
         else if (property == KEY_GRAPH)
         {
             ok = ok && deserializer->startReadObject();
-            ok = ok && graph.deserialize(deserializer);
+            ok = ok && graph->deserialize(deserializer);
             ok = ok && deserializer->finishReadObject();
+            hasGraph = ok;
+        }
+        else if (property == KEY_BAKED)
+        {
+            ok = ok && deserializer->readString(bakedResults);
         }
     }
+    // Reading stops early at the end of the data, eg, of a file cut short
+    if (ok && !hasGraph)
+    {
+        LOG_ERROR("Scene has no graph");
+        ok = false;
+    }
 
     if (ok)
     {
-        m_settings = std::move(settings);
-        m_graph = std::move(graph);
-        m_currNode = calculateCurrentNode(getViewNode());
+        m_settings = settings;
+        if (!bakedResults.empty())
+        {
+            bakedResults = (std::filesystem::path(directory) / bakedResults).string();
+        }
+        post([this, graph, settings, bakedResults]()
+             {
+                 m_appliedSettings = settings;
+                 m_graph = std::move(*graph);
+                 // Results are only restored from while their nodes' fingerprints match
+                 m_resultCache.setBakedResults(nullptr);
+                 m_bakedResults = bakedResults.empty() ? nullptr : BakedResults::open(bakedResults);
+                 m_resultCache.setBakedResults(m_bakedResults.get());
+                 findFlaggedNodes();
+                 m_targetIDs.clear();
+                 m_targetsChanged = true; });
     }
-
-    setInternalPause(false);
     return ok;
 }
+
+bool Scene::load(const std::string &filepath)
+{
+    // Baked results are named relative to the scene file
+    std::string directory = std::filesystem::path(filepath).parent_path().string();
+    std::unique_ptr<BinaryDeserializer> binary = BinaryDeserializer::open(filepath);
+    if (binary)
+    {
+        return loadVersioned(binary.get(), directory);
+    }
+
+    std::ifstream file{filepath};
+    if (!file.is_open())
+    {
+        LOG_ERROR("Failed to open: %s", filepath.c_str());
+        return false;
+    }
+
+    // Read the file into a buffer that a stringstream can read from
+    file.seekg(0, std::ios::end);
+    std::streampos filesize = file.tellg();
+    file.seekg(0, std::ios::beg);
+    std::vector<char> buffer(filesize);
+    file.read(buffer.data(), filesize);
+
+    std::stringstream ss;
+    ss.rdbuf()->pubsetbuf(buffer.data(), filesize);
+
+    StreamDeserializer deserializer{&ss};
+    return loadVersioned(&deserializer, directory);
+}
+bool Scene::loadVersioned(Deserializer *deserializer, const std::string &directory)
+{
+    std::string property;
+    int version;
+    if (deserializer->readProperty(property) && property == KEY_VERSION && deserializer->readInt(version))
+    {
+        deserializer->setVersion(version);
+    }
+    else
+    {
+        LOG_ERROR("Invalid file, must contain a leading version identifier");
+        return false;
+    }
+
+    return deserialize(deserializer, directory);
+}
@@ -1,20 +1,67 @@
 #pragma once
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <iostream>
 #include <memory>
 #include <mutex>
 #include <string>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
+#include <glm/glm.hpp>
+
+#include "BakedResults.h"
+#include "DiskCache.h"
+#include "EditQueue.h"
 #include "Graph.h"
+#include "GraphSnapshot.h"
 #include "Operator.h"
+#include "ResultCache.h"
+#include "Scheduler.h"
 #include "Serializer.h"
 #include "Settings.h"
 
+enum PreviewPass
+{
+    PreviewPass_None,
+    PreviewPass_Region, // Visible region at full resolution
+    PreviewPass_Proxy   // Full image at a reduced resolution
+};
+
 /*
 Scene owns no textures, each node owns the textures it generates.
+
+While the processing thread is running it's the only thread that modifies the graph.
+Edits from any other thread, eg, the UI, are queued without locking (see post()) and
+applied by the processing thread between steps, once every in-flight worker task has
+finished, so nothing being processed changes underneath it. Setting edits are made to
+the node's settings straight away so the UI reflects them, and only applied to the
+settings the node is evaluated with from the queue (see Node::appliedSettings()).
+
+Other threads read the graph's structure from the snapshot the processing thread takes
+after applying each batch of edits (see snapshot()), never the graph itself. Nodes found
+in a snapshot stay alive while it's held, even once deleted from the graph.
+
+While the view node is unprocessed, the processing thread first evaluates it over only
+the part of the image visible in the viewer (see setViewRegion()) if every operator
+upstream of it has a bounded footprint (see Operator::footprint). Every upstream node is
+evaluated over the visible region grown by the footprint margins, as for a tile (see
+TiledRenderer), and the result handed to capturePreview(). The region's results are then
+reset into the result cache and the full image is evaluated, restoring any full size
+results that were reset to make way for the region.
+
+Otherwise, if a proxy factor is set (see setProxyFactor()), the view node is first
+evaluated over the full image at a reduced resolution, with every setting measured in
+pixels scaled to match (see SettingHint_Pixels), and the result handed to
+capturePreview(). The full resolution image is only processed once no edits have been
+made for a short time, so dragging a setting only updates the proxy.
+
+Edits cancel any work in progress immediately (see Scheduler::cancel), but are only
+applied at most once per coalescing window (see setCoalesceWindow()). Edits made in
+quick succession, eg, while dragging a slider, are applied together rather than each
+starting work that the next would discard.
 */
 class Scene
 {
@@ -22,29 +69,122 @@ public:
     Scene();
     ~Scene();
 
+    /* Queues the creation of a node, returning the ID it will have once created */
     NodeID createNode(std::string nodeType);
 
-    // Gets the graph currently being processed
+    // Gets the graph currently being processed. Only the thread applying edits may use it.
     Graph *getCurrentGraph();
     Graph const *getCurrentGraph() const;
-    // Gets the node that is currently processing
+    /*
+    Gets the latest snapshot of the graph, taken once the last batch of edits was applied.
+    Thread safe and lock-free.
+    */
+    std::shared_ptr<GraphSnapshot const> snapshot() const;
+    // Gets the node last processed by the thread
     Node *getCurrentNode();
-    // Gets the node that the scene is trying to process up to
+    // Gets the node that the scene is trying to process up to, from the latest snapshot
     Node *getViewNode();
-    // Gets the first selected node
+    // Gets the selected node, from the latest snapshot
     Node *getSelectedNode();
-    // Gets a node from the scene by ID
+    // Gets a node by ID from the latest snapshot
     Node *getNode(NodeID nodeID);
     // Clears the scene to a fresh state
     void clear();
 
     void setDirty();
     /*
+    Queues an edit of the graph or scene settings, cancelling any processing in progress.
+    Edits are applied in order by the processing thread, or immediately if it's not
+    running. Edits must look up nodes by ID as they may have been deleted by an earlier
+    edit. Thread safe and lock-free.
+    */
+    void post(EditQueue::Edit edit);
+    /* Edits the node's setting, see post() */
+    void updateSetting(Node *node, const std::string &name, SettingValue value);
+    /*
+    Connects an input and output connector, see post(). Returns false if they can't be
+    connected, the connection may still fail once applied if either is full.
+    */
+    bool connect(Connector *a, Connector *b);
+    /* Disconnects everything from the connector, see post() */
+    void disconnectAll(Connector *connector);
+    /* Deletes the node, see post() */
+    void deleteNode(NodeID nodeID);
+    /*
+    Sets the backend used by nodes that don't set their own. Only affects nodes
+    processed after the change.
+    */
+    void setBackend(Backend backend);
+    Backend backend() const;
+    /*
+    Limits the memory held by the outputs of processed nodes. Once exceeded, processed
+    nodes the view node doesn't depend on are reset, moving their results to the cache.
+    0 is unlimited.
+    */
+    void setOutputBudget(size_t bytes);
+    size_t outputBudget() const;
+    /* Limits the memory held by results of reset nodes. Must not be called while processing. */
+    void setResultCacheCapacity(size_t bytes);
+    /*
+    Keeps results in the directory across sessions, see post(). Nodes whose fingerprint
+    matches a result on disk are restored from it instead of processed, eg, the unchanged
+    nodes of a scene that was stored before being closed. An empty directory disables it.
+    */
+    void setDiskCache(const std::string &directory, size_t capacityBytes);
+    /*
+    Writes the results of processed nodes, and those held in the result cache, to the disk
+    cache if set, see post().
+    */
+    void storeResults();
+    /*
+    Writes the results of processed nodes, and those held in the result cache, disk cache or
+    the scene's baked results, into a single compressed file at the path, see post(). A scene
+    serialized with the file's name restores matching nodes from it when loaded, so they
+    needn't be processed again.
+    */
+    void bake(const std::string &path);
+    /*
     Sets what operator the thread will process up to.
     If the target is already processed, no new processing is performed.
     */
     void setViewNode(Node *node);
     /*
+    Sets the nodes the thread processes up to along with the view node, eg, every Save
+    node to export them all, see post(). They're scheduled together with the view node,
+    so work they share upstream is done once, and kept processed as the graph is edited
+    until replaced. Previews are only evaluated while the view node is the only target.
+    */
+    void setTargetNodes(std::vector<NodeID> nodeIDs);
+    /* The IDs of every node of the type, from the latest snapshot */
+    std::vector<NodeID> findNodes(const std::string &nodeType) const;
+    /* Selects the node, deselecting any other. nullptr deselects every node. */
+    void setSelectedNode(Node *node);
+    /*
+    Sets the part of the image visible in the viewer, in pixels. An empty region, or one
+    covering the full image, disables evaluating the visible region first.
+    */
+    void setViewRegion(glm::ivec2 origin, glm::ivec2 size);
+    /*
+    Sets how many times smaller than the image the view node is evaluated first when the
+    visible region can't be evaluated alone, eg, 4 is a quarter of the width and height.
+    1 disables the proxy.
+    */
+    void setProxyFactor(int factor);
+    int proxyFactor() const;
+    /*
+    Sets the shortest time between edits being applied. Edits made within the window of
+    the last applied are held back until it has passed. 0 applies every edit immediately.
+    */
+    void setCoalesceWindow(std::chrono::milliseconds window);
+    std::chrono::milliseconds coalesceWindow() const;
+    /* Whether the thread is evaluating a preview of the view node, see PreviewPass */
+    bool isEvaluatingPreview() const;
+    /*
+    The number of pixels beyond a region of the node's output that the nodes upstream of
+    it must be evaluated over, or -1 if the footprint of any of them is unbounded.
+    */
+    int upstreamMargin(Node *node) const;
+    /*
     Starts the thread processing. Returns false if thread is already started.
     */
     bool startProcessing();
@@ -72,13 +212,44 @@ public:
     Returns true if there is anything to process, otherwise false.
     */
     bool processOne();
+    /*
+    Processes the target nodes and everything upstream of them to completion on the
+    calling thread, eg, for batch rendering. The calling thread must own a GL context and
+    the processing thread must not be running.
+
+    Nodes are processed with the scene's settings unless sceneSettings is given, eg, to
+    evaluate a region of the image (see TiledRenderer).
+
+    Returns true if every target was processed without error.
+    */
+    bool evaluate(const std::vector<Node *> &targets, Settings const *sceneSettings = nullptr);
+    Settings const *settings() const;
 
-    bool serialize(Serializer *serializer) const;
-    bool deserialize(Deserializer *deserializer);
+    /* Writes the scene, referring to the baked results file if given, see bake() */
+    bool serialize(Serializer *serializer, const std::string &bakedResults = "") const;
+    /* Reads a scene, opening any baked results it refers to relative to the directory */
+    bool deserialize(Deserializer *deserializer, const std::string &directory = "");
+    /*
+    Loads a scene file written with the StreamSerializer or BinarySerializer, replacing the
+    current scene. Binary files are recognised by their header and read from a memory map.
+    */
+    bool load(const std::string &filepath);
 
 protected:
     Graph m_graph;
+    // Scene settings as edited, and as applied by the processing thread for evaluation
     Settings m_settings;
+    Settings m_appliedSettings;
+    EditQueue m_edits;
+    // Only accessed with std::atomic_load and std::atomic_store
+    std::shared_ptr<GraphSnapshot const> m_snapshot;
+    // Results of reset nodes, restored if a node returns to the same fingerprint
+    ResultCache m_resultCache;
+    // Backs the result cache across sessions, only used by the thread
+    std::unique_ptr<DiskCache> m_diskCache;
+    // Results baked with the loaded scene, only used by the thread
+    std::unique_ptr<BakedResults> m_bakedResults;
+    Scheduler m_scheduler;
 
     // Thread variables. Lock is required for non-atomic states and the `stopped`
     // condition variable for pausing the thread.
@@ -92,10 +263,46 @@ protected:
     std::atomic<bool> m_stopped = false;
     std::atomic<bool> m_processOne = false;
     std::atomic<bool> m_isDirty = false;
-    // This is only ever read and written to by the thread
+    std::atomic<bool> m_targetsChanged = true;
+    std::atomic<size_t> m_outputBudget;
+    std::atomic<bool> m_viewRegionChanged = false;
+    std::atomic<PreviewPass> m_previewPass = PreviewPass_None;
+    std::atomic<int> m_proxyFactor;
+    std::atomic<std::chrono::steady_clock::rep> m_lastEdited = 0;
+    std::atomic<std::chrono::milliseconds::rep> m_coalesceWindow;
+    // Nodes with the view and select flags, 0 if none
+    std::atomic<NodeID> m_viewNodeID = 0;
+    std::atomic<NodeID> m_selectedNodeID = 0;
+    // These are only ever read and written to by the thread
     Node *m_currNode = nullptr;
+    std::vector<NodeID> m_targetIDs;
+    std::chrono::steady_clock::time_point m_lastCleaned;
+    // View node last handed to publishView(), and the fingerprint of its published outputs, 0 if none
+    NodeID m_publishedViewID = 0;
+    size_t m_publishedFingerprint = 0;
+
+    // Visible region as set by the viewer
+    std::mutex m_viewRegionMutex;
+    glm::ivec2 m_viewRegionOrigin{0};
+    glm::ivec2 m_viewRegionSize{0};
+    // Scene settings for the preview pass, and the part of the image it shows. Only used by the thread.
+    Settings m_previewSettings;
+    glm::ivec2 m_previewOrigin{0};
+    glm::ivec2 m_previewSize{0};
+    bool m_hasPreview = false;
+    // Nodes the preview pass evaluates, by ID as they may be deleted meanwhile
+    std::vector<NodeID> m_previewNodeIDs;
 
     void registerSettings(Settings *settings) const;
+    /* Edits a scene setting, see post() */
+    void updateSceneSetting(const std::string &name, SettingValue value);
+    /* Applies any queued edits once the scheduler has stopped. Returns true if any were applied. */
+    bool applyEdits();
+    /* Replaces the snapshot with one of the graph as it is now, on the thread applying edits */
+    void publishSnapshot();
+    Connector *connector(NodeID nodeID, Connector::Type type, size_t index);
+    /* Finds the view and selected nodes from their flags, eg, once a scene is loaded */
+    void findFlaggedNodes();
 
     /*
     Checks if any changes were made that would require an operator to be reset.
@@ -107,7 +314,23 @@ protected:
     */
     virtual void process();
     /*
-    Used by the thread to wait for work to be available, and to not be paused.
+    Called on the processing thread once the view node is processed for a preview. The
+    part of its output at offset of size covers extent pixels of the full image at origin,
+    ie, extent is larger than size for a proxy.
+    */
+    virtual void capturePreview(Node *viewNode, glm::ivec2 offset, glm::ivec2 size, glm::ivec2 origin, glm::ivec2 extent);
+    /* Called on the processing thread once the preview is no longer needed */
+    virtual void clearPreview();
+    /*
+    Called on the processing thread once the view node has new full size outputs for the
+    viewer, or with nullptr once the view node changes to one that has none
+    */
+    virtual void publishView(Node *viewNode);
+    /* Publishes the view node's outputs if they changed since they were last published */
+    void maybePublishView();
+    /*
+    Used by the thread to wait for work to be available, and to not be paused. Edits
+    wake the thread even when paused so they're applied.
     */
     bool waitToProcess();
     /*
@@ -120,9 +343,48 @@ protected:
     void setInternalPause(bool paused);
 
     /*
-    Calculates the next node to process based on current state and view node.
+    The nodes the thread is trying to process up to, the view node first if there is one.
+    */
+    std::vector<Node *> targetNodes();
+    /* Schedules the targets, starting with a preview pass if one can be evaluated */
+    void scheduleTargets();
+    /*
+    Sets up the region settings if the targets can be evaluated over the visible region
+    first. Returns false if the full image must be evaluated.
+    */
+    bool prepareRegionPass(const std::vector<Node *> &targets);
+    /*
+    Sets up the proxy settings if a proxy factor is set. Returns false if there's no proxy.
+    Full resolution results upstream are held while the proxy is processed, see resetUpstream().
+    */
+    bool prepareProxyPass(const std::vector<Node *> &targets);
+    /* Captures the preview's result and schedules the full image */
+    void finishPreviewPass();
+    /* Waits for edits to settle after a proxy pass. Returns false if there were no recent edits. */
+    bool waitForIdleInput();
+    /* Waits until the deadline or the thread is stopped. Returns false if it has already passed. */
+    bool waitUntil(std::chrono::steady_clock::time_point deadline);
+    /* Clips the visible region to the image. Returns false if none of it is visible. */
+    bool visibleRegion(glm::ivec2 &start, glm::ivec2 &end);
+    /* Whether the visible region has moved outside of the one being evaluated or previewed */
+    bool isViewRegionStale();
+    /* Reads the leading version identifier then deserializes the scene */
+    bool loadVersioned(Deserializer *deserializer, const std::string &directory);
+    /*
+    Resets every processed node upstream of the targets for a preview pass, which are
+    recorded as the nodes it evaluates. Their full size results are held by the cache
+    until restored by the full pass, see ResultCache::hold().
+    */
+    void resetUpstream(const std::vector<Node *> &targets);
+    /* Resets the nodes the preview pass evaluated, moving their preview results to the cache */
+    void resetPreviewNodes();
+    static int upstreamMargin(Node *node, std::unordered_map<Node *, int> &margins);
+    /*
+    Resets processed nodes that none of the targets depend on until the outputs fit in the
+    budget, see Graph::outputByteSize(). Nodes with anything downstream still waiting to be
+    processed are kept.
     */
-    Node *calculateCurrentNode(Node *viewNode) const;
+    void evictOutputs(const std::vector<Node *> &targets);
     /*
     Checks scene state and resets any nodes marked as dirty (or downstream of a dirty node)
     */
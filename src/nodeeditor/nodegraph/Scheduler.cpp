@@ -0,0 +1,382 @@
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+#include "../log.h"
+#include "Node.h"
+#include "ResultCache.h"
+#include "Settings.h"
+#include "Scheduler.h"
+
+// How long to wait on the oldest polled node when there is nothing else to do
+static const uint64_t POLL_TIMEOUT_NS = 1000000;
+
+Scheduler::Scheduler(ResultCache *cache, size_t numWorkers) : m_cache(cache), m_pool(numWorkers) {}
+
+void Scheduler::schedule(const std::vector<Node *> &targets)
+{
+    clear();
+
+    // Walk upstream from the targets recording the unprocessed dependencies of each
+    // node. Nodes are recorded in the order they're found so the ready queue is stable.
+    std::vector<Node *> order;
+    std::unordered_set<Node *> visited;
+    std::vector<Node *> stack;
+    for (Node *target : targets)
+    {
+        if (!target)
+        {
+            continue;
+        }
+        m_targets.insert(target);
+        if (target->state() != State::Processed)
+        {
+            stack.push_back(target);
+        }
+    }
+    while (!stack.empty())
+    {
+        Node *node = stack.back();
+        stack.pop_back();
+        if (!visited.insert(node).second)
+        {
+            continue;
+        }
+
+        Entry &entry = m_entries[node];
+        order.push_back(node);
+        for (size_t i = 0; i < node->numInputs(); ++i)
+        {
+            Connector *conn = node->input(i);
+            for (size_t j = 0; j < conn->numConnections(); ++j)
+            {
+                Node *upstream = conn->connection(j)->node();
+                if (upstream->state() == State::Processed)
+                {
+                    continue;
+                }
+                ++entry.numPending;
+                ++entry.numUnstarted;
+                entry.upstream.push_back(upstream);
+                // References to map elements remain valid on insertion
+                Entry &upstreamEntry = m_entries[upstream];
+                upstreamEntry.downstream.push_back(node);
+                ++upstreamEntry.numConsumers;
+                stack.push_back(upstream);
+            }
+        }
+    }
+    for (Node *node : order)
+    {
+        if (m_entries[node].numPending == 0 && node->state() != State::Error)
+        {
+            m_ready.push_back(node);
+        }
+    }
+    LOG_DEBUG("Scheduled %lu nodes, %lu ready", order.size(), m_ready.size());
+}
+
+void Scheduler::clear()
+{
+    wait();
+    {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        m_completed.clear();
+    }
+    if (m_cancelToken.isCancelled())
+    {
+        // Started nodes may have skipped some of their work, so can't be completed later
+        for (auto &[node, entry] : m_entries)
+        {
+            if (entry.started && !entry.complete)
+            {
+                LOG_DEBUG("Resetting %s, its work was cancelled", node->type().c_str());
+                node->reset();
+            }
+        }
+        m_cancelToken.reset();
+    }
+    m_entries.clear();
+    m_targets.clear();
+    m_ready.clear();
+    m_polled.clear();
+    m_numInFlight = 0;
+}
+
+void Scheduler::cancel()
+{
+    m_cancelToken.cancel();
+}
+bool Scheduler::isCancelled() const
+{
+    return m_cancelToken.isCancelled();
+}
+
+Node *Scheduler::step(Settings const *sceneSettings)
+{
+    // Nothing more is started until the schedule is replaced
+    if (m_cancelToken.isCancelled())
+    {
+        return nullptr;
+    }
+    m_sceneSettings = sceneSettings;
+    pollStarted();
+    collectCompleted(false);
+
+    // Every ready node that can run without the GL context is handed to the workers,
+    // only the first of the remaining nodes is stepped on this thread.
+    Node *syncNode = nullptr;
+    std::deque<Node *> deferred;
+    while (!m_ready.empty())
+    {
+        Node *node = m_ready.front();
+        m_ready.pop_front();
+        // Nodes that finished asynchronously only need completing on this thread
+        if (m_entries[node].started)
+        {
+            if (!syncNode)
+            {
+                syncNode = node;
+            }
+            else
+            {
+                deferred.push_back(node);
+            }
+            continue;
+        }
+
+        node->prepare(sceneSettings, &m_cancelToken);
+        // Cached results are restored immediately, releasing their downstream nodes
+        if (m_cache && node->restoreResult(m_cache))
+        {
+            onStepped(node);
+        }
+        else if (node->canStartAsync())
+        {
+            start(node);
+        }
+        else if (node->canProcessAsync())
+        {
+            ++m_numInFlight;
+            m_pool.submit([this, node, sceneSettings]()
+                          {
+                              node->processStep(sceneSettings);
+                              onWorkerDone(node); });
+        }
+        else if (!syncNode)
+        {
+            syncNode = node;
+        }
+        else
+        {
+            deferred.push_back(node);
+        }
+    }
+    m_ready.swap(deferred);
+
+    if (syncNode)
+    {
+        syncNode->processStep(sceneSettings);
+        onStepped(syncNode);
+        return syncNode;
+    }
+
+    if (m_numInFlight > 0)
+    {
+        // GPU work can't wake the condition so is waited on a little at a time
+        if (!m_polled.empty())
+        {
+            m_polled.front()->pollAsync(POLL_TIMEOUT_NS);
+        }
+        collectCompleted(m_polled.empty());
+    }
+    return nullptr;
+}
+
+bool Scheduler::isFinished() const
+{
+    return m_ready.empty() && m_numInFlight == 0;
+}
+
+bool Scheduler::isScheduled(Node *node) const
+{
+    return m_entries.count(node) > 0;
+}
+
+void Scheduler::wait()
+{
+    m_pool.wait();
+}
+
+void Scheduler::collectCompleted(bool block)
+{
+    std::vector<Node *> completed;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (block)
+        {
+            m_condition.wait(lock, [this]()
+                             { return !m_completed.empty(); });
+        }
+        completed.swap(m_completed);
+    }
+    for (Node *node : completed)
+    {
+        onCompleted(node);
+    }
+}
+
+void Scheduler::pollStarted()
+{
+    // Finished nodes are removed once collected
+    auto it = std::remove_if(m_polled.begin(), m_polled.end(), [](Node *node)
+                             { return !node->pollAsync(0); });
+    m_polled.erase(it, m_polled.end());
+}
+
+void Scheduler::onWorkerDone(Node *node)
+{
+    // Notified under the lock so the scheduler can't be destroyed before it returns
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_completed.push_back(node);
+    m_condition.notify_one();
+}
+
+void Scheduler::onStepped(Node *node)
+{
+    switch (node->state())
+    {
+    case State::Processed:
+    {
+        m_entries[node].complete = true;
+        // Release any downstream nodes that were only waiting on this one
+        bool started = m_entries[node].started;
+        for (Node *downstream : m_entries[node].downstream)
+        {
+            Entry &entry = m_entries[downstream];
+            if (!started)
+            {
+                --entry.numUnstarted;
+            }
+            if (--entry.numPending > 0)
+            {
+                maybeStartEarly(downstream);
+            }
+            // Nodes started early are queued once they finish instead
+            else if ((!entry.started || entry.finished) && downstream->state() != State::Error)
+            {
+                m_ready.push_back(downstream);
+            }
+        }
+        releaseInputs(node);
+        break;
+    }
+    case State::Error:
+        m_entries[node].complete = true;
+        // Downstream nodes can never become ready
+        break;
+    default:
+        // Multi-step operators go to the back of the queue so other branches can advance
+        m_ready.push_back(node);
+        break;
+    }
+}
+
+void Scheduler::onCompleted(Node *node)
+{
+    --m_numInFlight;
+    Entry &entry = m_entries[node];
+    if (!entry.started)
+    {
+        onStepped(node);
+        return;
+    }
+
+    // The final step waits on the inputs being processed
+    entry.finished = true;
+    m_polled.erase(std::remove(m_polled.begin(), m_polled.end(), node), m_polled.end());
+    if (entry.numPending == 0)
+    {
+        m_ready.push_back(node);
+    }
+}
+
+void Scheduler::start(Node *node)
+{
+    Entry &entry = m_entries[node];
+    entry.started = true;
+    ++m_numInFlight;
+    bool ok = node->startAsync(m_sceneSettings, &m_pool, [this, node]()
+                               { onWorkerDone(node); });
+    if (!ok)
+    {
+        --m_numInFlight;
+        onStepped(node);
+        return;
+    }
+    m_polled.push_back(node);
+
+    for (Node *downstream : entry.downstream)
+    {
+        --m_entries[downstream].numUnstarted;
+        maybeStartEarly(downstream);
+    }
+}
+
+void Scheduler::maybeStartEarly(Node *node)
+{
+    // Nodes with no pending inputs are started from the ready queue
+    Entry &entry = m_entries[node];
+    if (entry.started || entry.numPending == 0 || entry.numUnstarted > 0 || node->state() != State::Unprocessed)
+    {
+        return;
+    }
+
+    node->prepare(m_sceneSettings, &m_cancelToken);
+    // Cached results are restored once the inputs are processed instead
+    if (m_cache && m_cache->contains(node->fingerprint()))
+    {
+        return;
+    }
+    if (node->canStartAsync())
+    {
+        LOG_DEBUG("Starting %s before its inputs have finished", node->type().c_str());
+        start(node);
+    }
+}
+
+void Scheduler::releaseInputs(Node *node)
+{
+    for (Node *upstream : m_entries[node].upstream)
+    {
+        if (--m_entries[upstream].numConsumers == 0 && canRelease(upstream))
+        {
+            LOG_DEBUG("Releasing %s, every consumer is processed", upstream->type().c_str());
+            upstream->reset(m_cache);
+        }
+    }
+}
+
+bool Scheduler::canRelease(Node *node) const
+{
+    if (node->state() != State::Processed || m_targets.count(node) > 0 || node->hasSelectFlag(SelectFlag_Pinned))
+    {
+        return false;
+    }
+    // Any processed node may hold onto layers passed through from this one
+    for (size_t i = 0; i < node->numOutputs(); ++i)
+    {
+        Connector *conn = node->output(i);
+        for (size_t j = 0; j < conn->numConnections(); ++j)
+        {
+            Node *downstream = conn->connection(j)->node();
+            if (downstream->state() == State::Processed && node->op()->sharesOutputsWith(downstream->op()))
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
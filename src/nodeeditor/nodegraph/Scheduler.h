@@ -0,0 +1,133 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "CancelToken.h"
+#include "Node.h"
+#include "ResultCache.h"
+#include "Settings.h"
+#include "WorkStealingPool.h"
+
+/*
+Evaluates every unprocessed node upstream of a set of target nodes in dependency order.
+
+Each scheduled node counts how many of its upstream nodes are still unprocessed. A node
+with no outstanding dependencies is added to the ready queue, and every ready node is
+advanced in turn rather than fully processing one branch before starting the next, so
+independent branches progress together and the total time tends towards the length of
+the critical path.
+
+Operators that can process without a GL context (see Operator::canProcessAsync) are
+stepped on a pool of worker threads. All other operators are stepped on the thread
+calling step(), which owns the GL context and so acts as the command queue for GPU work.
+
+Operators that can be started asynchronously (see Operator::canStartAsync) run their
+work on the pool, eg, as tiles, and may be started as soon as every unprocessed upstream
+node has itself been started rather than waiting for it to finish, so a chain of such
+operators is pipelined. Once finished and all inputs are processed, a final step on the
+calling thread completes them. Operators whose work completes on the GPU (see
+Operator::pollAsync) are started the same way, so a chain of compute shaders is queued
+without waiting on each dispatch, and are polled by the calling thread until finished.
+
+If a ResultCache is provided, each node is first looked up in the cache by fingerprint
+and only processed if its result is not found.
+
+Intermediate results are only kept while they're needed. Once every scheduled consumer
+of a node is processed, the node is reset (moving its result to the cache) so that its
+memory can be reused by later nodes, unless it's a target, is pinned (SelectFlag_Pinned)
+or a processed consumer still passes through part of its output.
+
+The schedule can be cancelled from any thread, eg, once an edit makes its results
+stale. No further work is started, operators see the cancellation through
+Operator::isCancelled() and abandon what they're doing, and step() returns without
+stepping anything until the schedule is replaced. Nodes whose asynchronous work was
+abandoned are reset when the schedule is cleared.
+
+The scheduler is driven by a single processing thread. wait() and cancel() may be
+called from any thread.
+*/
+class Scheduler
+{
+public:
+    // A worker count of 0 uses the hardware concurrency
+    Scheduler(ResultCache *cache = nullptr, size_t numWorkers = 0);
+
+    /*
+    Replaces the current schedule with the unprocessed upstream closure of the targets.
+    Waits for any in-flight worker tasks from the previous schedule to complete first.
+    */
+    void schedule(const std::vector<Node *> &targets);
+    /* Drops the current schedule, waiting on any in-flight worker tasks. */
+    void clear();
+    /* Abandons the current schedule's work as soon as possible. Thread safe. */
+    void cancel();
+    bool isCancelled() const;
+    /*
+    Collects completed worker tasks, hands any ready asynchronous nodes to the workers
+    and performs one processing step of the next ready node that requires the calling
+    thread. If there is nothing to do on the calling thread but workers or the GPU are
+    still busy, blocks until one of them completes.
+
+    Returns the node stepped on the calling thread, if any.
+    */
+    Node *step(Settings const *sceneSettings);
+    /* Whether there is no ready node and no in-flight work left for the schedule */
+    bool isFinished() const;
+    /* Whether the node is part of the current schedule */
+    bool isScheduled(Node *node) const;
+    /* Blocks until every in-flight worker task has completed */
+    void wait();
+
+protected:
+    struct Entry
+    {
+        // Unprocessed upstream nodes, and those of them not yet started asynchronously
+        size_t numPending = 0;
+        size_t numUnstarted = 0;
+        std::vector<Node *> downstream;
+        // Scheduled upstream nodes, and how many scheduled consumers are left unprocessed
+        std::vector<Node *> upstream;
+        size_t numConsumers = 0;
+        bool started = false;
+        bool finished = false;
+        // Processed or in error, so no longer needs stepping
+        bool complete = false;
+    };
+
+    ResultCache *m_cache;
+    WorkStealingPool m_pool;
+    std::unordered_map<Node *, Entry> m_entries;
+    std::unordered_set<Node *> m_targets;
+    std::deque<Node *> m_ready;
+    size_t m_numInFlight = 0;
+    // Started nodes completed by polling rather than a worker, in the order started
+    std::vector<Node *> m_polled;
+    // Scene settings for the current step
+    Settings const *m_sceneSettings = nullptr;
+    // Shared with every scheduled operator, only reset once none are processing
+    CancelToken m_cancelToken;
+
+    // Nodes stepped by a worker, waiting to be collected by the processing thread
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::vector<Node *> m_completed;
+
+    /* Called from a worker once a node's work has finished */
+    void onWorkerDone(Node *node);
+    void collectCompleted(bool block);
+    /* Polls every started node, dropping those that don't need polling */
+    void pollStarted();
+    void onStepped(Node *node);
+    void onCompleted(Node *node);
+    /* Starts the node asynchronously and any downstream nodes that can now be started with it */
+    void start(Node *node);
+    /* Starts a node before its inputs are processed if every one of them has been started */
+    void maybeStartEarly(Node *node);
+    /* Resets any scheduled inputs of a processed node that have no consumers left */
+    void releaseInputs(Node *node);
+    bool canRelease(Node *node) const;
+};
@@ -1,5 +1,6 @@
 #include <iomanip>
 #include <iostream>
+#include <limits>
 
 #include "../constants.h"
 #include "../log.h"
@@ -8,7 +9,11 @@
 // =============================================================================
 // Serializer
 
-StreamSerializer::StreamSerializer(std::ostream *stream) : m_stream(stream) {}
+StreamSerializer::StreamSerializer(std::ostream *stream) : m_stream(stream)
+{
+    // Enough digits for floats to read back exactly, so a node's fingerprint survives a save
+    *m_stream << std::setprecision(std::numeric_limits<float>::max_digits10);
+}
 
 bool StreamSerializer::isOk() const
 {
@@ -1,3 +1,6 @@
+#include <atomic>
+#include <cmath>
+#include <functional>
 #include <map>
 #include <string>
 #include <variant>
@@ -5,9 +8,12 @@
 #include <glm/glm.hpp>
 
 #include "../log.h"
+#include "../util.h"
 #include "Settings.h"
 
 const std::string EMPTY_STRING = "";
+// Shared by every setting so that generations are never reused
+static std::atomic<uint64_t> lastGeneration{0};
 
 const std::string &currentChoice(SettingChoices choices, SettingValue value)
 {
@@ -21,17 +27,50 @@ const std::string &currentChoice(SettingChoices choices, SettingValue value)
     return EMPTY_STRING;
 }
 
+size_t hashValue(bool value) { return std::hash<bool>{}(value); }
+size_t hashValue(unsigned int value) { return std::hash<unsigned int>{}(value); }
+size_t hashValue(int value) { return std::hash<int>{}(value); }
+size_t hashValue(float value) { return std::hash<float>{}(value); }
+size_t hashValue(const std::string &value) { return std::hash<std::string>{}(value); }
+template <int N, typename T>
+size_t hashValue(const glm::vec<N, T> &value)
+{
+    size_t seed = 0;
+    for (int i = 0; i < N; ++i)
+    {
+        seed = hashCombine(seed, std::hash<T>{}(value[i]));
+    }
+    return seed;
+}
+size_t hashValue(const std::vector<glm::vec2> &value)
+{
+    size_t seed = value.size();
+    for (const auto &vec : value)
+    {
+        seed = hashCombine(seed, hashValue(vec));
+    }
+    return seed;
+}
+
 // =============================================================================
 // Setting
 Setting::Setting() {}
-Setting::Setting(const std::string name, const SettingType type, SettingValue value, SettingHint hints) : m_name(name), m_type(type), m_defaultValue(value), m_value(value), m_hints(hints) {}
-Setting::Setting(const std::string name, const SettingType type, SettingValue value, SettingChoices choices) : m_name(name), m_type(type), m_defaultValue(value), m_value(value), m_choices(choices) {}
-Setting::Setting(const std::string name, const SettingType type, SettingValue value, SettingValue min, SettingValue max, SettingHint hints) : m_name(name), m_type(type), m_defaultValue(value), m_value(value), m_hints(hints), m_min(min), m_max(max) {}
+Setting::Setting(const std::string name, const SettingType type, SettingValue value, SettingHint hints) : m_name(name), m_type(type), m_defaultValue(value), m_value(value), m_hints(hints) { changed(); }
+Setting::Setting(const std::string name, const SettingType type, SettingValue value, SettingChoices choices) : m_name(name), m_type(type), m_defaultValue(value), m_value(value), m_choices(choices) { changed(); }
+Setting::Setting(const std::string name, const SettingType type, SettingValue value, SettingValue min, SettingValue max, SettingHint hints) : m_name(name), m_type(type), m_defaultValue(value), m_value(value), m_hints(hints), m_min(min), m_max(max) { changed(); }
 const std::string &Setting::name() const { return m_name; }
 SettingType Setting::type() const { return m_type; }
 SettingHint Setting::hints() const { return m_hints; }
 
-void Setting::set(SettingValue value) { m_value = value; }
+void Setting::set(const SettingValue &value)
+{
+    if (value == m_value)
+    {
+        return;
+    }
+    m_value = value;
+    changed();
+}
 bool Setting::isEdited() const
 {
     return m_value != m_defaultValue;
@@ -43,20 +82,28 @@ const std::string &Setting::currentChoice() const
 {
     return ::currentChoice(m_choices, m_value);
 }
+size_t Setting::hash() const { return m_hash; }
+uint64_t Setting::generation() const { return m_generation; }
+void Setting::changed()
+{
+    m_generation = ++lastGeneration;
+    size_t valueHash = std::visit([](const auto &value)
+                                  { return hashValue(value); },
+                                  m_value);
+    m_hash = hashCombine(std::hash<std::string>{}(m_name), valueHash);
+}
 
 // =============================================================================
 // Settings
 
-void Settings::validateUniqueSetting(const std::string &name) const
+void Settings::addIndex(const std::string &name)
 {
     // Key can only be registered once
-    for (const auto setting : m_settings)
+    if (m_indices.find(name) != m_indices.end())
     {
-        if (setting.name() == name)
-        {
-            throw std::invalid_argument(name);
-        }
+        throw std::invalid_argument(name);
     }
+    m_indices[name] = m_settings.size();
 }
 
 Settings::iterator Settings::begin() { return m_settings.begin(); }
@@ -64,123 +111,111 @@ Settings::iterator Settings::end() { return m_settings.end(); }
 Settings::const_iterator Settings::cbegin() const { return m_settings.cbegin(); }
 Settings::const_iterator Settings::cend() const { return m_settings.cend(); }
 
-Setting *Settings::get(const std::string &key)
-{
-    for (auto &setting : m_settings)
-    {
-        if (setting.name() == key)
-        {
-            return &setting;
-        }
-    }
-    return nullptr;
-}
-const Setting *Settings::get(const std::string &key) const
+size_t Settings::size() const { return m_settings.size(); }
+Setting *Settings::get(const std::string &key) { return at(index(key)); }
+const Setting *Settings::get(const std::string &key) const { return at(index(key)); }
+size_t Settings::index(const std::string &key) const
 {
-    for (const auto &setting : m_settings)
-    {
-        if (setting.name() == key)
-        {
-            return &setting;
-        }
-    }
-    return nullptr;
+    auto it = m_indices.find(key);
+    return it == m_indices.end() ? INVALID_SETTING : it->second;
 }
+Setting *Settings::at(size_t index) { return index < m_settings.size() ? &m_settings[index] : nullptr; }
+const Setting *Settings::at(size_t index) const { return index < m_settings.size() ? &m_settings[index] : nullptr; }
 
 void Settings::registerBool(const std::string &name, bool value, SettingHint hints)
 {
-    validateUniqueSetting(name);
+    addIndex(name);
     m_settings.emplace_back(name, SettingType_Bool, value, hints);
 }
 void Settings::registerUInt(const std::string &name, unsigned int value, unsigned int min, unsigned int max, SettingHint hints)
 {
-    validateUniqueSetting(name);
+    addIndex(name);
     m_settings.emplace_back(name, SettingType_UInt, value, min, max, hints);
 }
 void Settings::registerInt(const std::string &name, int value, int min, int max, SettingHint hints)
 {
-    validateUniqueSetting(name);
+    addIndex(name);
     m_settings.emplace_back(name, SettingType_Int, value, min, max, hints);
 }
 void Settings::registerFloat(const std::string &name, float value, float min, float max, SettingHint hints)
 {
-    validateUniqueSetting(name);
+    addIndex(name);
     m_settings.emplace_back(name, SettingType_Float, value, min, max, hints);
 }
 void Settings::registerFloat2(const std::string &name, glm::vec2 value, float min, float max, SettingHint hints)
 {
-    validateUniqueSetting(name);
+    addIndex(name);
     m_settings.emplace_back(name, SettingType_Float2, value, min, max, hints);
 }
 void Settings::registerFloat3(const std::string &name, glm::vec3 value, float min, float max, SettingHint hints)
 {
-    validateUniqueSetting(name);
+    addIndex(name);
     m_settings.emplace_back(name, SettingType_Float3, value, min, max, hints);
 }
 void Settings::registerFloat4(const std::string &name, glm::vec4 value, float min, float max, SettingHint hints)
 {
-    validateUniqueSetting(name);
+    addIndex(name);
     m_settings.emplace_back(name, SettingType_Float4, value, min, max, hints);
 }
 void Settings::registerFloat2Array(const std::string &name, std::vector<glm::vec2> value, float min, float max, SettingHint hints)
 {
-    validateUniqueSetting(name);
+    addIndex(name);
     m_settings.emplace_back(name, SettingType_Float2Array, value, min, max, hints);
 }
 void Settings::registerInt2(const std::string &name, glm::ivec2 value, SettingHint hints)
 {
-    validateUniqueSetting(name);
+    addIndex(name);
     m_settings.emplace_back(name, SettingType_Int2, value, hints);
 }
 void Settings::registerString(const std::string &name, std::string value, SettingHint hints)
 {
-    validateUniqueSetting(name);
+    addIndex(name);
     m_settings.emplace_back(name, SettingType_String, value, hints);
 }
 
 void Settings::registerBool(const std::string &name, bool value, SettingChoices choices)
 {
-    validateUniqueSetting(name);
+    addIndex(name);
     m_settings.emplace_back(name, SettingType_Bool, value, choices);
 }
 void Settings::registerUInt(const std::string &name, unsigned int value, SettingChoices choices)
 {
-    validateUniqueSetting(name);
+    addIndex(name);
     m_settings.emplace_back(name, SettingType_UInt, value, choices);
 }
 void Settings::registerInt(const std::string &name, int value, SettingChoices choices)
 {
-    validateUniqueSetting(name);
+    addIndex(name);
     m_settings.emplace_back(name, SettingType_Int, value, choices);
 }
 void Settings::registerFloat(const std::string &name, float value, SettingChoices choices)
 {
-    validateUniqueSetting(name);
+    addIndex(name);
     m_settings.emplace_back(name, SettingType_Float, value, choices);
 }
 void Settings::registerFloat2(const std::string &name, glm::vec2 value, SettingChoices choices)
 {
-    validateUniqueSetting(name);
+    addIndex(name);
     m_settings.emplace_back(name, SettingType_Float2, value, choices);
 }
 void Settings::registerFloat3(const std::string &name, glm::vec3 value, SettingChoices choices)
 {
-    validateUniqueSetting(name);
+    addIndex(name);
     m_settings.emplace_back(name, SettingType_Float3, value, choices);
 }
 void Settings::registerFloat4(const std::string &name, glm::vec4 value, SettingChoices choices)
 {
-    validateUniqueSetting(name);
+    addIndex(name);
     m_settings.emplace_back(name, SettingType_Float4, value, choices);
 }
 void Settings::registerInt2(const std::string &name, glm::ivec2 value, SettingChoices choices)
 {
-    validateUniqueSetting(name);
+    addIndex(name);
     m_settings.emplace_back(name, SettingType_Int2, value, choices);
 }
 void Settings::registerString(const std::string &name, std::string value, SettingChoices choices)
 {
-    validateUniqueSetting(name);
+    addIndex(name);
     m_settings.emplace_back(name, SettingType_String, value, choices);
 }
 
@@ -221,6 +256,69 @@ std::string Settings::getString(const std::string &key) const
     return get(key)->value<std::string>();
 }
 
+size_t Settings::hash() const
+{
+    size_t seed = m_settings.size();
+    for (const auto &setting : m_settings)
+    {
+        seed = hashCombine(seed, setting.hash());
+    }
+    return seed;
+}
+
+// Rounds a scaled integer, never rounding a non-zero value to zero
+static int scaleInt(int value, float scale)
+{
+    int scaled = int(std::round(value * scale));
+    if (scaled == 0 && value != 0)
+    {
+        return value > 0 ? 1 : -1;
+    }
+    return scaled;
+}
+
+void Settings::scalePixels(float scale)
+{
+    for (auto &setting : m_settings)
+    {
+        if (setting.hints() & SettingHint_PerPixel && setting.type() == SettingType_Float)
+        {
+            setting.setValue(setting.value<float>() / scale);
+        }
+        if (!(setting.hints() & SettingHint_Pixels))
+        {
+            continue;
+        }
+        switch (setting.type())
+        {
+        case SettingType_Int:
+            setting.setValue(scaleInt(setting.value<int>(), scale));
+            break;
+        case SettingType_UInt:
+            setting.setValue((unsigned int)scaleInt(setting.value<unsigned int>(), scale));
+            break;
+        case SettingType_Int2:
+        {
+            glm::ivec2 value = setting.value<glm::ivec2>();
+            setting.setValue(glm::ivec2(scaleInt(value.x, scale), scaleInt(value.y, scale)));
+            break;
+        }
+        case SettingType_Float:
+            setting.setValue(setting.value<float>() * scale);
+            break;
+        case SettingType_Float2:
+            setting.setValue(setting.value<glm::vec2>() * scale);
+            break;
+        case SettingType_Float3:
+            setting.setValue(setting.value<glm::vec3>() * scale);
+            break;
+        default:
+            LOG_WARNING("Can't scale setting %s by pixels", setting.name().c_str());
+            break;
+        }
+    }
+}
+
 bool Settings::serialize(Serializer *serializer, bool editedOnly) const
 {
     bool ok = true;
@@ -314,7 +412,7 @@ bool Settings::deserialize(Deserializer *deserializer)
             ok = ok && deserializer->readInt2(std::get<glm::ivec2>(value));
             break;
         case SettingType_UInt:
-            value = 0; // Preset so `get` can access a reference
+            value = 0u; // Preset so `get` can access a reference
             ok = ok && deserializer->readUInt(std::get<unsigned int>(value));
             break;
         case SettingType_String:
@@ -1,6 +1,8 @@
 #pragma once
+#include <cstdint>
 #include <map>
 #include <string>
+#include <unordered_map>
 #include <variant>
 #include <vector>
 
@@ -14,6 +16,8 @@ const float DEFAULT_FLOAT_MIN = -1.0f;
 const float DEFAULT_FLOAT_MAX = 1.0f;
 
 const std::string &currentChoice(SettingChoices choices, SettingValue value);
+// Returned by Settings::index() for a setting that isn't registered
+const size_t INVALID_SETTING = SIZE_MAX;
 
 enum SettingType
 {
@@ -36,6 +40,8 @@ enum SettingHint
     SettingHint_ChannelMask = 1 << 1, // Displays a multi-channel selector
     SettingHint_Color = 1 << 2,       // Displays as a color. Supports Float3, Float4
     SettingHint_Logarithmic = 1 << 3, // UI interaction will make it easier to select smaller values. Supports Float
+    SettingHint_Pixels = 1 << 4,      // A distance in pixels, scaled with the image for proxies. Supports Int, UInt, Int2, Float, Float2, Float3
+    SettingHint_PerPixel = 1 << 5,    // A rate per pixel, eg, a frequency, scaled inversely with the image for proxies. Supports Float
 };
 
 class Setting
@@ -49,21 +55,28 @@ public:
     SettingType type() const;
     SettingHint hints() const;
 
-    void set(SettingValue value);
+    /* Sets the value, unless it's already equal, updating the generation and hash */
+    void set(const SettingValue &value);
     bool isEdited() const;
 
     bool hasChoices() const;
     const SettingChoices &choices() const;
     const std::string &currentChoice() const;
+    // Hash of the setting's name and current value, updated when it's set
+    size_t hash() const;
+    /*
+    Changes each time the value is set to a different value. Generations are unique across
+    every setting, so two settings with the same generation hold the same value, eg, a copy
+    that hasn't been set since.
+    */
+    uint64_t generation() const;
 
     template <typename T>
-    T defaultValue() const { return std::get<T>(m_defaultValue); }
+    const T &defaultValue() const { return std::get<T>(m_defaultValue); }
     template <typename T>
-    T value() const { return std::get<T>(m_value); }
-    // template <typename T>
-    // T &value() { return std::get<T>(m_value); }
+    const T &value() const { return std::get<T>(m_value); }
     template <typename T>
-    void setValue(T value) { m_value = value; }
+    void setValue(T value) { set(value); }
     template <typename T>
     T min() const { return std::get<T>(m_min); }
     template <typename T>
@@ -80,6 +93,11 @@ private:
     SettingValue m_min;
     SettingValue m_max;
     SettingChoices m_choices;
+
+    uint64_t m_generation = 0;
+    size_t m_hash = 0;
+
+    void changed();
 };
 
 class Settings
@@ -93,8 +111,13 @@ public:
     const_iterator cbegin() const;
     const_iterator cend() const;
 
+    size_t size() const;
     Setting *get(const std::string &key);
     const Setting *get(const std::string &key) const;
+    /* The setting's position in registration order, which stays the same for every copy, or INVALID_SETTING */
+    size_t index(const std::string &key) const;
+    Setting *at(size_t index);
+    const Setting *at(size_t index) const;
 
     // TODO: Add additional registration options and separate set methods
     void registerBool(const std::string &name, bool value, SettingHint hints = SettingHint_None);
@@ -127,11 +150,22 @@ public:
     glm::ivec2 getInt2(const std::string &key) const;
     std::string getString(const std::string &key) const;
 
+    // Hash of every setting's name and current value, combined from each setting's hash
+    size_t hash() const;
+    /*
+    Multiplies every setting measured in pixels by scale and divides those measured per
+    pixel by it, eg, for a proxy of the image at a quarter of the size. Integers are
+    rounded but remain non-zero if they were.
+    */
+    void scalePixels(float scale);
+
     bool serialize(Serializer *serializer, bool editedOnly = true) const;
     bool deserialize(Deserializer *deserializer);
 
 protected:
     std::vector<Setting> m_settings;
+    std::unordered_map<std::string, size_t> m_indices;
 
-    void validateUniqueSetting(const std::string &name) const;
+    /* Indexes a setting about to be registered, throwing if the name is already taken */
+    void addIndex(const std::string &name);
 };
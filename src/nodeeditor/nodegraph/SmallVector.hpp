@@ -0,0 +1,52 @@
+#pragma once
+#include <vector>
+
+/*
+Vector that stores its first N elements inline, only allocating once it grows past them.
+Elements past N are kept in a separate heap vector, so existing elements never move and
+are never copied when it grows. Only supports use as a stack. The inline elements are
+left uninitialized until pushed, so T should be cheap to assign.
+*/
+template <typename T, size_t N>
+class SmallVector
+{
+public:
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    T &operator[](size_t index) { return index < N ? m_inline[index] : m_heap[index - N]; }
+    const T &operator[](size_t index) const { return index < N ? m_inline[index] : m_heap[index - N]; }
+    T &back() { return (*this)[m_size - 1]; }
+    const T &back() const { return (*this)[m_size - 1]; }
+
+    void push_back(const T &value)
+    {
+        if (m_size < N)
+        {
+            m_inline[m_size] = value;
+        }
+        else
+        {
+            m_heap.push_back(value);
+        }
+        ++m_size;
+    }
+    void pop_back()
+    {
+        if (--m_size >= N)
+        {
+            m_heap.pop_back();
+        }
+    }
+    /* Keeps any heap storage for reuse */
+    void clear()
+    {
+        m_heap.clear();
+        m_size = 0;
+    }
+
+private:
+    T m_inline[N];
+    std::vector<T> m_heap;
+    size_t m_size = 0;
+};
@@ -0,0 +1,131 @@
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "WorkStealingPool.h"
+
+// The pool and queue index of the current thread, if it's a worker
+thread_local WorkStealingPool *currentPool = nullptr;
+thread_local size_t currentWorker = 0;
+
+WorkStealingPool::WorkStealingPool(size_t numThreads)
+{
+    if (numThreads == 0)
+    {
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (size_t i = 0; i < numThreads; ++i)
+    {
+        m_workers.emplace_back(std::make_unique<Worker>());
+    }
+    for (size_t i = 0; i < numThreads; ++i)
+    {
+        m_threads.emplace_back(std::bind(&WorkStealingPool::run, this, i));
+    }
+}
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        m_stopped = true;
+    }
+    m_taskCondition.notify_all();
+    for (std::thread &thread : m_threads)
+    {
+        thread.join();
+    }
+}
+
+size_t WorkStealingPool::numThreads() const { return m_threads.size(); }
+
+void WorkStealingPool::submit(Task task)
+{
+    ++m_numPending;
+    ++m_numQueued;
+    if (currentPool == this)
+    {
+        Worker &worker = *m_workers[currentWorker];
+        std::lock_guard<std::mutex> guard(worker.mutex);
+        worker.tasks.emplace_front(std::move(task));
+    }
+    else
+    {
+        Worker &worker = *m_workers[m_nextWorker++ % m_workers.size()];
+        std::lock_guard<std::mutex> guard(worker.mutex);
+        worker.tasks.emplace_back(std::move(task));
+    }
+
+    // Sleeping threads register themselves before checking for tasks, so either they
+    // see the queued task or the count of sleeping threads is seen here
+    if (m_numSleeping > 0)
+    {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        m_taskCondition.notify_one();
+    }
+}
+
+void WorkStealingPool::wait()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idleCondition.wait(lock, [this]()
+                         { return m_numPending == 0; });
+}
+
+void WorkStealingPool::run(size_t index)
+{
+    currentPool = this;
+    currentWorker = index;
+    while (true)
+    {
+        Task task;
+        if (!popTask(index, task))
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            ++m_numSleeping;
+            m_taskCondition.wait(lock, [this]()
+                                 { return m_stopped || m_numQueued > 0; });
+            --m_numSleeping;
+            if (m_stopped)
+            {
+                return;
+            }
+            continue;
+        }
+
+        task();
+
+        if (--m_numPending == 0)
+        {
+            std::lock_guard<std::mutex> guard(m_mutex);
+            m_idleCondition.notify_all();
+        }
+    }
+}
+
+bool WorkStealingPool::popTask(size_t index, Task &task)
+{
+    // Newest task from the worker's own queue, otherwise the oldest from any other
+    for (size_t i = 0; i < m_workers.size(); ++i)
+    {
+        Worker &worker = *m_workers[(index + i) % m_workers.size()];
+        std::lock_guard<std::mutex> guard(worker.mutex);
+        if (worker.tasks.empty())
+        {
+            continue;
+        }
+        if (i == 0)
+        {
+            task = std::move(worker.tasks.front());
+            worker.tasks.pop_front();
+        }
+        else
+        {
+            task = std::move(worker.tasks.back());
+            worker.tasks.pop_back();
+        }
+        --m_numQueued;
+        return true;
+    }
+    return false;
+}
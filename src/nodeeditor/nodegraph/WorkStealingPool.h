@@ -0,0 +1,60 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+A fixed number of worker threads, each with its own queue of tasks.
+
+Tasks submitted from a worker are pushed to the front of that worker's queue and run
+next on the same thread, so work spawned by a task (eg, a downstream tile reading the
+tile just written) runs while its data is still in cache. Tasks submitted from any
+other thread are added to the back of each worker's queue in turn. A worker with an
+empty queue steals from the back of another worker's queue before going to sleep.
+
+Tasks must not throw. The pool joins all workers on destruction, any tasks that have
+not started by then are discarded.
+*/
+class WorkStealingPool
+{
+public:
+    typedef std::function<void()> Task;
+
+    // A thread count of 0 uses the hardware concurrency
+    WorkStealingPool(size_t numThreads = 0);
+    ~WorkStealingPool();
+
+    size_t numThreads() const;
+    void submit(Task task);
+    // Blocks until every submitted task, including those submitted by other tasks, has completed
+    void wait();
+
+protected:
+    struct Worker
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::vector<std::thread> m_threads;
+    std::atomic<size_t> m_nextWorker{0};
+    // Tasks waiting in any queue, and tasks submitted but not yet completed
+    std::atomic<size_t> m_numQueued{0};
+    std::atomic<size_t> m_numPending{0};
+    std::atomic<size_t> m_numSleeping{0};
+    std::atomic<bool> m_stopped{false};
+
+    // Only used to put idle threads to sleep
+    std::mutex m_mutex;
+    std::condition_variable m_taskCondition;
+    std::condition_variable m_idleCondition;
+
+    void run(size_t index);
+    bool popTask(size_t index, Task &task);
+};
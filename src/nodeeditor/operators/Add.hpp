@@ -2,6 +2,7 @@
 #include <string>
 #include <vector>
 
+#include "../cpu/CpuOperator.h"
 #include "../gl/ComputeShaderOperator.h"
 #include "../nodegraph/OperatorRegistry.hpp"
 #include "../nodegraph/Settings.h"
@@ -21,12 +22,46 @@ namespace Op
         {
             return {{}};
         }
-        void registerSettings(Settings *const settings) const override
+        Footprint footprint([[maybe_unused]] Settings const *settings) const override
+        {
+            return {true, 0};
+        }
+        static void registerOperatorSettings(Settings *const settings)
         {
             settings->registerInt("channelMask", ChannelMask_RGB, ChannelMask_None, ChannelMask_Alpha, SettingHint_ChannelMask);
             settings->registerFloat("add", 0.0f);
         }
+        void registerSettings(Settings *const settings) const override
+        {
+            registerOperatorSettings(settings);
+        }
+    };
+
+    class AddCpu : public CpuOperator
+    {
+    public:
+        static AddCpu *create()
+        {
+            return new AddCpu();
+        }
+
+        std::vector<Input> inputs() const override
+        {
+            return {{}};
+        }
+        void registerSettings(Settings *const settings) const override
+        {
+            Add::registerOperatorSettings(settings);
+        }
+        void compute(const std::vector<ImageBuffer const *> &inputs, ImageBuffer *output, const ImageRegion &region, Settings const *settings) const override
+        {
+            __m256 lanes = Simd::channelLanes(settings->getInt("channelMask"));
+            __m256 add = _mm256_and_ps(_mm256_set1_ps(settings->getFloat("add")), lanes);
+            transformRegion(inputs[0], output, region, [add](__m256 value)
+                            { return _mm256_add_ps(value, add); });
+        }
     };
 
     REGISTER_OPERATOR(Add, Add::create);
+    REGISTER_CPU_OPERATOR(Add, AddCpu::create);
 }
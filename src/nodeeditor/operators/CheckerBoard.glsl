@@ -5,10 +5,11 @@ layout(rgba32f, binding=0) uniform image2D imgOut;
 uniform uint size = 128;
 uniform vec4 color1 = vec4(0);
 uniform vec4 color2 = vec4(1);
+uniform ivec2 _imageOrigin = ivec2(0);
 
 void main(){
     ivec2 pixel_coords = ivec2(gl_GlobalInvocationID.xy);
-    uvec2 ratio = (pixel_coords / size) % 2;
+    uvec2 ratio = ((pixel_coords + _imageOrigin) / size) % 2;
     vec4 color = bool(ratio.x ^ ratio.y) ? color1 : color2;
     imageStore(imgOut, pixel_coords, color);
 }
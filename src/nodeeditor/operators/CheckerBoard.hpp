@@ -1,7 +1,9 @@
 #pragma once
+#include <algorithm>
 #include <string>
 #include <vector>
 
+#include "../cpu/ContentCreatorCpuOperator.h"
 #include "../gl/ContentCreatorComputeShaderOperator.h"
 #include "../nodegraph/OperatorRegistry.hpp"
 #include "../nodegraph/Settings.h"
@@ -17,14 +19,62 @@ namespace Op
         }
 
         CheckerBoard() : ContentCreatorComputeShaderOperator("src/nodeeditor/operators/CheckerBoard.glsl") {}
-        void registerSettings(Settings *const settings) const override
+        static void registerOperatorSettings(Settings *const settings)
         {
-            ContentCreatorComputeShaderOperator::registerSettings(settings);
-            settings->registerUInt("size", 128, 0, 2048);
+            settings->registerUInt("size", 128, 0, 2048, SettingHint_Pixels);
             settings->registerFloat4("color1", {0.0f, 0.0f, 0.0f, 1.0f}, 0.0f, 1.0f, SettingHint_Color);
             settings->registerFloat4("color2", {1.0f, 1.0f, 1.0f, 1.0f}, 0.0f, 1.0f, SettingHint_Color);
         }
+        void registerSettings(Settings *const settings) const override
+        {
+            ContentCreatorComputeShaderOperator::registerSettings(settings);
+            registerOperatorSettings(settings);
+        }
+    };
+
+    class CheckerBoardCpu : public ContentCreatorCpuOperator
+    {
+    public:
+        static CheckerBoardCpu *create()
+        {
+            return new CheckerBoardCpu();
+        }
+
+        void registerSettings(Settings *const settings) const override
+        {
+            ContentCreatorCpuOperator::registerSettings(settings);
+            CheckerBoard::registerOperatorSettings(settings);
+        }
+        void compute([[maybe_unused]] const std::vector<ImageBuffer const *> &inputs, ImageBuffer *output, const ImageRegion &region, Settings const *settings) const override
+        {
+            int size = settings->getUInt("size");
+            glm::vec4 color1 = settings->getFloat4("color1");
+            glm::vec4 color2 = settings->getFloat4("color2");
+            if (size == 0)
+            {
+                // Every pixel divides into the same square
+                fillRegion(output, region, color2);
+                return;
+            }
+
+            // Each row is a run of alternating squares, filled a span at a time
+            for (int y = region.y; y < region.y + region.height; ++y)
+            {
+                // Squares are aligned to the full image
+                int rowParity = ((m_imageOrigin.y + y) / size) % 2;
+                int x = region.x;
+                while (x < region.x + region.width)
+                {
+                    int imageX = m_imageOrigin.x + x;
+                    int end = std::min((imageX / size + 1) * size - m_imageOrigin.x, region.x + region.width);
+                    bool isColor1 = ((imageX / size) % 2) ^ rowParity;
+                    Simd::fillPixels(output->pixel(x, y), end - x, isColor1 ? color1 : color2);
+                    x = end;
+                }
+            }
+        }
     };
 
     REGISTER_OPERATOR(CheckerBoard, CheckerBoard::create);
+    REGISTER_CPU_OPERATOR(CheckerBoard, CheckerBoardCpu::create);
 }
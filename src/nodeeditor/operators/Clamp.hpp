@@ -2,6 +2,7 @@
 #include <string>
 #include <vector>
 
+#include "../cpu/CpuOperator.h"
 #include "../gl/ComputeShaderOperator.h"
 #include "../nodegraph/OperatorRegistry.hpp"
 #include "../nodegraph/Settings.h"
@@ -21,12 +22,52 @@ namespace Op
         {
             return {{}};
         }
-        void registerSettings(Settings *const settings) const override
+        Footprint footprint([[maybe_unused]] Settings const *settings) const override
+        {
+            return {true, 0};
+        }
+        static void registerOperatorSettings(Settings *const settings)
         {
             settings->registerFloat("minValue", 0.0f, 0.0f, 1.0f);
             settings->registerFloat("maxValue", 1.0f, 0.0f, 1.0f);
         }
+        void registerSettings(Settings *const settings) const override
+        {
+            registerOperatorSettings(settings);
+        }
+    };
+
+    class ClampCpu : public CpuOperator
+    {
+    public:
+        static ClampCpu *create()
+        {
+            return new ClampCpu();
+        }
+
+        std::vector<Input> inputs() const override
+        {
+            return {{}};
+        }
+        void registerSettings(Settings *const settings) const override
+        {
+            Clamp::registerOperatorSettings(settings);
+        }
+        void compute(const std::vector<ImageBuffer const *> &inputs, ImageBuffer *output, const ImageRegion &region, Settings const *settings) const override
+        {
+            // Alpha is not clamped
+            __m256 lanes = Simd::channelLanes(ChannelMask_RGB);
+            __m256 minValue = _mm256_set1_ps(settings->getFloat("minValue"));
+            __m256 maxValue = _mm256_set1_ps(settings->getFloat("maxValue"));
+            transformRegion(inputs[0], output, region, [lanes, minValue, maxValue](__m256 value)
+                            {
+                                // Same order of comparisons as the shader for when minValue > maxValue
+                                __m256 clamped = _mm256_blendv_ps(value, maxValue, _mm256_cmp_ps(value, maxValue, _CMP_GT_OQ));
+                                clamped = _mm256_blendv_ps(clamped, minValue, _mm256_cmp_ps(value, minValue, _CMP_LT_OQ));
+                                return _mm256_blendv_ps(value, clamped, lanes); });
+        }
     };
 
     REGISTER_OPERATOR(Clamp, Clamp::create);
+    REGISTER_CPU_OPERATOR(Clamp, ClampCpu::create);
 }
@@ -2,6 +2,7 @@
 #include <string>
 #include <vector>
 
+#include "../cpu/ContentCreatorCpuOperator.h"
 #include "../gl/ContentCreatorComputeShaderOperator.h"
 #include "../nodegraph/OperatorRegistry.hpp"
 #include "../nodegraph/Settings.h"
@@ -17,12 +18,36 @@ namespace Op
         }
 
         Constant() : ContentCreatorComputeShaderOperator("src/nodeeditor/operators/Constant.glsl") {}
+        static void registerOperatorSettings(Settings *const settings)
+        {
+            settings->registerFloat4("color", glm::vec4(0, 0, 0, 1), 0.0f, 1.0f, SettingHint_Color);
+        }
         void registerSettings(Settings *const settings) const override
         {
             ContentCreatorComputeShaderOperator::registerSettings(settings);
-            settings->registerFloat4("color", glm::vec4(0, 0, 0, 1), 0.0f, 1.0f, SettingHint_Color);
+            registerOperatorSettings(settings);
+        }
+    };
+
+    class ConstantCpu : public ContentCreatorCpuOperator
+    {
+    public:
+        static ConstantCpu *create()
+        {
+            return new ConstantCpu();
+        }
+
+        void registerSettings(Settings *const settings) const override
+        {
+            ContentCreatorCpuOperator::registerSettings(settings);
+            Constant::registerOperatorSettings(settings);
+        }
+        void compute([[maybe_unused]] const std::vector<ImageBuffer const *> &inputs, ImageBuffer *output, const ImageRegion &region, Settings const *settings) const override
+        {
+            fillRegion(output, region, settings->getFloat4("color"));
         }
     };
 
     REGISTER_OPERATOR(Constant, Constant::create);
+    REGISTER_CPU_OPERATOR(Constant, ConstantCpu::create);
 }
@@ -21,6 +21,10 @@ namespace Op
         {
             return {{"Left"}, {"Right"}};
         }
+        Footprint footprint([[maybe_unused]] Settings const *settings) const override
+        {
+            return {true, 0};
+        }
         void registerSettings(Settings *const settings) const override
         {
             // TODO: How would these register choices based on inputs? SettingHint?
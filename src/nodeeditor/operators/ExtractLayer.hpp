@@ -21,6 +21,10 @@ namespace Op
         {
             return {{}};
         }
+        Footprint footprint([[maybe_unused]] Settings const *settings) const override
+        {
+            return {true, 0};
+        }
         void registerSettings(Settings *const settings) const override
         {
             settings->registerString("fromLayer", DEFAULT_LAYER);
@@ -21,8 +21,12 @@ namespace Op
         void registerSettings(Settings *const settings) const override
         {
             ConvolveOperator::registerSettings(settings);
-            settings->registerInt("radius", 3, 1, 30);
-            settings->registerFloat("sigma", 3.0f, 1.0f, 10.0f);
+            settings->registerInt("radius", 3, 1, 30, SettingHint_Pixels);
+            settings->registerFloat("sigma", 3.0f, 1.0f, 10.0f, SettingHint_Pixels);
+        }
+        Footprint footprint(Settings const *settings) const override
+        {
+            return {true, settings->getInt("radius")};
         }
         bool populateKernel(ConvolveKernel *kernel,
                             [[maybe_unused]] const std::vector<RenderSetOperator const *> &inputs,
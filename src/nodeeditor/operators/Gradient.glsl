@@ -11,9 +11,11 @@ uniform vec2 end;
 uniform vec4 startColour;
 uniform vec4 endColour;
 uniform float falloff;
+uniform ivec2 _imageOrigin = ivec2(0);
 
 void main(){
     ivec2 pixel_coords = ivec2(gl_GlobalInvocationID.xy);
+    vec2 pos = pixel_coords + _imageOrigin;
 
     float gradientLength = dot(start - end, start - end);
 
@@ -21,11 +23,11 @@ void main(){
     if (mode == MODE_LINEAR)
     {
         // Project the current pixel onto the gradient defined line to get it's offset
-        dotDist = dot(start - end, pixel_coords - end) / gradientLength;
+        dotDist = dot(start - end, pos - end) / gradientLength;
     }
     else if (mode == MODE_RADIAL)
     {
-        dotDist = 1.0f - dot(pixel_coords - start, pixel_coords - start) / gradientLength;
+        dotDist = 1.0f - dot(pos - start, pos - start) / gradientLength;
     }
     else
     {
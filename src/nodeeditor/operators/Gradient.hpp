@@ -2,6 +2,7 @@
 #include <string>
 #include <vector>
 
+#include "../cpu/ContentCreatorCpuOperator.h"
 #include "../gl/ContentCreatorComputeShaderOperator.h"
 #include "../nodegraph/OperatorRegistry.hpp"
 #include "../nodegraph/Settings.h"
@@ -23,20 +24,104 @@ namespace Op
         }
 
         Gradient() : ContentCreatorComputeShaderOperator("src/nodeeditor/operators/Gradient.glsl") {}
-        void registerSettings(Settings *const settings) const override
+        static void registerOperatorSettings(Settings *const settings)
         {
-            ContentCreatorComputeShaderOperator::registerSettings(settings);
             settings->registerInt("mode",
                                   (int)GradientMode_Linear,
                                   {{"Linear", GradientMode_Linear},
                                    {"Radial", GradientMode_Radial}});
             settings->registerFloat4("startColour", glm::vec4(1), 0.0f, 1.0f, SettingHint_Color);
             settings->registerFloat4("endColour", glm::vec4(0), 0.0f, 1.0f, SettingHint_Color);
-            settings->registerFloat2("start", glm::vec2(0), 0.0f, 1024.0f);
-            settings->registerFloat2("end", glm::vec2(100), 0.0f, 1024.0f);
+            settings->registerFloat2("start", glm::vec2(0), 0.0f, 1024.0f, SettingHint_Pixels);
+            settings->registerFloat2("end", glm::vec2(100), 0.0f, 1024.0f, SettingHint_Pixels);
             settings->registerFloat("falloff", 1.0f, 0.0f, 5.0f);
         }
+        void registerSettings(Settings *const settings) const override
+        {
+            ContentCreatorComputeShaderOperator::registerSettings(settings);
+            registerOperatorSettings(settings);
+        }
+    };
+
+    class GradientCpu : public ContentCreatorCpuOperator
+    {
+    public:
+        static GradientCpu *create()
+        {
+            return new GradientCpu();
+        }
+
+        void registerSettings(Settings *const settings) const override
+        {
+            ContentCreatorCpuOperator::registerSettings(settings);
+            Gradient::registerOperatorSettings(settings);
+        }
+        void compute([[maybe_unused]] const std::vector<ImageBuffer const *> &inputs, ImageBuffer *output, const ImageRegion &region, Settings const *settings) const override
+        {
+            int mode = settings->getInt("mode");
+            glm::vec2 start = settings->getFloat2("start");
+            glm::vec2 end = settings->getFloat2("end");
+            glm::vec4 startColour = settings->getFloat4("startColour");
+            glm::vec4 endColour = settings->getFloat4("endColour");
+            float falloff = settings->getFloat("falloff");
+            glm::vec2 direction = start - end;
+            float gradientLength = glm::dot(direction, direction);
+
+            // Distances are calculated for 8 pixels at a time, then mixed two pixels per register
+            const __m256 zero = _mm256_setzero_ps();
+            const __m256 one = _mm256_set1_ps(1.0f);
+            const __m256 offsets = _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7);
+            __m256 startValue = Simd::broadcastPixel(startColour);
+            __m256 endValue = Simd::broadcastPixel(endColour);
+            alignas(32) float distances[8];
+            for (int y = region.y; y < region.y + region.height; ++y)
+            {
+                float *pixels = output->pixel(region.x, y);
+                for (int i = 0; i < region.width; i += 8)
+                {
+                    __m256 px = _mm256_add_ps(_mm256_set1_ps(float(m_imageOrigin.x + region.x + i)), offsets);
+                    __m256 dotDist;
+                    if (mode == GradientMode_Linear)
+                    {
+                        // Project the pixels onto the gradient line to get their offset
+                        __m256 dx = _mm256_sub_ps(px, _mm256_set1_ps(end.x));
+                        __m256 dy = _mm256_set1_ps(m_imageOrigin.y + y - end.y);
+                        dotDist = _mm256_fmadd_ps(_mm256_set1_ps(direction.x), dx, _mm256_mul_ps(_mm256_set1_ps(direction.y), dy));
+                        dotDist = _mm256_div_ps(dotDist, _mm256_set1_ps(gradientLength));
+                    }
+                    else if (mode == GradientMode_Radial)
+                    {
+                        __m256 dx = _mm256_sub_ps(px, _mm256_set1_ps(start.x));
+                        __m256 dy = _mm256_set1_ps(m_imageOrigin.y + y - start.y);
+                        dotDist = _mm256_fmadd_ps(dx, dx, _mm256_mul_ps(dy, dy));
+                        dotDist = _mm256_sub_ps(one, _mm256_div_ps(dotDist, _mm256_set1_ps(gradientLength)));
+                    }
+                    else
+                    {
+                        dotDist = zero;
+                    }
+                    __m256 clampedDist = _mm256_max_ps(zero, _mm256_min_ps(dotDist, one));
+                    _mm256_store_ps(distances, Simd::pow(clampedDist, _mm256_set1_ps(falloff)));
+
+                    int count = std::min(8, region.width - i);
+                    for (int j = 0; j < count; j += 2)
+                    {
+                        __m256 t = _mm256_setr_m128(_mm_set1_ps(distances[j]), _mm_set1_ps(distances[j + 1]));
+                        __m256 colour = Simd::mix(endValue, startValue, t);
+                        if (j + 1 < count)
+                        {
+                            Simd::storePixels(pixels + (i + j) * 4, colour);
+                        }
+                        else
+                        {
+                            Simd::storePixel(pixels + (i + j) * 4, colour);
+                        }
+                    }
+                }
+            }
+        }
     };
 
     REGISTER_OPERATOR(Gradient, Gradient::create);
+    REGISTER_CPU_OPERATOR(Gradient, GradientCpu::create);
 }
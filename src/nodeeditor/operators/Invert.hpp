@@ -2,6 +2,7 @@
 #include <string>
 #include <vector>
 
+#include "../cpu/CpuOperator.h"
 #include "../gl/ComputeShaderOperator.h"
 #include "../nodegraph/OperatorRegistry.hpp"
 #include "../nodegraph/Settings.h"
@@ -21,7 +22,39 @@ namespace Op
         {
             return {{}};
         }
+        Footprint footprint([[maybe_unused]] Settings const *settings) const override
+        {
+            return {true, 0};
+        }
+        std::vector<OutputLayer> outputLayers(const std::vector<RenderSetOperator const *> &inputs, [[maybe_unused]] Settings const *settings, Settings const *sceneSettings) override
+        {
+            // Greyscale, so only the red channel is stored
+            return {{DEFAULT_LAYER, outputLayerSize(0, inputs, sceneSettings), GL_R32F}};
+        }
+    };
+
+    class InvertCpu : public CpuOperator
+    {
+    public:
+        static InvertCpu *create()
+        {
+            return new InvertCpu();
+        }
+
+        std::vector<Input> inputs() const override
+        {
+            return {{}};
+        }
+        void compute(const std::vector<ImageBuffer const *> &inputs, ImageBuffer *output, const ImageRegion &region, [[maybe_unused]] Settings const *settings) const override
+        {
+            // Inverts the red channel into RGB with an alpha of 1
+            __m256 one = _mm256_set1_ps(1.0f);
+            __m256 alphaLanes = Simd::channelLanes(ChannelMask_Alpha);
+            transformRegion(inputs[0], output, region, [one, alphaLanes](__m256 value)
+                            { return _mm256_blendv_ps(_mm256_sub_ps(one, Simd::broadcastChannel<Channel_Red>(value)), one, alphaLanes); });
+        }
     };
 
     REGISTER_OPERATOR(Invert, Invert::create);
+    REGISTER_CPU_OPERATOR(Invert, InvertCpu::create);
 }
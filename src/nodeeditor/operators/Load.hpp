@@ -1,4 +1,8 @@
 #pragma once
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -6,6 +10,7 @@
 #include "../nodegraph/Settings.h"
 #include "../gl/RenderSetOperator.h"
 #include "../nodegraph/OperatorRegistry.hpp"
+#include "../util.h"
 #include "../../stb/stb_image.h"
 
 namespace Op
@@ -23,6 +28,20 @@ namespace Op
             settings->registerString("filepath", "");
         }
 
+        // The file may be replaced without its path changing
+        size_t volatileHash(Settings const *settings) const override
+        {
+            std::error_code error;
+            std::filesystem::path filepath = settings->getString("filepath");
+            uintmax_t size = std::filesystem::file_size(filepath, error);
+            if (error)
+            {
+                return 0;
+            }
+            auto modified = std::filesystem::last_write_time(filepath, error);
+            return hashCombine(size_t(size), size_t(modified.time_since_epoch().count()));
+        }
+
         FileType detectFileType(const std::string &filepath)
         {
             for (auto &[filetype, ext] : FILE_TYPES)
@@ -35,27 +54,55 @@ namespace Op
             return FileType_None;
         }
 
-        void loadPNG(const std::string &filepath)
+        // Point samples RGBA pixels down to the image size of a proxy
+        template <typename T>
+        static std::vector<T> downsample(const T *pixels, int width, int height, glm::ivec2 size)
+        {
+            std::vector<T> scaled(size_t(size.x) * size.y * 4);
+            for (int y = 0; y < size.y; ++y)
+            {
+                int sourceY = std::min(height - 1, int((y + 0.5f) * height / size.y));
+                for (int x = 0; x < size.x; ++x)
+                {
+                    int sourceX = std::min(width - 1, int((x + 0.5f) * width / size.x));
+                    std::copy_n(pixels + (size_t(sourceY) * width + sourceX) * 4, 4, scaled.data() + (size_t(y) * size.x + x) * 4);
+                }
+            }
+            return scaled;
+        }
+
+        template <typename T>
+        void write(T *pixels, int width, int height, float pixelScale)
+        {
+            if (pixelScale == 1.0f)
+            {
+                Texture *texture = ensureOutputLayer(DEFAULT_LAYER, {width, height});
+                texture->write(pixels, texture->width(), texture->height());
+                return;
+            }
+            glm::ivec2 size(std::max(1, int(std::round(width * pixelScale))), std::max(1, int(std::round(height * pixelScale))));
+            std::vector<T> scaled = downsample(pixels, width, height, size);
+            Texture *texture = ensureOutputLayer(DEFAULT_LAYER, size);
+            texture->write(scaled.data(), texture->width(), texture->height());
+        }
+
+        void loadPNG(const std::string &filepath, float pixelScale)
         {
             stbi_set_flip_vertically_on_load(true);
             int width, height, numChannels;
             unsigned char *pixels = stbi_load(filepath.c_str(), &width, &height, &numChannels, 4);
-
-            Texture *texture = ensureOutputLayer(DEFAULT_LAYER, {width, height});
-            texture->write(pixels, texture->width(), texture->height());
+            write(pixels, width, height, pixelScale);
         }
 
-        void loadHDR(const std::string &filepath)
+        void loadHDR(const std::string &filepath, float pixelScale)
         {
             stbi_set_flip_vertically_on_load(true);
             int width, height, numChannels;
             float *pixels = stbi_loadf(filepath.c_str(), &width, &height, &numChannels, 4);
-
-            Texture *texture = ensureOutputLayer(DEFAULT_LAYER, {width, height});
-            texture->write(pixels, texture->width(), texture->height());
+            write(pixels, width, height, pixelScale);
         }
 
-        bool process([[maybe_unused]] const std::vector<RenderSetOperator const *> &inputs, Settings const *settings, [[maybe_unused]] Settings const *sceneSettings) override
+        bool process([[maybe_unused]] const std::vector<RenderSetOperator const *> &inputs, Settings const *settings, Settings const *sceneSettings) override
         {
             std::string filepath = settings->getString("filepath");
             if (filepath.empty())
@@ -71,13 +118,16 @@ namespace Op
                 return false;
             }
 
+            // Proxies are loaded at the reduced size of the rest of the image
+            Setting const *pixelScale = sceneSettings->get(SCENE_SETTING_PIXEL_SCALE);
+            float scale = pixelScale ? pixelScale->value<float>() : 1.0f;
             switch (filetype)
             {
             case FileType_PNG:
-                loadPNG(filepath);
+                loadPNG(filepath, scale);
                 break;
             case FileType_HDR:
-                loadHDR(filepath);
+                loadHDR(filepath, scale);
                 break;
 
             default:
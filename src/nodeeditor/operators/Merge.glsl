@@ -52,6 +52,19 @@ float screen(float A, float B)
     else if (B > A) { return B; }
     else { return A; }
 }
+// As defined by the W3C compositing spec, with B as the source
+float colorBurn(float A, float B)
+{
+    if (A == 1) { return 1; }
+    else if (B <= 0) { return 0; }
+    else { return 1 - min(1.0f, (1 - A) / B); }
+}
+float colorDodge(float A, float B)
+{
+    if (A <= 0) { return 0; }
+    else if (B >= 1) { return 1; }
+    else { return min(1.0f, A / (1 - B)); }
+}
 
 void main(){
     ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
@@ -74,10 +87,22 @@ void main(){
     case MODE_AVERAGE:
         value = (A + B) * 0.5f;
         break;
-    // case MODE_COLORBURN:
-    //     break;
-    // case MODE_COLORDODGE:
-    //     break;
+    case MODE_COLORBURN:
+        value = vec4(
+            colorBurn(A.r, B.r),
+            colorBurn(A.g, B.g),
+            colorBurn(A.b, B.b),
+            colorBurn(A.a, B.a)
+        );
+        break;
+    case MODE_COLORDODGE:
+        value = vec4(
+            colorDodge(A.r, B.r),
+            colorDodge(A.g, B.g),
+            colorDodge(A.b, B.b),
+            colorDodge(A.a, B.a)
+        );
+        break;
     case MODE_CONJOINTOVER:
         value = (B.a > A.a) ? B : B + A * (1 - B.a) / A.a;
         break;
@@ -3,6 +3,7 @@
 #include <vector>
 
 #include "../constants.h"
+#include "../cpu/CpuOperator.h"
 #include "../gl/ComputeShaderOperator.h"
 #include "../nodegraph/OperatorRegistry.hpp"
 #include "../nodegraph/Settings.h"
@@ -52,11 +53,19 @@ namespace Op
         }
 
         Merge() : ComputeShaderOperator("src/nodeeditor/operators/Merge.glsl") {}
-        std::vector<Input> inputs() const override
+        static std::vector<Input> operatorInputs()
         {
             return {{"A"}, {"B"}, {"Mask", false}};
         }
-        void registerSettings(Settings *const settings) const override
+        std::vector<Input> inputs() const override
+        {
+            return operatorInputs();
+        }
+        Footprint footprint([[maybe_unused]] Settings const *settings) const override
+        {
+            return {true, 0};
+        }
+        static void registerOperatorSettings(Settings *const settings)
         {
             settings->registerInt("mode",
                                   (int)MergeMode_Over,
@@ -94,7 +103,167 @@ namespace Op
             settings->registerBool("alphaMask", true);
             settings->registerInt("maskChannel", ::Channel_Alpha, 0, 3, SettingHint_Channel);
         }
+        void registerSettings(Settings *const settings) const override
+        {
+            registerOperatorSettings(settings);
+        }
+    };
+
+    class MergeCpu : public CpuOperator
+    {
+    public:
+        static MergeCpu *create()
+        {
+            return new MergeCpu();
+        }
+
+        std::vector<Input> inputs() const override
+        {
+            return Merge::operatorInputs();
+        }
+        void registerSettings(Settings *const settings) const override
+        {
+            Merge::registerOperatorSettings(settings);
+        }
+        void compute(const std::vector<ImageBuffer const *> &inputs, ImageBuffer *output, const ImageRegion &region, Settings const *settings) const override
+        {
+            int mode = settings->getInt("mode");
+            __m256 blend = _mm256_set1_ps(settings->getFloat("blend"));
+            bool alphaMask = settings->getBool("alphaMask");
+            int maskChannel = settings->getInt("maskChannel");
+            __m256 alphaLanes = Simd::channelLanes(ChannelMask_Alpha);
+            const __m256 one = _mm256_set1_ps(1.0f);
+
+            // B and the mask may be a different size to A, pixels outside of them are zero
+            std::vector<float> scratchB, scratchMask;
+            for (int y = region.y; y < region.y + region.height; ++y)
+            {
+                const float *rowA = inputs[0]->pixel(region.x, y);
+                const float *rowB = readRow(inputs[1], region.x, y, region.width, scratchB);
+                // Without a mask, the first input is read as a stand in and the mask set to 1
+                const float *rowMask = inputs[2] ? readRow(inputs[2], region.x, y, region.width, scratchMask) : rowA;
+                Simd::transformPixels(rowA, rowB, rowMask, output->pixel(region.x, y), region.width,
+                                      [&](__m256 A, __m256 B, __m256 maskPixels)
+                                      {
+                                          __m256 mask = inputs[2] ? Simd::broadcastChannel(maskPixels, maskChannel) : one;
+                                          __m256 value = Simd::mix(A, merge(mode, A, B), _mm256_mul_ps(blend, mask));
+                                          if (alphaMask)
+                                          {
+                                              __m256 Aa = Simd::broadcastChannel<Channel_Alpha>(A);
+                                              __m256 Ba = Simd::broadcastChannel<Channel_Alpha>(B);
+                                              value = _mm256_blendv_ps(value, _mm256_fnmadd_ps(Ba, Aa, _mm256_add_ps(Ba, Aa)), alphaLanes);
+                                          }
+                                          return value;
+                                      });
+            }
+        }
+
+    protected:
+        static __m256 multiply(__m256 A, __m256 B)
+        {
+            const __m256 zero = _mm256_setzero_ps();
+            __m256 bothNegative = _mm256_and_ps(_mm256_cmp_ps(A, zero, _CMP_LT_OQ), _mm256_cmp_ps(B, zero, _CMP_LT_OQ));
+            return _mm256_blendv_ps(_mm256_mul_ps(A, B), B, bothNegative);
+        }
+        static __m256 screen(__m256 A, __m256 B)
+        {
+            const __m256 zero = _mm256_setzero_ps();
+            const __m256 one = _mm256_set1_ps(1.0f);
+            __m256 inRange = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(A, zero, _CMP_GE_OQ), _mm256_cmp_ps(A, one, _CMP_LE_OQ)),
+                                           _mm256_and_ps(_mm256_cmp_ps(B, zero, _CMP_GE_OQ), _mm256_cmp_ps(B, one, _CMP_LE_OQ)));
+            __m256 larger = _mm256_blendv_ps(A, B, _mm256_cmp_ps(B, A, _CMP_GT_OQ));
+            return _mm256_blendv_ps(larger, _mm256_fnmadd_ps(A, B, _mm256_add_ps(B, A)), inRange);
+        }
+        // The blended value for each mode before the blend and mask are applied, matching Merge.glsl
+        static __m256 merge(int mode, __m256 A, __m256 B)
+        {
+            const __m256 zero = _mm256_setzero_ps();
+            const __m256 one = _mm256_set1_ps(1.0f);
+            const __m256 half = _mm256_set1_ps(0.5f);
+            const __m256 two = _mm256_set1_ps(2.0f);
+            __m256 Aa = Simd::broadcastChannel<Channel_Alpha>(A);
+            __m256 Ba = Simd::broadcastChannel<Channel_Alpha>(B);
+            __m256 AB = _mm256_mul_ps(A, B);
+            switch (mode)
+            {
+            case MergeMode_Atop:
+                return _mm256_fmadd_ps(B, Aa, _mm256_mul_ps(A, _mm256_sub_ps(one, Ba)));
+            case MergeMode_Average:
+                return _mm256_mul_ps(_mm256_add_ps(A, B), half);
+            case MergeMode_ColorBurn:
+            {
+                __m256 burn = _mm256_sub_ps(one, _mm256_min_ps(one, _mm256_div_ps(_mm256_sub_ps(one, A), B)));
+                burn = _mm256_blendv_ps(burn, zero, _mm256_cmp_ps(B, zero, _CMP_LE_OQ));
+                return _mm256_blendv_ps(burn, one, _mm256_cmp_ps(A, one, _CMP_EQ_OQ));
+            }
+            case MergeMode_ColorDodge:
+            {
+                __m256 dodge = _mm256_min_ps(one, _mm256_div_ps(A, _mm256_sub_ps(one, B)));
+                dodge = _mm256_blendv_ps(dodge, one, _mm256_cmp_ps(B, one, _CMP_GE_OQ));
+                return _mm256_blendv_ps(dodge, zero, _mm256_cmp_ps(A, zero, _CMP_LE_OQ));
+            }
+            case MergeMode_ConjointOver:
+                return _mm256_blendv_ps(_mm256_add_ps(B, _mm256_div_ps(_mm256_mul_ps(A, _mm256_sub_ps(one, Ba)), Aa)), B,
+                                        _mm256_cmp_ps(Ba, Aa, _CMP_GT_OQ));
+            case MergeMode_Difference:
+                return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), _mm256_sub_ps(B, A));
+            case MergeMode_DisjointOver:
+                return _mm256_blendv_ps(_mm256_add_ps(B, _mm256_div_ps(_mm256_mul_ps(A, _mm256_sub_ps(one, Ba)), Aa)), _mm256_add_ps(A, B),
+                                        _mm256_cmp_ps(_mm256_add_ps(Ba, Aa), one, _CMP_LT_OQ));
+            case MergeMode_Divide:
+                // Prevents two negatives becoming a positive
+                return _mm256_blendv_ps(_mm256_div_ps(B, A), zero,
+                                        _mm256_and_ps(_mm256_cmp_ps(A, zero, _CMP_LT_OQ), _mm256_cmp_ps(B, zero, _CMP_LT_OQ)));
+            case MergeMode_Exclusion:
+                return _mm256_fnmadd_ps(two, AB, _mm256_add_ps(A, B));
+            case MergeMode_From:
+            case MergeMode_Minus:
+                return _mm256_sub_ps(A, B);
+            case MergeMode_Geometric:
+                return _mm256_div_ps(_mm256_mul_ps(two, AB), _mm256_add_ps(A, B));
+            case MergeMode_HardLight:
+                return _mm256_blendv_ps(screen(A, B), multiply(A, B), _mm256_cmp_ps(B, half, _CMP_LT_OQ));
+            case MergeMode_Hypot:
+                return _mm256_sqrt_ps(_mm256_fmadd_ps(A, A, _mm256_mul_ps(B, B)));
+            case MergeMode_In:
+                return _mm256_mul_ps(B, Aa);
+            case MergeMode_Mask:
+                return _mm256_mul_ps(A, Ba);
+            case MergeMode_Matte:
+                return _mm256_fmadd_ps(B, Ba, _mm256_mul_ps(Aa, _mm256_sub_ps(one, Ba)));
+            case MergeMode_Max:
+                return _mm256_max_ps(B, A);
+            case MergeMode_Min:
+                return _mm256_min_ps(B, A);
+            case MergeMode_Multiply:
+                return multiply(A, B);
+            case MergeMode_Out:
+                return _mm256_mul_ps(B, _mm256_sub_ps(one, Aa));
+            case MergeMode_Over:
+                return _mm256_fmadd_ps(A, _mm256_sub_ps(one, Ba), B);
+            case MergeMode_Overlay:
+                return _mm256_blendv_ps(screen(A, B), multiply(A, B), _mm256_cmp_ps(A, half, _CMP_LT_OQ));
+            case MergeMode_Plus:
+                return _mm256_add_ps(A, B);
+            case MergeMode_Screen:
+                return screen(A, B);
+            case MergeMode_SoftLight:
+            {
+                __m256 soft = _mm256_mul_ps(A, _mm256_fmadd_ps(two, B, _mm256_mul_ps(A, _mm256_sub_ps(one, AB))));
+                return _mm256_blendv_ps(_mm256_mul_ps(two, AB), soft, _mm256_cmp_ps(AB, one, _CMP_LT_OQ));
+            }
+            case MergeMode_Stencil:
+                return _mm256_mul_ps(A, _mm256_sub_ps(one, Ba));
+            case MergeMode_Under:
+                return _mm256_fmadd_ps(B, _mm256_sub_ps(one, Aa), A);
+            case MergeMode_Xor:
+                return _mm256_fmadd_ps(A, _mm256_sub_ps(one, Ba), _mm256_mul_ps(B, _mm256_sub_ps(one, Aa)));
+            default:
+                return A;
+            }
+        }
     };
 
     REGISTER_OPERATOR(Merge, Merge::create);
+    REGISTER_CPU_OPERATOR(Merge, MergeCpu::create);
 }
@@ -2,6 +2,7 @@
 #include <string>
 #include <vector>
 
+#include "../cpu/CpuOperator.h"
 #include "../gl/ComputeShaderOperator.h"
 #include "../nodegraph/OperatorRegistry.hpp"
 #include "../nodegraph/Settings.h"
@@ -21,12 +22,47 @@ namespace Op
         {
             return {{}};
         }
-        void registerSettings(Settings *const settings) const override
+        Footprint footprint([[maybe_unused]] Settings const *settings) const override
+        {
+            return {true, 0};
+        }
+        static void registerOperatorSettings(Settings *const settings)
         {
             settings->registerInt("channelMask", ChannelMask_RGB, ChannelMask_Red, ChannelMask_Alpha, SettingHint_ChannelMask);
             settings->registerFloat("multiplier", 1.0f, -5.0f, 5.0f);
         }
+        void registerSettings(Settings *const settings) const override
+        {
+            registerOperatorSettings(settings);
+        }
+    };
+
+    class MultiplyCpu : public CpuOperator
+    {
+    public:
+        static MultiplyCpu *create()
+        {
+            return new MultiplyCpu();
+        }
+
+        std::vector<Input> inputs() const override
+        {
+            return {{}};
+        }
+        void registerSettings(Settings *const settings) const override
+        {
+            Multiply::registerOperatorSettings(settings);
+        }
+        void compute(const std::vector<ImageBuffer const *> &inputs, ImageBuffer *output, const ImageRegion &region, Settings const *settings) const override
+        {
+            // Unmasked channels are multiplied by 1
+            __m256 multiplier = _mm256_blendv_ps(_mm256_set1_ps(1.0f), _mm256_set1_ps(settings->getFloat("multiplier")),
+                                                 Simd::channelLanes(settings->getInt("channelMask")));
+            transformRegion(inputs[0], output, region, [multiplier](__m256 value)
+                            { return _mm256_mul_ps(value, multiplier); });
+        }
     };
 
     REGISTER_OPERATOR(Multiply, Multiply::create);
+    REGISTER_CPU_OPERATOR(Multiply, MultiplyCpu::create);
 }
@@ -22,9 +22,14 @@ namespace Op
         {
             return {{}};
         }
+        Footprint footprint([[maybe_unused]] Settings const *settings) const override
+        {
+            // Reads the neighbouring pixels
+            return {true, 1};
+        }
         void registerSettings(Settings *const settings) const override
         {
-            settings->registerFloat("scale", true, 0.01f, 100.0f);
+            settings->registerFloat("scale", true, 0.01f, 100.0f, SettingHint_Pixels);
             settings->registerInt("channel", ::Channel_Red, 0, 3, SettingHint_Channel);
         }
     };
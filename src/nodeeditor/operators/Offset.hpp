@@ -23,7 +23,7 @@ namespace Op
         }
         void registerSettings(Settings *const settings) const override
         {
-            settings->registerInt2("offset", glm::ivec2(0));
+            settings->registerInt2("offset", glm::ivec2(0), SettingHint_Pixels);
         }
     };
 
@@ -0,0 +1,27 @@
+#pragma once
+
+// Not used directly, but must be included by the executable for operators to be added to the registry
+#include "Add.hpp"
+#include "CheckerBoard.hpp"
+#include "Clamp.hpp"
+#include "Constant.hpp"
+#include "ConvolveTexture.hpp"
+#include "CopyLayer.hpp"
+#include "ExtractLayer.hpp"
+#include "Gaussian.hpp"
+#include "Gradient.hpp"
+#include "Invert.hpp"
+#include "JumpFlood.hpp"
+#include "Load.hpp"
+#include "Merge.hpp"
+#include "Multiply.hpp"
+#include "Normals.hpp"
+#include "Offset.hpp"
+#include "Perlin.hpp"
+#include "Pixel.hpp"
+#include "Power.hpp"
+#include "Save.hpp"
+#include "Shuffle.hpp"
+#include "Temperature.hpp"
+#include "VectorBand.hpp"
+#include "Voronoi.hpp"
@@ -8,6 +8,7 @@ uniform float frequency = 1.0f;
 uniform float amplitude = 1.0f;
 uniform float lacunarity = 1.0f;
 uniform float persistence = 0.5f;
+uniform ivec2 _imageOrigin = ivec2(0);
 
 
 vec3 mod289(vec3 x) {
@@ -130,7 +131,7 @@ vec3 maxAxis(vec3 v)
 void main()
 {
     ivec2 pixel_coords = ivec2(gl_GlobalInvocationID.xy);
-    vec3 pos = vec3(pixel_coords, 0) + offset;
+    vec3 pos = vec3(pixel_coords + _imageOrigin, 0) + offset;
     float noise = fbm(pos, octaves, frequency, amplitude, lacunarity, persistence);
     imageStore(imgOut, pixel_coords, vec4(noise, noise, noise, 1));
 }
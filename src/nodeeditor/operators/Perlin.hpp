@@ -17,14 +17,14 @@ namespace Op
             return new PerlinNoise();
         }
 
-        PerlinNoise() : ContentCreatorComputeShaderOperator("src/nodeeditor/operators/Perlin.glsl") {}
+        PerlinNoise() : ContentCreatorComputeShaderOperator("src/nodeeditor/operators/Perlin.glsl", GL_R32F) {}
 
         void registerSettings(Settings *const settings) const override
         {
             ContentCreatorComputeShaderOperator::registerSettings(settings);
-            settings->registerFloat3("offset", glm::vec3(1), FLT_MIN, FLT_MAX);
+            settings->registerFloat3("offset", glm::vec3(1), FLT_MIN, FLT_MAX, SettingHint_Pixels);
             settings->registerInt("octaves", 8, 1, 16);
-            settings->registerFloat("frequency", 0.003f, 0.0f, 1.0f, SettingHint_Logarithmic);
+            settings->registerFloat("frequency", 0.003f, 0.0f, 1.0f, SettingHint(SettingHint_Logarithmic | SettingHint_PerPixel));
             settings->registerFloat("amplitude", 1.0f, 0.01f, 100.0f, SettingHint_Logarithmic);
             settings->registerFloat("lacunarity", 1.5f, 0.01f, 100.0f, SettingHint_Logarithmic);
             settings->registerFloat("persistence", 0.66f);
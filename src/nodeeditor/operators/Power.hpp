@@ -2,6 +2,7 @@
 #include <string>
 #include <vector>
 
+#include "../cpu/CpuOperator.h"
 #include "../gl/ComputeShaderOperator.h"
 #include "../nodegraph/OperatorRegistry.hpp"
 #include "../nodegraph/Settings.h"
@@ -21,12 +22,46 @@ namespace Op
         {
             return {{}};
         }
-        void registerSettings(Settings *const settings) const override
+        Footprint footprint([[maybe_unused]] Settings const *settings) const override
+        {
+            return {true, 0};
+        }
+        static void registerOperatorSettings(Settings *const settings)
         {
             settings->registerInt("channelMask", ChannelMask_RGB, ChannelMask_Red, ChannelMask_Alpha, SettingHint_ChannelMask);
             settings->registerFloat("exponent", 2.0f, 0.0f, 10.0f);
         }
+        void registerSettings(Settings *const settings) const override
+        {
+            registerOperatorSettings(settings);
+        }
+    };
+
+    class PowerCpu : public CpuOperator
+    {
+    public:
+        static PowerCpu *create()
+        {
+            return new PowerCpu();
+        }
+
+        std::vector<Input> inputs() const override
+        {
+            return {{}};
+        }
+        void registerSettings(Settings *const settings) const override
+        {
+            Power::registerOperatorSettings(settings);
+        }
+        void compute(const std::vector<ImageBuffer const *> &inputs, ImageBuffer *output, const ImageRegion &region, Settings const *settings) const override
+        {
+            __m256 lanes = Simd::channelLanes(settings->getInt("channelMask"));
+            __m256 exponent = _mm256_set1_ps(settings->getFloat("exponent"));
+            transformRegion(inputs[0], output, region, [lanes, exponent](__m256 value)
+                            { return _mm256_blendv_ps(value, Simd::pow(value, exponent), lanes); });
+        }
     };
 
     REGISTER_OPERATOR(Power, Power::create);
+    REGISTER_CPU_OPERATOR(Power, PowerCpu::create);
 }
@@ -39,7 +39,10 @@ namespace Op
             unsigned char *pixels = new unsigned char[texture->width() * texture->height() * texture->numChannels()];
             glActiveTexture(GL_TEXTURE0);
             glBindTexture(GL_TEXTURE_2D, texture->id());
+            // Rows of single channel images aren't a multiple of the default 4 byte alignment
+            glPixelStorei(GL_PACK_ALIGNMENT, 1);
             glGetTexImage(GL_TEXTURE_2D, 0, texture->format(), GL_UNSIGNED_BYTE, pixels);
+            glPixelStorei(GL_PACK_ALIGNMENT, 4);
 
             stbi_flip_vertically_on_write(true);
             int result = stbi_write_png((filepath + EXTENSION_PNG).c_str(),
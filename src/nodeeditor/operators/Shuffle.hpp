@@ -2,6 +2,7 @@
 #include <string>
 #include <vector>
 
+#include "../cpu/CpuOperator.h"
 #include "../gl/ComputeShaderOperator.h"
 #include "../nodegraph/OperatorRegistry.hpp"
 #include "../nodegraph/Settings.h"
@@ -21,7 +22,11 @@ namespace Op
         {
             return {{}};
         }
-        void registerSettings(Settings *const settings) const override
+        Footprint footprint([[maybe_unused]] Settings const *settings) const override
+        {
+            return {true, 0};
+        }
+        static void registerOperatorSettings(Settings *const settings)
         {
             settings->registerInt("red", ChannelMask_Red, ChannelMask_None, ChannelMask_Alpha, SettingHint_ChannelMask);
             settings->registerInt("green", ChannelMask_Green, ChannelMask_None, ChannelMask_Alpha, SettingHint_ChannelMask);
@@ -30,7 +35,65 @@ namespace Op
             settings->registerInt("white", ChannelMask_None, ChannelMask_None, ChannelMask_Alpha, SettingHint_ChannelMask);
             settings->registerInt("black", ChannelMask_None, ChannelMask_None, ChannelMask_Alpha, SettingHint_ChannelMask);
         }
+        void registerSettings(Settings *const settings) const override
+        {
+            registerOperatorSettings(settings);
+        }
+    };
+
+    class ShuffleCpu : public CpuOperator
+    {
+    public:
+        static ShuffleCpu *create()
+        {
+            return new ShuffleCpu();
+        }
+
+        std::vector<Input> inputs() const override
+        {
+            return {{}};
+        }
+        void registerSettings(Settings *const settings) const override
+        {
+            Shuffle::registerOperatorSettings(settings);
+        }
+        void compute(const std::vector<ImageBuffer const *> &inputs, ImageBuffer *output, const ImageRegion &region, Settings const *settings) const override
+        {
+            // As in the shader, the last source selecting an output channel wins
+            const char *sources[] = {"red", "green", "blue", "alpha", "white", "black"};
+            int source[4] = {-1, -1, -1, -1};
+            for (int i = 0; i < 6; ++i)
+            {
+                int mask = settings->getInt(sources[i]);
+                for (int c = 0; c < 4; ++c)
+                {
+                    if (mask & (1 << c))
+                    {
+                        source[c] = i;
+                    }
+                }
+            }
+
+            // Input channels are permuted into place, white and black (or unselected) are constants
+            __m256i permute = _mm256_setr_epi32(source[0], source[1], source[2], source[3],
+                                                source[0], source[1], source[2], source[3]);
+            glm::vec4 constant(0.0f);
+            int constantMask = 0;
+            for (int c = 0; c < 4; ++c)
+            {
+                if (source[c] < 0 || source[c] > 3)
+                {
+                    constant[c] = source[c] == 4 ? 1.0f : 0.0f;
+                    constantMask |= 1 << c;
+                }
+            }
+            __m256 constantValue = Simd::broadcastPixel(constant);
+            __m256 constantLanes = Simd::channelLanes(constantMask);
+            transformRegion(inputs[0], output, region, [permute, constantValue, constantLanes](__m256 value)
+                            { return _mm256_blendv_ps(_mm256_permutevar_ps(value, permute), constantValue, constantLanes); });
+        }
     };
 
     REGISTER_OPERATOR(Shuffle, Shuffle::create);
+    REGISTER_CPU_OPERATOR(Shuffle, ShuffleCpu::create);
 }
@@ -23,7 +23,8 @@ namespace Op
         }
         std::vector<OutputLayer> outputLayers(const std::vector<RenderSetOperator const *> &inputs, [[maybe_unused]] Settings const *settings, Settings const *sceneSettings) override
         {
-            return {{"Temperature", outputLayerSize(0, inputs, sceneSettings)}};
+            // Greyscale, so only the red channel is stored
+            return {{"Temperature", outputLayerSize(0, inputs, sceneSettings), GL_R32F}};
         }
         void registerSettings(Settings *const settings) const override
         {
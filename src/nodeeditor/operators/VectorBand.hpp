@@ -17,13 +17,18 @@ namespace Op
             return new VectorBand();
         }
 
-        VectorBand() : ContentCreatorComputeShaderOperator("src/mapgen/operators/VectorBand.glsl") {}
+        VectorBand() : ContentCreatorComputeShaderOperator("src/nodeeditor/operators/VectorBand.glsl") {}
         void registerSettings(Settings *const settings) const override
         {
             ContentCreatorComputeShaderOperator::registerSettings(settings);
-            settings->registerInt("divisionSize", 0, 0, 100);
+            settings->registerInt("divisionSize", 0, 0, 100, SettingHint_Pixels);
             settings->registerFloat2Array("vectors", {{1, 1}, {0.5, 0.5}});
         }
+        Footprint footprint([[maybe_unused]] Settings const *settings) const override
+        {
+            // Bands are divided over the full image height
+            return {};
+        }
     };
 
     REGISTER_OPERATOR(VectorBand, VectorBand::create);
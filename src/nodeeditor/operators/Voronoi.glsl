@@ -5,6 +5,7 @@ layout(rgba32f, binding=0) uniform image2D heightmap;
 uniform ivec2 offset = ivec2(0);
 uniform float size = 100.0f;
 uniform float skew = 0.5f;
+uniform ivec2 _imageOrigin = ivec2(0);
 
 vec3 hash3( vec2 vec ){
     vec3 q = vec3(
@@ -42,6 +43,6 @@ vec3 voronoi(vec2 pos, float skew){
 }
 
 void main() {
-    vec3 noise = voronoi((gl_GlobalInvocationID.xy + offset) / size, skew);
+    vec3 noise = voronoi((gl_GlobalInvocationID.xy + _imageOrigin + offset) / size, skew);
     imageStore(heightmap, ivec2(gl_GlobalInvocationID.xy), vec4(noise.x, noise.x, noise.x, 1));
 }
\ No newline at end of file
@@ -15,12 +15,12 @@ namespace Op
             return new VoronoiNoise();
         }
 
-        VoronoiNoise() : ContentCreatorComputeShaderOperator("src/nodeeditor/operators/Voronoi.glsl") {}
+        VoronoiNoise() : ContentCreatorComputeShaderOperator("src/nodeeditor/operators/Voronoi.glsl", GL_R32F) {}
         void registerSettings(Settings *const settings) const override
         {
             ContentCreatorComputeShaderOperator::registerSettings(settings);
-            settings->registerInt2("offset", glm::ivec2(0));
-            settings->registerFloat("size", 100.0f, 1.0f, 2048.0f);
+            settings->registerInt2("offset", glm::ivec2(0), SettingHint_Pixels);
+            settings->registerFloat("size", 100.0f, 1.0f, 2048.0f, SettingHint_Pixels);
             settings->registerFloat("skew", 0.5f);
         }
     };
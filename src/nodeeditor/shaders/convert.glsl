@@ -0,0 +1,13 @@
+#version 430 core
+layout(local_size_x = 8, local_size_y = 4) in;
+layout(rgba32f, binding=0) uniform image2D imgIn;
+layout(rgba32f, binding=1) uniform image2D imgOut;
+
+uniform bool greyscale;
+
+void main(){
+    ivec2 pixel_coords = ivec2(gl_GlobalInvocationID.xy);
+    vec4 col = imageLoad(imgIn, pixel_coords);
+    if (greyscale) col = vec4(col.x, col.x, col.x, 1);
+    imageStore(imgOut, pixel_coords, col);
+}
\ No newline at end of file
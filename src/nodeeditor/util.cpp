@@ -64,3 +64,8 @@ bool containsTextCaseInsensitive(const char *text, const char *search)
 
     return false;
 }
+
+size_t hashCombine(size_t seed, size_t value)
+{
+    return seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+}
@@ -1,7 +1,10 @@
 #pragma once
+#include <cstddef>
 
 #include "constants.h"
 
 const char *getChannelName(Channel channel);
 bool textMatchesCaseInsensitive(const char *text, const char *search);
 bool containsTextCaseInsensitive(const char *text, const char *search);
+// Mixes a value into a running hash, as per boost::hash_combine
+size_t hashCombine(size_t seed, size_t value);
@@ -0,0 +1,29 @@
+#pragma once
+#include <iostream>
+#include <string>
+
+/*
+Minimal checks shared by the tests. Each failed check is reported and counted, and main()
+returns finish() so a test fails if any check did.
+*/
+inline int &numFailures()
+{
+    static int count = 0;
+    return count;
+}
+
+inline void check(bool condition, const std::string &message)
+{
+    if (!condition)
+    {
+        std::cout << "FAILED: " << message << std::endl;
+        ++numFailures();
+    }
+}
+
+/* Reports the result of the named tests and returns the exit code for main() */
+inline int finish(const std::string &name)
+{
+    std::cout << name << (numFailures() ? " tests failed" : " tests passed") << std::endl;
+    return numFailures() ? 1 : 0;
+}
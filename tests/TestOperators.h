@@ -0,0 +1,178 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/nodeeditor/nodegraph/Node.h"
+#include "../src/nodeeditor/nodegraph/Operator.h"
+#include "../src/nodeeditor/nodegraph/OperatorRegistry.hpp"
+#include "../src/nodeeditor/nodegraph/ResultCache.h"
+#include "../src/nodeeditor/nodegraph/Settings.h"
+
+/*
+Operators for testing the framework without a GL context. Each outputs one number, its
+"value" setting plus the numbers of its inputs, once processed in as many calls as its
+"steps" setting. Every operator is recorded as it finishes processing, see processed().
+
+- TestSource has no inputs
+- TestAdd has two optional inputs
+- TestAsyncAdd is a TestAdd processed by the scheduler's workers
+- TestWait is a TestAdd with one input processed by the workers, whose first call to
+  process() blocks until cancelled, see waitForCancel()
+*/
+namespace TestOp
+{
+    inline std::mutex &processedMutex()
+    {
+        static std::mutex mutex;
+        return mutex;
+    }
+    inline std::vector<Op::Operator const *> &processedOps()
+    {
+        static std::vector<Op::Operator const *> ops;
+        return ops;
+    }
+    /* The operators processed since the last call to clearProcessed(), in the order they finished */
+    inline std::vector<Op::Operator const *> processed()
+    {
+        std::lock_guard<std::mutex> guard(processedMutex());
+        return processedOps();
+    }
+    inline void clearProcessed()
+    {
+        std::lock_guard<std::mutex> guard(processedMutex());
+        processedOps().clear();
+    }
+
+    class ValueResult : public CachedResult
+    {
+    public:
+        ValueResult(float value) : value(value) {}
+
+        float value;
+
+        size_t byteSize() const override { return sizeof(float); }
+    };
+
+    class ValueOperator : public Op::Operator
+    {
+    public:
+        ValueOperator(size_t numInputs, bool isAsync, bool waitsForCancel = false)
+            : m_numInputs(numInputs), m_isAsync(isAsync), m_waitsForCancel(waitsForCancel) {}
+
+        float value() const { return m_value; }
+        /* Number of calls to process() since the operator was created */
+        int numProcessCalls() const { return m_numProcessCalls; }
+        /* Whether the operator saw its work cancelled */
+        bool sawCancel() const { return m_sawCancel; }
+
+        std::vector<Op::Input> inputs() const override
+        {
+            return std::vector<Op::Input>(m_numInputs, Op::Input{"in", false});
+        }
+        std::vector<Op::Output> outputs() const override { return {{"out"}}; }
+        void registerSettings(Settings *const settings) const override
+        {
+            settings->registerFloat("value", 1.0f);
+            settings->registerInt("steps", 1);
+        }
+
+        bool process(const std::vector<Op::Operator const *> &inputs, Settings const *settings,
+                     [[maybe_unused]] Settings const *sceneSettings) override
+        {
+            if (++m_numProcessCalls == 1 && m_waitsForCancel)
+            {
+                waitForCancel();
+            }
+            if (isCancelled())
+            {
+                m_sawCancel = true;
+                return false;
+            }
+            if (++m_step < settings->getInt("steps"))
+            {
+                return false;
+            }
+            m_value = settings->getFloat("value");
+            for (Op::Operator const *input : inputs)
+            {
+                m_value += input ? static_cast<ValueOperator const *>(input)->value() : 0.0f;
+            }
+            m_isProcessed = true;
+            std::lock_guard<std::mutex> guard(processedMutex());
+            processedOps().push_back(this);
+            return true;
+        }
+        bool canProcessAsync([[maybe_unused]] const std::vector<Op::Operator const *> &inputs) const override
+        {
+            return m_isAsync;
+        }
+
+        std::unique_ptr<CachedResult> releaseResult() override
+        {
+            return std::make_unique<ValueResult>(m_value);
+        }
+        bool restoreResult(std::unique_ptr<CachedResult> result, [[maybe_unused]] const std::vector<Op::Operator const *> &inputs) override
+        {
+            ValueResult *valueResult = dynamic_cast<ValueResult *>(result.get());
+            if (!valueResult)
+            {
+                return false;
+            }
+            m_value = valueResult->value;
+            m_isProcessed = true;
+            return true;
+        }
+        size_t outputByteSize() const override { return m_isProcessed ? sizeof(float) : 0; }
+
+        void reset() override
+        {
+            Op::Operator::reset();
+            m_value = 0.0f;
+            m_step = 0;
+            m_isProcessed = false;
+        }
+
+    protected:
+        size_t m_numInputs;
+        bool m_isAsync;
+        bool m_waitsForCancel;
+        float m_value = 0.0f;
+        int m_step = 0;
+        bool m_isProcessed = false;
+        // Written by a worker for asynchronous operators
+        std::atomic<int> m_numProcessCalls = 0;
+        std::atomic<bool> m_sawCancel = false;
+
+        /* Blocks until cancelled, giving up after a few seconds so a failing test still ends */
+        void waitForCancel() const
+        {
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+            while (!isCancelled() && std::chrono::steady_clock::now() < deadline)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+    };
+
+    inline void registerOperators()
+    {
+        Op::OperatorRegistry::registerOperator("TestSource", []()
+                                               { return new ValueOperator(0, false); });
+        Op::OperatorRegistry::registerOperator("TestAdd", []()
+                                               { return new ValueOperator(2, false); });
+        Op::OperatorRegistry::registerOperator("TestAsyncAdd", []()
+                                               { return new ValueOperator(2, true); });
+        Op::OperatorRegistry::registerOperator("TestWait", []()
+                                               { return new ValueOperator(1, true, true); });
+    }
+
+    inline ValueOperator const *op(Node *node)
+    {
+        return static_cast<ValueOperator const *>(node->op());
+    }
+}
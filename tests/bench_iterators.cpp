@@ -0,0 +1,156 @@
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "../src/nodeeditor/nodegraph/Iterators.h"
+#include "../src/nodeeditor/nodegraph/Node.h"
+
+/*
+Compares DepthIterator against the recursive iterator it replaced, which held a
+shared_ptr to an iterator per depth level and walked shared nodes once per path.
+*/
+class RecursiveIterator
+{
+public:
+    RecursiveIterator() {}
+    RecursiveIterator(Node *node, int depth = 0) : m_node(node), m_depth(depth) {}
+
+    Node *operator->() { return currentNode(); }
+    RecursiveIterator &operator++()
+    {
+        advance();
+        return *this;
+    }
+    bool operator!=(const RecursiveIterator &it) const { return currentNode() != it.currentNode(); }
+
+private:
+    Node *m_node = nullptr;
+    int m_depth = 0;
+    std::shared_ptr<RecursiveIterator> m_next = nullptr;
+    int m_connectorIndex = 0;
+    int m_connectionIndex = -1;
+    bool m_isExhausted = false;
+
+    Node *currentNode() const
+    {
+        if (m_isExhausted || !m_node)
+        {
+            return nullptr;
+        }
+        const RecursiveIterator *curr = this;
+        while (curr->m_next)
+        {
+            curr = curr->m_next.get();
+        }
+        return curr->m_node;
+    }
+    bool advance()
+    {
+        if (m_isExhausted)
+        {
+            return false;
+        }
+        if (m_next && m_next->advance())
+        {
+            return true;
+        }
+        while ((size_t)m_connectorIndex < m_node->numInputs())
+        {
+            Connector *conn = m_node->input(m_connectorIndex);
+            while (size_t(++m_connectionIndex) < conn->numConnections())
+            {
+                m_next = std::make_shared<RecursiveIterator>(conn->connection(m_connectionIndex)->node(), m_depth + 1);
+                return true;
+            }
+            ++m_connectorIndex;
+            m_connectionIndex = -1;
+        }
+        m_isExhausted = true;
+        return false;
+    }
+};
+
+typedef std::vector<std::unique_ptr<Node>> Nodes;
+
+Node *addNode(Nodes &nodes, size_t numInputs)
+{
+    nodes.push_back(std::make_unique<Node>(NodeID(nodes.size() + 1), nullptr));
+    Node *node = nodes.back().get();
+    node->addOutput();
+    for (size_t i = 0; i < numInputs; ++i)
+    {
+        node->addInput();
+    }
+    return node;
+}
+
+// Binary tree of 1023 nodes, every node is reached along one path
+Node *buildTree(Nodes &nodes)
+{
+    Node *root = addNode(nodes, 2);
+    std::vector<Node *> leaves = {root};
+    while (nodes.size() < 1023)
+    {
+        std::vector<Node *> next;
+        for (Node *leaf : leaves)
+        {
+            for (size_t i = 0; i < 2; ++i)
+            {
+                Node *node = addNode(nodes, nodes.size() < 511 ? 2 : 0);
+                leaf->input(i)->connect(node->output(0));
+                next.push_back(node);
+            }
+        }
+        leaves = next;
+    }
+    return root;
+}
+
+// 1000 nodes, a source feeding 998 nodes that all feed the root
+Node *buildFan(Nodes &nodes)
+{
+    Node *root = addNode(nodes, 998);
+    Node *source = addNode(nodes, 0);
+    for (size_t i = 0; i < 998; ++i)
+    {
+        Node *node = addNode(nodes, 1);
+        node->input(0)->connect(source->output(0));
+        root->input(i)->connect(node->output(0));
+    }
+    return root;
+}
+
+template <typename Iterator>
+void bench(const char *name, Node *root, int repeats)
+{
+    size_t visits = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repeats; ++i)
+    {
+        for (Iterator it{root}; it != Iterator(); ++it)
+        {
+            visits += it->id() > 0;
+        }
+    }
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << name << ": " << visits / repeats << " visits, " << elapsed.count() / repeats << "us per walk" << std::endl;
+}
+
+int main()
+{
+    const int repeats = 200;
+
+    Nodes tree;
+    Node *treeRoot = buildTree(tree);
+    std::cout << "Tree of " << tree.size() << " nodes" << std::endl;
+    bench<RecursiveIterator>("  recursive", treeRoot, repeats);
+    bench<DepthIterator>("  depth", treeRoot, repeats);
+
+    Nodes fan;
+    Node *fanRoot = buildFan(fan);
+    std::cout << "Fan of " << fan.size() << " nodes" << std::endl;
+    bench<RecursiveIterator>("  recursive", fanRoot, repeats);
+    bench<DepthIterator>("  depth", fanRoot, repeats);
+    return 0;
+}
@@ -0,0 +1,76 @@
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "Check.h"
+#include "../src/nodeeditor/constants.h"
+#include "../src/nodeeditor/gl/HeadlessContext.h"
+#include "../src/nodeeditor/nodegraph/BakedResults.h"
+#include "../src/nodeeditor/nodegraph/Scene.h"
+#include "../src/nodeeditor/nodegraph/Serializer.h"
+#include "../src/nodeeditor/operators/Operators.hpp"
+
+// Saves the scene referring to results baked next to it, as the editor does
+static bool save(Scene &scene, const std::filesystem::path &path, const std::filesystem::path &bakedResults)
+{
+    std::ofstream stream{path};
+    StreamSerializer serializer{&stream};
+    serializer.writePropertyInt(KEY_VERSION, VERSION);
+    return scene.serialize(&serializer, bakedResults.filename().string()) && stream.good();
+}
+
+int main()
+{
+    HeadlessContext context{true};
+    if (!context.isInitialised())
+    {
+        std::cout << "Bake tests need an OpenGL context" << std::endl;
+        return 1;
+    }
+
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "nodeeditor_test_bake";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    std::filesystem::path scenePath = directory / "scene.txt";
+    std::filesystem::path bakedPath = directory / ("scene.txt" + BAKED_RESULTS_EXTENSION);
+
+    // Two branches from a gradient, both processed and baked
+    Scene scene;
+    NodeID gradient = scene.createNode("Gradient");
+    NodeID power = scene.createNode("Power");
+    NodeID invert = scene.createNode("Invert");
+    scene.connect(scene.getNode(power)->input(0), scene.getNode(gradient)->output(0));
+    scene.connect(scene.getNode(invert)->input(0), scene.getNode(gradient)->output(0));
+    check(scene.evaluate({scene.getNode(power), scene.getNode(invert)}), "Processing the scene");
+    scene.bake(bakedPath.string());
+    scene.evaluate({});
+    check(save(scene, scenePath, bakedPath), "Saving the scene");
+    size_t invertFingerprint = scene.getNode(invert)->fingerprint();
+    std::unique_ptr<BakedResults> baked = BakedResults::open(bakedPath.string());
+    check(baked && baked->size() == 3, "Baking every processed node");
+
+    // Opened again, only the power branch is edited and processed before baking over the file
+    Scene opened;
+    check(opened.load(scenePath.string()), "Opening the baked scene");
+    opened.evaluate({});
+    opened.updateSetting(opened.getNode(power), "exponent", 3.0f);
+    check(opened.evaluate({opened.getNode(power)}), "Processing the edited branch");
+    size_t powerFingerprint = opened.getNode(power)->fingerprint();
+    check(opened.getNode(invert)->state() == State::Unprocessed, "Untouched branch left unprocessed");
+    opened.bake(bakedPath.string());
+    opened.evaluate({});
+
+    // The untouched result is carried over from the previous bake, the edited one replaced
+    std::unique_ptr<BakedResults> rebaked = BakedResults::open(bakedPath.string());
+    check(rebaked && rebaked->size() == 3, "Baking every result again");
+    check(rebaked && rebaked->contains(invertFingerprint) && rebaked->load(invertFingerprint),
+          "Keeping the untouched result");
+    check(rebaked && rebaked->contains(powerFingerprint), "Baking the edited result");
+
+    baked.reset();
+    rebaked.reset();
+    std::filesystem::remove_all(directory);
+    return finish("Bake");
+}
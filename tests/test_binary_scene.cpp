@@ -0,0 +1,148 @@
+#include <cmath>
+#include <initializer_list>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <utility>
+
+#include "Check.h"
+#include "../src/nodeeditor/constants.h"
+#include "../src/nodeeditor/gl/HeadlessContext.h"
+#include "../src/nodeeditor/nodegraph/BinarySerializer.h"
+#include "../src/nodeeditor/nodegraph/Scene.h"
+#include "../src/nodeeditor/nodegraph/Serializer.h"
+#include "../src/nodeeditor/operators/Operators.hpp"
+
+static std::string writeText(Scene &scene)
+{
+    std::stringstream stream;
+    StreamSerializer serializer{&stream};
+    serializer.writePropertyInt(KEY_VERSION, VERSION);
+    scene.serialize(&serializer);
+    return stream.str();
+}
+
+static std::string writeBinary(Scene &scene)
+{
+    std::stringstream stream;
+    BinarySerializer serializer{&stream};
+    serializer.writePropertyInt(KEY_VERSION, VERSION);
+    scene.serialize(&serializer);
+    return stream.str();
+}
+
+// Reads a scene written by writeBinary() from the first size bytes of data
+static bool readBinary(Scene &scene, const std::string &data, size_t size)
+{
+    BinaryDeserializer deserializer{data.data(), size};
+    std::string property;
+    int version;
+    bool ok = deserializer.readProperty(property) && property == KEY_VERSION && deserializer.readInt(version);
+    ok = ok && scene.deserialize(&deserializer);
+    // Nothing is applied unless the scene was read in full
+    scene.evaluate({});
+    return ok;
+}
+
+// The bytes writeInt() writes for each value in turn, without the file header
+static std::string writeInts(std::initializer_list<int> values)
+{
+    std::stringstream stream;
+    BinarySerializer serializer{&stream};
+    size_t headerSize = stream.str().size();
+    for (int value : values)
+    {
+        serializer.writeInt(value);
+    }
+    return stream.str().substr(headerSize);
+}
+
+// Replaces the connection record from..to in data, which must hold it. Searched
+// from the end as the connections are written last, after the nodes' settings.
+static std::string replaceConnection(std::string data, std::initializer_list<int> from, std::initializer_list<int> to)
+{
+    std::string pattern = writeInts(from);
+    size_t pos = data.rfind(pattern);
+    check(pos != std::string::npos, "Finding the connection to replace");
+    return pos == std::string::npos ? data : data.replace(pos, pattern.size(), writeInts(to));
+}
+
+// Reads a single value written as a float back as an int
+static bool readFloatAsInt(float value)
+{
+    std::stringstream stream;
+    BinarySerializer serializer{&stream};
+    serializer.writePropertyFloat("value", value);
+    std::string data = stream.str();
+    BinaryDeserializer deserializer{data.data(), data.size()};
+    std::string property;
+    int result;
+    return deserializer.readProperty(property) && deserializer.readInt(result);
+}
+
+int main()
+{
+    HeadlessContext context{true};
+    if (!context.isInitialised())
+    {
+        std::cout << "Binary scene tests need an OpenGL context" << std::endl;
+        return 1;
+    }
+
+    Scene scene;
+    NodeID gradient = scene.createNode("Gradient");
+    NodeID power = scene.createNode("Power");
+    NodeID merge = scene.createNode("Merge");
+    scene.updateSetting(scene.getNode(power), "exponent", 2.5f);
+    scene.updateSetting(scene.getNode(merge), "mode", 24);
+    scene.connect(scene.getNode(power)->input(0), scene.getNode(gradient)->output(0));
+    scene.connect(scene.getNode(merge)->input(0), scene.getNode(gradient)->output(0));
+    scene.connect(scene.getNode(merge)->input(1), scene.getNode(power)->output(0));
+    scene.evaluate({});
+    std::string text = writeText(scene);
+    std::string binary = writeBinary(scene);
+
+    Scene loaded;
+    check(readBinary(loaded, binary, binary.size()), "Reading the full scene");
+    check(writeText(loaded) == text, "The scene read is the scene written");
+
+    // A scene cut short anywhere fails to read and leaves the scene as it was
+    for (size_t size = 0; size < binary.size(); ++size)
+    {
+        Scene cut;
+        NodeID existing = cut.createNode("Invert");
+        check(!readBinary(cut, binary, size), "Reading the scene cut to " + std::to_string(size) + " bytes");
+        check(cut.getNode(existing) && cut.snapshot()->numNodes() == 1, "Scene unchanged after reading " + std::to_string(size) + " bytes");
+    }
+
+    // Connections to nodes or connectors that don't exist, or that form a cycle, fail to read
+    int m = int(merge), p = int(power), g = int(gradient);
+    const std::initializer_list<int> mergeFromPower = {m, 1, p, 0};
+    const std::initializer_list<int> powerFromGradient = {p, 0, g, 0};
+    const std::pair<std::string, std::string> corrupted[] = {
+        {"an unknown node", replaceConnection(binary, mergeFromPower, {m, 1, p + 100, 0})},
+        {"an unknown input node", replaceConnection(binary, mergeFromPower, {m + 100, 1, p, 0})},
+        {"an input out of range", replaceConnection(binary, mergeFromPower, {m, 7, p, 0})},
+        {"a negative input", replaceConnection(binary, mergeFromPower, {m, -1, p, 0})},
+        {"an output out of range", replaceConnection(binary, mergeFromPower, {m, 1, p, 3})},
+        {"a connected input", replaceConnection(binary, mergeFromPower, {m, 0, p, 0})},
+        {"a cycle", replaceConnection(binary, powerFromGradient, {p, 0, m, 0})},
+    };
+    for (const auto &[name, data] : corrupted)
+    {
+        Scene damaged;
+        NodeID existing = damaged.createNode("Invert");
+        check(!readBinary(damaged, data, data.size()), "Reading a connection to " + name);
+        check(damaged.getNode(existing) && damaged.snapshot()->numNodes() == 1, "Scene unchanged after a connection to " + name);
+    }
+
+    // Floats that can't be represented as an int are rejected rather than converted
+    check(readFloatAsInt(42.0f), "Reading a float as an int");
+    check(!readFloatAsInt(1e20f), "Reading a float too large for an int");
+    check(!readFloatAsInt(-1e20f), "Reading a float too small for an int");
+    check(!readFloatAsInt(std::numeric_limits<float>::quiet_NaN()), "Reading NaN as an int");
+    check(!readFloatAsInt(std::numeric_limits<float>::infinity()), "Reading infinity as an int");
+
+    return finish("Binary scene");
+}
@@ -0,0 +1,141 @@
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <thread>
+
+#include "Check.h"
+#include "TestOperators.h"
+#include "../src/nodeeditor/nodegraph/Graph.h"
+#include "../src/nodeeditor/nodegraph/Scene.h"
+#include "../src/nodeeditor/nodegraph/Scheduler.h"
+#include "../src/nodeeditor/nodegraph/Settings.h"
+
+// Exposes whether the processing thread is waiting for changes
+class IdleScene : public Scene
+{
+public:
+    bool isIdle() const { return m_internalPause.load(); }
+};
+
+static bool waitFor(std::function<bool()> done)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+    while (!done())
+    {
+        if (std::chrono::steady_clock::now() > deadline)
+        {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+static void checkScheduler()
+{
+    Graph graph;
+    Settings sceneSettings;
+    Node *wait = graph.node(graph.createNode("TestWait"));
+    Node *add = graph.node(graph.createNode("TestAdd"));
+    add->input(0)->connect(wait->output(0));
+
+    Scheduler scheduler(nullptr, 1);
+    scheduler.schedule({add});
+    // Blocks on the worker until cancelled from another thread
+    std::thread canceller([&scheduler]()
+                          {
+                              std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                              scheduler.cancel(); });
+    scheduler.step(&sceneSettings);
+    canceller.join();
+    check(scheduler.isCancelled() && TestOp::op(wait)->sawCancel(), "Cancelling work in progress");
+    check(wait->state() != State::Processed, "Leaving cancelled work unprocessed");
+
+    for (int i = 0; i < 3; ++i)
+    {
+        check(scheduler.step(&sceneSettings) == nullptr, "Starting nothing once cancelled");
+    }
+    check(add->state() == State::Unprocessed && TestOp::op(add)->numProcessCalls() == 0, "Leaving downstream nodes unprocessed");
+
+    scheduler.clear();
+    check(!scheduler.isCancelled(), "Clearing the cancellation with the schedule");
+    wait->reset();
+    scheduler.schedule({add});
+    while (!scheduler.isFinished())
+    {
+        scheduler.step(&sceneSettings);
+    }
+    check(add->state() == State::Processed && TestOp::op(add)->value() == 2.0f, "Processing a new schedule once cleared");
+}
+
+static void checkEditCancels()
+{
+    IdleScene scene;
+    scene.setCoalesceWindow(std::chrono::milliseconds(0));
+    NodeID source = scene.createNode("TestSource");
+    NodeID wait = scene.createNode("TestWait");
+    scene.evaluate({});
+    scene.connect(scene.getNode(wait)->input(0), scene.getNode(source)->output(0));
+    scene.evaluate({});
+    Node *waitNode = scene.getNode(wait);
+
+    scene.startProcessing();
+    scene.setViewNode(waitNode);
+    check(waitFor([&]()
+                  { return TestOp::op(waitNode)->numProcessCalls() > 0; }),
+          "Starting the view node");
+    auto start = std::chrono::steady_clock::now();
+    scene.updateSetting(scene.getNode(source), "value", 2.0f);
+    check(waitFor([&]()
+                  { return scene.isIdle() && waitNode->state() == State::Processed; }),
+          "Processing the view node after the edit");
+    check(TestOp::op(waitNode)->sawCancel(), "Cancelling the view node's work on an edit");
+    // The wait gives up on its own after a few seconds
+    check(std::chrono::steady_clock::now() - start < std::chrono::seconds(4), "Cancelling without waiting for the work");
+    check(TestOp::op(waitNode)->value() == 3.0f, "Processing with the edited setting");
+    scene.stopProcessing();
+}
+
+static void checkCoalescing()
+{
+    IdleScene scene;
+    scene.setCoalesceWindow(std::chrono::milliseconds(300));
+    NodeID source = scene.createNode("TestSource");
+    NodeID add = scene.createNode("TestAdd");
+    scene.evaluate({});
+    scene.connect(scene.getNode(add)->input(0), scene.getNode(source)->output(0));
+    scene.evaluate({});
+    Node *addNode = scene.getNode(add);
+
+    scene.startProcessing();
+    scene.setViewNode(addNode);
+    auto isProcessed = [&]()
+    { return scene.isIdle() && addNode->state() == State::Processed; };
+    check(waitFor(isProcessed), "Processing the view node");
+
+    // A burst of edits, eg, dragging a slider
+    int numProcessCalls = TestOp::op(addNode)->numProcessCalls();
+    const int numEdits = 20;
+    for (int i = 1; i <= numEdits; ++i)
+    {
+        scene.updateSetting(addNode, "value", float(i));
+    }
+    check(waitFor([&]()
+                  { return isProcessed() && TestOp::op(addNode)->value() == numEdits + 1.0f; }),
+          "Processing the last edit");
+    int numProcessed = TestOp::op(addNode)->numProcessCalls() - numProcessCalls;
+    check(numProcessed >= 1 && numProcessed <= 2, "Coalescing the burst of edits, processed " + std::to_string(numProcessed) + " times");
+    scene.stopProcessing();
+}
+
+int main()
+{
+    TestOp::registerOperators();
+
+    checkScheduler();
+    checkEditCancels();
+    checkCoalescing();
+
+    return finish("Cancel");
+}
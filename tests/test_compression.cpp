@@ -0,0 +1,115 @@
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Check.h"
+#include "../src/nodeeditor/nodegraph/Compression.h"
+
+static std::vector<char> compress(const std::vector<char> &data)
+{
+    std::vector<char> compressed(compressBound(data.size()));
+    size_t size = compressBlock(data.data(), data.size(), compressed.data(), compressed.size());
+    compressed.resize(size);
+    return compressed;
+}
+
+static bool roundTrips(const std::vector<char> &data)
+{
+    std::vector<char> compressed = compress(data);
+    std::vector<char> decompressed(data.size());
+    return (!compressed.empty() || data.empty()) &&
+           decompressBlock(compressed.data(), compressed.size(), decompressed.data(), decompressed.size()) && decompressed == data;
+}
+
+static std::vector<char> randomBytes(std::mt19937 &rng, size_t size)
+{
+    std::vector<char> data(size);
+    for (char &c : data)
+    {
+        c = char(rng());
+    }
+    return data;
+}
+
+// Short runs of repeated bytes with the odd random byte, like a flat image
+static std::vector<char> runBytes(std::mt19937 &rng, size_t size)
+{
+    std::vector<char> data;
+    while (data.size() < size)
+    {
+        data.insert(data.end(), std::min<size_t>(rng() % 300, size - data.size()), char(rng() % 4));
+        if (data.size() < size && rng() % 2)
+        {
+            data.push_back(char(rng()));
+        }
+    }
+    return data;
+}
+
+int main()
+{
+    std::mt19937 rng(1234);
+
+    // Sizes around the minimum match and the end of block limits
+    for (size_t size : {0, 1, 4, 5, 12, 13, 17, 64, 255, 4096, 1 << 20})
+    {
+        check(roundTrips(randomBytes(rng, size)), "Random bytes of size " + std::to_string(size));
+        check(roundTrips(runBytes(rng, size)), "Runs of bytes of size " + std::to_string(size));
+        check(roundTrips(std::vector<char>(size, 'x')), "One byte repeated " + std::to_string(size) + " times");
+    }
+
+    std::vector<char> runs = runBytes(rng, 100000);
+    check(compress(runs).size() < runs.size() / 10, "Runs of bytes compress");
+    std::vector<char> random = randomBytes(rng, 100000);
+    check(compress(random).size() <= compressBound(random.size()), "Random bytes stay within the bound");
+
+    // Too little space to compress into
+    std::vector<char> small(random.size() / 2);
+    check(compressBlock(random.data(), random.size(), small.data(), small.size()) == 0, "Compressing into too small a buffer fails");
+
+    // Every truncation of a block fails, as the block no longer decodes to the full size
+    std::vector<char> data = runBytes(rng, 5000);
+    std::vector<char> compressed = compress(data);
+    std::vector<char> decompressed(data.size());
+    for (size_t size = 0; size < compressed.size(); ++size)
+    {
+        check(!decompressBlock(compressed.data(), size, decompressed.data(), decompressed.size()),
+              "Block truncated to " + std::to_string(size) + " bytes");
+    }
+    check(!decompressBlock(compressed.data(), compressed.size(), decompressed.data(), decompressed.size() - 1),
+          "Block decoded into too small a buffer");
+    check(!decompressBlock(compressed.data(), compressed.size(), decompressed.data(), decompressed.size() + 1),
+          "Block decoded into too large a size");
+
+    // Corrupted blocks must only ever write within the output
+    std::vector<char> guarded(data.size() + 64, char(0x5a));
+    for (size_t i = 0; i < 10000; ++i)
+    {
+        std::vector<char> corrupted = compressed;
+        for (int j = 0; j < 4; ++j)
+        {
+            corrupted[rng() % corrupted.size()] = char(rng());
+        }
+        decompressBlock(corrupted.data(), corrupted.size(), guarded.data(), data.size());
+    }
+    bool isGuarded = true;
+    for (size_t i = data.size(); i < guarded.size(); ++i)
+    {
+        isGuarded = isGuarded && guarded[i] == char(0x5a);
+    }
+    check(isGuarded, "Corrupted blocks write past the output");
+
+    // Shuffling is reversible, including bytes past the last whole element
+    for (size_t size : {0, 3, 4, 15, 4096})
+    {
+        std::vector<char> bytes = randomBytes(rng, size);
+        std::vector<char> shuffled(size), unshuffled(size);
+        shuffleBytes(bytes.data(), shuffled.data(), size, 4);
+        unshuffleBytes(shuffled.data(), unshuffled.data(), size, 4);
+        check(unshuffled == bytes, "Shuffling " + std::to_string(size) + " bytes");
+    }
+
+    return finish("Compression");
+}
@@ -0,0 +1,93 @@
+#include <atomic>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "Check.h"
+#include "../src/nodeeditor/nodegraph/EditQueue.h"
+
+static void checkOrder()
+{
+    EditQueue queue;
+    check(queue.empty() && queue.apply() == 0, "Starting empty");
+
+    std::vector<int> applied;
+    for (int i = 0; i < 3; ++i)
+    {
+        queue.push([&applied, i]()
+                   { applied.push_back(i); });
+    }
+    check(!queue.empty(), "Holding pushed edits");
+    check(queue.apply() == 3 && applied == std::vector<int>{0, 1, 2}, "Applying edits in the order pushed");
+    check(queue.empty(), "Emptied once applied");
+
+    // Edits pushed while applying are applied after the rest
+    applied.clear();
+    queue.push([&queue, &applied]()
+               {
+                   applied.push_back(0);
+                   queue.push([&applied]()
+                              { applied.push_back(2); }); });
+    queue.push([&applied]()
+               { applied.push_back(1); });
+    check(queue.apply() == 3 && applied == std::vector<int>{0, 1, 2}, "Applying edits pushed by edits in the same pass");
+}
+
+// Several threads push numbered edits while one thread applies them
+static void checkConcurrentProducers()
+{
+    const int numProducers = 8;
+    const int numEdits = 20000;
+    EditQueue queue;
+    // Only touched by the applying thread
+    std::vector<std::pair<int, int>> applied;
+    applied.reserve(numProducers * numEdits);
+
+    std::atomic<int> numStarted = 0;
+    std::vector<std::thread> producers;
+    for (int producer = 0; producer < numProducers; ++producer)
+    {
+        producers.emplace_back([&, producer]()
+                               {
+                                   ++numStarted;
+                                   while (numStarted.load() < numProducers)
+                                   {
+                                       std::this_thread::yield();
+                                   }
+                                   for (int i = 0; i < numEdits; ++i)
+                                   {
+                                       queue.push([&applied, producer, i]()
+                                                  { applied.emplace_back(producer, i); });
+                                   } });
+    }
+    size_t numApplied = 0;
+    while (numApplied < size_t(numProducers * numEdits))
+    {
+        numApplied += queue.apply();
+    }
+    for (std::thread &producer : producers)
+    {
+        producer.join();
+    }
+    check(queue.apply() == 0 && queue.empty(), "Applying nothing more than was pushed");
+    check(applied.size() == size_t(numProducers * numEdits), "Applying every edit once");
+
+    // Each producer's edits are applied in the order it pushed them
+    std::vector<int> next(numProducers, 0);
+    bool inOrder = true;
+    for (const auto &[producer, i] : applied)
+    {
+        inOrder = inOrder && i == next[producer];
+        ++next[producer];
+    }
+    check(inOrder, "Applying each producer's edits in order");
+}
+
+int main()
+{
+    checkOrder();
+    checkConcurrentProducers();
+
+    return finish("Edit queue");
+}
@@ -0,0 +1,110 @@
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include <EGL/egl.h>
+
+#include "Check.h"
+#include "../src/nodeeditor/constants.h"
+#include "../src/nodeeditor/gl/HeadlessContext.h"
+#include "../src/nodeeditor/nodegraph/Scene.h"
+#include "../src/nodeeditor/operators/Operators.hpp"
+
+// Processes on the scene's thread, checking the cache still has a full size result as each preview is captured
+class PreviewScene : public Scene
+{
+public:
+    PreviewScene(HeadlessContext *context) : m_context(context) {}
+
+    std::atomic<size_t> fullFingerprint = 0;
+    std::atomic<int> numPreviews = 0;
+    std::atomic<int> numKept = 0;
+
+    bool isIdle() const { return m_internalPause.load(); }
+
+protected:
+    HeadlessContext *m_context;
+
+    void process() override
+    {
+        m_context->use();
+        Scene::process();
+        // The context is used again by the test's thread once processing stops
+        eglMakeCurrent(eglGetCurrentDisplay(), EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    }
+    void capturePreview([[maybe_unused]] Node *viewNode, [[maybe_unused]] glm::ivec2 offset, [[maybe_unused]] glm::ivec2 size,
+                        [[maybe_unused]] glm::ivec2 origin, [[maybe_unused]] glm::ivec2 extent) override
+    {
+        numKept += m_resultCache.contains(fullFingerprint.load());
+        ++numPreviews;
+    }
+};
+
+static bool waitFor(std::function<bool()> done)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(60);
+    while (!done())
+    {
+        if (std::chrono::steady_clock::now() > deadline)
+        {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return true;
+}
+
+// Edits a blur of pinned noise, which is previewed while the noise's full size result is kept
+static void checkPreview(HeadlessContext &context, const std::string &name, bool isProxy)
+{
+    PreviewScene scene{&context};
+    // Too small to cache any result
+    scene.setResultCacheCapacity(1);
+    scene.setProxyFactor(isProxy ? 4 : 1);
+    if (!isProxy)
+    {
+        scene.setViewRegion({100, 200}, {40, 30});
+    }
+    NodeID noise = scene.createNode("PerlinNoise");
+    NodeID blur = scene.createNode("Gaussian");
+    scene.evaluate({});
+    scene.connect(scene.getNode(blur)->input(0), scene.getNode(noise)->output(0));
+    scene.getNode(noise)->setSelectFlag(SelectFlag_Pinned);
+    scene.evaluate({});
+
+    eglMakeCurrent(eglGetCurrentDisplay(), EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    scene.startProcessing();
+    scene.setViewNode(scene.getNode(blur));
+    auto isProcessed = [&]()
+    { return scene.isIdle() && scene.snapshot()->node(blur)->state() == State::Processed; };
+    check(waitFor(isProcessed), name + ": processing the full image");
+
+    scene.fullFingerprint = scene.snapshot()->node(noise)->fingerprint();
+    scene.numPreviews = 0;
+    scene.numKept = 0;
+    scene.updateSetting(scene.getNode(blur), "sigma", 5.0f);
+    check(waitFor([&]()
+                  { return scene.numPreviews > 0 && isProcessed(); }),
+          name + ": processing the preview then the full image");
+    check(scene.numKept == scene.numPreviews, name + ": keeping the pinned full size result during the preview");
+    scene.stopProcessing();
+    context.use();
+}
+
+int main()
+{
+    HeadlessContext context{true};
+    if (!context.isInitialised())
+    {
+        std::cout << "Preview tests need an OpenGL context" << std::endl;
+        return 1;
+    }
+
+    checkPreview(context, "Region", false);
+    checkPreview(context, "Proxy", true);
+
+    return finish("Preview");
+}
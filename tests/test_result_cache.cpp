@@ -0,0 +1,92 @@
+#include <memory>
+#include <string>
+
+#include "Check.h"
+#include "TestOperators.h"
+#include "../src/nodeeditor/constants.h"
+#include "../src/nodeeditor/nodegraph/ResultCache.h"
+#include "../src/nodeeditor/nodegraph/Scene.h"
+
+static float takeValue(ResultCache &cache, size_t key)
+{
+    std::unique_ptr<CachedResult> result = cache.take(key);
+    TestOp::ValueResult *value = dynamic_cast<TestOp::ValueResult *>(result.get());
+    return value ? value->value : -1.0f;
+}
+
+static void checkCache()
+{
+    // Room for two results
+    ResultCache cache(2 * sizeof(float));
+    cache.insert(1, std::make_unique<TestOp::ValueResult>(1.0f));
+    cache.insert(2, std::make_unique<TestOp::ValueResult>(2.0f));
+    check(cache.contains(1) && cache.contains(2) && !cache.contains(3), "Finding results by key");
+    check(cache.byteSize() == 2 * sizeof(float), "Counting the results' size");
+
+    cache.insert(2, std::make_unique<TestOp::ValueResult>(20.0f));
+    check(cache.size() == 2, "Replacing the result of a key");
+    cache.insert(3, std::make_unique<TestOp::ValueResult>(3.0f));
+    check(!cache.contains(1) && cache.contains(2) && cache.contains(3), "Evicting the oldest result once over capacity");
+
+    check(takeValue(cache, 2) == 20.0f && !cache.contains(2), "Taking a result out of the cache");
+    check(cache.take(2) == nullptr, "Missing a result that was taken");
+    check(cache.byteSize() == sizeof(float), "Counting the size once taken");
+
+    // Held results aren't evicted until released
+    cache.hold(4, std::make_unique<TestOp::ValueResult>(4.0f));
+    cache.insert(5, std::make_unique<TestOp::ValueResult>(5.0f));
+    cache.insert(6, std::make_unique<TestOp::ValueResult>(6.0f));
+    check(cache.contains(4) && !cache.contains(3), "Holding a result apart from the capacity");
+    cache.releaseHeld();
+    check(cache.contains(4) && !cache.contains(5) && cache.size() == 2, "Caching a released result as the most recent");
+}
+
+static void checkFingerprints()
+{
+    Scene scene;
+    NodeID source = scene.createNode("TestSource");
+    NodeID add = scene.createNode("TestAdd");
+    scene.evaluate({});
+    scene.connect(scene.getNode(add)->input(0), scene.getNode(source)->output(0));
+    Node *sourceNode = scene.getNode(source);
+    Node *addNode = scene.getNode(add);
+
+    check(scene.evaluate({addNode}) && TestOp::op(addNode)->value() == 2.0f, "Processing the graph");
+    size_t fingerprint = addNode->fingerprint();
+    int numProcessCalls = TestOp::op(addNode)->numProcessCalls();
+
+    // Edited, the node's fingerprint changes so it misses the cache
+    scene.updateSetting(addNode, "value", 3.0f);
+    check(scene.evaluate({addNode}) && TestOp::op(addNode)->value() == 4.0f, "Processing the edited node");
+    check(addNode->fingerprint() != fingerprint, "Changing the fingerprint with a setting");
+    check(TestOp::op(addNode)->numProcessCalls() == numProcessCalls + 1, "Processing a node whose fingerprint isn't cached");
+
+    // Edited back, the first result is restored
+    scene.updateSetting(addNode, "value", 1.0f);
+    check(scene.evaluate({addNode}) && TestOp::op(addNode)->value() == 2.0f, "Restoring the first result");
+    check(addNode->fingerprint() == fingerprint, "Returning to the first fingerprint");
+    check(TestOp::op(addNode)->numProcessCalls() == numProcessCalls + 1, "Restoring a cached result instead of processing");
+
+    // Edits upstream change the fingerprint of every node downstream
+    scene.updateSetting(sourceNode, "value", 5.0f);
+    check(scene.evaluate({addNode}) && TestOp::op(addNode)->value() == 6.0f, "Processing after an upstream edit");
+    check(addNode->fingerprint() != fingerprint, "Changing the fingerprint with an upstream setting");
+    check(TestOp::op(addNode)->numProcessCalls() == numProcessCalls + 2, "Processing the node after an upstream edit");
+
+    // As do the scene settings, so the first result is missed once edited back
+    scene.setBackend(Backend_CPU);
+    scene.updateSetting(sourceNode, "value", 1.0f);
+    check(scene.evaluate({addNode}) && TestOp::op(addNode)->value() == 2.0f, "Processing after a scene edit");
+    check(addNode->fingerprint() != fingerprint, "Changing the fingerprint with a scene setting");
+    check(TestOp::op(addNode)->numProcessCalls() == numProcessCalls + 3, "Processing the node after a scene edit");
+}
+
+int main()
+{
+    TestOp::registerOperators();
+
+    checkCache();
+    checkFingerprints();
+
+    return finish("Result cache");
+}
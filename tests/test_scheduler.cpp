@@ -0,0 +1,174 @@
+#include <algorithm>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "Check.h"
+#include "TestOperators.h"
+#include "../src/nodeeditor/constants.h"
+#include "../src/nodeeditor/nodegraph/Graph.h"
+#include "../src/nodeeditor/nodegraph/ResultCache.h"
+#include "../src/nodeeditor/nodegraph/Scheduler.h"
+#include "../src/nodeeditor/nodegraph/Settings.h"
+
+// Steps the schedule to completion, returning the nodes stepped on this thread in order
+static std::vector<Node *> run(Scheduler &scheduler, Settings const *sceneSettings)
+{
+    std::vector<Node *> stepped;
+    while (!scheduler.isFinished())
+    {
+        if (Node *node = scheduler.step(sceneSettings))
+        {
+            stepped.push_back(node);
+        }
+    }
+    return stepped;
+}
+
+static bool isProcessedBefore(Op::Operator const *first, Op::Operator const *second)
+{
+    std::vector<Op::Operator const *> processed = TestOp::processed();
+    auto a = std::find(processed.begin(), processed.end(), first);
+    auto b = std::find(processed.begin(), processed.end(), second);
+    return a != processed.end() && b != processed.end() && a < b;
+}
+
+/*
+    a   b
+     \ /
+      sum   c
+        \  /
+        total
+*/
+static void checkReadyQueue()
+{
+    Graph graph;
+    Settings sceneSettings;
+    Node *a = graph.node(graph.createNode("TestSource"));
+    Node *b = graph.node(graph.createNode("TestSource"));
+    Node *c = graph.node(graph.createNode("TestSource"));
+    Node *sum = graph.node(graph.createNode("TestAdd"));
+    Node *total = graph.node(graph.createNode("TestAdd"));
+    sum->input(0)->connect(a->output(0));
+    sum->input(1)->connect(b->output(0));
+    total->input(0)->connect(sum->output(0));
+    total->input(1)->connect(c->output(0));
+    // The sources take two steps each
+    for (Node *source : {a, b, c})
+    {
+        source->updateSetting("steps", 2);
+    }
+    a->updateSetting("value", 2.0f);
+
+    Scheduler scheduler;
+    TestOp::clearProcessed();
+    scheduler.schedule({total});
+    check(scheduler.isScheduled(a) && scheduler.isScheduled(sum) && scheduler.isScheduled(total), "Scheduling the upstream nodes");
+    std::vector<Node *> stepped = run(scheduler, &sceneSettings);
+
+    check(total->state() == State::Processed && TestOp::op(total)->value() == 6.0f, "Processing the target from its inputs");
+    check(stepped.size() == 8, "Stepping each source twice and each sum once");
+    // Every ready source is advanced before any is stepped again
+    check(stepped.size() >= 3 && std::set<Node *>(stepped.begin(), stepped.begin() + 3) == std::set<Node *>{a, b, c},
+          "Interleaving the independent sources");
+    check(isProcessedBefore(a->op(), sum->op()) && isProcessedBefore(b->op(), sum->op()) &&
+              isProcessedBefore(sum->op(), total->op()) && isProcessedBefore(c->op(), total->op()),
+          "Processing nodes after their inputs");
+    check(stepped.back() == total, "Stepping the target last");
+
+    // Only unprocessed nodes are scheduled
+    scheduler.schedule({total});
+    check(scheduler.isFinished() && !scheduler.isScheduled(a), "Nothing left to schedule once the target is processed");
+    check(scheduler.step(&sceneSettings) == nullptr, "Stepping an empty schedule");
+}
+
+static void checkWorkers()
+{
+    Graph graph;
+    Settings sceneSettings;
+    Node *a = graph.node(graph.createNode("TestSource"));
+    Node *b = graph.node(graph.createNode("TestSource"));
+    Node *left = graph.node(graph.createNode("TestAsyncAdd"));
+    Node *right = graph.node(graph.createNode("TestAsyncAdd"));
+    Node *total = graph.node(graph.createNode("TestAdd"));
+    left->input(0)->connect(a->output(0));
+    right->input(0)->connect(b->output(0));
+    total->input(0)->connect(left->output(0));
+    total->input(1)->connect(right->output(0));
+
+    Scheduler scheduler(nullptr, 2);
+    scheduler.schedule({total});
+    std::vector<Node *> stepped = run(scheduler, &sceneSettings);
+    check(total->state() == State::Processed && TestOp::op(total)->value() == 5.0f, "Processing asynchronous nodes on the workers");
+    check(std::find(stepped.begin(), stepped.end(), left) == stepped.end() && std::find(stepped.begin(), stepped.end(), right) == stepped.end(),
+          "Asynchronous nodes aren't stepped on the calling thread");
+}
+
+static void checkRelease()
+{
+    Graph graph;
+    Settings sceneSettings;
+    Node *a = graph.node(graph.createNode("TestSource"));
+    Node *b = graph.node(graph.createNode("TestSource"));
+    Node *pinned = graph.node(graph.createNode("TestSource"));
+    Node *sum = graph.node(graph.createNode("TestAdd"));
+    Node *total = graph.node(graph.createNode("TestAdd"));
+    Node *other = graph.node(graph.createNode("TestAdd"));
+    Node *slow = graph.node(graph.createNode("TestSource"));
+    sum->input(0)->connect(a->output(0));
+    sum->input(1)->connect(b->output(0));
+    total->input(0)->connect(sum->output(0));
+    total->input(1)->connect(pinned->output(0));
+    // b is consumed twice, so is kept until both consumers are processed
+    other->input(0)->connect(b->output(0));
+    other->input(1)->connect(slow->output(0));
+    slow->updateSetting("steps", 8);
+    pinned->setSelectFlag(SelectFlag_Pinned);
+    // Sources with the same settings have the same fingerprint
+    b->updateSetting("value", 2.0f);
+
+    ResultCache cache(1 << 20);
+    Scheduler scheduler(&cache);
+    scheduler.schedule({total, other});
+    bool keptB = true;
+    bool checkedB = false;
+    while (!scheduler.isFinished())
+    {
+        scheduler.step(&sceneSettings);
+        if (sum->state() == State::Processed && other->state() != State::Processed)
+        {
+            keptB = keptB && b->state() == State::Processed;
+            checkedB = true;
+        }
+    }
+    check(checkedB && keptB, "Keeping a result until every consumer is processed");
+    check(total->state() == State::Processed && other->state() == State::Processed, "Keeping the targets");
+    check(pinned->state() == State::Processed, "Keeping a pinned node");
+    check(a->state() == State::Unprocessed && b->state() == State::Unprocessed && sum->state() == State::Unprocessed &&
+              slow->state() == State::Unprocessed,
+          "Releasing the intermediate results once consumed");
+    check(graph.outputByteSize() == 3 * sizeof(float), "Only counting the outputs kept");
+    check(cache.size() == 4 && cache.contains(sum->fingerprint()), "Moving the released results to the cache");
+
+    // Released results are restored rather than processed again
+    int numProcessCalls = TestOp::op(sum)->numProcessCalls();
+    for (Node *target : {total, other})
+    {
+        target->reset();
+    }
+    scheduler.schedule({total, other});
+    run(scheduler, &sceneSettings);
+    check(total->state() == State::Processed && TestOp::op(total)->value() == 6.0f, "Processing the targets again");
+    check(TestOp::op(sum)->numProcessCalls() == numProcessCalls, "Restoring the released result from the cache");
+}
+
+int main()
+{
+    TestOp::registerOperators();
+
+    checkReadyQueue();
+    checkWorkers();
+    checkRelease();
+
+    return finish("Scheduler");
+}
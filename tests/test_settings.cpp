@@ -0,0 +1,106 @@
+#include <stdexcept>
+#include <string>
+
+#include "Check.h"
+#include "TestOperators.h"
+#include "../src/nodeeditor/nodegraph/Graph.h"
+#include "../src/nodeeditor/nodegraph/Settings.h"
+
+static void checkGeneration()
+{
+    Settings settings;
+    settings.registerFloat("a", 1.0f);
+    settings.registerInt("b", 2);
+    Setting *a = settings.get("a");
+    check(a->generation() != settings.get("b")->generation(), "Giving each setting its own generation");
+
+    uint64_t generation = a->generation();
+    a->set(1.0f);
+    check(a->generation() == generation, "Keeping the generation when set to the same value");
+    a->set(3.0f);
+    check(a->generation() > generation, "Changing the generation when set to a new value");
+    uint64_t changed = a->generation();
+    a->set(1.0f);
+    check(a->generation() != generation && a->generation() != changed, "Never reusing a generation");
+
+    // Copies hold the same values, so share generations until set
+    Settings copy = settings;
+    check(copy.get("a")->generation() == a->generation(), "Sharing the generation with a copy");
+    copy.get("a")->set(5.0f);
+    check(copy.get("a")->generation() != a->generation(), "Changing only the generation of the copy that's set");
+}
+
+static void checkHash()
+{
+    Settings settings;
+    settings.registerFloat("a", 1.0f);
+    settings.registerInt("b", 2);
+    size_t hash = settings.hash();
+    size_t settingHash = settings.get("a")->hash();
+
+    settings.get("a")->set(3.0f);
+    check(settings.get("a")->hash() != settingHash && settings.hash() != hash, "Changing the hash with the value");
+    settings.get("a")->set(1.0f);
+    check(settings.get("a")->hash() == settingHash && settings.hash() == hash, "Hashing the value, not the generation");
+
+    // Equal settings hash the same, the name is part of the hash
+    Settings other;
+    other.registerFloat("a", 1.0f);
+    other.registerInt("b", 2);
+    check(other.hash() == hash, "Hashing settings registered alike equally");
+    Settings renamed;
+    renamed.registerFloat("c", 1.0f);
+    renamed.registerInt("b", 2);
+    check(renamed.hash() != hash, "Hashing the names of settings");
+    Settings fewer;
+    fewer.registerFloat("a", 1.0f);
+    check(fewer.hash() != hash, "Hashing the number of settings");
+}
+
+static void checkIndex()
+{
+    Settings settings;
+    settings.registerFloat("a", 1.0f);
+    settings.registerString("b", "value");
+    check(settings.index("a") == 0 && settings.index("b") == 1, "Indexing settings in registration order");
+    check(settings.at(settings.index("b"))->name() == "b" && settings.getString("b") == "value", "Finding settings by index");
+    check(settings.index("c") == INVALID_SETTING && settings.get("c") == nullptr && settings.at(INVALID_SETTING) == nullptr,
+          "Missing unregistered settings");
+    Settings copy = settings;
+    check(copy.index("b") == 1 && copy.get("b") == copy.at(1), "Keeping the indices of a copy");
+
+    bool threw = false;
+    try
+    {
+        settings.registerInt("a", 0);
+    }
+    catch (const std::invalid_argument &)
+    {
+        threw = true;
+    }
+    check(threw && settings.size() == 2, "Refusing a setting registered twice");
+}
+
+static void checkNodeDirty()
+{
+    Graph graph;
+    Node *node = graph.node(graph.createNode("TestSource"));
+    node->setDirty(false);
+    node->applySetting("value", 1.0f);
+    check(!node->isDirty(), "Leaving a node clean when a setting is applied unchanged");
+    node->applySetting("value", 2.0f);
+    check(node->isDirty(), "Marking a node dirty when a setting changes");
+    check(node->settings()->getFloat("value") == 1.0f, "Only applying the setting, not editing it");
+}
+
+int main()
+{
+    TestOp::registerOperators();
+
+    checkGeneration();
+    checkHash();
+    checkIndex();
+    checkNodeDirty();
+
+    return finish("Settings");
+}
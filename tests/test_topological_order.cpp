@@ -0,0 +1,223 @@
+#include <algorithm>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "Check.h"
+#include "TestOperators.h"
+#include "../src/nodeeditor/nodegraph/Graph.h"
+
+// Whether to is downstream of, or is, from, found by walking every output
+static bool reaches(Node *from, Node *to)
+{
+    std::vector<Node *> stack{from};
+    std::unordered_set<Node *> visited;
+    while (!stack.empty())
+    {
+        Node *node = stack.back();
+        stack.pop_back();
+        if (node == to)
+        {
+            return true;
+        }
+        if (!visited.insert(node).second)
+        {
+            continue;
+        }
+        for (size_t i = 0; i < node->numOutputs(); ++i)
+        {
+            for (size_t j = 0; j < node->output(i)->numConnections(); ++j)
+            {
+                stack.push_back(node->output(i)->connection(j)->node());
+            }
+        }
+    }
+    return false;
+}
+
+// Whether every node is in the order once, after every node connected to its inputs
+static bool isOrdered(Graph &graph)
+{
+    const std::vector<Node *> &order = graph.topologicalOrder();
+    if (order.size() != graph.numNodes())
+    {
+        return false;
+    }
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        Node *node = order[i];
+        if (node->topologicalIndex() != i)
+        {
+            return false;
+        }
+        for (size_t j = 0; j < node->numInputs(); ++j)
+        {
+            Connector *input = node->input(j);
+            if (input->numConnections() > 0 && input->connection(0)->node()->topologicalIndex() >= i)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static std::vector<Node *> invalidated(Graph &graph)
+{
+    std::vector<Node *> nodes;
+    graph.invalidateDirty([&nodes](Node *node)
+                          { nodes.push_back(node); });
+    return nodes;
+}
+
+static void clearDirty(Graph &graph)
+{
+    for (Node *node : graph.topologicalOrder())
+    {
+        node->setDirty(false);
+    }
+}
+
+/*
+    a   b
+     \ /
+      c   d
+       \ /
+        e
+*/
+static void checkOrder()
+{
+    Graph graph;
+    Node *e = graph.node(graph.createNode("TestAdd"));
+    Node *c = graph.node(graph.createNode("TestAdd"));
+    Node *d = graph.node(graph.createNode("TestSource"));
+    Node *b = graph.node(graph.createNode("TestSource"));
+    Node *a = graph.node(graph.createNode("TestSource"));
+    // Connected against the order the nodes were created in, so each reorders them
+    check(e->input(0)->connect(c->output(0)), "Connecting c to e");
+    check(e->input(1)->connect(d->output(0)), "Connecting d to e");
+    check(c->input(0)->connect(a->output(0)), "Connecting a to c");
+    check(c->input(1)->connect(b->output(0)), "Connecting b to c");
+    check(isOrdered(graph), "Ordering nodes after their inputs");
+
+    // Connections that would form a cycle are refused, leaving the graph as it was
+    std::vector<Node *> order = graph.topologicalOrder();
+    Node *f = graph.node(graph.createNode("TestAdd"));
+    check(f->input(0)->connect(e->output(0)), "Connecting e to f");
+    order.push_back(f);
+    c->input(0)->disconnectAll();
+    check(!c->input(0)->connect(f->output(0)), "Refusing a cycle through several nodes");
+    check(!c->input(0)->connect(e->output(0)), "Refusing a cycle with a consumer");
+    check(c->input(0)->numConnections() == 0 && e->output(0)->numConnections() == 1, "Leaving a refused connection unconnected");
+    check(graph.topologicalOrder() == order && isOrdered(graph), "Leaving the order of a refused connection");
+
+    // Removed nodes leave the rest in order
+    graph.deleteNode(c->id());
+    check(isOrdered(graph), "Keeping the order once a node is deleted");
+}
+
+static void checkInvalidation()
+{
+    Graph graph;
+    Node *a = graph.node(graph.createNode("TestSource"));
+    Node *b = graph.node(graph.createNode("TestSource"));
+    Node *c = graph.node(graph.createNode("TestAdd"));
+    Node *d = graph.node(graph.createNode("TestAdd"));
+    Node *e = graph.node(graph.createNode("TestAdd"));
+    c->input(0)->connect(a->output(0));
+    c->input(1)->connect(b->output(0));
+    d->input(0)->connect(c->output(0));
+    d->input(1)->connect(a->output(0));
+    e->input(0)->connect(b->output(0));
+    clearDirty(graph);
+    check(invalidated(graph).empty(), "Invalidating nothing without dirty nodes");
+
+    // a reaches d both directly and through c, but it's invalidated once
+    a->setDirty();
+    std::vector<Node *> nodes = invalidated(graph);
+    check(nodes == std::vector<Node *>{a, c, d}, "Invalidating a dirty node and everything downstream of it once, in order");
+    clearDirty(graph);
+
+    a->setDirty();
+    b->setDirty();
+    nodes = invalidated(graph);
+    check(nodes.size() == 5 && std::unordered_set<Node *>(nodes.begin(), nodes.end()).size() == 5,
+          "Invalidating the nodes downstream of several dirty nodes once");
+    clearDirty(graph);
+    e->setDirty();
+    check(invalidated(graph) == std::vector<Node *>{e}, "Invalidating only a dirty node without outputs");
+}
+
+// Random connections and edits checked against walking the graph
+static void checkRandomGraphs()
+{
+    std::mt19937 rng(4321);
+    bool ordered = true;
+    bool refusedCycles = true;
+    bool invalidatedDownstream = true;
+    for (int round = 0; round < 20; ++round)
+    {
+        Graph graph;
+        std::vector<Node *> nodes;
+        for (int i = 0; i < 40; ++i)
+        {
+            nodes.push_back(graph.node(graph.createNode(rng() % 4 ? "TestAdd" : "TestSource")));
+        }
+        for (int i = 0; i < 200; ++i)
+        {
+            Node *from = nodes[rng() % nodes.size()];
+            Node *to = nodes[rng() % nodes.size()];
+            if (from == to || to->numInputs() == 0)
+            {
+                continue;
+            }
+            Connector *input = to->input(rng() % to->numInputs());
+            if (rng() % 4 == 0)
+            {
+                input->disconnectAll();
+            }
+            if (input->numConnections() > 0)
+            {
+                continue;
+            }
+            bool isCycle = reaches(to, from);
+            bool connected = input->connect(from->output(0));
+            refusedCycles = refusedCycles && connected == !isCycle;
+            ordered = ordered && isOrdered(graph);
+        }
+
+        // Only a few nodes dirty, so most of the graph is left alone
+        clearDirty(graph);
+        std::vector<Node *> dirty;
+        for (int i = 0; i < 3; ++i)
+        {
+            dirty.push_back(nodes[rng() % nodes.size()]);
+            dirty.back()->setDirty();
+        }
+        std::vector<Node *> expected;
+        for (Node *node : graph.topologicalOrder())
+        {
+            if (std::any_of(dirty.begin(), dirty.end(), [node](Node *d)
+                            { return reaches(d, node); }))
+            {
+                expected.push_back(node);
+            }
+        }
+        invalidatedDownstream = invalidatedDownstream && invalidated(graph) == expected;
+    }
+    check(refusedCycles, "Refusing exactly the connections that form cycles");
+    check(ordered, "Keeping random graphs in order");
+    check(invalidatedDownstream, "Invalidating exactly the nodes downstream of dirty nodes in random graphs");
+}
+
+int main()
+{
+    TestOp::registerOperators();
+
+    checkOrder();
+    checkInvalidation();
+    checkRandomGraphs();
+
+    return finish("Topological order");
+}
@@ -0,0 +1,143 @@
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <EGL/egl.h>
+
+#include "Check.h"
+#include "../src/nodeeditor/constants.h"
+#include "../src/nodeeditor/gl/HeadlessContext.h"
+#include "../src/nodeeditor/gl/RenderSetOperator.h"
+#include "../src/nodeeditor/gl/TexturePool.h"
+#include "../src/nodeeditor/gl/ViewLayers.h"
+#include "../src/nodeeditor/nodegraph/Scene.h"
+#include "../src/nodeeditor/operators/Operators.hpp"
+
+// Publishes the view node's layers as RenderScene does, without a window
+class ViewScene : public Scene
+{
+public:
+    ViewScene(HeadlessContext *context) : m_context(context) {}
+
+    std::atomic<int> numPublished = 0;
+
+    bool isIdle() const { return m_internalPause.load(); }
+    std::shared_ptr<ViewLayers const> viewLayers() const { return std::atomic_load(&m_viewLayers); }
+
+protected:
+    HeadlessContext *m_context;
+    std::shared_ptr<ViewLayers const> m_viewLayers;
+
+    void process() override
+    {
+        m_context->use();
+        Scene::process();
+        std::atomic_store(&m_viewLayers, std::shared_ptr<ViewLayers const>());
+        // The context is used again by the test's thread once processing stops
+        eglMakeCurrent(eglGetCurrentDisplay(), EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    }
+    void publishView(Node *viewNode) override
+    {
+        Op::RenderSetOperator const *op = viewNode ? dynamic_cast<Op::RenderSetOperator const *>(viewNode->op()) : nullptr;
+        std::shared_ptr<ViewLayers const> layers;
+        if (op)
+        {
+            layers = std::make_shared<ViewLayers const>(viewNode->id(), *op->renderSet());
+        }
+        std::atomic_store(&m_viewLayers, layers);
+        ++numPublished;
+    }
+};
+
+static bool waitFor(std::function<bool()> done)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(60);
+    while (!done())
+    {
+        if (std::chrono::steady_clock::now() > deadline)
+        {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return true;
+}
+
+static void checkPool()
+{
+    TexturePool pool(1 << 30);
+    Texture *texture = pool.acquire({16, 16});
+    pool.hold(texture);
+    pool.hold(texture);
+    pool.release(texture);
+    Texture *other = pool.acquire({16, 16});
+    check(other != texture, "A held texture isn't reused once released");
+    pool.unhold(texture);
+    check(pool.isHeld(texture), "A texture held twice is held until unheld twice");
+    pool.unhold(texture);
+    check(!pool.isHeld(texture), "Unholding every hold");
+    check(pool.acquire({16, 16}) == texture, "A released texture is reused once unheld");
+    pool.release(texture);
+    pool.release(other);
+}
+
+static void checkPublished(HeadlessContext &context)
+{
+    ViewScene scene{&context};
+    NodeID gradient = scene.createNode("Gradient");
+    NodeID power = scene.createNode("Power");
+    scene.evaluate({});
+    scene.connect(scene.getNode(power)->input(0), scene.getNode(gradient)->output(0));
+    scene.evaluate({});
+
+    eglMakeCurrent(eglGetCurrentDisplay(), EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    scene.startProcessing();
+    scene.setViewNode(scene.getNode(power));
+    auto isProcessed = [&]()
+    { return scene.isIdle() && scene.snapshot()->node(power)->state() == State::Processed; };
+    check(waitFor(isProcessed), "Processing the view node");
+    std::shared_ptr<ViewLayers const> layers = scene.viewLayers();
+    check(layers && layers->nodeID() == power && layers->layer(DEFAULT_LAYER), "Publishing the view node's layers");
+    Texture const *texture = layers ? layers->layer(DEFAULT_LAYER) : nullptr;
+
+    // Processed again while the first layers are held
+    int numPublished = scene.numPublished;
+    scene.updateSetting(scene.getNode(power), "exponent", 3.0f);
+    check(waitFor([&]()
+                  { return scene.numPublished > numPublished && isProcessed(); }),
+          "Publishing the edited view node");
+    std::shared_ptr<ViewLayers const> edited = scene.viewLayers();
+    check(edited && edited->layer(DEFAULT_LAYER) && edited->layer(DEFAULT_LAYER) != texture,
+          "Writing the edited view node to another texture while the first is held");
+    check(TexturePool::instance().isHeld(texture), "Holding the first layers until they're dropped");
+
+    // Cleared once there is no view node
+    scene.setViewNode(nullptr);
+    check(waitFor([&]()
+                  { return !scene.viewLayers(); }),
+          "Clearing the published layers without a view node");
+    scene.stopProcessing();
+    context.use();
+    layers.reset();
+    check(!TexturePool::instance().isHeld(texture), "Releasing the first layers once dropped");
+}
+
+int main()
+{
+    HeadlessContext context{true};
+    if (!context.isInitialised())
+    {
+        std::cout << "View layer tests need an OpenGL context" << std::endl;
+        return 1;
+    }
+
+    checkPool();
+    checkPublished(context);
+
+    return finish("View layers");
+}